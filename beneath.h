@@ -47,6 +47,9 @@ LICENSE
 /* Helper Macros */
 #define BENEATH_ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
 
+/* Platforms that link against the C runtime (e.g. for a system GL/EGL driver)
+ * define BENEATH_USE_CRT so these do not interpose the libc versions. */
+#ifndef BENEATH_USE_CRT
 #ifdef _MSC_VER
 #pragma function(memset)
 #endif
@@ -73,6 +76,7 @@ void *memcpy(void *dest, const void *src, unsigned int count)
   }
   return dest;
 }
+#endif /* BENEATH_USE_CRT */
 
 void beneath_strcpy(char *dest, char *src, int dest_size)
 {
@@ -104,10 +108,158 @@ void beneath_strcpy(char *dest, char *src, int dest_size)
 
 typedef unsigned char beneath_bool;
 
+/* #############################################################################
+ * # Beneath Memory Arena
+ * #############################################################################
+ *
+ * Linear (bump) allocator over a platform provided block. Nothing is freed
+ * individually, an arena is reset as a whole or rolled back to a marker.
+ * The base has to be aligned to BENEATH_ARENA_ALIGNMENT_DEFAULT so that
+ * aligned offsets are aligned addresses (page aligned platform memory is).
+ *
+ * An arena can sit on reserved (not yet committed) address space. Pushes past
+ * the committed part commit more pages through the platform commit callback,
+ * in steps of BENEATH_ARENA_COMMIT_GRANULARITY. Committed pages are kept on reset.
+ */
+#define BENEATH_ARENA_ALIGNMENT_DEFAULT 16             /* Largest alignment of engine types (SSE) */
+#define BENEATH_ARENA_COMMIT_GRANULARITY (64 * 1024) /* 64 KB, the windows allocation granularity */
+
+#define BENEATH_ARENA_PUSH_STRUCT(arena, type) ((type *)beneath_arena_push_zero((arena), sizeof(type), BENEATH_ARENA_ALIGNMENT_DEFAULT))
+#define BENEATH_ARENA_PUSH_ARRAY(arena, type, count) ((type *)beneath_arena_push((arena), (unsigned int)(sizeof(type) * (count)), BENEATH_ARENA_ALIGNMENT_DEFAULT))
+
+/* Makes [address, address + size) readable and writable, the range may start/end inside a page */
+typedef beneath_bool (*beneath_arena_commit)(void *address, unsigned int size);
+
+typedef struct beneath_arena
+{
+  unsigned char *base;
+  unsigned int size;       /* Capacity in bytes (reserved) */
+  unsigned int offset;     /* Bytes in use */
+  unsigned int offset_max; /* High water mark, useful for sizing the arena */
+  unsigned int committed;  /* Bytes backed by memory, equals size without commit callback */
+
+  beneath_arena_commit commit;
+
+} beneath_arena;
+
+/* Saved arena offset, everything pushed after begin is released by end */
+typedef struct beneath_arena_temp
+{
+  beneath_arena *arena;
+  unsigned int offset;
+
+} beneath_arena_temp;
+
+/* commit == 0 means the whole block is already usable */
+BENEATH_API BENEATH_INLINE void beneath_arena_initialize(beneath_arena *arena, void *base, unsigned int size, beneath_arena_commit commit)
+{
+  arena->base = (unsigned char *)base;
+  arena->size = size;
+  arena->offset = 0;
+  arena->offset_max = 0;
+  arena->committed = commit ? 0 : size;
+  arena->commit = commit;
+}
+
+/* Returns size bytes aligned to alignment (power of two) or 0 if the arena is full */
+BENEATH_API BENEATH_INLINE void *beneath_arena_push(beneath_arena *arena, unsigned int size, unsigned int alignment)
+{
+  unsigned int offset = (arena->offset + (alignment - 1)) & ~(alignment - 1);
+
+  if (offset < arena->offset || offset > arena->size || size > arena->size - offset)
+  {
+    return (void *)0;
+  }
+
+  if (offset + size > arena->committed)
+  {
+    unsigned int granularity_mask = BENEATH_ARENA_COMMIT_GRANULARITY - 1;
+    unsigned int committed = (offset + size + granularity_mask) & ~granularity_mask;
+
+    if (committed < offset + size || committed > arena->size)
+    {
+      committed = arena->size;
+    }
+
+    if (!arena->commit || !arena->commit(arena->base + arena->committed, committed - arena->committed))
+    {
+      return (void *)0;
+    }
+
+    arena->committed = committed;
+  }
+
+  arena->offset = offset + size;
+
+  if (arena->offset > arena->offset_max)
+  {
+    arena->offset_max = arena->offset;
+  }
+
+  return arena->base + offset;
+}
+
+BENEATH_API BENEATH_INLINE void *beneath_arena_push_zero(beneath_arena *arena, unsigned int size, unsigned int alignment)
+{
+  unsigned char *result = (unsigned char *)beneath_arena_push(arena, size, alignment);
+  unsigned int i;
+
+  if (result)
+  {
+    for (i = 0; i < size; ++i)
+    {
+      result[i] = 0;
+    }
+  }
+
+  return result;
+}
+
+BENEATH_API BENEATH_INLINE void beneath_arena_reset(beneath_arena *arena)
+{
+  arena->offset = 0;
+}
+
+BENEATH_API BENEATH_INLINE beneath_arena_temp beneath_arena_temp_begin(beneath_arena *arena)
+{
+  beneath_arena_temp temp;
+  temp.arena = arena;
+  temp.offset = arena->offset;
+  return temp;
+}
+
+BENEATH_API BENEATH_INLINE void beneath_arena_temp_end(beneath_arena_temp temp)
+{
+  temp.arena->offset = temp.offset;
+}
+
 /* #############################################################################
  * # Beneath Memory Block
  * #############################################################################
+ *
+ * The platform reserves one address range and splits it into:
+ *
+ * [beneath_state | permanent arena ........ | frame arena]
+ *
+ * - permanent: application lifetime data (meshes, draw calls, instance buffers)
+ * - frame:     scratch data, reset by the platform before every beneath_update
+ *
+ * Only the beneath_state is committed up front, the arenas commit pages as
+ * they grow. The sizes are upper bounds of address space, not memory usage,
+ * and can be overridden when building the platform layer, e.g.
+ * -DBENEATH_MEMORY_PERMANENT_SIZE=2147483648u (must fit an unsigned int together).
  */
+#ifndef BENEATH_MEMORY_PERMANENT_SIZE
+#define BENEATH_MEMORY_PERMANENT_SIZE (512u * 1024u * 1024u) /* 512 MB */
+#endif
+
+#ifndef BENEATH_MEMORY_FRAME_SIZE
+#define BENEATH_MEMORY_FRAME_SIZE (64u * 1024u * 1024u) /* 64 MB */
+#endif
+
+/* Total address space the platform has to reserve */
+#define BENEATH_MEMORY_RESERVE_SIZE (BENEATH_MEMORY_PERMANENT_SIZE + BENEATH_MEMORY_FRAME_SIZE + (unsigned int)sizeof(beneath_state) + BENEATH_ARENA_ALIGNMENT_DEFAULT)
+
 typedef struct beneath_memory
 {
   beneath_bool memory_initialized;
@@ -115,12 +267,73 @@ typedef struct beneath_memory
   unsigned int memory_offset; /* By default the first entry of the memory is the beneath_state struct */
   void *memory;
 
+  beneath_arena permanent; /* Starts at memory_offset */
+  beneath_arena frame;     /* Reset every frame */
+
 } beneath_memory;
 
+/* Called by the platform once memory, memory_size and memory_offset are set and
+ * the beneath_state is committed. commit == 0 for fully committed memory.
+ */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_memory_arenas_initialize(beneath_memory *memory, unsigned int frame_size, beneath_arena_commit commit)
+{
+  unsigned int alignment_mask = BENEATH_ARENA_ALIGNMENT_DEFAULT - 1;
+  unsigned int permanent_offset = (memory->memory_offset + alignment_mask) & ~alignment_mask;
+  unsigned int frame_offset;
+
+  frame_size = (frame_size + alignment_mask) & ~alignment_mask;
+
+  if (permanent_offset > memory->memory_size || frame_size > memory->memory_size - permanent_offset)
+  {
+    return false;
+  }
+
+  frame_offset = memory->memory_size - frame_size;
+
+  memory->memory_offset = permanent_offset;
+
+  beneath_arena_initialize(&memory->permanent, (unsigned char *)memory->memory + permanent_offset, frame_offset - permanent_offset, commit);
+  beneath_arena_initialize(&memory->frame, (unsigned char *)memory->memory + frame_offset, frame_size, commit);
+
+  return true;
+}
+
 /* #############################################################################
  * # Beneath Rendering
  * #############################################################################
  */
+/* Vertex attributes of a mesh, in the order of the shader layout locations */
+typedef enum beneath_vertex_attribute
+{
+  BENEATH_VERTEX_ATTRIBUTE_POSITION = 0,
+  BENEATH_VERTEX_ATTRIBUTE_UV,
+  BENEATH_VERTEX_ATTRIBUTE_NORMAL,
+  BENEATH_VERTEX_ATTRIBUTE_TANGENT,
+  BENEATH_VERTEX_ATTRIBUTE_BITANGENT,
+  BENEATH_VERTEX_ATTRIBUTE_COLOR,
+  BENEATH_VERTEX_ATTRIBUTE_COUNT
+
+} beneath_vertex_attribute;
+
+/* Storage of one attribute inside the interleaved vertex stream, every attribute takes a multiple of 4 bytes */
+typedef enum beneath_vertex_format
+{
+  BENEATH_VERTEX_FORMAT_NONE = 0,         /* Attribute not present */
+  BENEATH_VERTEX_FORMAT_FLOAT32,          /* Any attribute, 4 bytes per component */
+  BENEATH_VERTEX_FORMAT_FLOAT16,          /* uvs, 2 bytes per component */
+  BENEATH_VERTEX_FORMAT_SNORM_10_10_10_2, /* normals, tangents, bitangents, xyz in 4 bytes (w unused) */
+  BENEATH_VERTEX_FORMAT_UNORM8            /* colors, rgb in 4 bytes (a = 255) */
+
+} beneath_vertex_format;
+
+typedef struct beneath_vertex_layout
+{
+  unsigned int stride;                                   /* Bytes per vertex */
+  unsigned char formats[BENEATH_VERTEX_ATTRIBUTE_COUNT]; /* beneath_vertex_format per attribute */
+  unsigned char offsets[BENEATH_VERTEX_ATTRIBUTE_COUNT]; /* Byte offset inside a vertex */
+
+} beneath_vertex_layout;
+
 typedef struct beneath_mesh
 {
   unsigned int id;
@@ -142,9 +355,635 @@ typedef struct beneath_mesh
   float *bitangents;
   float *colors;
   unsigned int *indices;
+  unsigned short *indices16; /* Optional 16 bit copy of indices (see beneath_mesh_indices_narrow), preferred if set */
+
+  /* Optional interleaved vertex stream (see beneath_mesh_interleave). If set the
+   * OpenGL renderer uploads it as one buffer instead of the separate arrays above.
+   */
+  beneath_vertex_layout layout;
+  unsigned int interleaved_count; /* Number of vertices */
+  unsigned char *interleaved;
+
+  /* Object space bounding box (see beneath_mesh_bounds_compute), meshes without bounds are never culled.
+   * Renderers compute missing bounds on upload, recompute them after moving vertices.
+   */
+  beneath_bool bounds_valid;
+  float bounds_center[3];
+  float bounds_extents[3]; /* Half size per axis */
+
+  /* Object space distance the mesh deviates from the mesh it was simplified from
+   * (see beneath_mesh_simplify), 0 for source meshes. Drives the LOD selection.
+   */
+  float lod_error;
 
 } beneath_mesh;
 
+BENEATH_API BENEATH_INLINE unsigned int beneath_mesh_index(beneath_mesh *mesh, unsigned int i)
+{
+  return mesh->indices16 ? (unsigned int)mesh->indices16[i] : mesh->indices[i];
+}
+
+/* Stores a 16 bit copy of the indices allocated from arena if every index fits,
+ * which halves index memory and bandwidth. Returns false if the mesh keeps 32 bit indices.
+ */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_indices_narrow(beneath_mesh *mesh, beneath_arena *arena)
+{
+  unsigned short *indices16;
+  unsigned int i;
+
+  if (mesh->indices16)
+  {
+    return true;
+  }
+
+  if (!mesh->indices)
+  {
+    return false;
+  }
+
+  for (i = 0; i < mesh->indices_count; ++i)
+  {
+    if (mesh->indices[i] > 0xFFFFu)
+    {
+      return false;
+    }
+  }
+
+  indices16 = BENEATH_ARENA_PUSH_ARRAY(arena, unsigned short, mesh->indices_count);
+
+  if (!indices16)
+  {
+    return false;
+  }
+
+  for (i = 0; i < mesh->indices_count; ++i)
+  {
+    indices16[i] = (unsigned short)mesh->indices[i];
+  }
+
+  mesh->indices16 = indices16;
+  mesh->changed = true;
+
+  return true;
+}
+
+/* Computes the object space bounding box from the vertex positions */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_bounds_compute(beneath_mesh *mesh)
+{
+  float min[3];
+  float max[3];
+  unsigned int i;
+  unsigned int j;
+
+  mesh->bounds_valid = false;
+
+  if (!mesh->vertices || mesh->vertices_count < 3)
+  {
+    return false;
+  }
+
+  for (j = 0; j < 3; ++j)
+  {
+    min[j] = mesh->vertices[j];
+    max[j] = mesh->vertices[j];
+  }
+
+  for (i = 3; i + 2 < mesh->vertices_count; i += 3)
+  {
+    for (j = 0; j < 3; ++j)
+    {
+      float v = mesh->vertices[i + j];
+      min[j] = v < min[j] ? v : min[j];
+      max[j] = v > max[j] ? v : max[j];
+    }
+  }
+
+  for (j = 0; j < 3; ++j)
+  {
+    mesh->bounds_center[j] = (min[j] + max[j]) * 0.5f;
+    mesh->bounds_extents[j] = (max[j] - min[j]) * 0.5f;
+  }
+
+  mesh->bounds_valid = true;
+
+  return true;
+}
+
+/* Is the attribute present, taken from the layout for interleaved meshes */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_has_attribute(beneath_mesh *mesh, beneath_vertex_attribute attribute)
+{
+  if (mesh->interleaved)
+  {
+    return mesh->layout.formats[attribute] != BENEATH_VERTEX_FORMAT_NONE;
+  }
+
+  switch (attribute)
+  {
+  case BENEATH_VERTEX_ATTRIBUTE_POSITION:
+    return mesh->vertices_count > 0;
+  case BENEATH_VERTEX_ATTRIBUTE_UV:
+    return mesh->uvs_count > 0;
+  case BENEATH_VERTEX_ATTRIBUTE_NORMAL:
+    return mesh->normals_count > 0;
+  case BENEATH_VERTEX_ATTRIBUTE_TANGENT:
+    return mesh->tangents_count > 0;
+  case BENEATH_VERTEX_ATTRIBUTE_BITANGENT:
+    return mesh->bitangents_count > 0;
+  case BENEATH_VERTEX_ATTRIBUTE_COLOR:
+    return mesh->colors_count > 0;
+  default:
+    return false;
+  }
+}
+
+BENEATH_API BENEATH_INLINE unsigned short beneath_vertex_pack_float16(float value)
+{
+  union
+  {
+    float f;
+    unsigned int u;
+  } bits;
+
+  unsigned int sign;
+  unsigned int exponent;
+  unsigned int mantissa;
+
+  bits.f = value;
+  sign = (bits.u >> 16) & 0x8000u;
+  exponent = (bits.u >> 23) & 0xFFu;
+  mantissa = bits.u & 0x7FFFFFu;
+
+  /* Infinity and NaN */
+  if (exponent == 0xFFu)
+  {
+    return (unsigned short)(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+  }
+
+  /* Too large, infinity */
+  if (exponent > 142u)
+  {
+    return (unsigned short)(sign | 0x7C00u);
+  }
+
+  /* Subnormal half or zero */
+  if (exponent < 113u)
+  {
+    unsigned int shift = 126u - exponent;
+
+    if (exponent < 103u)
+    {
+      return (unsigned short)sign;
+    }
+
+    mantissa |= 0x800000u;
+
+    return (unsigned short)(sign | ((mantissa + (1u << (shift - 1u))) >> shift));
+  }
+
+  /* Round to nearest, a mantissa carry correctly moves into the exponent */
+  return (unsigned short)(sign | ((((exponent - 112u) << 10) | (mantissa >> 13)) + ((mantissa >> 12) & 1u)));
+}
+
+BENEATH_API BENEATH_INLINE unsigned int beneath_vertex_pack_snorm10(float value)
+{
+  int quantized;
+
+  value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+  quantized = (int)(value * 511.0f + (value < 0.0f ? -0.5f : 0.5f));
+
+  return (unsigned int)quantized & 0x3FFu;
+}
+
+BENEATH_API BENEATH_INLINE unsigned int beneath_vertex_pack_unorm8(float value)
+{
+  value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+
+  return (unsigned int)(value * 255.0f + 0.5f);
+}
+
+/* Floats per vertex of each beneath_vertex_attribute in the separate mesh arrays */
+BENEATH_API BENEATH_INLINE unsigned int beneath_vertex_attribute_components(unsigned int attribute)
+{
+  return attribute == BENEATH_VERTEX_ATTRIBUTE_UV ? 2u : 3u;
+}
+
+/* Bytes of the attribute in an interleaved vertex, 0 for NONE and for unsupported attribute and format combinations */
+BENEATH_API BENEATH_INLINE unsigned int beneath_vertex_attribute_size(unsigned int attribute, unsigned int format)
+{
+  switch (format)
+  {
+  case BENEATH_VERTEX_FORMAT_FLOAT32:
+    return beneath_vertex_attribute_components(attribute) * 4;
+  case BENEATH_VERTEX_FORMAT_FLOAT16:
+    return attribute == BENEATH_VERTEX_ATTRIBUTE_UV ? 4u : 0u;
+  case BENEATH_VERTEX_FORMAT_SNORM_10_10_10_2:
+    return (attribute == BENEATH_VERTEX_ATTRIBUTE_NORMAL || attribute == BENEATH_VERTEX_ATTRIBUTE_TANGENT || attribute == BENEATH_VERTEX_ATTRIBUTE_BITANGENT) ? 4u : 0u;
+  case BENEATH_VERTEX_FORMAT_UNORM8:
+    return attribute == BENEATH_VERTEX_ATTRIBUTE_COLOR ? 4u : 0u;
+  default:
+    return 0;
+  }
+}
+
+/* Packs the separate attribute arrays of the mesh into one interleaved vertex stream
+ * allocated from arena. formats holds the wanted beneath_vertex_format per attribute,
+ * attributes missing in the mesh are left out. Positions must be FLOAT32.
+ * The separate arrays stay untouched (the software renderer still reads them).
+ */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_interleave(beneath_mesh *mesh, unsigned char formats[BENEATH_VERTEX_ATTRIBUTE_COUNT], beneath_arena *arena)
+{
+  float *sources[BENEATH_VERTEX_ATTRIBUTE_COUNT];
+  beneath_vertex_layout layout;
+  unsigned int vertex_count = mesh->vertices_count / 3;
+  unsigned int offset = 0;
+  unsigned int vertex;
+  unsigned int i;
+
+  if (!mesh->vertices || vertex_count == 0 || formats[BENEATH_VERTEX_ATTRIBUTE_POSITION] != BENEATH_VERTEX_FORMAT_FLOAT32)
+  {
+    return false;
+  }
+
+  sources[BENEATH_VERTEX_ATTRIBUTE_POSITION] = mesh->vertices;
+  sources[BENEATH_VERTEX_ATTRIBUTE_UV] = mesh->uvs_count > 0 ? mesh->uvs : (float *)0;
+  sources[BENEATH_VERTEX_ATTRIBUTE_NORMAL] = mesh->normals_count > 0 ? mesh->normals : (float *)0;
+  sources[BENEATH_VERTEX_ATTRIBUTE_TANGENT] = mesh->tangents_count > 0 ? mesh->tangents : (float *)0;
+  sources[BENEATH_VERTEX_ATTRIBUTE_BITANGENT] = mesh->bitangents_count > 0 ? mesh->bitangents : (float *)0;
+  sources[BENEATH_VERTEX_ATTRIBUTE_COLOR] = mesh->colors_count > 0 ? mesh->colors : (float *)0;
+
+  for (i = 0; i < BENEATH_VERTEX_ATTRIBUTE_COUNT; ++i)
+  {
+    unsigned int format = sources[i] ? formats[i] : BENEATH_VERTEX_FORMAT_NONE;
+    unsigned int size = beneath_vertex_attribute_size(i, format);
+
+    /* Unsupported attribute and format combination */
+    if (format != BENEATH_VERTEX_FORMAT_NONE && size == 0)
+    {
+      return false;
+    }
+
+    layout.formats[i] = (unsigned char)format;
+    layout.offsets[i] = (unsigned char)offset;
+    offset += size;
+  }
+
+  layout.stride = offset;
+
+  mesh->interleaved = BENEATH_ARENA_PUSH_ARRAY(arena, unsigned char, vertex_count * layout.stride);
+
+  if (!mesh->interleaved)
+  {
+    return false;
+  }
+
+  for (vertex = 0; vertex < vertex_count; ++vertex)
+  {
+    unsigned char *dst = mesh->interleaved + vertex * layout.stride;
+
+    for (i = 0; i < BENEATH_VERTEX_ATTRIBUTE_COUNT; ++i)
+    {
+      float *src = sources[i] ? sources[i] + vertex * beneath_vertex_attribute_components(i) : (float *)0;
+      unsigned char *attribute = dst + layout.offsets[i];
+
+      switch (layout.formats[i])
+      {
+      case BENEATH_VERTEX_FORMAT_FLOAT32:
+      {
+        unsigned int c;
+
+        for (c = 0; c < beneath_vertex_attribute_components(i); ++c)
+        {
+          ((float *)attribute)[c] = src[c];
+        }
+      }
+      break;
+      case BENEATH_VERTEX_FORMAT_FLOAT16:
+        ((unsigned short *)attribute)[0] = beneath_vertex_pack_float16(src[0]);
+        ((unsigned short *)attribute)[1] = beneath_vertex_pack_float16(src[1]);
+        break;
+      case BENEATH_VERTEX_FORMAT_SNORM_10_10_10_2:
+        ((unsigned int *)attribute)[0] = beneath_vertex_pack_snorm10(src[0]) | (beneath_vertex_pack_snorm10(src[1]) << 10) | (beneath_vertex_pack_snorm10(src[2]) << 20);
+        break;
+      case BENEATH_VERTEX_FORMAT_UNORM8:
+        attribute[0] = (unsigned char)beneath_vertex_pack_unorm8(src[0]);
+        attribute[1] = (unsigned char)beneath_vertex_pack_unorm8(src[1]);
+        attribute[2] = (unsigned char)beneath_vertex_pack_unorm8(src[2]);
+        attribute[3] = 255;
+        break;
+      default:
+        break;
+      }
+    }
+  }
+
+  mesh->layout = layout;
+  mesh->interleaved_count = vertex_count;
+  mesh->changed = true;
+
+  return true;
+}
+
+/* Binary mesh container (.bmesh) holding a beneath_mesh as stored in memory.
+ * beneath_mesh_file_write serializes a mesh, beneath_mesh_file_load points the mesh
+ * fields straight into the file data (usually a read only mapping from api->io_file_map),
+ * there is no parse step and no copy. The file is little endian:
+ *
+ *   beneath_mesh_file_header
+ *   streams, each at a BENEATH_MESH_FILE_ALIGNMENT aligned offset in beneath_mesh_file_stream order
+ */
+#define BENEATH_MESH_FILE_MAGIC 0x48534D42u /* "BMSH" */
+#define BENEATH_MESH_FILE_VERSION 2u
+#define BENEATH_MESH_FILE_ALIGNMENT 16u
+
+typedef enum beneath_mesh_file_stream
+{
+  BENEATH_MESH_FILE_STREAM_VERTICES = 0,
+  BENEATH_MESH_FILE_STREAM_UVS,
+  BENEATH_MESH_FILE_STREAM_NORMALS,
+  BENEATH_MESH_FILE_STREAM_TANGENTS,
+  BENEATH_MESH_FILE_STREAM_BITANGENTS,
+  BENEATH_MESH_FILE_STREAM_COLORS,
+  BENEATH_MESH_FILE_STREAM_INDICES,
+  BENEATH_MESH_FILE_STREAM_INDICES16,
+  BENEATH_MESH_FILE_STREAM_INTERLEAVED,
+  BENEATH_MESH_FILE_STREAM_COUNT
+
+} beneath_mesh_file_stream;
+
+typedef struct beneath_mesh_file_header
+{
+  unsigned int magic;
+  unsigned int version;
+  unsigned int file_size;                                       /* Total bytes including the header */
+  unsigned int stream_offsets[BENEATH_MESH_FILE_STREAM_COUNT]; /* Byte offset from the file start, 0 if the stream is absent */
+  unsigned int stream_counts[BENEATH_MESH_FILE_STREAM_COUNT];  /* The beneath_mesh count (floats, indices or interleaved vertices) */
+  beneath_vertex_layout layout;                                 /* Layout of the interleaved stream */
+  float lod_error;                                              /* beneath_mesh lod_error */
+
+} beneath_mesh_file_header;
+
+/* Bytes of one stream element */
+BENEATH_API BENEATH_INLINE unsigned int beneath_mesh_file_stream_stride(beneath_mesh_file_stream stream, beneath_vertex_layout *layout)
+{
+  switch (stream)
+  {
+  case BENEATH_MESH_FILE_STREAM_INDICES16:
+    return sizeof(unsigned short);
+  case BENEATH_MESH_FILE_STREAM_INTERLEAVED:
+    return layout->stride;
+  case BENEATH_MESH_FILE_STREAM_INDICES:
+    return sizeof(unsigned int);
+  default:
+    return sizeof(float);
+  }
+}
+
+BENEATH_API BENEATH_INLINE unsigned int beneath_mesh_file_align(unsigned int offset)
+{
+  return (offset + BENEATH_MESH_FILE_ALIGNMENT - 1) & ~(BENEATH_MESH_FILE_ALIGNMENT - 1);
+}
+
+/* Fills the header (stream offsets, counts and total size) for the mesh */
+BENEATH_API BENEATH_INLINE void beneath_mesh_file_header_build(beneath_mesh *mesh, beneath_mesh_file_header *header, unsigned char *streams[BENEATH_MESH_FILE_STREAM_COUNT])
+{
+  unsigned int offset = beneath_mesh_file_align(sizeof(beneath_mesh_file_header));
+  unsigned int i;
+
+  streams[BENEATH_MESH_FILE_STREAM_VERTICES] = (unsigned char *)mesh->vertices;
+  streams[BENEATH_MESH_FILE_STREAM_UVS] = (unsigned char *)mesh->uvs;
+  streams[BENEATH_MESH_FILE_STREAM_NORMALS] = (unsigned char *)mesh->normals;
+  streams[BENEATH_MESH_FILE_STREAM_TANGENTS] = (unsigned char *)mesh->tangents;
+  streams[BENEATH_MESH_FILE_STREAM_BITANGENTS] = (unsigned char *)mesh->bitangents;
+  streams[BENEATH_MESH_FILE_STREAM_COLORS] = (unsigned char *)mesh->colors;
+  streams[BENEATH_MESH_FILE_STREAM_INDICES] = (unsigned char *)mesh->indices;
+  streams[BENEATH_MESH_FILE_STREAM_INDICES16] = (unsigned char *)mesh->indices16;
+  streams[BENEATH_MESH_FILE_STREAM_INTERLEAVED] = mesh->interleaved;
+
+  header->magic = BENEATH_MESH_FILE_MAGIC;
+  header->version = BENEATH_MESH_FILE_VERSION;
+  header->stream_counts[BENEATH_MESH_FILE_STREAM_VERTICES] = mesh->vertices_count;
+  header->stream_counts[BENEATH_MESH_FILE_STREAM_UVS] = mesh->uvs_count;
+  header->stream_counts[BENEATH_MESH_FILE_STREAM_NORMALS] = mesh->normals_count;
+  header->stream_counts[BENEATH_MESH_FILE_STREAM_TANGENTS] = mesh->tangents_count;
+  header->stream_counts[BENEATH_MESH_FILE_STREAM_BITANGENTS] = mesh->bitangents_count;
+  header->stream_counts[BENEATH_MESH_FILE_STREAM_COLORS] = mesh->colors_count;
+  header->stream_counts[BENEATH_MESH_FILE_STREAM_INDICES] = mesh->indices_count;
+  header->stream_counts[BENEATH_MESH_FILE_STREAM_INDICES16] = mesh->indices_count;
+  header->stream_counts[BENEATH_MESH_FILE_STREAM_INTERLEAVED] = mesh->interleaved_count;
+  header->layout = mesh->layout;
+  header->lod_error = mesh->lod_error;
+
+  for (i = 0; i < BENEATH_MESH_FILE_STREAM_COUNT; ++i)
+  {
+    if (!streams[i] || header->stream_counts[i] == 0)
+    {
+      streams[i] = (unsigned char *)0;
+      header->stream_offsets[i] = 0;
+      header->stream_counts[i] = 0;
+      continue;
+    }
+
+    header->stream_offsets[i] = offset;
+    offset = beneath_mesh_file_align(offset + header->stream_counts[i] * beneath_mesh_file_stream_stride((beneath_mesh_file_stream)i, &header->layout));
+  }
+
+  header->file_size = offset;
+}
+
+/* The number of bytes beneath_mesh_file_write needs for the mesh */
+BENEATH_API BENEATH_INLINE unsigned int beneath_mesh_file_size(beneath_mesh *mesh)
+{
+  beneath_mesh_file_header header;
+  unsigned char *streams[BENEATH_MESH_FILE_STREAM_COUNT];
+
+  beneath_mesh_file_header_build(mesh, &header, streams);
+
+  return header.file_size;
+}
+
+/* Serializes the mesh into buffer, padding bytes are zeroed */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_file_write(beneath_mesh *mesh, unsigned char *buffer, unsigned int buffer_capacity, unsigned int *buffer_size)
+{
+  beneath_mesh_file_header header;
+  unsigned char *streams[BENEATH_MESH_FILE_STREAM_COUNT];
+  unsigned char *source = (unsigned char *)&header;
+  unsigned int i;
+
+  beneath_mesh_file_header_build(mesh, &header, streams);
+
+  if (!buffer || buffer_capacity < header.file_size)
+  {
+    return false;
+  }
+
+  for (i = 0; i < header.file_size; ++i)
+  {
+    buffer[i] = 0;
+  }
+
+  for (i = 0; i < sizeof(beneath_mesh_file_header); ++i)
+  {
+    buffer[i] = source[i];
+  }
+
+  for (i = 0; i < BENEATH_MESH_FILE_STREAM_COUNT; ++i)
+  {
+    unsigned int size = header.stream_counts[i] * beneath_mesh_file_stream_stride((beneath_mesh_file_stream)i, &header.layout);
+    unsigned char *destination = buffer + header.stream_offsets[i];
+    unsigned int b;
+
+    if (!streams[i])
+    {
+      continue;
+    }
+
+    for (b = 0; b < size; ++b)
+    {
+      destination[b] = streams[i][b];
+    }
+  }
+
+  *buffer_size = header.file_size;
+
+  return true;
+}
+
+/* Points the mesh fields into data, which has to outlive the mesh and be aligned to
+ * BENEATH_MESH_FILE_ALIGNMENT (page aligned file mappings are). The arrays are not copied,
+ * if data is a read only mapping the mesh must not be modified in place (beneath_mesh_optimize).
+ * id and dynamic are left to the caller.
+ * The file is not trusted: stream counts, the interleaved layout and every index are checked
+ * against the vertex count once here, so the renderers can index the arrays without checks.
+ */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_file_load(beneath_mesh *mesh, void *data, unsigned int data_size)
+{
+  unsigned char *bytes = (unsigned char *)data;
+  beneath_mesh_file_header *header = (beneath_mesh_file_header *)data;
+  void *streams[BENEATH_MESH_FILE_STREAM_COUNT];
+  unsigned int counts[BENEATH_MESH_FILE_STREAM_COUNT]; /* 0 for absent streams */
+  unsigned int vertex_count;
+  unsigned int *indices;
+  unsigned short *indices16;
+  unsigned int i;
+
+  if (!data || data_size < sizeof(beneath_mesh_file_header) || header->magic != BENEATH_MESH_FILE_MAGIC || header->version != BENEATH_MESH_FILE_VERSION || header->file_size > data_size)
+  {
+    return false;
+  }
+
+  for (i = 0; i < BENEATH_MESH_FILE_STREAM_COUNT; ++i)
+  {
+    unsigned int offset = header->stream_offsets[i];
+    unsigned int count = header->stream_counts[i];
+    unsigned int stride = beneath_mesh_file_stream_stride((beneath_mesh_file_stream)i, &header->layout);
+
+    streams[i] = (void *)0;
+    counts[i] = 0;
+
+    if (offset == 0 || count == 0)
+    {
+      continue;
+    }
+
+    /* Misaligned or out of bounds (the division check guards against overflow) */
+    if ((offset & (BENEATH_MESH_FILE_ALIGNMENT - 1)) != 0 || offset > header->file_size || stride == 0 || count > (header->file_size - offset) / stride)
+    {
+      return false;
+    }
+
+    streams[i] = bytes + offset;
+    counts[i] = count;
+  }
+
+  if (!streams[BENEATH_MESH_FILE_STREAM_VERTICES] || (streams[BENEATH_MESH_FILE_STREAM_INDICES16] && !streams[BENEATH_MESH_FILE_STREAM_INDICES]))
+  {
+    return false;
+  }
+
+  /* Present streams have to match the vertex and index counts */
+  vertex_count = counts[BENEATH_MESH_FILE_STREAM_VERTICES] / 3;
+
+  if (counts[BENEATH_MESH_FILE_STREAM_VERTICES] % 3 != 0 || counts[BENEATH_MESH_FILE_STREAM_INDICES] % 3 != 0 ||
+      (counts[BENEATH_MESH_FILE_STREAM_INDICES16] != 0 && counts[BENEATH_MESH_FILE_STREAM_INDICES16] != counts[BENEATH_MESH_FILE_STREAM_INDICES]) ||
+      (counts[BENEATH_MESH_FILE_STREAM_INTERLEAVED] != 0 && counts[BENEATH_MESH_FILE_STREAM_INTERLEAVED] != vertex_count))
+  {
+    return false;
+  }
+
+  /* The attribute streams follow the attribute order, positions first */
+  for (i = BENEATH_MESH_FILE_STREAM_UVS; i <= BENEATH_MESH_FILE_STREAM_COLORS; ++i)
+  {
+    if (counts[i] != 0 && counts[i] != vertex_count * beneath_vertex_attribute_components(i))
+    {
+      return false;
+    }
+  }
+
+  /* Every attribute of the interleaved layout has to fit into the stride */
+  if (counts[BENEATH_MESH_FILE_STREAM_INTERLEAVED] != 0)
+  {
+    if (header->layout.formats[BENEATH_VERTEX_ATTRIBUTE_POSITION] != BENEATH_VERTEX_FORMAT_FLOAT32)
+    {
+      return false;
+    }
+
+    for (i = 0; i < BENEATH_VERTEX_ATTRIBUTE_COUNT; ++i)
+    {
+      unsigned int size = beneath_vertex_attribute_size(i, header->layout.formats[i]);
+
+      if (header->layout.formats[i] != BENEATH_VERTEX_FORMAT_NONE && (size == 0 || header->layout.offsets[i] + size > header->layout.stride))
+      {
+        return false;
+      }
+    }
+  }
+
+  /* indices16 is the same index list narrowed, so checking it against indices bounds it too */
+  indices = (unsigned int *)streams[BENEATH_MESH_FILE_STREAM_INDICES];
+  indices16 = (unsigned short *)streams[BENEATH_MESH_FILE_STREAM_INDICES16];
+
+  for (i = 0; i < counts[BENEATH_MESH_FILE_STREAM_INDICES]; ++i)
+  {
+    if (indices[i] >= vertex_count || (indices16 && (unsigned int)indices16[i] != indices[i]))
+    {
+      return false;
+    }
+  }
+
+  mesh->vertices_count = counts[BENEATH_MESH_FILE_STREAM_VERTICES];
+  mesh->uvs_count = counts[BENEATH_MESH_FILE_STREAM_UVS];
+  mesh->normals_count = counts[BENEATH_MESH_FILE_STREAM_NORMALS];
+  mesh->tangents_count = counts[BENEATH_MESH_FILE_STREAM_TANGENTS];
+  mesh->bitangents_count = counts[BENEATH_MESH_FILE_STREAM_BITANGENTS];
+  mesh->colors_count = counts[BENEATH_MESH_FILE_STREAM_COLORS];
+  mesh->indices_count = counts[BENEATH_MESH_FILE_STREAM_INDICES];
+
+  mesh->vertices = (float *)streams[BENEATH_MESH_FILE_STREAM_VERTICES];
+  mesh->uvs = (float *)streams[BENEATH_MESH_FILE_STREAM_UVS];
+  mesh->normals = (float *)streams[BENEATH_MESH_FILE_STREAM_NORMALS];
+  mesh->tangents = (float *)streams[BENEATH_MESH_FILE_STREAM_TANGENTS];
+  mesh->bitangents = (float *)streams[BENEATH_MESH_FILE_STREAM_BITANGENTS];
+  mesh->colors = (float *)streams[BENEATH_MESH_FILE_STREAM_COLORS];
+  mesh->indices = (unsigned int *)streams[BENEATH_MESH_FILE_STREAM_INDICES];
+  mesh->indices16 = (unsigned short *)streams[BENEATH_MESH_FILE_STREAM_INDICES16];
+
+  mesh->layout = header->layout;
+  mesh->lod_error = header->lod_error;
+  mesh->interleaved_count = counts[BENEATH_MESH_FILE_STREAM_INTERLEAVED];
+  mesh->interleaved = (unsigned char *)streams[BENEATH_MESH_FILE_STREAM_INTERLEAVED];
+
+  if (!mesh->interleaved)
+  {
+    mesh->interleaved_count = 0;
+    mesh->layout.stride = 0;
+  }
+
+  beneath_mesh_bounds_compute(mesh);
+  mesh->changed = true;
+
+  return true;
+}
+
 typedef struct beneath_light_directional
 {
 
@@ -162,6 +1001,10 @@ typedef struct beneath_lightning
 
 } beneath_lightning;
 
+/* LOD chain of a draw call: mesh plus up to BENEATH_DRAW_CALL_LODS_MAX coarser meshes */
+#define BENEATH_DRAW_CALL_LODS_MAX 4
+#define BENEATH_DRAW_CALL_LOD_PIXELS_DEFAULT 1.0f
+
 /* SoA style draw call */
 typedef struct beneath_draw_call
 {
@@ -179,6 +1022,13 @@ typedef struct beneath_draw_call
   float *colors;        /* Instance data model colors (Vec3 = 3 floats) */
   int *texture_indices; /* Instance data texture indices (1 int) */
 
+  /* Optional coarser versions of mesh with increasing lod_error (see beneath_mesh_simplify).
+   * They need their own mesh id and the vertex attributes of mesh, culling uses the bounds of mesh.
+   */
+  beneath_mesh *lods[BENEATH_DRAW_CALL_LODS_MAX];
+  unsigned int lods_count;
+  float lod_pixels; /* Allowed screen space error of a LOD in pixels, 0 = BENEATH_DRAW_CALL_LOD_PIXELS_DEFAULT */
+
   beneath_bool pixelize; /* Temporary */
   beneath_lightning *lightning;
   beneath_bool shadow;
@@ -250,6 +1100,66 @@ BENEATH_API BENEATH_INLINE beneath_bool beneath_draw_call_append(
   return true;
 }
 
+/* Mesh of a LOD chain level, 0 is the draw call mesh */
+BENEATH_API BENEATH_INLINE beneath_mesh *beneath_draw_call_lod_mesh(beneath_draw_call *draw_call, unsigned int lod)
+{
+  return lod == 0 ? draw_call->mesh : draw_call->lods[lod - 1];
+}
+
+/* Picks the LOD chain level for the instance with the model matrix m: the coarsest mesh whose
+ * lod_error, scaled like the instance and projected at the distance of its bounding sphere center,
+ * stays within lod_pixels. Cameras inside the bounding sphere get the full mesh.
+ * pixels_per_unit is the screen size of one world unit at distance one (viewport height / 2 * projection[5]).
+ * Everything is compared squared, so there is no square root per instance.
+ */
+BENEATH_API BENEATH_INLINE unsigned int beneath_draw_call_lod_select(beneath_draw_call *draw_call, float *m, float camera_position[3], float pixels_per_unit)
+{
+  float *c = draw_call->mesh->bounds_center;
+  float *e = draw_call->mesh->bounds_extents;
+  float pixels = draw_call->lod_pixels > 0.0f ? draw_call->lod_pixels : BENEATH_DRAW_CALL_LOD_PIXELS_DEFAULT;
+  float error_scale = pixels_per_unit / pixels;
+  float scale_squared = 0.0f;
+  float distance_squared = 0.0f;
+  float radius_squared;
+  unsigned int lod;
+  int i;
+
+  if (draw_call->lods_count == 0 || !draw_call->mesh->bounds_valid)
+  {
+    return 0;
+  }
+
+  for (i = 0; i < 3; ++i)
+  {
+    /* Largest axis scale of the model matrix and the world space sphere center */
+    float column = m[i * 4] * m[i * 4] + m[i * 4 + 1] * m[i * 4 + 1] + m[i * 4 + 2] * m[i * 4 + 2];
+    float d = m[i] * c[0] + m[4 + i] * c[1] + m[8 + i] * c[2] + m[12 + i] - camera_position[i];
+
+    scale_squared = column > scale_squared ? column : scale_squared;
+    distance_squared += d * d;
+  }
+
+  radius_squared = (e[0] * e[0] + e[1] * e[1] + e[2] * e[2]) * scale_squared;
+
+  if (distance_squared <= radius_squared)
+  {
+    return 0;
+  }
+
+  for (lod = draw_call->lods_count; lod > 0; --lod)
+  {
+    /* error * scale * pixels_per_unit / distance <= pixels */
+    float error = draw_call->lods[lod - 1]->lod_error * error_scale;
+
+    if (error * error * scale_squared <= distance_squared)
+    {
+      return lod;
+    }
+  }
+
+  return 0;
+}
+
 BENEATH_API BENEATH_INLINE unsigned int beneath_draw_call_hash(beneath_draw_call *dc)
 {
   unsigned int hash = 2166136261u; /* FNV-1a offset basis */
@@ -277,20 +1187,20 @@ BENEATH_API BENEATH_INLINE unsigned int beneath_draw_call_hash(beneath_draw_call
     beneath_mesh *m = dc->mesh;
     beneath_bool use_mesh_color;
 
-    /* Mesh attributes: 0 = unused, >0 = used as layout */
-    hash ^= (m->vertices_count > 0 ? 1 : 0);
+    /* Mesh attributes: 0 = unused, >0 = used as layout (packed formats decode to the same shader inputs) */
+    hash ^= (beneath_mesh_has_attribute(m, BENEATH_VERTEX_ATTRIBUTE_POSITION) ? 1 : 0);
     hash *= prime;
-    hash ^= (m->uvs_count > 0 ? 1 : 0);
+    hash ^= (beneath_mesh_has_attribute(m, BENEATH_VERTEX_ATTRIBUTE_UV) ? 1 : 0);
     hash *= prime;
-    hash ^= (m->normals_count > 0 ? 1 : 0);
+    hash ^= (beneath_mesh_has_attribute(m, BENEATH_VERTEX_ATTRIBUTE_NORMAL) ? 1 : 0);
     hash *= prime;
-    hash ^= (m->tangents_count > 0 ? 1 : 0);
+    hash ^= (beneath_mesh_has_attribute(m, BENEATH_VERTEX_ATTRIBUTE_TANGENT) ? 1 : 0);
     hash *= prime;
-    hash ^= (m->bitangents_count > 0 ? 1 : 0);
+    hash ^= (beneath_mesh_has_attribute(m, BENEATH_VERTEX_ATTRIBUTE_BITANGENT) ? 1 : 0);
     hash *= prime;
 
     /* Vertex colors: only used if draw_call colors_count and texture_indices_count are zero */
-    use_mesh_color = (m->colors_count > 0 && dc->colors_count == 0 && dc->texture_indices_count == 0);
+    use_mesh_color = (beneath_mesh_has_attribute(m, BENEATH_VERTEX_ATTRIBUTE_COLOR) && dc->colors_count == 0 && dc->texture_indices_count == 0);
     hash ^= (use_mesh_color ? 1 : 0);
     hash *= prime;
 
@@ -486,11 +1396,101 @@ typedef beneath_bool (*beneath_api_io_file_write)(
     unsigned int buffer_size /* The size of the file content buffer */
 );
 
+/* Asynchronous whole file reads, the frame loop does not wait for the disk.
+ * io_file_read_async queues the read and returns a handle (0 if the request cannot be queued),
+ * io_file_read_poll reports its status. The file_buffer has to stay untouched until poll
+ * returned COMPLETED or FAILED, which also releases the handle. Like io_file_read the
+ * contents are zero terminated, so the capacity must be at least the file size + 1.
+ */
+#define BENEATH_IO_FILENAME_MAX 260
+
+typedef unsigned int beneath_io_handle;
+
+typedef enum beneath_io_status
+{
+  BENEATH_IO_STATUS_INVALID = 0, /* Unknown or already released handle */
+  BENEATH_IO_STATUS_PENDING,
+  BENEATH_IO_STATUS_COMPLETED,
+  BENEATH_IO_STATUS_FAILED
+
+} beneath_io_status;
+
+typedef beneath_io_handle (*beneath_api_io_file_read_async)(
+    char *filename,                   /* The filename/path to read, copied (at most BENEATH_IO_FILENAME_MAX - 1 characters) */
+    unsigned char *file_buffer,       /* The user provided file_buffer large enough to hold the file contents */
+    unsigned int file_buffer_capacity /* The capacity/max site of the file_buffer */
+);
+
+typedef beneath_io_status (*beneath_api_io_file_read_poll)(
+    beneath_io_handle handle,      /* The handle returned by io_file_read_async */
+    unsigned int *file_buffer_size /* The total number of bytes read once COMPLETED */
+);
+
+/* Maps the whole file read only into memory (page aligned, no copy). The mapping stays
+ * valid until io_file_unmap and is shared between hot reloads of the application.
+ */
+typedef beneath_bool (*beneath_api_io_file_map)(
+    char *filename,         /* The filename/path to map */
+    void **file_data,       /* The start of the mapped file contents */
+    unsigned int *file_size /* The size of the mapping in bytes */
+);
+
+typedef beneath_bool (*beneath_api_io_file_unmap)(
+    void *file_data,       /* The file_data returned by io_file_map */
+    unsigned int file_size /* The file_size returned by io_file_map */
+);
+
 /* Platform Performance Metrics */
 typedef unsigned int (*beneath_api_perf_cycle_count)(void);
 typedef double (*beneath_api_perf_time_nanoseconds)(void);
 
-/* Platform Graphics */
+/* Platform Jobs
+ *
+ * Work is split into jobs that run on all cores (the calling thread included). A job
+ * runs function(data, index, thread_index) with index in [0, count), thread_index in
+ * [0, job_threads_count()) identifies the executing thread (e.g. for per thread scratch).
+ * A counter tracks the unfinished jobs of one or more job_run calls, job_wait returns once
+ * it reached zero and runs queued jobs meanwhile. Jobs express dependencies by waiting on
+ * the counter of the jobs they depend on, which never blocks a worker.
+ */
+typedef struct beneath_job_counter
+{
+  int value; /* Unfinished jobs, zero initialize */
+
+} beneath_job_counter;
+
+typedef void (*beneath_job_function)(void *data, unsigned int index, unsigned int thread_index);
+typedef void (*beneath_job_range_function)(void *data, unsigned int begin, unsigned int end, unsigned int thread_index);
+
+typedef void (*beneath_api_job_run)(
+    beneath_job_function function, /* The job */
+    void *data,                    /* Passed to every job */
+    unsigned int count,            /* Number of jobs, called with index 0 to count - 1 */
+    beneath_job_counter *counter   /* Incremented by count, decremented as jobs finish (optional) */
+);
+
+typedef void (*beneath_api_job_wait)(
+    beneath_job_counter *counter /* Waits until all jobs of the counter finished */
+);
+
+typedef void (*beneath_api_job_parallel_for)(
+    beneath_job_range_function function, /* Called with consecutive [begin, end) ranges */
+    void *data,                          /* Passed to every call */
+    unsigned int count,                  /* The total number of items */
+    unsigned int batch_size              /* Items per range, at least 1 */
+);
+
+typedef unsigned int (*beneath_api_job_threads_count)(void);
+
+/* Platform Graphics
+ *
+ * Draw calls are queued and rendered once after beneath_update returns (sorted by
+ * shader, mesh and depth with a single shadow and post processing pass). The draw
+ * call has to stay valid until then, the camera of the last call is used for the frame.
+ * Platforms built with BENEATH_RENDER_THREAD copy the draw call and render it on their
+ * render thread during the next beneath_update, mesh vertex/index arrays are not copied
+ * and must not change until then.
+ */
 typedef beneath_bool (*beneath_api_graphics_draw)(
     beneath_state *state,         /* The state */
     beneath_draw_call *draw_call, /* The draw call instanced objects */
@@ -507,11 +1507,21 @@ typedef struct beneath_api
   beneath_api_io_file_size io_file_size;   /* Returns the file size */
   beneath_api_io_file_read io_file_read;   /* Reads the specified file into the buffer */
   beneath_api_io_file_write io_file_write; /* Writes the specified buffer to a file */
+  beneath_api_io_file_map io_file_map;     /* Maps a file read only into memory */
+  beneath_api_io_file_unmap io_file_unmap; /* Releases a mapping of io_file_map */
+  beneath_api_io_file_read_async io_file_read_async; /* Queues a background read of the specified file */
+  beneath_api_io_file_read_poll io_file_read_poll;   /* Status of a background read */
 
   /* Platform Performance Metrics */
   beneath_api_perf_cycle_count perf_cycle_count;           /* The current cpu cycle count  */
   beneath_api_perf_time_nanoseconds perf_time_nanoseconds; /* The curent nanoseconds epoch */
 
+  /* Platform Jobs */
+  beneath_api_job_run job_run;                     /* Queues jobs on the worker threads */
+  beneath_api_job_wait job_wait;                   /* Runs jobs until a counter reached zero */
+  beneath_api_job_parallel_for job_parallel_for;   /* Splits a range into jobs and waits for them */
+  beneath_api_job_threads_count job_threads_count; /* Threads that execute jobs, the caller included */
+
   /* Platform Graphics */
   beneath_api_graphics_draw graphics_draw;
 
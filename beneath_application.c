@@ -1,6 +1,7 @@
 #include "beneath.h"
 #include "deps/vm.h"
 #include "deps/sb.h"
+#include "beneath_mesh_optimizer.h"
 
 typedef struct camera
 {
@@ -106,21 +107,42 @@ static float cube_colors[] = {
     0.75f, 0.75f, 0.75f,
     0.25f, 0.75f, 0.75f};
 
+/* Cooked cube (optimized, interleaved, 16 bit indices) in the beneath_mesh_file format */
+#define APP_MESH_FILE "beneath_cube.bmesh"
+
+/* Lives at the start of the permanent arena, survives hot reloading */
 typedef struct app_state
 {
     beneath_bool is_fullscreen;
 
+    camera cam;
+    m4x4 model;
+    m4x4 model_floor;
+    m4x4 model_other;
+    m4x4 model_next;
+
+    beneath_mesh mesh;
+    beneath_draw_call draw_call;
+    beneath_draw_call draw_call_floor;
+    beneath_lightning ligthning;
+
+    /* Background read of the cooked cube, exercises the async file io */
+    beneath_io_handle stream;
+    unsigned char *stream_buffer;
+    unsigned int stream_frames;
+
 } app_state;
 
-static float models[16 * 16];
-static beneath_mesh mesh = {0};
-static beneath_draw_call draw_call = {0};
-static beneath_lightning ligthning = {0};
-static m4x4 model;
-static m4x4 model_floor;
-static m4x4 model_other;
-static m4x4 model_next;
-static camera cam;
+/* Per frame matrices, bump allocated from the frame arena */
+typedef struct app_frame
+{
+    m4x4 projection;
+    m4x4 projection_inverse;
+    m4x4 view;
+    m4x4 view_inverse;
+    m4x4 projection_view;
+
+} app_frame;
 
 void beneath_update(
     beneath_memory *memory,          /* The total block of memory handed to the application */
@@ -129,12 +151,17 @@ void beneath_update(
 )
 {
     beneath_state *state = (beneath_state *)memory->memory;
-    app_state *app = (app_state *)(((unsigned char *)memory->memory) + memory->memory_offset);
+    app_state *app = (app_state *)memory->permanent.base;
 
     if (!memory->memory_initialized)
     {
+        beneath_bool mesh_loaded = false;
+
         memory->memory_initialized = true;
 
+        /* First allocation, always at the permanent arena base */
+        app = BENEATH_ARENA_PUSH_STRUCT(&memory->permanent, app_state);
+
         api->io_print(__FILE__, __LINE__, "Hello from application :)\n");
 
         /* Test changing the state */
@@ -145,40 +172,139 @@ void beneath_update(
         state->changed_flags = BENEATH_STATE_CHANGED_FLAG_WINDOW;
 
         /* Temporary Tests */
-        cam = camera_init();
-        cam.position.x = -1.0f;
-        cam.position.y = 1.0f;
-        cam.position.z = 3.0f;
-        camera_update_vectors(&cam);
-
-        model = vm_m4x4_translate(vm_m4x4_identity, vm_v3_zero);
-        model_floor = vm_m4x4_scale(vm_m4x4_translate(vm_m4x4_identity, vm_v3(0.0f, -1.0f, 0.0f)), vm_v3(10.0f, 0.1f, 10.0f));
-        model_other = vm_m4x4_translate(vm_m4x4_identity, vm_v3(-2.0f, 2.0f, 0.5f));
-        model_next = vm_m4x4_scale(vm_m4x4_translate(vm_m4x4_identity, vm_v3(1.0f, 1.0f, -1.0f)), vm_v3(0.2f, 0.2f, 5.0f));
-
-        mesh.id = 0;
-        mesh.changed = true;
-        mesh.dynamic = true;
-        mesh.vertices_count = BENEATH_ARRAY_SIZE(cube_vertices);
-        mesh.indices_count = BENEATH_ARRAY_SIZE(cube_indices);
-        mesh.normals_count = BENEATH_ARRAY_SIZE(cube_normals);
-        mesh.colors_count = BENEATH_ARRAY_SIZE(cube_colors);
-        mesh.vertices = cube_vertices;
-        mesh.normals = cube_normals;
-        mesh.indices = cube_indices;
-        mesh.colors = cube_colors;
-
-        draw_call.id = 0;
-        draw_call.data_capacity = 16;
-        draw_call.changed = true;
-        draw_call.mesh = &mesh;
-
-        draw_call.models = models;
-
-        beneath_draw_call_append(&draw_call, model.e, (void *)0, -1);
-        beneath_draw_call_append(&draw_call, model_floor.e, (void *)0, -1);
-        beneath_draw_call_append(&draw_call, model_other.e, (void *)0, -1);
-        beneath_draw_call_append(&draw_call, model_next.e, (void *)0, -1);
+        app->cam = camera_init();
+        app->cam.position.x = -1.0f;
+        app->cam.position.y = 1.0f;
+        app->cam.position.z = 3.0f;
+        camera_update_vectors(&app->cam);
+
+        app->model = vm_m4x4_translate(vm_m4x4_identity, vm_v3_zero);
+        app->model_floor = vm_m4x4_scale(vm_m4x4_translate(vm_m4x4_identity, vm_v3(0.0f, -1.0f, 0.0f)), vm_v3(10.0f, 0.1f, 10.0f));
+        app->model_other = vm_m4x4_translate(vm_m4x4_identity, vm_v3(-2.0f, 2.0f, 0.5f));
+        app->model_next = vm_m4x4_scale(vm_m4x4_translate(vm_m4x4_identity, vm_v3(1.0f, 1.0f, -1.0f)), vm_v3(0.2f, 0.2f, 5.0f));
+
+        app->mesh.id = 0;
+        app->mesh.changed = true;
+        app->mesh.dynamic = true;
+
+        /* Map the cube cooked by a previous start, the mesh points straight into the file */
+        {
+            void *file_data;
+            unsigned int file_size;
+
+            if (api->io_file_map(APP_MESH_FILE, &file_data, &file_size))
+            {
+                if (beneath_mesh_file_load(&app->mesh, file_data, file_size))
+                {
+                    api->io_print(__FILE__, __LINE__, "[mesh] mapped " APP_MESH_FILE "\n");
+                    mesh_loaded = true;
+                }
+                else
+                {
+                    api->io_print(__FILE__, __LINE__, "[mesh] " APP_MESH_FILE " is invalid, cooking it again\n");
+                    api->io_file_unmap(file_data, file_size);
+                }
+            }
+        }
+
+        if (!mesh_loaded)
+        {
+            app->mesh.vertices_count = BENEATH_ARRAY_SIZE(cube_vertices);
+            app->mesh.indices_count = BENEATH_ARRAY_SIZE(cube_indices);
+            app->mesh.normals_count = BENEATH_ARRAY_SIZE(cube_normals);
+            app->mesh.colors_count = BENEATH_ARRAY_SIZE(cube_colors);
+            app->mesh.vertices = cube_vertices;
+            app->mesh.normals = cube_normals;
+            app->mesh.indices = cube_indices;
+            app->mesh.colors = cube_colors;
+
+            /* Vertex cache and overdraw order, scratch memory from the frame arena */
+            {
+                beneath_mesh_optimizer_stats stats;
+
+                if (beneath_mesh_optimize(&app->mesh, &memory->frame, &stats))
+                {
+                    char buffer[256];
+                    sb s = {0};
+                    sb_init(&s, buffer, 256);
+                    sb_append_cstr(&s, "[mesh] vertices: ");
+                    sb_append_ulong_direct(&s, stats.vertices_before);
+                    sb_append_cstr(&s, " -> ");
+                    sb_append_ulong_direct(&s, stats.vertices_after);
+                    sb_append_cstr(&s, ", acmr: ");
+                    sb_append_float(&s, stats.acmr_before, 0, 3, SB_PAD_NONE);
+                    sb_append_cstr(&s, " -> ");
+                    sb_append_float(&s, stats.acmr_after, 0, 3, SB_PAD_NONE);
+                    sb_append_cstr(&s, ", atvr: ");
+                    sb_append_float(&s, stats.atvr_before, 0, 3, SB_PAD_NONE);
+                    sb_append_cstr(&s, " -> ");
+                    sb_append_float(&s, stats.atvr_after, 0, 3, SB_PAD_NONE);
+                    sb_append_cstr(&s, "\n");
+                    sb_term(&s);
+                    api->io_print(__FILE__, __LINE__, buffer);
+                }
+            }
+
+            /* One packed vertex stream for the GPU: float positions, 10:10:10:2 normals, unorm8 colors (20 instead of 36 bytes) */
+            {
+                unsigned char formats[BENEATH_VERTEX_ATTRIBUTE_COUNT] = {0};
+
+                formats[BENEATH_VERTEX_ATTRIBUTE_POSITION] = BENEATH_VERTEX_FORMAT_FLOAT32;
+                formats[BENEATH_VERTEX_ATTRIBUTE_NORMAL] = BENEATH_VERTEX_FORMAT_SNORM_10_10_10_2;
+                formats[BENEATH_VERTEX_ATTRIBUTE_COLOR] = BENEATH_VERTEX_FORMAT_UNORM8;
+
+                if (!beneath_mesh_interleave(&app->mesh, formats, &memory->permanent))
+                {
+                    api->io_print(__FILE__, __LINE__, "cannot interleave the cube mesh, using separate vertex buffers\n");
+                }
+            }
+
+            /* 8 vertices, 16 bit indices are enough */
+            beneath_mesh_indices_narrow(&app->mesh, &memory->permanent);
+
+            /* Store the cooked cube for the next start */
+            {
+                unsigned int file_size = beneath_mesh_file_size(&app->mesh);
+                unsigned char *file_buffer = BENEATH_ARENA_PUSH_ARRAY(&memory->frame, unsigned char, file_size);
+
+                if (!beneath_mesh_file_write(&app->mesh, file_buffer, file_size, &file_size) ||
+                    !api->io_file_write(APP_MESH_FILE, file_buffer, file_size))
+                {
+                    api->io_print(__FILE__, __LINE__, "[mesh] cannot write " APP_MESH_FILE "\n");
+                }
+            }
+        }
+
+        app->draw_call.id = 0;
+        app->draw_call.data_capacity = 16;
+        app->draw_call.changed = true;
+        app->draw_call.mesh = &app->mesh;
+
+        app->draw_call.models = BENEATH_ARENA_PUSH_ARRAY(&memory->permanent, float, 16 * app->draw_call.data_capacity);
+
+        beneath_draw_call_append(&app->draw_call, app->model.e, (void *)0, -1);
+        beneath_draw_call_append(&app->draw_call, app->model_other.e, (void *)0, -1);
+        beneath_draw_call_append(&app->draw_call, app->model_next.e, (void *)0, -1);
+
+        /* The floor shares the cube mesh in its own draw call, the render queue batches both */
+        app->draw_call_floor.id = 1;
+        app->draw_call_floor.data_capacity = 1;
+        app->draw_call_floor.changed = true;
+        app->draw_call_floor.mesh = &app->mesh;
+        app->draw_call_floor.models = BENEATH_ARENA_PUSH_ARRAY(&memory->permanent, float, 16 * app->draw_call_floor.data_capacity);
+
+        beneath_draw_call_append(&app->draw_call_floor, app->model_floor.e, (void *)0, -1);
+
+        /* Stream the cooked cube again in the background, the frames keep running meanwhile */
+        {
+            unsigned int file_size;
+
+            if (api->io_file_size(APP_MESH_FILE, &file_size))
+            {
+                app->stream_buffer = BENEATH_ARENA_PUSH_ARRAY(&memory->permanent, unsigned char, file_size + 1);
+                app->stream = app->stream_buffer ? api->io_file_read_async(APP_MESH_FILE, app->stream_buffer, file_size + 1) : 0;
+            }
+        }
 
         /* Setup ligthning*/
         {
@@ -189,20 +315,58 @@ void beneath_update(
             v3 dl_diffuse = vm_v3(1.0f, 0.95f, 0.8f);
             v3 dl_specular = vm_v3(0.3f, 0.3f, 0.3f);
 
-            ligthning.directional.direction[0] = dl_direction.x;
-            ligthning.directional.direction[1] = dl_direction.y;
-            ligthning.directional.direction[2] = dl_direction.z;
-            ligthning.directional.ambient[0] = dl_ambient.x;
-            ligthning.directional.ambient[1] = dl_ambient.y;
-            ligthning.directional.ambient[2] = dl_ambient.z;
-            ligthning.directional.diffuse[0] = dl_diffuse.x;
-            ligthning.directional.diffuse[1] = dl_diffuse.y;
-            ligthning.directional.diffuse[2] = dl_diffuse.z;
-            ligthning.directional.specular[0] = dl_specular.x;
-            ligthning.directional.specular[1] = dl_specular.y;
-            ligthning.directional.specular[2] = dl_specular.z;
-
-            draw_call.lightning = &ligthning;
+            app->ligthning.directional.direction[0] = dl_direction.x;
+            app->ligthning.directional.direction[1] = dl_direction.y;
+            app->ligthning.directional.direction[2] = dl_direction.z;
+            app->ligthning.directional.ambient[0] = dl_ambient.x;
+            app->ligthning.directional.ambient[1] = dl_ambient.y;
+            app->ligthning.directional.ambient[2] = dl_ambient.z;
+            app->ligthning.directional.diffuse[0] = dl_diffuse.x;
+            app->ligthning.directional.diffuse[1] = dl_diffuse.y;
+            app->ligthning.directional.diffuse[2] = dl_diffuse.z;
+            app->ligthning.directional.specular[0] = dl_specular.x;
+            app->ligthning.directional.specular[1] = dl_specular.y;
+            app->ligthning.directional.specular[2] = dl_specular.z;
+
+            app->draw_call.lightning = &app->ligthning;
+            app->draw_call_floor.lightning = &app->ligthning;
+        }
+    }
+
+    if (app->stream)
+    {
+        unsigned int stream_size = 0;
+        beneath_io_status status = api->io_file_read_poll(app->stream, &stream_size);
+
+        if (status == BENEATH_IO_STATUS_PENDING)
+        {
+            app->stream_frames++;
+        }
+        else
+        {
+            beneath_mesh streamed = {0};
+            char buffer[256];
+            sb s = {0};
+            sb_init(&s, buffer, 256);
+            sb_append_cstr(&s, "[io] streamed " APP_MESH_FILE ": ");
+
+            if (status == BENEATH_IO_STATUS_COMPLETED && beneath_mesh_file_load(&streamed, app->stream_buffer, stream_size))
+            {
+                sb_append_ulong_direct(&s, stream_size);
+                sb_append_cstr(&s, " bytes, ");
+                sb_append_ulong_direct(&s, streamed.indices_count / 3);
+                sb_append_cstr(&s, " triangles, pending for ");
+                sb_append_ulong_direct(&s, app->stream_frames);
+                sb_append_cstr(&s, " frames\n");
+            }
+            else
+            {
+                sb_append_cstr(&s, "failed\n");
+            }
+
+            sb_term(&s);
+            api->io_print(__FILE__, __LINE__, buffer);
+            app->stream = 0;
         }
     }
 
@@ -227,44 +391,47 @@ void beneath_update(
 
     if (input->keys[BENEATH_KEY_W].ended_down)
     {
-        cam.position.z -= 5.0f * (float)state->delta_time;
+        app->cam.position.z -= 5.0f * (float)state->delta_time;
     }
 
     if (input->keys[BENEATH_KEY_A].ended_down)
     {
-        cam.position.x -= 5.0f * (float)state->delta_time;
+        app->cam.position.x -= 5.0f * (float)state->delta_time;
     }
 
     if (input->keys[BENEATH_KEY_S].ended_down)
     {
-        cam.position.z += 5.0f * (float)state->delta_time;
+        app->cam.position.z += 5.0f * (float)state->delta_time;
     }
 
     if (input->keys[BENEATH_KEY_D].ended_down)
     {
-        cam.position.x += 5.0f * (float)state->delta_time;
+        app->cam.position.x += 5.0f * (float)state->delta_time;
     }
 
     if (input->keys[BENEATH_KEY_CONTROL].ended_down)
     {
-        cam.position.y -= 5.0f * (float)state->delta_time;
+        app->cam.position.y -= 5.0f * (float)state->delta_time;
     }
 
     if (input->keys[BENEATH_KEY_SPACE].ended_down)
     {
-        cam.position.y += 5.0f * (float)state->delta_time;
+        app->cam.position.y += 5.0f * (float)state->delta_time;
     }
 
     if (input->keys[BENEATH_KEY_F5].pressed)
     {
-        cam.position.x = -1.0f;
-        cam.position.y = 1.0f;
-        cam.position.z = 3.0f;
+        app->cam.position.x = -1.0f;
+        app->cam.position.y = 1.0f;
+        app->cam.position.z = 3.0f;
     }
 
-    draw_call.pixelize = input->keys[BENEATH_KEY_F1].active;
-    draw_call.shadow = true;
-    draw_call.volumetric = true;
+    app->draw_call.pixelize = input->keys[BENEATH_KEY_F1].active;
+    app->draw_call.shadow = true;
+    app->draw_call.volumetric = true;
+    app->draw_call_floor.pixelize = app->draw_call.pixelize;
+    app->draw_call_floor.shadow = true;
+    app->draw_call_floor.volumetric = true;
 
     /* Print FPS */
     if (input->keys[BENEATH_KEY_F2].pressed)
@@ -281,26 +448,30 @@ void beneath_update(
 
     /* Draw Call Test */
     {
-        m4x4 projection;
-        m4x4 projection_inverse;
-        m4x4 view;
-        m4x4 view_inverse;
-        m4x4 projection_view;
+        app_frame *frame = BENEATH_ARENA_PUSH_STRUCT(&memory->frame, app_frame);
         float *camera_pos;
 
-        projection = vm_m4x4_perspective(vm_radf(cam.fov), (float)state->window_width / (float)state->window_height, 0.1f, 1000.0f);
-        projection_inverse = vm_m4x4_inverse(projection);
-        view = vm_m4x4_lookAt(cam.position, vm_v3_zero, cam.up);
-        view_inverse = vm_m4x4_inverse(view);
-        projection_view = vm_m4x4_mul(projection, view);
-        camera_pos = vm_v3_data(&cam.position);
+        frame->projection = vm_m4x4_perspective(vm_radf(app->cam.fov), (float)state->window_width / (float)state->window_height, 0.1f, 1000.0f);
+        frame->projection_inverse = vm_m4x4_inverse(frame->projection);
+        frame->view = vm_m4x4_lookAt(app->cam.position, vm_v3_zero, app->cam.up);
+        frame->view_inverse = vm_m4x4_inverse(frame->view);
+        frame->projection_view = vm_m4x4_mul(frame->projection, frame->view);
+        camera_pos = vm_v3_data(&app->cam.position);
+
+        api->graphics_draw(
+            state,
+            &app->draw_call,
+            frame->projection_view.e,
+            frame->projection_inverse.e,
+            frame->view_inverse.e,
+            camera_pos);
 
         api->graphics_draw(
             state,
-            &draw_call,
-            projection_view.e,
-            projection_inverse.e,
-            view_inverse.e,
+            &app->draw_call_floor,
+            frame->projection_view.e,
+            frame->projection_inverse.e,
+            frame->view_inverse.e,
             camera_pos);
     }
 }
@@ -0,0 +1,703 @@
+#ifndef BENEATH_BVH_H
+#define BENEATH_BVH_H
+
+#include "beneath.h"
+#include "deps/vm.h" /* Temporary for prototype: Vector math */
+
+/* Dynamic bounding volume hierarchy over axis aligned boxes, e.g. the instances of a scene.
+ *
+ * The tree lives in one node array allocated from an arena, children and parents are
+ * indices into it and unused nodes form a free list. Leaves carry a user item (the
+ * instance index) and are placed by the surface area heuristic: an insert walks down to
+ * the sibling with the lowest added area and tree rotations on the way back up keep the
+ * heights of siblings within one (Catto, box2d dynamic tree), so queries stay logarithmic
+ * under incremental inserts and removes.
+ *
+ * Moving leaves are either refit one at a time (beneath_bvh_move walks up to the root) or
+ * all at once (beneath_bvh_leaf_set for every moved leaf, then one beneath_bvh_refit).
+ * Refitting keeps the topology, leaves that moved far should be removed and inserted again.
+ * beneath_bvh_compact puts the nodes into depth first order after larger changes.
+ *
+ * Queries recurse down the tree, its height is logarithmic so the depth stays small:
+ * - beneath_bvh_query_frustum: items whose box intersects a frustum (culling, shadow casters)
+ * - beneath_bvh_query_frustum_candidates: the same with the leaf tests left to a batch test of the caller
+ * - beneath_bvh_raycast: the closest item along a ray (picking)
+ */
+#define BENEATH_BVH_NONE 0xFFFFFFFFu
+
+typedef struct beneath_bvh_node
+{
+    float min[3];
+    float max[3];
+    unsigned int parent;      /* Next free node while the node is unused */
+    unsigned int children[2]; /* BENEATH_BVH_NONE for leaves */
+    unsigned int height;      /* 0 for leaves */
+    unsigned int item;        /* Leaf payload */
+
+} beneath_bvh_node;
+
+typedef struct beneath_bvh
+{
+    beneath_bvh_node *nodes;
+    unsigned int nodes_capacity; /* 2 * leaves_capacity - 1 */
+    unsigned int root;
+    unsigned int free_list;
+    unsigned int leaves_count;
+    unsigned int leaves_capacity;
+
+} beneath_bvh;
+
+/* Exact hit test of a leaf for beneath_bvh_raycast, returns the distance along the ray or a negative value for a miss */
+typedef float (*beneath_bvh_ray_function)(void *data, unsigned int item, float origin[3], float direction[3], float max_distance);
+
+/* Half the surface area, the cost of visiting a node */
+BENEATH_API BENEATH_INLINE float beneath_bvh_area(float min[3], float max[3])
+{
+    float x = max[0] - min[0];
+    float y = max[1] - min[1];
+    float z = max[2] - min[2];
+
+    return x * y + y * z + z * x;
+}
+
+BENEATH_API BENEATH_INLINE void beneath_bvh_union(float min[3], float max[3], float a_min[3], float a_max[3], float b_min[3], float b_max[3])
+{
+    int i;
+
+    for (i = 0; i < 3; ++i)
+    {
+        min[i] = a_min[i] < b_min[i] ? a_min[i] : b_min[i];
+        max[i] = a_max[i] > b_max[i] ? a_max[i] : b_max[i];
+    }
+}
+
+/* Empties the tree, all nodes go back to the free list */
+BENEATH_API BENEATH_INLINE void beneath_bvh_clear(beneath_bvh *bvh)
+{
+    unsigned int i;
+
+    for (i = 0; i < bvh->nodes_capacity; ++i)
+    {
+        bvh->nodes[i].parent = i + 1 < bvh->nodes_capacity ? i + 1 : BENEATH_BVH_NONE;
+    }
+
+    bvh->root = BENEATH_BVH_NONE;
+    bvh->free_list = bvh->nodes_capacity ? 0 : BENEATH_BVH_NONE;
+    bvh->leaves_count = 0;
+}
+
+/* Room for leaves_capacity leaves, false if the arena is exhausted */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_bvh_initialize(beneath_bvh *bvh, beneath_arena *arena, unsigned int leaves_capacity)
+{
+    bvh->leaves_capacity = leaves_capacity < 1 ? 1 : leaves_capacity;
+    bvh->nodes_capacity = bvh->leaves_capacity * 2 - 1;
+    bvh->nodes = BENEATH_ARENA_PUSH_ARRAY(arena, beneath_bvh_node, bvh->nodes_capacity);
+
+    if (!bvh->nodes)
+    {
+        bvh->nodes_capacity = 0;
+        bvh->leaves_capacity = 0;
+        beneath_bvh_clear(bvh);
+        return false;
+    }
+
+    beneath_bvh_clear(bvh);
+
+    return true;
+}
+
+BENEATH_API BENEATH_INLINE unsigned int beneath_bvh_node_allocate(beneath_bvh *bvh)
+{
+    unsigned int index = bvh->free_list;
+    beneath_bvh_node *node = &bvh->nodes[index];
+
+    bvh->free_list = node->parent;
+
+    node->parent = BENEATH_BVH_NONE;
+    node->children[0] = BENEATH_BVH_NONE;
+    node->children[1] = BENEATH_BVH_NONE;
+    node->height = 0;
+    node->item = 0;
+
+    return index;
+}
+
+BENEATH_API BENEATH_INLINE void beneath_bvh_node_free(beneath_bvh *bvh, unsigned int index)
+{
+    bvh->nodes[index].parent = bvh->free_list;
+    bvh->free_list = index;
+}
+
+/* Box and height of an inner node from its children */
+BENEATH_API BENEATH_INLINE void beneath_bvh_node_fit(beneath_bvh *bvh, unsigned int index)
+{
+    beneath_bvh_node *node = &bvh->nodes[index];
+    beneath_bvh_node *a = &bvh->nodes[node->children[0]];
+    beneath_bvh_node *b = &bvh->nodes[node->children[1]];
+
+    beneath_bvh_union(node->min, node->max, a->min, a->max, b->min, b->max);
+    node->height = 1 + (a->height > b->height ? a->height : b->height);
+}
+
+/* Points the child slot of parent (or the root) that held child_old at child_new */
+BENEATH_API BENEATH_INLINE void beneath_bvh_child_replace(beneath_bvh *bvh, unsigned int parent, unsigned int child_old, unsigned int child_new)
+{
+    if (parent == BENEATH_BVH_NONE)
+    {
+        bvh->root = child_new;
+    }
+    else if (bvh->nodes[parent].children[0] == child_old)
+    {
+        bvh->nodes[parent].children[0] = child_new;
+    }
+    else
+    {
+        bvh->nodes[parent].children[1] = child_new;
+    }
+}
+
+/* Rotates the higher child of a up if the heights of its children differ by more than one,
+ * returns the node now at the position of a.
+ */
+BENEATH_API BENEATH_INLINE unsigned int beneath_bvh_balance(beneath_bvh *bvh, unsigned int a)
+{
+    beneath_bvh_node *nodes = bvh->nodes;
+    unsigned int side;
+
+    if (nodes[a].height < 2)
+    {
+        return a;
+    }
+
+    for (side = 0; side < 2; ++side)
+    {
+        unsigned int up = nodes[a].children[side];
+        unsigned int stay = nodes[a].children[1 - side];
+        unsigned int f;
+        unsigned int g;
+
+        if (nodes[up].height <= nodes[stay].height + 1)
+        {
+            continue;
+        }
+
+        /* up takes the place of a, a becomes its first child */
+        f = nodes[up].children[0];
+        g = nodes[up].children[1];
+
+        nodes[up].children[0] = a;
+        nodes[up].parent = nodes[a].parent;
+        nodes[a].parent = up;
+        beneath_bvh_child_replace(bvh, nodes[up].parent, a, up);
+
+        /* The higher grandchild stays with up, the lower one moves to a */
+        if (nodes[f].height < nodes[g].height)
+        {
+            unsigned int swap = f;
+            f = g;
+            g = swap;
+        }
+
+        nodes[up].children[1] = f;
+        nodes[a].children[side] = g;
+        nodes[g].parent = a;
+
+        beneath_bvh_node_fit(bvh, a);
+        beneath_bvh_node_fit(bvh, up);
+
+        return up;
+    }
+
+    return a;
+}
+
+/* Refits and rebalances from index up to the root */
+BENEATH_API BENEATH_INLINE void beneath_bvh_ancestors_fit(beneath_bvh *bvh, unsigned int index)
+{
+    while (index != BENEATH_BVH_NONE)
+    {
+        index = beneath_bvh_balance(bvh, index);
+        beneath_bvh_node_fit(bvh, index);
+        index = bvh->nodes[index].parent;
+    }
+}
+
+/* Returns the leaf holding item, BENEATH_BVH_NONE if the tree is full */
+BENEATH_API BENEATH_INLINE unsigned int beneath_bvh_insert(beneath_bvh *bvh, float min[3], float max[3], unsigned int item)
+{
+    beneath_bvh_node *nodes = bvh->nodes;
+    unsigned int leaf;
+    unsigned int sibling;
+    unsigned int parent;
+    int i;
+
+    if (bvh->leaves_count == bvh->leaves_capacity)
+    {
+        return BENEATH_BVH_NONE;
+    }
+
+    leaf = beneath_bvh_node_allocate(bvh);
+    bvh->leaves_count++;
+
+    for (i = 0; i < 3; ++i)
+    {
+        nodes[leaf].min[i] = min[i];
+        nodes[leaf].max[i] = max[i];
+    }
+
+    nodes[leaf].item = item;
+
+    if (bvh->root == BENEATH_BVH_NONE)
+    {
+        bvh->root = leaf;
+        return leaf;
+    }
+
+    /* Descend while pushing the leaf further down is cheaper than pairing it with the node */
+    sibling = bvh->root;
+
+    while (nodes[sibling].height > 0)
+    {
+        float combined_min[3];
+        float combined_max[3];
+        float area = beneath_bvh_area(nodes[sibling].min, nodes[sibling].max);
+        float combined_area;
+        float cost_here;
+        float cost_inherited;
+        float cost_children[2];
+        int c;
+
+        beneath_bvh_union(combined_min, combined_max, nodes[sibling].min, nodes[sibling].max, min, max);
+        combined_area = beneath_bvh_area(combined_min, combined_max);
+
+        /* A new parent here, or growing this node for a pairing further down */
+        cost_here = 2.0f * combined_area;
+        cost_inherited = 2.0f * (combined_area - area);
+
+        for (c = 0; c < 2; ++c)
+        {
+            beneath_bvh_node *child = &nodes[nodes[sibling].children[c]];
+
+            beneath_bvh_union(combined_min, combined_max, child->min, child->max, min, max);
+            cost_children[c] = beneath_bvh_area(combined_min, combined_max) + cost_inherited;
+
+            if (child->height > 0)
+            {
+                cost_children[c] -= beneath_bvh_area(child->min, child->max);
+            }
+        }
+
+        if (cost_here < cost_children[0] && cost_here < cost_children[1])
+        {
+            break;
+        }
+
+        sibling = nodes[sibling].children[cost_children[0] < cost_children[1] ? 0 : 1];
+    }
+
+    /* A new parent takes the place of the sibling */
+    parent = beneath_bvh_node_allocate(bvh);
+    nodes[parent].parent = nodes[sibling].parent;
+    nodes[parent].children[0] = sibling;
+    nodes[parent].children[1] = leaf;
+    beneath_bvh_child_replace(bvh, nodes[sibling].parent, sibling, parent);
+    nodes[sibling].parent = parent;
+    nodes[leaf].parent = parent;
+
+    beneath_bvh_ancestors_fit(bvh, parent);
+
+    return leaf;
+}
+
+BENEATH_API BENEATH_INLINE void beneath_bvh_remove(beneath_bvh *bvh, unsigned int leaf)
+{
+    beneath_bvh_node *nodes = bvh->nodes;
+    unsigned int parent = nodes[leaf].parent;
+
+    bvh->leaves_count--;
+
+    if (parent == BENEATH_BVH_NONE)
+    {
+        bvh->root = BENEATH_BVH_NONE;
+    }
+    else
+    {
+        /* The sibling takes the place of the parent */
+        unsigned int sibling = nodes[parent].children[nodes[parent].children[0] == leaf ? 1 : 0];
+        unsigned int grandparent = nodes[parent].parent;
+
+        beneath_bvh_child_replace(bvh, grandparent, parent, sibling);
+        nodes[sibling].parent = grandparent;
+        beneath_bvh_node_free(bvh, parent);
+
+        beneath_bvh_ancestors_fit(bvh, grandparent);
+    }
+
+    beneath_bvh_node_free(bvh, leaf);
+}
+
+/* New box of a leaf, the ancestors are only updated by beneath_bvh_refit */
+BENEATH_API BENEATH_INLINE void beneath_bvh_leaf_set(beneath_bvh *bvh, unsigned int leaf, float min[3], float max[3])
+{
+    int i;
+
+    for (i = 0; i < 3; ++i)
+    {
+        bvh->nodes[leaf].min[i] = min[i];
+        bvh->nodes[leaf].max[i] = max[i];
+    }
+}
+
+/* New box of a single leaf, the ancestors are refit on the way up to the root */
+BENEATH_API BENEATH_INLINE void beneath_bvh_move(beneath_bvh *bvh, unsigned int leaf, float min[3], float max[3])
+{
+    unsigned int index = bvh->nodes[leaf].parent;
+
+    beneath_bvh_leaf_set(bvh, leaf, min, max);
+
+    while (index != BENEATH_BVH_NONE)
+    {
+        beneath_bvh_node_fit(bvh, index);
+        index = bvh->nodes[index].parent;
+    }
+}
+
+BENEATH_API BENEATH_INLINE void beneath_bvh_refit_node(beneath_bvh *bvh, unsigned int index)
+{
+    if (bvh->nodes[index].height == 0)
+    {
+        return;
+    }
+
+    beneath_bvh_refit_node(bvh, bvh->nodes[index].children[0]);
+    beneath_bvh_refit_node(bvh, bvh->nodes[index].children[1]);
+    beneath_bvh_node_fit(bvh, index);
+}
+
+/* Recomputes every inner box bottom up after beneath_bvh_leaf_set */
+BENEATH_API BENEATH_INLINE void beneath_bvh_refit(beneath_bvh *bvh)
+{
+    if (bvh->root != BENEATH_BVH_NONE)
+    {
+        beneath_bvh_refit_node(bvh, bvh->root);
+    }
+}
+
+BENEATH_API BENEATH_INLINE unsigned int beneath_bvh_compact_node(beneath_bvh *bvh, unsigned int index, unsigned int parent, beneath_bvh_node *nodes, unsigned int *nodes_count, unsigned int *item_leaves)
+{
+    unsigned int compacted = (*nodes_count)++;
+
+    nodes[compacted] = bvh->nodes[index];
+    nodes[compacted].parent = parent;
+
+    if (nodes[compacted].height == 0)
+    {
+        if (item_leaves)
+        {
+            item_leaves[nodes[compacted].item] = compacted;
+        }
+
+        return compacted;
+    }
+
+    nodes[compacted].children[0] = beneath_bvh_compact_node(bvh, bvh->nodes[index].children[0], compacted, nodes, nodes_count, item_leaves);
+    nodes[compacted].children[1] = beneath_bvh_compact_node(bvh, bvh->nodes[index].children[1], compacted, nodes, nodes_count, item_leaves);
+
+    return compacted;
+}
+
+/* Moves the nodes into depth first order at the front of the array so traversals walk
+ * memory forwards instead of jumping around the free list order of incremental inserts.
+ * Leaf indices change, item_leaves (indexed by item, may be 0) receives the new ones.
+ * Scratch memory comes from the given arena and is released before returning.
+ */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_bvh_compact(beneath_bvh *bvh, beneath_arena *scratch, unsigned int *item_leaves)
+{
+    beneath_arena_temp temp;
+    beneath_bvh_node *nodes;
+    unsigned int nodes_count = 0;
+    unsigned int i;
+
+    if (bvh->root == BENEATH_BVH_NONE)
+    {
+        return true;
+    }
+
+    temp = beneath_arena_temp_begin(scratch);
+    nodes = BENEATH_ARENA_PUSH_ARRAY(scratch, beneath_bvh_node, bvh->leaves_count * 2 - 1);
+
+    if (!nodes)
+    {
+        beneath_arena_temp_end(temp);
+        return false;
+    }
+
+    beneath_bvh_compact_node(bvh, bvh->root, BENEATH_BVH_NONE, nodes, &nodes_count, item_leaves);
+
+    for (i = 0; i < nodes_count; ++i)
+    {
+        bvh->nodes[i] = nodes[i];
+    }
+
+    /* The unused nodes behind the tree form the free list again */
+    for (i = nodes_count; i < bvh->nodes_capacity; ++i)
+    {
+        bvh->nodes[i].parent = i + 1 < bvh->nodes_capacity ? i + 1 : BENEATH_BVH_NONE;
+    }
+
+    bvh->root = 0;
+    bvh->free_list = nodes_count < bvh->nodes_capacity ? nodes_count : BENEATH_BVH_NONE;
+
+    beneath_arena_temp_end(temp);
+
+    return true;
+}
+
+/* Appends the items of all leaves below index */
+BENEATH_API BENEATH_INLINE void beneath_bvh_items_collect(beneath_bvh *bvh, unsigned int index, unsigned int *items, unsigned int items_capacity, unsigned int *items_count)
+{
+    beneath_bvh_node *node = &bvh->nodes[index];
+
+    if (node->height == 0)
+    {
+        if (*items_count < items_capacity)
+        {
+            items[(*items_count)++] = node->item;
+        }
+
+        return;
+    }
+
+    beneath_bvh_items_collect(bvh, node->children[0], items, items_capacity, items_count);
+    beneath_bvh_items_collect(bvh, node->children[1], items, items_capacity, items_count);
+}
+
+/* planes_mask holds the planes the parent box is not completely inside of, a subtree
+ * inside all planes is collected without further tests. With candidates set, leaves that
+ * still have planes to test are appended there untested instead.
+ */
+BENEATH_API BENEATH_INLINE void beneath_bvh_query_frustum_node(beneath_bvh *bvh, unsigned int index, v4 *planes, unsigned int planes_mask, unsigned int *items, unsigned int items_capacity, unsigned int *items_count, unsigned int *candidates, unsigned int *candidates_count)
+{
+    beneath_bvh_node *node = &bvh->nodes[index];
+    float cx = (node->min[0] + node->max[0]) * 0.5f;
+    float cy = (node->min[1] + node->max[1]) * 0.5f;
+    float cz = (node->min[2] + node->max[2]) * 0.5f;
+    float ex = (node->max[0] - node->min[0]) * 0.5f;
+    float ey = (node->max[1] - node->min[1]) * 0.5f;
+    float ez = (node->max[2] - node->min[2]) * 0.5f;
+    unsigned int i;
+
+    if (candidates && node->height == 0)
+    {
+        if (*candidates_count < items_capacity)
+        {
+            candidates[(*candidates_count)++] = node->item;
+        }
+
+        return;
+    }
+
+    for (i = 0; i < VM_FRUSTUM_PLANE_SIZE; ++i)
+    {
+        float distance;
+        float radius;
+
+        if (!(planes_mask & (1u << i)))
+        {
+            continue;
+        }
+
+        distance = planes[i].x * cx + planes[i].y * cy + planes[i].z * cz + planes[i].w;
+        radius = vm_absf(planes[i].x) * ex + vm_absf(planes[i].y) * ey + vm_absf(planes[i].z) * ez;
+
+        if (distance < -radius)
+        {
+            return;
+        }
+
+        if (distance >= radius)
+        {
+            planes_mask &= ~(1u << i);
+        }
+    }
+
+    if (planes_mask == 0 || node->height == 0)
+    {
+        beneath_bvh_items_collect(bvh, index, items, items_capacity, items_count);
+        return;
+    }
+
+    beneath_bvh_query_frustum_node(bvh, node->children[0], planes, planes_mask, items, items_capacity, items_count, candidates, candidates_count);
+    beneath_bvh_query_frustum_node(bvh, node->children[1], planes, planes_mask, items, items_capacity, items_count, candidates, candidates_count);
+}
+
+/* Writes the items whose box intersects the frustum (plane normals pointing inside, as
+ * returned by vm_frustum_extract_planes) and returns their count, at most items_capacity.
+ */
+BENEATH_API BENEATH_INLINE unsigned int beneath_bvh_query_frustum(beneath_bvh *bvh, frustum *planes, unsigned int *items, unsigned int items_capacity)
+{
+    unsigned int items_count = 0;
+
+    if (bvh->root != BENEATH_BVH_NONE)
+    {
+        beneath_bvh_query_frustum_node(bvh, bvh->root, vm_frustum_data(planes), (1u << VM_FRUSTUM_PLANE_SIZE) - 1, items, items_capacity, &items_count, (unsigned int *)0, (unsigned int *)0);
+    }
+
+    return items_count;
+}
+
+/* Like beneath_bvh_query_frustum, but only inner nodes are tested. Items of subtrees completely
+ * inside the frustum go to items, the leaves below partially visible nodes go to candidates
+ * untested, for a batch test by the caller (e.g. vm_frustum_cull_spheres over the instances).
+ * Both lists hold at most capacity items, returns the items count.
+ */
+BENEATH_API BENEATH_INLINE unsigned int beneath_bvh_query_frustum_candidates(beneath_bvh *bvh, frustum *planes, unsigned int *items, unsigned int *candidates, unsigned int capacity, unsigned int *candidates_count)
+{
+    unsigned int items_count = 0;
+
+    *candidates_count = 0;
+
+    if (bvh->root != BENEATH_BVH_NONE)
+    {
+        beneath_bvh_query_frustum_node(bvh, bvh->root, vm_frustum_data(planes), (1u << VM_FRUSTUM_PLANE_SIZE) - 1, items, capacity, &items_count, candidates, candidates_count);
+    }
+
+    return items_count;
+}
+
+/* Distance along the ray where it enters the box, negative if it misses it before max_distance */
+BENEATH_API BENEATH_INLINE float beneath_bvh_ray_box(beneath_bvh_node *node, float origin[3], float direction_inverse[3], float max_distance)
+{
+    float t_min = 0.0f;
+    float t_max = max_distance;
+    int i;
+
+    for (i = 0; i < 3; ++i)
+    {
+        float t0 = (node->min[i] - origin[i]) * direction_inverse[i];
+        float t1 = (node->max[i] - origin[i]) * direction_inverse[i];
+
+        if (t0 > t1)
+        {
+            float swap = t0;
+            t0 = t1;
+            t1 = swap;
+        }
+
+        t_min = t0 > t_min ? t0 : t_min;
+        t_max = t1 < t_max ? t1 : t_max;
+
+        if (t_min > t_max)
+        {
+            return -1.0f;
+        }
+    }
+
+    return t_min;
+}
+
+typedef struct beneath_bvh_ray
+{
+    float *origin;
+    float *direction;
+    float direction_inverse[3];
+    beneath_bvh_ray_function function;
+    void *data;
+    float distance; /* Closest hit so far */
+    unsigned int item;
+
+} beneath_bvh_ray;
+
+/* Nearer child first, subtrees entered beyond the closest hit are skipped */
+BENEATH_API BENEATH_INLINE void beneath_bvh_raycast_node(beneath_bvh *bvh, unsigned int index, beneath_bvh_ray *ray)
+{
+    beneath_bvh_node *node = &bvh->nodes[index];
+
+    if (node->height == 0)
+    {
+        float distance = ray->function ? ray->function(ray->data, node->item, ray->origin, ray->direction, ray->distance) : beneath_bvh_ray_box(node, ray->origin, ray->direction_inverse, ray->distance);
+
+        if (distance >= 0.0f && distance < ray->distance)
+        {
+            ray->distance = distance;
+            ray->item = node->item;
+        }
+
+        return;
+    }
+
+    {
+        unsigned int first = node->children[0];
+        unsigned int second = node->children[1];
+        float first_distance = beneath_bvh_ray_box(&bvh->nodes[first], ray->origin, ray->direction_inverse, ray->distance);
+        float second_distance = beneath_bvh_ray_box(&bvh->nodes[second], ray->origin, ray->direction_inverse, ray->distance);
+
+        if (second_distance >= 0.0f && (first_distance < 0.0f || second_distance < first_distance))
+        {
+            unsigned int swap = first;
+            float swap_distance = first_distance;
+
+            first = second;
+            second = swap;
+            first_distance = second_distance;
+            second_distance = swap_distance;
+        }
+
+        if (first_distance >= 0.0f)
+        {
+            beneath_bvh_raycast_node(bvh, first, ray);
+        }
+
+        /* The closest hit may have moved in front of the second child */
+        if (second_distance >= 0.0f && second_distance < ray->distance)
+        {
+            beneath_bvh_raycast_node(bvh, second, ray);
+        }
+    }
+}
+
+/* Closest item hit by the ray within max_distance. function tests a leaf exactly,
+ * without one the leaf boxes are the hit shapes. False if nothing was hit.
+ */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_bvh_raycast(beneath_bvh *bvh, float origin[3], float direction[3], float max_distance, beneath_bvh_ray_function function, void *data, unsigned int *item, float *distance)
+{
+    beneath_bvh_ray ray;
+    int i;
+
+    if (bvh->root == BENEATH_BVH_NONE)
+    {
+        return false;
+    }
+
+    ray.origin = origin;
+    ray.direction = direction;
+    ray.function = function;
+    ray.data = data;
+    ray.distance = max_distance;
+    ray.item = BENEATH_BVH_NONE;
+
+    /* Axis parallel rays get a huge instead of an infinite slope */
+    for (i = 0; i < 3; ++i)
+    {
+        ray.direction_inverse[i] = direction[i] != 0.0f ? 1.0f / direction[i] : 1e30f;
+    }
+
+    if (beneath_bvh_ray_box(&bvh->nodes[bvh->root], origin, ray.direction_inverse, max_distance) < 0.0f)
+    {
+        return false;
+    }
+
+    beneath_bvh_raycast_node(bvh, bvh->root, &ray);
+
+    if (ray.item == BENEATH_BVH_NONE)
+    {
+        return false;
+    }
+
+    *item = ray.item;
+    *distance = ray.distance;
+
+    return true;
+}
+
+#endif /* BENEATH_BVH_H */
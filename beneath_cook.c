@@ -0,0 +1,455 @@
+/* beneath_cook - offline mesh cooker
+ *
+ * Converts a Wavefront OBJ or glTF 2.0 binary (.glb) mesh into the beneath_mesh_file
+ * format (.bmesh) that the runtime maps without parsing:
+ *
+ *   beneath_cook <input.obj|input.glb> <output.bmesh> [lods]
+ *
+ * The mesh is optimized (beneath_mesh_optimize), interleaved into a packed vertex
+ * stream and narrowed to 16 bit indices where possible. The separate attribute arrays
+ * stay in the file for the software renderer.
+ *
+ * With lods > 0 a LOD chain is written next to the output (output_lod1.bmesh, ...).
+ * Each level is simplified from the optimized source mesh (beneath_mesh_simplify) to
+ * half the triangles of the level before, the files carry the error for the LOD selection.
+ * The chain is checked before the tool succeeds: every level has fewer triangles and a larger
+ * error than the one before, and beneath_draw_call_lod_select walks down the chain as an
+ * instance moves away from the camera.
+ *
+ * An offline tool, so it uses the C runtime for file access and memory.
+ */
+#define BENEATH_USE_CRT
+#include "beneath.h"
+#include "beneath_mesh_optimizer.h"
+#include "beneath_mesh_simplifier.h"
+#include "beneath_mesh_import.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENEATH_COOK_MEMORY_MIN (16u * 1024u * 1024u)
+#define BENEATH_COOK_MEMORY_MAX 0x7FFFFFF0u
+#define BENEATH_COOK_FILENAME_MAX 1024
+#define BENEATH_COOK_LOD_ERROR_MAX 1.0e30f /* LOD levels are limited by their triangle count only */
+#define BENEATH_COOK_LOD_PIXELS_PER_UNIT 935.3f /* 1080 pixels high at a 60 degree vertical fov: 540 / tan(30) */
+
+static beneath_bool beneath_cook_ends_with(char *string, char *suffix)
+{
+    unsigned int string_length = 0;
+    unsigned int suffix_length = 0;
+    unsigned int i;
+
+    while (string[string_length])
+    {
+        string_length++;
+    }
+
+    while (suffix[suffix_length])
+    {
+        suffix_length++;
+    }
+
+    if (suffix_length > string_length)
+    {
+        return false;
+    }
+
+    for (i = 0; i < suffix_length; ++i)
+    {
+        char c = string[string_length - suffix_length + i];
+
+        /* ASCII lower case */
+        if (c >= 'A' && c <= 'Z')
+        {
+            c = (char)(c - 'A' + 'a');
+        }
+
+        if (c != suffix[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static unsigned char *beneath_cook_file_read(char *filename, unsigned int *file_size)
+{
+    FILE *file = fopen(filename, "rb");
+    unsigned char *buffer;
+    long size;
+
+    if (!file)
+    {
+        return (unsigned char *)0;
+    }
+
+    if (fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < 0 || size > (long)BENEATH_COOK_MEMORY_MAX || fseek(file, 0, SEEK_SET) != 0)
+    {
+        fclose(file);
+        return (unsigned char *)0;
+    }
+
+    buffer = (unsigned char *)malloc((size_t)size + 1);
+
+    if (!buffer || fread(buffer, 1, (size_t)size, file) != (size_t)size)
+    {
+        free(buffer);
+        fclose(file);
+        return (unsigned char *)0;
+    }
+
+    buffer[size] = 0;
+    *file_size = (unsigned int)size;
+
+    fclose(file);
+
+    return buffer;
+}
+
+static beneath_bool beneath_cook_file_write(char *filename, unsigned char *buffer, unsigned int buffer_size)
+{
+    FILE *file = fopen(filename, "wb");
+    beneath_bool written;
+
+    if (!file)
+    {
+        return false;
+    }
+
+    written = fwrite(buffer, 1, buffer_size, file) == buffer_size;
+
+    return (fclose(file) == 0) && written;
+}
+
+/* Copies the separate attribute arrays and indices into the arena, the copy can be simplified on its own */
+static beneath_bool beneath_cook_mesh_copy(beneath_mesh *mesh, beneath_mesh *copy, beneath_arena *arena)
+{
+    float **arrays[6];
+    float **copies[6];
+    unsigned int counts[6];
+    unsigned int i;
+    unsigned int j;
+
+    *copy = *mesh;
+
+    arrays[0] = &mesh->vertices;
+    arrays[1] = &mesh->uvs;
+    arrays[2] = &mesh->normals;
+    arrays[3] = &mesh->tangents;
+    arrays[4] = &mesh->bitangents;
+    arrays[5] = &mesh->colors;
+    copies[0] = &copy->vertices;
+    copies[1] = &copy->uvs;
+    copies[2] = &copy->normals;
+    copies[3] = &copy->tangents;
+    copies[4] = &copy->bitangents;
+    copies[5] = &copy->colors;
+    counts[0] = mesh->vertices_count;
+    counts[1] = mesh->uvs_count;
+    counts[2] = mesh->normals_count;
+    counts[3] = mesh->tangents_count;
+    counts[4] = mesh->bitangents_count;
+    counts[5] = mesh->colors_count;
+
+    for (i = 0; i < 6; ++i)
+    {
+        if (!*arrays[i] || counts[i] == 0)
+        {
+            continue;
+        }
+
+        *copies[i] = BENEATH_ARENA_PUSH_ARRAY(arena, float, counts[i]);
+
+        if (!*copies[i])
+        {
+            return false;
+        }
+
+        for (j = 0; j < counts[i]; ++j)
+        {
+            (*copies[i])[j] = (*arrays[i])[j];
+        }
+    }
+
+    copy->indices = BENEATH_ARENA_PUSH_ARRAY(arena, unsigned int, mesh->indices_count);
+
+    if (!copy->indices)
+    {
+        return false;
+    }
+
+    for (j = 0; j < mesh->indices_count; ++j)
+    {
+        copy->indices[j] = mesh->indices[j];
+    }
+
+    return true;
+}
+
+/* Packs the optimized mesh for the GPU and writes it as .bmesh */
+static beneath_bool beneath_cook_mesh_write(beneath_mesh *mesh, char *filename, beneath_arena *arena, beneath_arena *scratch)
+{
+    unsigned char formats[BENEATH_VERTEX_ATTRIBUTE_COUNT] = {0};
+    beneath_arena_temp temp = beneath_arena_temp_begin(scratch);
+    unsigned char *output;
+    unsigned int output_size;
+    beneath_bool written;
+
+    /* The packed formats of beneath_mesh_interleave, attributes missing in the mesh are skipped */
+    formats[BENEATH_VERTEX_ATTRIBUTE_POSITION] = BENEATH_VERTEX_FORMAT_FLOAT32;
+    formats[BENEATH_VERTEX_ATTRIBUTE_UV] = BENEATH_VERTEX_FORMAT_FLOAT16;
+    formats[BENEATH_VERTEX_ATTRIBUTE_NORMAL] = BENEATH_VERTEX_FORMAT_SNORM_10_10_10_2;
+    formats[BENEATH_VERTEX_ATTRIBUTE_TANGENT] = BENEATH_VERTEX_FORMAT_SNORM_10_10_10_2;
+    formats[BENEATH_VERTEX_ATTRIBUTE_BITANGENT] = BENEATH_VERTEX_FORMAT_SNORM_10_10_10_2;
+    formats[BENEATH_VERTEX_ATTRIBUTE_COLOR] = BENEATH_VERTEX_FORMAT_UNORM8;
+
+    if (!beneath_mesh_interleave(mesh, formats, arena))
+    {
+        fprintf(stderr, "[cook] cannot interleave '%s', keeping separate vertex arrays\n", filename);
+    }
+
+    beneath_mesh_indices_narrow(mesh, arena);
+
+    output_size = beneath_mesh_file_size(mesh);
+    output = BENEATH_ARENA_PUSH_ARRAY(scratch, unsigned char, output_size);
+    written = beneath_mesh_file_write(mesh, output, output_size, &output_size) && beneath_cook_file_write(filename, output, output_size);
+
+    beneath_arena_temp_end(temp);
+
+    if (!written)
+    {
+        fprintf(stderr, "[cook] cannot write '%s'\n", filename);
+    }
+
+    return written;
+}
+
+/* output.bmesh -> output_lod<lod>.bmesh, the suffix is appended if there is no extension */
+static beneath_bool beneath_cook_lod_filename(char *output, unsigned int lod, char *filename)
+{
+    unsigned int length = 0;
+    unsigned int extension;
+
+    while (output[length])
+    {
+        length++;
+    }
+
+    extension = length;
+
+    while (extension > 0 && output[extension - 1] != '.' && output[extension - 1] != '/' && output[extension - 1] != '\\')
+    {
+        extension--;
+    }
+
+    extension = (extension > 0 && output[extension - 1] == '.') ? extension - 1 : length;
+
+    if (length + 16 > BENEATH_COOK_FILENAME_MAX)
+    {
+        return false;
+    }
+
+    sprintf(filename, "%.*s_lod%u%s", (int)extension, output, lod, output + extension);
+
+    return true;
+}
+
+/* Fails if a level is not coarser than the one before or the selection does not move down the chain with distance */
+static beneath_bool beneath_cook_lod_check(beneath_mesh *mesh, beneath_mesh *levels, unsigned int lods, char *input)
+{
+    beneath_draw_call draw_call = {0};
+    float model[16] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+    float camera_position[3] = {0.0f, 0.0f, 0.0f};
+    float distance;
+    float distance_max;
+    unsigned int previous = 0;
+    unsigned int lod;
+
+    for (lod = 0; lod < lods; ++lod)
+    {
+        beneath_mesh *finer = lod > 0 ? &levels[lod - 1] : mesh;
+        beneath_mesh *coarser = &levels[lod];
+
+        if (coarser->indices_count >= finer->indices_count || coarser->lod_error <= finer->lod_error)
+        {
+            fprintf(stderr, "[cook] lod %u of '%s' is not coarser than lod %u: %u -> %u triangles, error %.6f -> %.6f\n",
+                    lod + 1, input, lod, finer->indices_count / 3, coarser->indices_count / 3, (double)finer->lod_error, (double)coarser->lod_error);
+            return false;
+        }
+
+        draw_call.lods[lod] = coarser;
+    }
+
+    if (!beneath_mesh_bounds_compute(mesh))
+    {
+        fprintf(stderr, "[cook] cannot compute the bounds of '%s'\n", input);
+        return false;
+    }
+
+    draw_call.mesh = mesh;
+    draw_call.lods_count = lods;
+
+    /* From just outside the bounding sphere until well past the distance of the coarsest level, the instance moves along -z */
+    distance = vm_sqrtf(mesh->bounds_extents[0] * mesh->bounds_extents[0] + mesh->bounds_extents[1] * mesh->bounds_extents[1] + mesh->bounds_extents[2] * mesh->bounds_extents[2]) * 1.01f;
+    distance_max = distance + 2.0f * levels[lods - 1].lod_error * BENEATH_COOK_LOD_PIXELS_PER_UNIT / BENEATH_DRAW_CALL_LOD_PIXELS_DEFAULT;
+
+    for (; distance < distance_max; distance *= 1.01f)
+    {
+        model[12] = -mesh->bounds_center[0];
+        model[13] = -mesh->bounds_center[1];
+        model[14] = -mesh->bounds_center[2] - distance;
+        lod = beneath_draw_call_lod_select(&draw_call, model, camera_position, BENEATH_COOK_LOD_PIXELS_PER_UNIT);
+
+        if (lod < previous)
+        {
+            fprintf(stderr, "[cook] lod selection of '%s' goes back from lod %u to %u at %.2f units\n", input, previous, lod, (double)distance);
+            return false;
+        }
+
+        if (lod > previous)
+        {
+            printf("[cook] %s: lod %u is selected from %.2f units (1080p, 60 degree fov)\n", input, lod, (double)distance);
+            previous = lod;
+        }
+    }
+
+    if (previous != lods)
+    {
+        fprintf(stderr, "[cook] lod selection of '%s' never reaches lod %u\n", input, lods);
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    beneath_mesh mesh = {0};
+    beneath_mesh levels[BENEATH_DRAW_CALL_LODS_MAX];
+    beneath_arena arena;
+    beneath_arena scratch;
+    beneath_mesh_optimizer_stats stats;
+    unsigned char *source;
+    unsigned char *memory;
+    unsigned int source_size = 0;
+    unsigned int memory_size;
+    unsigned int lods = 0;
+    unsigned int triangles;
+    unsigned int lod;
+    beneath_bool imported;
+
+    if (argc < 3 || argc > 4 || (argc == 4 && (sscanf(argv[3], "%u", &lods) != 1 || lods > BENEATH_DRAW_CALL_LODS_MAX)))
+    {
+        fprintf(stderr, "usage: beneath_cook <input.obj|input.glb> <output.bmesh> [lods 0 - %d]\n", BENEATH_DRAW_CALL_LODS_MAX);
+        return 1;
+    }
+
+    source = beneath_cook_file_read(argv[1], &source_size);
+
+    if (!source)
+    {
+        fprintf(stderr, "[cook] cannot read '%s'\n", argv[1]);
+        return 1;
+    }
+
+    /* Text is the densest input, 32 bytes of arena per source byte covers the welded OBJ arrays and tables */
+    memory_size = source_size < (BENEATH_COOK_MEMORY_MAX - BENEATH_COOK_MEMORY_MIN) / 32 ? BENEATH_COOK_MEMORY_MIN + source_size * 32 : BENEATH_COOK_MEMORY_MAX;
+    memory = (unsigned char *)malloc((size_t)memory_size * 2);
+
+    if (!memory)
+    {
+        fprintf(stderr, "[cook] cannot allocate %u bytes\n", memory_size * 2);
+        free(source);
+        return 1;
+    }
+
+    /* malloc returns at least 16 byte aligned blocks on the supported 64 bit platforms */
+    beneath_arena_initialize(&arena, memory, memory_size, 0);
+    beneath_arena_initialize(&scratch, memory + memory_size, memory_size, 0);
+
+    if (beneath_cook_ends_with(argv[1], ".obj"))
+    {
+        imported = beneath_mesh_import_obj(&mesh, (char *)source, source_size, &arena, &scratch);
+    }
+    else if (beneath_cook_ends_with(argv[1], ".glb"))
+    {
+        imported = beneath_mesh_import_glb(&mesh, source, source_size, &arena);
+    }
+    else
+    {
+        fprintf(stderr, "[cook] unknown input format '%s', expected .obj or .glb\n", argv[1]);
+        imported = false;
+    }
+
+    if (!imported)
+    {
+        fprintf(stderr, "[cook] cannot import '%s'\n", argv[1]);
+        free(memory);
+        free(source);
+        return 1;
+    }
+
+    if (!beneath_mesh_optimize(&mesh, &scratch, &stats))
+    {
+        fprintf(stderr, "[cook] cannot optimize '%s'\n", argv[1]);
+        free(memory);
+        free(source);
+        return 1;
+    }
+
+    /* The LOD chain comes from the source mesh before it gets packed, the simplifier needs the separate arrays */
+    triangles = mesh.indices_count / 3;
+
+    for (lod = 1; lod <= lods; ++lod)
+    {
+        char filename[BENEATH_COOK_FILENAME_MAX];
+        beneath_mesh *simplified = &levels[lod - 1];
+
+        triangles = triangles / 2 > 0 ? triangles / 2 : 1;
+
+        if (!beneath_cook_lod_filename(argv[2], lod, filename) ||
+            !beneath_cook_mesh_copy(&mesh, simplified, &arena) ||
+            !beneath_mesh_simplify(simplified, triangles * 3, BENEATH_COOK_LOD_ERROR_MAX, &scratch) ||
+            !beneath_mesh_optimize(simplified, &scratch, (beneath_mesh_optimizer_stats *)0))
+        {
+            fprintf(stderr, "[cook] cannot simplify '%s' for lod %u\n", argv[1], lod);
+            free(memory);
+            free(source);
+            return 1;
+        }
+
+        if (!beneath_cook_mesh_write(simplified, filename, &arena, &scratch))
+        {
+            free(memory);
+            free(source);
+            return 1;
+        }
+
+        printf("[cook] %s -> %s: lod %u, %u vertices, %u triangles (target %u), error %.6f\n",
+               argv[1], filename, lod, simplified->vertices_count / 3, simplified->indices_count / 3, triangles, (double)simplified->lod_error);
+    }
+
+    if (lods > 0 && !beneath_cook_lod_check(&mesh, levels, lods, argv[1]))
+    {
+        free(memory);
+        free(source);
+        return 1;
+    }
+
+    if (!beneath_cook_mesh_write(&mesh, argv[2], &arena, &scratch))
+    {
+        free(memory);
+        free(source);
+        return 1;
+    }
+
+    printf("[cook] %s -> %s: %u vertices, %u triangles, %u bit indices, stride %u, acmr %.3f -> %.3f, %u bytes\n",
+           argv[1], argv[2], stats.vertices_after, mesh.indices_count / 3, mesh.indices16 ? 16u : 32u, mesh.layout.stride,
+           (double)stats.acmr_before, (double)stats.acmr_after, beneath_mesh_file_size(&mesh));
+
+    free(memory);
+    free(source);
+
+    return 0;
+}
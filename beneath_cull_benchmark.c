@@ -0,0 +1,124 @@
+/* beneath_cull_benchmark - objects per nanosecond of the vm.h sphere culling kernels
+ *
+ *   beneath_cull_benchmark [spheres] [runs]
+ *
+ * Culls random spheres against the frustum of the demo camera with vm_frustum_cull_spheres_scalar
+ * and with vm_frustum_cull_spheres, checks that both agree and prints objects per nanosecond.
+ * The SIMD path of vm_frustum_cull_spheres is picked at compile time, the build scripts build
+ * the tool once with AVX and once with SSE only.
+ *
+ * A standalone tool, so it uses the C runtime for memory and timing.
+ */
+#include "deps/vm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENEATH_CULL_BENCHMARK_SPHERES 100000
+#define BENEATH_CULL_BENCHMARK_RUNS 50
+
+#if defined(VM_FRUSTUM_CULL_AVX)
+#define BENEATH_CULL_BENCHMARK_PATH "avx"
+#elif defined(VM_FRUSTUM_CULL_SSE)
+#define BENEATH_CULL_BENCHMARK_PATH "sse"
+#else
+#define BENEATH_CULL_BENCHMARK_PATH "scalar"
+#endif
+
+static double beneath_cull_benchmark_seconds(void)
+{
+    return (double)clock() / (double)CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv)
+{
+    frustum planes = vm_frustum_extract_planes(vm_m4x4_mul(
+        vm_m4x4_perspective(vm_radf(45.0f), 1.5f, 0.1f, 1000.0f),
+        vm_m4x4_lookAt(vm_v3(-1.0f, 1.0f, 3.0f), vm_v3_zero, vm_v3(0.0f, 1.0f, 0.0f))));
+    unsigned int spheres = BENEATH_CULL_BENCHMARK_SPHERES;
+    unsigned int runs = BENEATH_CULL_BENCHMARK_RUNS;
+    float *cx;
+    float *cy;
+    float *cz;
+    float *r;
+    unsigned char *mask_scalar;
+    unsigned char *mask_simd;
+    unsigned long visible = 0;
+    unsigned int mismatches = 0;
+    double start;
+    double scalar_ns;
+    double simd_ns;
+    double objects;
+    unsigned int i;
+
+    if (argc > 3 || (argc > 1 && (sscanf(argv[1], "%u", &spheres) != 1 || spheres == 0)) || (argc > 2 && (sscanf(argv[2], "%u", &runs) != 1 || runs == 0)))
+    {
+        fprintf(stderr, "usage: beneath_cull_benchmark [spheres] [runs]\n");
+        return 1;
+    }
+
+    cx = (float *)malloc(sizeof(float) * spheres);
+    cy = (float *)malloc(sizeof(float) * spheres);
+    cz = (float *)malloc(sizeof(float) * spheres);
+    r = (float *)malloc(sizeof(float) * spheres);
+    mask_scalar = (unsigned char *)malloc(spheres);
+    mask_simd = (unsigned char *)malloc(spheres);
+
+    if (!cx || !cy || !cz || !r || !mask_scalar || !mask_simd)
+    {
+        fprintf(stderr, "[cull] cannot allocate %u spheres\n", spheres);
+        return 1;
+    }
+
+    for (i = 0; i < spheres; ++i)
+    {
+        cx[i] = vm_randf_range(-50.0f, 50.0f);
+        cy[i] = vm_randf_range(-50.0f, 50.0f);
+        cz[i] = vm_randf_range(-50.0f, 50.0f);
+        r[i] = vm_randf_range(0.1f, 2.0f);
+    }
+
+    start = beneath_cull_benchmark_seconds();
+
+    for (i = 0; i < runs; ++i)
+    {
+        vm_frustum_cull_spheres_scalar(&planes, cx, cy, cz, r, (int)spheres, mask_scalar);
+    }
+
+    scalar_ns = (beneath_cull_benchmark_seconds() - start) * 1.0e9;
+    start = beneath_cull_benchmark_seconds();
+
+    for (i = 0; i < runs; ++i)
+    {
+        vm_frustum_cull_spheres(&planes, cx, cy, cz, r, (int)spheres, mask_simd);
+    }
+
+    simd_ns = (beneath_cull_benchmark_seconds() - start) * 1.0e9;
+
+    for (i = 0; i < spheres; ++i)
+    {
+        visible += mask_simd[i];
+        mismatches += mask_simd[i] != mask_scalar[i];
+    }
+
+    objects = (double)spheres * (double)runs;
+
+    printf("[cull] spheres: %u, runs: %u, visible: %lu, objects/ns scalar: %.3f, %s: %.3f\n",
+           spheres, runs, visible, scalar_ns > 0.0 ? objects / scalar_ns : 0.0, BENEATH_CULL_BENCHMARK_PATH, simd_ns > 0.0 ? objects / simd_ns : 0.0);
+
+    free(cx);
+    free(cy);
+    free(cz);
+    free(r);
+    free(mask_scalar);
+    free(mask_simd);
+
+    if (mismatches > 0)
+    {
+        fprintf(stderr, "[cull] the " BENEATH_CULL_BENCHMARK_PATH " kernel disagrees with the scalar one for %u spheres\n", mismatches);
+        return 1;
+    }
+
+    return 0;
+}
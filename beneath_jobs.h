@@ -0,0 +1,362 @@
+#ifndef BENEATH_JOBS_H
+#define BENEATH_JOBS_H
+
+#include "beneath.h"
+
+/* Work stealing job scheduler behind the beneath_api job calls.
+ *
+ * Every thread (0 is the main thread, workers are 1 to threads_count - 1) owns a
+ * Chase-Lev deque (Le et al. 2013): the owner pushes and pops jobs at the bottom,
+ * idle threads steal from the top of the others. Idle workers spin briefly and then
+ * sleep on a futex like signal that is bumped on every submission. Threads waiting on
+ * a counter keep running jobs and spin while there is nothing to take.
+ *
+ * The platform layer starts the workers (running beneath_jobs_worker) and provides
+ * the calling thread index and a wait/wake pair with futex semantics.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define BENEATH_JOBS_ATOMIC_LOAD(p) __sync_fetch_and_add((p), 0)
+#define BENEATH_JOBS_ATOMIC_ADD(p, v) __sync_fetch_and_add((p), (v))
+#define BENEATH_JOBS_ATOMIC_CAS(p, expected, desired) __sync_bool_compare_and_swap((p), (expected), (desired))
+#define BENEATH_JOBS_FENCE() __sync_synchronize()
+#if defined(__x86_64__) || defined(__i386__)
+#define BENEATH_JOBS_PAUSE() __asm__ __volatile__("pause")
+#elif defined(__aarch64__)
+#define BENEATH_JOBS_PAUSE() __asm__ __volatile__("yield")
+#else
+#define BENEATH_JOBS_PAUSE()
+#endif
+#else
+/* No atomics available, only the calling thread runs jobs */
+#define BENEATH_JOBS_SINGLE_THREADED
+#define BENEATH_JOBS_ATOMIC_LOAD(p) (*(p))
+#define BENEATH_JOBS_ATOMIC_ADD(p, v) ((*(p) += (v)) - (v))
+#define BENEATH_JOBS_ATOMIC_CAS(p, expected, desired) (*(p) == (expected) ? (*(p) = (desired), 1) : 0)
+#define BENEATH_JOBS_FENCE()
+#define BENEATH_JOBS_PAUSE()
+#endif
+
+#define BENEATH_JOBS_THREADS_MAX 64
+#define BENEATH_JOBS_DEQUE_CAPACITY 1024 /* Jobs per thread (power of two), a full deque runs new jobs inline */
+#define BENEATH_JOBS_SPINS 256           /* Empty polls before an idle worker sleeps */
+#define BENEATH_JOBS_CACHE_LINE 64
+
+/* The index of the calling thread, 0 for the main thread */
+typedef unsigned int (*beneath_jobs_thread_index)(void);
+
+/* Sleeps while *address == expected (may return spuriously) / wakes up to count sleepers */
+typedef void (*beneath_jobs_wait)(int *address, int expected);
+typedef void (*beneath_jobs_wake)(int *address, int count);
+
+typedef struct beneath_job
+{
+    beneath_job_function function;
+    void *data;
+    unsigned int index;
+    beneath_job_counter *counter;
+
+} beneath_job;
+
+/* top and bottom on their own cache lines, thieves and the owner do not share one */
+typedef struct beneath_jobs_deque
+{
+    int top;
+    char top_padding[BENEATH_JOBS_CACHE_LINE - sizeof(int)];
+    int bottom;
+    char bottom_padding[BENEATH_JOBS_CACHE_LINE - sizeof(int)];
+    beneath_job jobs[BENEATH_JOBS_DEQUE_CAPACITY];
+
+} beneath_jobs_deque;
+
+typedef struct beneath_jobs
+{
+    unsigned int threads_count; /* Including the main thread */
+    beneath_jobs_thread_index thread_index;
+    beneath_jobs_wait wait;
+    beneath_jobs_wake wake;
+
+    int signal;   /* Futex, incremented on every submission */
+    int sleepers; /* Workers inside wait */
+
+    beneath_jobs_deque deques[BENEATH_JOBS_THREADS_MAX];
+
+} beneath_jobs;
+
+/* Splits a parallel_for into batch jobs, lives on the stack of the waiting caller */
+typedef struct beneath_jobs_range
+{
+    beneath_job_range_function function;
+    void *data;
+    unsigned int count;
+    unsigned int batch_size;
+
+} beneath_jobs_range;
+
+/* threads_count includes the main thread, the platform starts threads_count - 1 workers afterwards */
+BENEATH_API BENEATH_INLINE void beneath_jobs_initialize(beneath_jobs *jobs, unsigned int threads_count, beneath_jobs_thread_index thread_index, beneath_jobs_wait wait, beneath_jobs_wake wake)
+{
+    unsigned int i;
+
+#ifdef BENEATH_JOBS_SINGLE_THREADED
+    threads_count = 1;
+#endif
+
+    jobs->threads_count = threads_count < 1 ? 1 : (threads_count > BENEATH_JOBS_THREADS_MAX ? BENEATH_JOBS_THREADS_MAX : threads_count);
+    jobs->thread_index = thread_index;
+    jobs->wait = wait;
+    jobs->wake = wake;
+    jobs->signal = 0;
+    jobs->sleepers = 0;
+
+    for (i = 0; i < BENEATH_JOBS_THREADS_MAX; ++i)
+    {
+        jobs->deques[i].top = 0;
+        jobs->deques[i].bottom = 0;
+    }
+}
+
+/* Owner only, false if the deque is full */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_jobs_push(beneath_jobs_deque *deque, beneath_job *job)
+{
+    int bottom = deque->bottom;
+    int top = BENEATH_JOBS_ATOMIC_LOAD(&deque->top);
+
+    if (bottom - top >= BENEATH_JOBS_DEQUE_CAPACITY)
+    {
+        return false;
+    }
+
+    deque->jobs[(unsigned int)bottom & (BENEATH_JOBS_DEQUE_CAPACITY - 1)] = *job;
+
+    /* The job is visible before the new bottom */
+    BENEATH_JOBS_FENCE();
+    *(volatile int *)&deque->bottom = bottom + 1;
+
+    return true;
+}
+
+/* Owner only, newest job first */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_jobs_pop(beneath_jobs_deque *deque, beneath_job *job)
+{
+    int bottom = deque->bottom - 1;
+    int top;
+    beneath_bool taken = true;
+
+    *(volatile int *)&deque->bottom = bottom;
+    BENEATH_JOBS_FENCE();
+    top = *(volatile int *)&deque->top;
+
+    if (top > bottom)
+    {
+        *(volatile int *)&deque->bottom = bottom + 1;
+        return false;
+    }
+
+    *job = deque->jobs[(unsigned int)bottom & (BENEATH_JOBS_DEQUE_CAPACITY - 1)];
+
+    /* The last job, race the thieves for it */
+    if (top == bottom)
+    {
+        taken = BENEATH_JOBS_ATOMIC_CAS(&deque->top, top, top + 1);
+        *(volatile int *)&deque->bottom = bottom + 1;
+    }
+
+    return taken;
+}
+
+/* Any thread, oldest job first */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_jobs_steal(beneath_jobs_deque *deque, beneath_job *job)
+{
+    int top = *(volatile int *)&deque->top;
+    int bottom;
+
+    BENEATH_JOBS_FENCE();
+    bottom = *(volatile int *)&deque->bottom;
+
+    if (top >= bottom)
+    {
+        return false;
+    }
+
+    /* The copy is discarded if another thread took the job first */
+    *job = deque->jobs[(unsigned int)top & (BENEATH_JOBS_DEQUE_CAPACITY - 1)];
+
+    return BENEATH_JOBS_ATOMIC_CAS(&deque->top, top, top + 1);
+}
+
+/* Own jobs first, then steal round robin starting at the next thread */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_jobs_next(beneath_jobs *jobs, unsigned int self, beneath_job *job)
+{
+    unsigned int i;
+
+    if (beneath_jobs_pop(&jobs->deques[self], job))
+    {
+        return true;
+    }
+
+    for (i = 1; i < jobs->threads_count; ++i)
+    {
+        if (beneath_jobs_steal(&jobs->deques[(self + i) % jobs->threads_count], job))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+BENEATH_API BENEATH_INLINE void beneath_jobs_execute(beneath_job *job, unsigned int self)
+{
+    job->function(job->data, job->index, self);
+
+    if (job->counter)
+    {
+        BENEATH_JOBS_ATOMIC_ADD(&job->counter->value, -1);
+    }
+}
+
+/* Body of every worker thread, never returns */
+BENEATH_API BENEATH_INLINE void beneath_jobs_worker(beneath_jobs *jobs, unsigned int self)
+{
+    beneath_job job;
+    unsigned int spins = 0;
+
+    for (;;)
+    {
+        int signal;
+
+        if (beneath_jobs_next(jobs, self, &job))
+        {
+            beneath_jobs_execute(&job, self);
+            spins = 0;
+            continue;
+        }
+
+        if (++spins < BENEATH_JOBS_SPINS)
+        {
+            BENEATH_JOBS_PAUSE();
+            continue;
+        }
+
+        /* Read the signal before the last look, a submission after it changes the signal and the wait returns */
+        signal = BENEATH_JOBS_ATOMIC_LOAD(&jobs->signal);
+
+        if (beneath_jobs_next(jobs, self, &job))
+        {
+            beneath_jobs_execute(&job, self);
+            spins = 0;
+            continue;
+        }
+
+        BENEATH_JOBS_ATOMIC_ADD(&jobs->sleepers, 1);
+        jobs->wait(&jobs->signal, signal);
+        BENEATH_JOBS_ATOMIC_ADD(&jobs->sleepers, -1);
+        spins = 0;
+    }
+}
+
+BENEATH_API BENEATH_INLINE void beneath_jobs_run(beneath_jobs *jobs, beneath_job_function function, void *data, unsigned int count, beneath_job_counter *counter)
+{
+    unsigned int self = jobs->thread_index();
+    beneath_job job;
+    unsigned int pushed = 0;
+    int sleepers;
+    unsigned int i;
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (counter)
+    {
+        BENEATH_JOBS_ATOMIC_ADD(&counter->value, (int)count);
+    }
+
+    job.function = function;
+    job.data = data;
+    job.counter = counter;
+
+    for (i = 0; i < count; ++i)
+    {
+        job.index = i;
+
+        if (beneath_jobs_push(&jobs->deques[self], &job))
+        {
+            pushed++;
+        }
+        else
+        {
+            /* Deque full, the submitting thread does the work */
+            beneath_jobs_execute(&job, self);
+        }
+    }
+
+    if (pushed == 0 || jobs->threads_count == 1)
+    {
+        return;
+    }
+
+    BENEATH_JOBS_ATOMIC_ADD(&jobs->signal, 1);
+    sleepers = BENEATH_JOBS_ATOMIC_LOAD(&jobs->sleepers);
+
+    if (sleepers > 0)
+    {
+        jobs->wake(&jobs->signal, (unsigned int)sleepers < pushed ? sleepers : (int)pushed);
+    }
+}
+
+BENEATH_API BENEATH_INLINE void beneath_jobs_wait_counter(beneath_jobs *jobs, beneath_job_counter *counter)
+{
+    unsigned int self = jobs->thread_index();
+    beneath_job job;
+
+    while (BENEATH_JOBS_ATOMIC_LOAD(&counter->value) != 0)
+    {
+        if (beneath_jobs_next(jobs, self, &job))
+        {
+            beneath_jobs_execute(&job, self);
+        }
+        else
+        {
+            BENEATH_JOBS_PAUSE();
+        }
+    }
+}
+
+BENEATH_API BENEATH_INLINE void beneath_jobs_range_job(void *data, unsigned int index, unsigned int thread_index)
+{
+    beneath_jobs_range *range = (beneath_jobs_range *)data;
+    unsigned int begin = index * range->batch_size;
+    unsigned int end = range->count - begin < range->batch_size ? range->count : begin + range->batch_size;
+
+    range->function(range->data, begin, end, thread_index);
+}
+
+BENEATH_API BENEATH_INLINE void beneath_jobs_parallel_for(beneath_jobs *jobs, beneath_job_range_function function, void *data, unsigned int count, unsigned int batch_size)
+{
+    beneath_jobs_range range;
+    beneath_job_counter counter = {0};
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    range.function = function;
+    range.data = data;
+    range.count = count;
+    range.batch_size = batch_size < 1 ? 1 : batch_size;
+
+    /* A single batch runs inline */
+    if (count <= range.batch_size || jobs->threads_count == 1)
+    {
+        function(data, 0, count, jobs->thread_index());
+        return;
+    }
+
+    beneath_jobs_run(jobs, beneath_jobs_range_job, &range, (count + range.batch_size - 1) / range.batch_size, &counter);
+    beneath_jobs_wait_counter(jobs, &counter);
+}
+
+#endif /* BENEATH_JOBS_H */
@@ -0,0 +1,1197 @@
+#ifndef BENEATH_MESH_IMPORT_H
+#define BENEATH_MESH_IMPORT_H
+
+#include "beneath.h"
+
+/* Mesh importers for the offline cook step (see beneath_cook.c). The application maps
+ * the cooked beneath_mesh_file at startup and never parses text.
+ *
+ * - Wavefront OBJ: v (optionally followed by r g b), vt, vn and f. Polygons are fanned,
+ *   negative (relative) indices are resolved. Corners sharing the same v/vt/vn triple
+ *   become one vertex. Objects, groups, smoothing groups and materials are ignored.
+ * - glTF 2.0 binary (.glb): the first primitive of the first mesh (triangles) with the
+ *   POSITION, NORMAL, TEXCOORD_0, TANGENT and COLOR_0 attributes and the indices, all read
+ *   from the embedded BIN chunk. Node transforms, sparse accessors and external buffers
+ *   are not supported.
+ *
+ * Nothing is allocated on the heap. The mesh arrays come from 'arena', the OBJ lookup tables
+ * from 'scratch' (a different arena) which is rolled back before returning. The source
+ * buffer is only read and does not need to be zero terminated. id and dynamic of the mesh
+ * are left to the caller.
+ */
+#define BENEATH_MESH_IMPORT_NONE 0xFFFFFFFFu
+
+#define BENEATH_MESH_IMPORT_GLB_MAGIC 0x46546C67u      /* "glTF" */
+#define BENEATH_MESH_IMPORT_GLB_CHUNK_JSON 0x4E4F534Au /* "JSON" */
+#define BENEATH_MESH_IMPORT_GLB_CHUNK_BIN 0x004E4942u  /* "BIN\0" */
+
+/* glTF accessor component types (the OpenGL enums) */
+#define BENEATH_MESH_IMPORT_GLTF_BYTE 5120
+#define BENEATH_MESH_IMPORT_GLTF_UNSIGNED_BYTE 5121
+#define BENEATH_MESH_IMPORT_GLTF_SHORT 5122
+#define BENEATH_MESH_IMPORT_GLTF_UNSIGNED_SHORT 5123
+#define BENEATH_MESH_IMPORT_GLTF_UNSIGNED_INT 5125
+#define BENEATH_MESH_IMPORT_GLTF_FLOAT 5126
+#define BENEATH_MESH_IMPORT_GLTF_TRIANGLES 4
+
+BENEATH_API BENEATH_INLINE void beneath_mesh_import_clear(beneath_mesh *mesh)
+{
+    mesh->changed = true;
+    mesh->vertices_count = 0;
+    mesh->uvs_count = 0;
+    mesh->normals_count = 0;
+    mesh->tangents_count = 0;
+    mesh->bitangents_count = 0;
+    mesh->colors_count = 0;
+    mesh->indices_count = 0;
+    mesh->vertices = (float *)0;
+    mesh->uvs = (float *)0;
+    mesh->normals = (float *)0;
+    mesh->tangents = (float *)0;
+    mesh->bitangents = (float *)0;
+    mesh->colors = (float *)0;
+    mesh->indices = (unsigned int *)0;
+    mesh->indices16 = (unsigned short *)0;
+    mesh->layout.stride = 0;
+    mesh->interleaved_count = 0;
+    mesh->interleaved = (unsigned char *)0;
+}
+
+/* #############################################################################
+ * # Text scanning
+ * #############################################################################
+ */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_import_is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_import_is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+BENEATH_API BENEATH_INLINE char *beneath_mesh_import_skip_spaces(char *at, char *end)
+{
+    while (at < end && beneath_mesh_import_is_space(*at))
+    {
+        ++at;
+    }
+
+    return at;
+}
+
+/* Start of the next line */
+BENEATH_API BENEATH_INLINE char *beneath_mesh_import_next_line(char *at, char *end)
+{
+    while (at < end && *at != '\n')
+    {
+        ++at;
+    }
+
+    return at < end ? at + 1 : end;
+}
+
+/* Decimal float without locale or strtod: up to 9 significant digits are gathered in
+ * an integer and scaled once by a power of ten, enough for float precision.
+ */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_import_parse_float(char **cursor, char *end, float *value)
+{
+    static double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                              1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    char *at = *cursor;
+    unsigned int mantissa = 0;
+    unsigned int digits = 0;
+    int exponent = 0;
+    beneath_bool negative = false;
+    beneath_bool any = false;
+    double result;
+
+    if (at < end && (*at == '-' || *at == '+'))
+    {
+        negative = *at == '-';
+        ++at;
+    }
+
+    for (; at < end && beneath_mesh_import_is_digit(*at); ++at)
+    {
+        if (digits < 9)
+        {
+            mantissa = mantissa * 10 + (unsigned int)(*at - '0');
+            digits += mantissa ? 1u : 0u;
+        }
+        else
+        {
+            exponent++;
+        }
+
+        any = true;
+    }
+
+    if (at < end && *at == '.')
+    {
+        for (++at; at < end && beneath_mesh_import_is_digit(*at); ++at)
+        {
+            if (digits < 9)
+            {
+                mantissa = mantissa * 10 + (unsigned int)(*at - '0');
+                digits += mantissa ? 1u : 0u;
+                exponent--;
+            }
+
+            any = true;
+        }
+    }
+
+    if (!any)
+    {
+        return false;
+    }
+
+    if (at < end && (*at == 'e' || *at == 'E'))
+    {
+        char *exponent_at = at + 1;
+        beneath_bool exponent_negative = false;
+        int exponent_value = 0;
+
+        if (exponent_at < end && (*exponent_at == '-' || *exponent_at == '+'))
+        {
+            exponent_negative = *exponent_at == '-';
+            ++exponent_at;
+        }
+
+        if (exponent_at < end && beneath_mesh_import_is_digit(*exponent_at))
+        {
+            for (; exponent_at < end && beneath_mesh_import_is_digit(*exponent_at); ++exponent_at)
+            {
+                if (exponent_value < 1000)
+                {
+                    exponent_value = exponent_value * 10 + (*exponent_at - '0');
+                }
+            }
+
+            exponent += exponent_negative ? -exponent_value : exponent_value;
+            at = exponent_at;
+        }
+    }
+
+    result = (double)mantissa;
+
+    for (; exponent > 22; exponent -= 22)
+    {
+        result *= powers[22];
+    }
+
+    for (; exponent < -22; exponent += 22)
+    {
+        result /= powers[22];
+    }
+
+    result = exponent < 0 ? result / powers[-exponent] : result * powers[exponent];
+
+    *value = (float)(negative ? -result : result);
+    *cursor = at;
+
+    return true;
+}
+
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_import_parse_int(char **cursor, char *end, int *value)
+{
+    char *at = *cursor;
+    beneath_bool negative = false;
+    int result = 0;
+
+    if (at < end && (*at == '-' || *at == '+'))
+    {
+        negative = *at == '-';
+        ++at;
+    }
+
+    if (at >= end || !beneath_mesh_import_is_digit(*at))
+    {
+        return false;
+    }
+
+    for (; at < end && beneath_mesh_import_is_digit(*at); ++at)
+    {
+        if (result < 100000000)
+        {
+            result = result * 10 + (*at - '0');
+        }
+    }
+
+    *value = negative ? -result : result;
+    *cursor = at;
+
+    return true;
+}
+
+/* #############################################################################
+ * # Wavefront OBJ
+ * #############################################################################
+ */
+typedef struct beneath_mesh_import_obj_counts
+{
+    unsigned int positions;
+    unsigned int uvs;
+    unsigned int normals;
+    unsigned int face_corners;     /* Corners as written in the faces */
+    unsigned int triangle_corners; /* Corners after fanning into triangles */
+    beneath_bool colors;
+
+} beneath_mesh_import_obj_counts;
+
+/* 'v', 'vt', 'vn' or 'f' keyword of a line, 0 for anything else */
+BENEATH_API BENEATH_INLINE char beneath_mesh_import_obj_keyword(char **cursor, char *end)
+{
+    char *at = beneath_mesh_import_skip_spaces(*cursor, end);
+    char keyword = 0;
+
+    if (end - at >= 2 && at[0] == 'v' && beneath_mesh_import_is_space(at[1]))
+    {
+        keyword = 'v';
+        at += 1;
+    }
+    else if (end - at >= 3 && at[0] == 'v' && (at[1] == 't' || at[1] == 'n') && beneath_mesh_import_is_space(at[2]))
+    {
+        keyword = at[1];
+        at += 2;
+    }
+    else if (end - at >= 2 && at[0] == 'f' && beneath_mesh_import_is_space(at[1]))
+    {
+        keyword = 'f';
+        at += 1;
+    }
+
+    *cursor = at;
+
+    return keyword;
+}
+
+/* Parses one face corner 'v', 'v/vt', 'v//vn' or 'v/vt/vn' into zero based indices */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_import_obj_corner(char **cursor, char *end, beneath_mesh_import_obj_counts *read, unsigned int corner[3])
+{
+    unsigned int counts[3];
+    int values[3];
+    unsigned int i;
+
+    counts[0] = read->positions;
+    counts[1] = read->uvs;
+    counts[2] = read->normals;
+
+    if (!beneath_mesh_import_parse_int(cursor, end, &values[0]))
+    {
+        return false;
+    }
+
+    values[1] = 0;
+    values[2] = 0;
+
+    for (i = 1; i < 3 && *cursor < end && **cursor == '/'; ++i)
+    {
+        ++*cursor;
+
+        /* Empty slot as in 'v//vn' */
+        if (*cursor < end && **cursor == '/')
+        {
+            continue;
+        }
+
+        if (!beneath_mesh_import_parse_int(cursor, end, &values[i]))
+        {
+            return false;
+        }
+    }
+
+    /* Positive indices are one based, negative ones count back from the last read element */
+    for (i = 0; i < 3; ++i)
+    {
+        if (values[i] > 0 && (unsigned int)values[i] <= counts[i])
+        {
+            corner[i] = (unsigned int)(values[i] - 1);
+        }
+        else if (values[i] < 0 && (unsigned int)-values[i] <= counts[i])
+        {
+            corner[i] = counts[i] - (unsigned int)-values[i];
+        }
+        else if (values[i] == 0 && i > 0)
+        {
+            corner[i] = BENEATH_MESH_IMPORT_NONE;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+BENEATH_API BENEATH_INLINE void beneath_mesh_import_obj_count(char *text, char *end, beneath_mesh_import_obj_counts *counts)
+{
+    char *line = text;
+
+    counts->positions = 0;
+    counts->uvs = 0;
+    counts->normals = 0;
+    counts->face_corners = 0;
+    counts->triangle_corners = 0;
+    counts->colors = false;
+
+    while (line < end)
+    {
+        char *at = line;
+        char keyword = beneath_mesh_import_obj_keyword(&at, end);
+
+        if (keyword == 'v')
+        {
+            unsigned int floats = 0;
+            float value;
+
+            counts->positions++;
+
+            for (at = beneath_mesh_import_skip_spaces(at, end); beneath_mesh_import_parse_float(&at, end, &value); at = beneath_mesh_import_skip_spaces(at, end))
+            {
+                floats++;
+            }
+
+            if (floats >= 6)
+            {
+                counts->colors = true;
+            }
+        }
+        else if (keyword == 't')
+        {
+            counts->uvs++;
+        }
+        else if (keyword == 'n')
+        {
+            counts->normals++;
+        }
+        else if (keyword == 'f')
+        {
+            unsigned int corners = 0;
+
+            /* Counting tokens is enough here, the second pass validates them */
+            for (at = beneath_mesh_import_skip_spaces(at, end); at < end && *at != '\n' && *at != '#'; at = beneath_mesh_import_skip_spaces(at, end))
+            {
+                while (at < end && *at != '\n' && !beneath_mesh_import_is_space(*at))
+                {
+                    ++at;
+                }
+
+                corners++;
+            }
+
+            counts->face_corners += corners;
+            counts->triangle_corners += corners >= 3 ? (corners - 2) * 3 : 0;
+        }
+
+        line = beneath_mesh_import_next_line(at, end);
+    }
+}
+
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_import_obj(beneath_mesh *mesh, char *text, unsigned int text_size, beneath_arena *arena, beneath_arena *scratch)
+{
+    beneath_arena_temp arena_temp = beneath_arena_temp_begin(arena);
+    beneath_arena_temp scratch_temp = beneath_arena_temp_begin(scratch);
+    char *end = text + text_size;
+    char *line = text;
+    beneath_mesh_import_obj_counts counts;
+    beneath_mesh_import_obj_counts read;
+    unsigned int capacity = 1;
+    unsigned int unique = 0;
+    unsigned int triangle_corners = 0;
+    unsigned int *slots;
+    unsigned int *keys;
+    unsigned int *indices;
+    float *positions;
+    float *colors;
+    float *uvs;
+    float *normals;
+    unsigned int v;
+
+    beneath_mesh_import_obj_count(text, end, &counts);
+
+    if (counts.positions == 0 || counts.triangle_corners == 0)
+    {
+        return false;
+    }
+
+    /* Open addressing over the v/vt/vn triples, at most half full, a slot holds the vertex + 1 (0 = empty) */
+    while (capacity < counts.face_corners * 2)
+    {
+        capacity *= 2;
+    }
+
+    positions = BENEATH_ARENA_PUSH_ARRAY(scratch, float, counts.positions * 3);
+    colors = counts.colors ? BENEATH_ARENA_PUSH_ARRAY(scratch, float, counts.positions * 3) : (float *)0;
+    uvs = BENEATH_ARENA_PUSH_ARRAY(scratch, float, counts.uvs * 2 + 1);
+    normals = BENEATH_ARENA_PUSH_ARRAY(scratch, float, counts.normals * 3 + 1);
+    keys = BENEATH_ARENA_PUSH_ARRAY(scratch, unsigned int, counts.face_corners * 3);
+    slots = (unsigned int *)beneath_arena_push_zero(scratch, capacity * (unsigned int)sizeof(unsigned int), BENEATH_ARENA_ALIGNMENT_DEFAULT);
+    indices = BENEATH_ARENA_PUSH_ARRAY(arena, unsigned int, counts.triangle_corners);
+
+    if (!positions || (counts.colors && !colors) || !uvs || !normals || !keys || !slots || !indices)
+    {
+        beneath_arena_temp_end(scratch_temp);
+        beneath_arena_temp_end(arena_temp);
+        return false;
+    }
+
+    read.positions = 0;
+    read.uvs = 0;
+    read.normals = 0;
+
+    while (line < end)
+    {
+        char *at = line;
+        char keyword = beneath_mesh_import_obj_keyword(&at, end);
+
+        if (keyword == 'v')
+        {
+            float values[6] = {0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+            unsigned int i;
+
+            for (i = 0, at = beneath_mesh_import_skip_spaces(at, end); i < 6 && beneath_mesh_import_parse_float(&at, end, &values[i]); ++i)
+            {
+                at = beneath_mesh_import_skip_spaces(at, end);
+            }
+
+            positions[read.positions * 3 + 0] = values[0];
+            positions[read.positions * 3 + 1] = values[1];
+            positions[read.positions * 3 + 2] = values[2];
+
+            if (colors)
+            {
+                colors[read.positions * 3 + 0] = values[3];
+                colors[read.positions * 3 + 1] = values[4];
+                colors[read.positions * 3 + 2] = values[5];
+            }
+
+            read.positions++;
+        }
+        else if (keyword == 't')
+        {
+            float *uv = uvs + read.uvs * 2;
+
+            uv[0] = 0.0f;
+            uv[1] = 0.0f;
+            at = beneath_mesh_import_skip_spaces(at, end);
+
+            if (beneath_mesh_import_parse_float(&at, end, &uv[0]))
+            {
+                at = beneath_mesh_import_skip_spaces(at, end);
+                beneath_mesh_import_parse_float(&at, end, &uv[1]);
+            }
+
+            read.uvs++;
+        }
+        else if (keyword == 'n')
+        {
+            float *normal = normals + read.normals * 3;
+            unsigned int i;
+
+            normal[0] = 0.0f;
+            normal[1] = 0.0f;
+            normal[2] = 0.0f;
+
+            for (i = 0, at = beneath_mesh_import_skip_spaces(at, end); i < 3 && beneath_mesh_import_parse_float(&at, end, &normal[i]); ++i)
+            {
+                at = beneath_mesh_import_skip_spaces(at, end);
+            }
+
+            read.normals++;
+        }
+        else if (keyword == 'f')
+        {
+            unsigned int first = 0;
+            unsigned int previous = 0;
+            unsigned int corners = 0;
+
+            for (at = beneath_mesh_import_skip_spaces(at, end); at < end && *at != '\n' && *at != '#'; at = beneath_mesh_import_skip_spaces(at, end))
+            {
+                unsigned int corner[3];
+                unsigned int hash;
+                unsigned int slot;
+                unsigned int vertex;
+
+                /* The first pass counted the same tokens, the bounds only guard against malformed corners */
+                if (!beneath_mesh_import_obj_corner(&at, end, &read, corner) || unique >= counts.face_corners ||
+                    (corners >= 2 && triangle_corners + 3 > counts.triangle_corners))
+                {
+                    beneath_arena_temp_end(scratch_temp);
+                    beneath_arena_temp_end(arena_temp);
+                    return false;
+                }
+
+                hash = ((corner[0] * 73856093u) ^ (corner[1] * 19349663u) ^ (corner[2] * 83492791u)) & (capacity - 1);
+
+                for (slot = hash; slots[slot]; slot = (slot + 1) & (capacity - 1))
+                {
+                    unsigned int *key = keys + (slots[slot] - 1) * 3;
+
+                    if (key[0] == corner[0] && key[1] == corner[1] && key[2] == corner[2])
+                    {
+                        break;
+                    }
+                }
+
+                if (!slots[slot])
+                {
+                    keys[unique * 3 + 0] = corner[0];
+                    keys[unique * 3 + 1] = corner[1];
+                    keys[unique * 3 + 2] = corner[2];
+                    slots[slot] = ++unique;
+                }
+
+                vertex = slots[slot] - 1;
+
+                if (corners == 0)
+                {
+                    first = vertex;
+                }
+                else if (corners >= 2)
+                {
+                    indices[triangle_corners++] = first;
+                    indices[triangle_corners++] = previous;
+                    indices[triangle_corners++] = vertex;
+                }
+
+                previous = vertex;
+                corners++;
+            }
+        }
+
+        line = beneath_mesh_import_next_line(at, end);
+    }
+
+    beneath_mesh_import_clear(mesh);
+
+    mesh->vertices = BENEATH_ARENA_PUSH_ARRAY(arena, float, unique * 3);
+    mesh->colors = colors ? BENEATH_ARENA_PUSH_ARRAY(arena, float, unique * 3) : (float *)0;
+    mesh->uvs = counts.uvs ? BENEATH_ARENA_PUSH_ARRAY(arena, float, unique * 2) : (float *)0;
+    mesh->normals = counts.normals ? BENEATH_ARENA_PUSH_ARRAY(arena, float, unique * 3) : (float *)0;
+
+    if (!mesh->vertices || (colors && !mesh->colors) || (counts.uvs && !mesh->uvs) || (counts.normals && !mesh->normals))
+    {
+        beneath_mesh_import_clear(mesh);
+        beneath_arena_temp_end(scratch_temp);
+        beneath_arena_temp_end(arena_temp);
+        return false;
+    }
+
+    /* Corners without uv or normal get zeros */
+    for (v = 0; v < unique; ++v)
+    {
+        unsigned int *key = keys + v * 3;
+        unsigned int c;
+
+        for (c = 0; c < 3; ++c)
+        {
+            mesh->vertices[v * 3 + c] = positions[key[0] * 3 + c];
+
+            if (mesh->colors)
+            {
+                mesh->colors[v * 3 + c] = colors[key[0] * 3 + c];
+            }
+
+            if (mesh->normals)
+            {
+                mesh->normals[v * 3 + c] = key[2] != BENEATH_MESH_IMPORT_NONE ? normals[key[2] * 3 + c] : 0.0f;
+            }
+
+            if (mesh->uvs && c < 2)
+            {
+                mesh->uvs[v * 2 + c] = key[1] != BENEATH_MESH_IMPORT_NONE ? uvs[key[1] * 2 + c] : 0.0f;
+            }
+        }
+    }
+
+    mesh->vertices_count = unique * 3;
+    mesh->colors_count = mesh->colors ? unique * 3 : 0;
+    mesh->uvs_count = mesh->uvs ? unique * 2 : 0;
+    mesh->normals_count = mesh->normals ? unique * 3 : 0;
+    mesh->indices = indices;
+    mesh->indices_count = triangle_corners;
+
+    beneath_arena_temp_end(scratch_temp);
+
+    return true;
+}
+
+/* #############################################################################
+ * # glTF 2.0 binary (.glb)
+ * #############################################################################
+ */
+BENEATH_API BENEATH_INLINE unsigned int beneath_mesh_import_u32(unsigned char *bytes)
+{
+    return (unsigned int)bytes[0] | ((unsigned int)bytes[1] << 8) | ((unsigned int)bytes[2] << 16) | ((unsigned int)bytes[3] << 24);
+}
+
+BENEATH_API BENEATH_INLINE char *beneath_mesh_import_json_skip_space(char *at, char *end)
+{
+    while (at < end && (*at == ' ' || *at == '\t' || *at == '\r' || *at == '\n'))
+    {
+        ++at;
+    }
+
+    return at;
+}
+
+/* Position after the string starting at the opening quote, 0 if unterminated */
+BENEATH_API BENEATH_INLINE char *beneath_mesh_import_json_skip_string(char *at, char *end)
+{
+    for (++at; at < end; ++at)
+    {
+        if (*at == '\\')
+        {
+            ++at;
+        }
+        else if (*at == '"')
+        {
+            return at + 1;
+        }
+    }
+
+    return (char *)0;
+}
+
+/* Position after the value starting at 'at', 0 on malformed input */
+BENEATH_API BENEATH_INLINE char *beneath_mesh_import_json_skip_value(char *at, char *end)
+{
+    unsigned int depth = 0;
+
+    at = beneath_mesh_import_json_skip_space(at, end);
+
+    if (at >= end)
+    {
+        return (char *)0;
+    }
+
+    if (*at == '"')
+    {
+        return beneath_mesh_import_json_skip_string(at, end);
+    }
+
+    if (*at != '{' && *at != '[')
+    {
+        /* Number, true, false or null */
+        while (at < end && *at != ',' && *at != '}' && *at != ']' && *at != ' ' && *at != '\t' && *at != '\r' && *at != '\n')
+        {
+            ++at;
+        }
+
+        return at;
+    }
+
+    while (at < end)
+    {
+        if (*at == '"')
+        {
+            at = beneath_mesh_import_json_skip_string(at, end);
+
+            if (!at)
+            {
+                return (char *)0;
+            }
+
+            continue;
+        }
+
+        if (*at == '{' || *at == '[')
+        {
+            depth++;
+        }
+        else if (*at == '}' || *at == ']')
+        {
+            if (--depth == 0)
+            {
+                return at + 1;
+            }
+        }
+
+        ++at;
+    }
+
+    return (char *)0;
+}
+
+/* The value of 'key' in the object starting at 'object', 0 if absent */
+BENEATH_API BENEATH_INLINE char *beneath_mesh_import_json_object_get(char *object, char *end, char *key)
+{
+    char *at = object ? beneath_mesh_import_json_skip_space(object, end) : (char *)0;
+
+    if (!at || at >= end || *at != '{')
+    {
+        return (char *)0;
+    }
+
+    for (at = beneath_mesh_import_json_skip_space(at + 1, end); at && at < end && *at == '"'; at = beneath_mesh_import_json_skip_space(at + 1, end))
+    {
+        char *name = at + 1;
+        char *name_end = beneath_mesh_import_json_skip_string(at, end);
+        unsigned int i;
+        beneath_bool match = true;
+
+        if (!name_end)
+        {
+            return (char *)0;
+        }
+
+        /* name_end - 1 is the closing quote */
+        for (i = 0; key[i] && match; ++i)
+        {
+            match = name + i < name_end - 1 && name[i] == key[i];
+        }
+
+        match = match && name + i == name_end - 1;
+
+        at = beneath_mesh_import_json_skip_space(name_end, end);
+
+        if (at >= end || *at != ':')
+        {
+            return (char *)0;
+        }
+
+        at = beneath_mesh_import_json_skip_space(at + 1, end);
+
+        if (match)
+        {
+            return at;
+        }
+
+        at = beneath_mesh_import_json_skip_value(at, end);
+        at = at ? beneath_mesh_import_json_skip_space(at, end) : (char *)0;
+
+        if (!at || at >= end || *at != ',')
+        {
+            return (char *)0;
+        }
+    }
+
+    return (char *)0;
+}
+
+/* Element 'index' of the array starting at 'array', 0 if out of range */
+BENEATH_API BENEATH_INLINE char *beneath_mesh_import_json_array_get(char *array, char *end, unsigned int index)
+{
+    char *at = array ? beneath_mesh_import_json_skip_space(array, end) : (char *)0;
+    unsigned int i;
+
+    if (!at || at >= end || *at != '[')
+    {
+        return (char *)0;
+    }
+
+    at = beneath_mesh_import_json_skip_space(at + 1, end);
+
+    if (at >= end || *at == ']')
+    {
+        return (char *)0;
+    }
+
+    for (i = 0; i < index; ++i)
+    {
+        at = beneath_mesh_import_json_skip_value(at, end);
+        at = at ? beneath_mesh_import_json_skip_space(at, end) : (char *)0;
+
+        if (!at || at >= end || *at != ',')
+        {
+            return (char *)0;
+        }
+
+        at = beneath_mesh_import_json_skip_space(at + 1, end);
+    }
+
+    return at;
+}
+
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_import_json_uint(char *value, char *end, unsigned int *result)
+{
+    unsigned int number = 0;
+
+    if (!value || value >= end || !beneath_mesh_import_is_digit(*value))
+    {
+        return false;
+    }
+
+    for (; value < end && beneath_mesh_import_is_digit(*value); ++value)
+    {
+        if (number > 429496728u)
+        {
+            return false;
+        }
+
+        number = number * 10 + (unsigned int)(*value - '0');
+    }
+
+    *result = number;
+
+    return true;
+}
+
+/* Unsigned integer member of an object, 'fallback' if absent */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_import_json_member_uint(char *object, char *end, char *key, unsigned int fallback, unsigned int *result)
+{
+    char *value = beneath_mesh_import_json_object_get(object, end, key);
+
+    if (!value)
+    {
+        *result = fallback;
+        return fallback != BENEATH_MESH_IMPORT_NONE;
+    }
+
+    return beneath_mesh_import_json_uint(value, end, result);
+}
+
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_import_json_equals(char *value, char *end, char *literal)
+{
+    unsigned int i;
+
+    for (i = 0; literal[i]; ++i)
+    {
+        if (!value || value + i >= end || value[i] != literal[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* A resolved glTF accessor inside the BIN chunk */
+typedef struct beneath_mesh_import_accessor
+{
+    unsigned char *data; /* First element */
+    unsigned int count;
+    unsigned int components; /* 1 for SCALAR up to 4 for VEC4 */
+    unsigned int component_type;
+    unsigned int stride; /* Bytes between elements */
+    beneath_bool normalized;
+
+} beneath_mesh_import_accessor;
+
+BENEATH_API BENEATH_INLINE unsigned int beneath_mesh_import_component_size(unsigned int component_type)
+{
+    switch (component_type)
+    {
+    case BENEATH_MESH_IMPORT_GLTF_BYTE:
+    case BENEATH_MESH_IMPORT_GLTF_UNSIGNED_BYTE:
+        return 1;
+    case BENEATH_MESH_IMPORT_GLTF_SHORT:
+    case BENEATH_MESH_IMPORT_GLTF_UNSIGNED_SHORT:
+        return 2;
+    case BENEATH_MESH_IMPORT_GLTF_UNSIGNED_INT:
+    case BENEATH_MESH_IMPORT_GLTF_FLOAT:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_import_accessor_get(char *json, char *end, unsigned int index, unsigned char *bin, unsigned int bin_size, beneath_mesh_import_accessor *accessor)
+{
+    char *object = beneath_mesh_import_json_array_get(beneath_mesh_import_json_object_get(json, end, "accessors"), end, index);
+    char *type = beneath_mesh_import_json_object_get(object, end, "type");
+    char *normalized = beneath_mesh_import_json_object_get(object, end, "normalized");
+    char *view;
+    unsigned int view_index;
+    unsigned int view_offset;
+    unsigned int view_length;
+    unsigned int view_stride;
+    unsigned int buffer;
+    unsigned int offset;
+    unsigned int element_size;
+
+    if (!object || !type || beneath_mesh_import_json_object_get(object, end, "sparse") ||
+        !beneath_mesh_import_json_member_uint(object, end, "bufferView", BENEATH_MESH_IMPORT_NONE, &view_index) ||
+        !beneath_mesh_import_json_member_uint(object, end, "componentType", BENEATH_MESH_IMPORT_NONE, &accessor->component_type) ||
+        !beneath_mesh_import_json_member_uint(object, end, "count", BENEATH_MESH_IMPORT_NONE, &accessor->count) ||
+        !beneath_mesh_import_json_member_uint(object, end, "byteOffset", 0, &offset))
+    {
+        return false;
+    }
+
+    if (beneath_mesh_import_json_equals(type, end, "\"SCALAR\""))
+    {
+        accessor->components = 1;
+    }
+    else if (beneath_mesh_import_json_equals(type, end, "\"VEC2\""))
+    {
+        accessor->components = 2;
+    }
+    else if (beneath_mesh_import_json_equals(type, end, "\"VEC3\""))
+    {
+        accessor->components = 3;
+    }
+    else if (beneath_mesh_import_json_equals(type, end, "\"VEC4\""))
+    {
+        accessor->components = 4;
+    }
+    else
+    {
+        return false;
+    }
+
+    accessor->normalized = beneath_mesh_import_json_equals(normalized, end, "true");
+    element_size = accessor->components * beneath_mesh_import_component_size(accessor->component_type);
+
+    view = beneath_mesh_import_json_array_get(beneath_mesh_import_json_object_get(json, end, "bufferViews"), end, view_index);
+
+    if (!view || element_size == 0 || accessor->count == 0 ||
+        !beneath_mesh_import_json_member_uint(view, end, "buffer", BENEATH_MESH_IMPORT_NONE, &buffer) ||
+        !beneath_mesh_import_json_member_uint(view, end, "byteOffset", 0, &view_offset) ||
+        !beneath_mesh_import_json_member_uint(view, end, "byteLength", BENEATH_MESH_IMPORT_NONE, &view_length) ||
+        !beneath_mesh_import_json_member_uint(view, end, "byteStride", element_size, &view_stride))
+    {
+        return false;
+    }
+
+    /* Only the embedded BIN chunk (buffer 0), every element has to lie inside the view */
+    if (buffer != 0 || view_offset > bin_size || view_length > bin_size - view_offset || view_stride < element_size ||
+        offset > view_length || element_size > view_length - offset ||
+        accessor->count - 1 > (view_length - offset - element_size) / view_stride)
+    {
+        return false;
+    }
+
+    accessor->data = bin + view_offset + offset;
+    accessor->stride = view_stride;
+
+    return true;
+}
+
+/* Component c of element i as float, normalized integers map to [0, 1] or [-1, 1] */
+BENEATH_API BENEATH_INLINE float beneath_mesh_import_accessor_float(beneath_mesh_import_accessor *accessor, unsigned int i, unsigned int c)
+{
+    unsigned char *at = accessor->data + i * accessor->stride + c * beneath_mesh_import_component_size(accessor->component_type);
+    float value;
+
+    switch (accessor->component_type)
+    {
+    case BENEATH_MESH_IMPORT_GLTF_FLOAT:
+    {
+        union
+        {
+            unsigned int u;
+            float f;
+        } bits;
+
+        bits.u = beneath_mesh_import_u32(at);
+
+        return bits.f;
+    }
+    case BENEATH_MESH_IMPORT_GLTF_UNSIGNED_BYTE:
+        value = (float)at[0];
+        return accessor->normalized ? value / 255.0f : value;
+    case BENEATH_MESH_IMPORT_GLTF_UNSIGNED_SHORT:
+        value = (float)((unsigned int)at[0] | ((unsigned int)at[1] << 8));
+        return accessor->normalized ? value / 65535.0f : value;
+    case BENEATH_MESH_IMPORT_GLTF_BYTE:
+        value = (float)(signed char)at[0];
+        value = accessor->normalized ? value / 127.0f : value;
+        return value < -1.0f && accessor->normalized ? -1.0f : value;
+    case BENEATH_MESH_IMPORT_GLTF_SHORT:
+        value = (float)(short)((unsigned int)at[0] | ((unsigned int)at[1] << 8));
+        value = accessor->normalized ? value / 32767.0f : value;
+        return value < -1.0f && accessor->normalized ? -1.0f : value;
+    case BENEATH_MESH_IMPORT_GLTF_UNSIGNED_INT:
+        return (float)beneath_mesh_import_u32(at);
+    default:
+        return 0.0f;
+    }
+}
+
+BENEATH_API BENEATH_INLINE unsigned int beneath_mesh_import_accessor_uint(beneath_mesh_import_accessor *accessor, unsigned int i)
+{
+    unsigned char *at = accessor->data + i * accessor->stride;
+
+    switch (accessor->component_type)
+    {
+    case BENEATH_MESH_IMPORT_GLTF_UNSIGNED_BYTE:
+        return at[0];
+    case BENEATH_MESH_IMPORT_GLTF_UNSIGNED_SHORT:
+        return (unsigned int)at[0] | ((unsigned int)at[1] << 8);
+    case BENEATH_MESH_IMPORT_GLTF_UNSIGNED_INT:
+        return beneath_mesh_import_u32(at);
+    default:
+        return BENEATH_MESH_IMPORT_NONE;
+    }
+}
+
+/* Copies 'components' floats per vertex of the attribute into a new array, 0 if absent or invalid */
+BENEATH_API BENEATH_INLINE float *beneath_mesh_import_glb_attribute(char *json, char *end, char *attributes, char *name, unsigned int components, unsigned int vertex_count,
+                                                                    unsigned char *bin, unsigned int bin_size, beneath_arena *arena, beneath_bool *invalid)
+{
+    beneath_mesh_import_accessor accessor;
+    unsigned int index;
+    float *result;
+    unsigned int v;
+    unsigned int c;
+
+    if (!beneath_mesh_import_json_object_get(attributes, end, name))
+    {
+        return (float *)0;
+    }
+
+    if (!beneath_mesh_import_json_member_uint(attributes, end, name, BENEATH_MESH_IMPORT_NONE, &index) ||
+        !beneath_mesh_import_accessor_get(json, end, index, bin, bin_size, &accessor) ||
+        accessor.count != vertex_count || accessor.components < components ||
+        (result = BENEATH_ARENA_PUSH_ARRAY(arena, float, vertex_count * components)) == 0)
+    {
+        *invalid = true;
+        return (float *)0;
+    }
+
+    for (v = 0; v < vertex_count; ++v)
+    {
+        for (c = 0; c < components; ++c)
+        {
+            result[v * components + c] = beneath_mesh_import_accessor_float(&accessor, v, c);
+        }
+    }
+
+    return result;
+}
+
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_import_glb(beneath_mesh *mesh, unsigned char *data, unsigned int data_size, beneath_arena *arena)
+{
+    beneath_arena_temp arena_temp = beneath_arena_temp_begin(arena);
+    beneath_mesh_import_accessor positions;
+    beneath_mesh_import_accessor tangents;
+    beneath_mesh_import_accessor indices;
+    unsigned int json_size;
+    unsigned int bin_offset;
+    unsigned int bin_size = 0;
+    unsigned char *bin = (unsigned char *)0;
+    char *json;
+    char *end;
+    char *primitive;
+    char *attributes;
+    unsigned int position_index;
+    unsigned int tangent_index;
+    unsigned int indices_index;
+    unsigned int mode;
+    beneath_bool invalid = false;
+    unsigned int i;
+
+    if (!data || data_size < 20 || beneath_mesh_import_u32(data) != BENEATH_MESH_IMPORT_GLB_MAGIC || beneath_mesh_import_u32(data + 4) != 2 ||
+        beneath_mesh_import_u32(data + 8) > data_size || beneath_mesh_import_u32(data + 16) != BENEATH_MESH_IMPORT_GLB_CHUNK_JSON)
+    {
+        return false;
+    }
+
+    data_size = beneath_mesh_import_u32(data + 8);
+    json_size = beneath_mesh_import_u32(data + 12);
+
+    if (json_size > data_size - 20)
+    {
+        return false;
+    }
+
+    json = (char *)data + 20;
+    end = json + json_size;
+
+    /* The optional BIN chunk follows the 4 byte aligned JSON chunk */
+    bin_offset = 20 + ((json_size + 3) & ~3u);
+
+    if (bin_offset <= data_size && data_size - bin_offset >= 8 && beneath_mesh_import_u32(data + bin_offset + 4) == BENEATH_MESH_IMPORT_GLB_CHUNK_BIN &&
+        beneath_mesh_import_u32(data + bin_offset) <= data_size - bin_offset - 8)
+    {
+        bin = data + bin_offset + 8;
+        bin_size = beneath_mesh_import_u32(data + bin_offset);
+    }
+
+    primitive = beneath_mesh_import_json_array_get(beneath_mesh_import_json_object_get(json, end, "meshes"), end, 0);
+    primitive = beneath_mesh_import_json_array_get(beneath_mesh_import_json_object_get(primitive, end, "primitives"), end, 0);
+    attributes = beneath_mesh_import_json_object_get(primitive, end, "attributes");
+
+    if (!bin || !attributes ||
+        !beneath_mesh_import_json_member_uint(primitive, end, "mode", BENEATH_MESH_IMPORT_GLTF_TRIANGLES, &mode) || mode != BENEATH_MESH_IMPORT_GLTF_TRIANGLES ||
+        !beneath_mesh_import_json_member_uint(attributes, end, "POSITION", BENEATH_MESH_IMPORT_NONE, &position_index) ||
+        !beneath_mesh_import_accessor_get(json, end, position_index, bin, bin_size, &positions) ||
+        positions.component_type != BENEATH_MESH_IMPORT_GLTF_FLOAT || positions.components != 3)
+    {
+        return false;
+    }
+
+    beneath_mesh_import_clear(mesh);
+
+    mesh->vertices = beneath_mesh_import_glb_attribute(json, end, attributes, "POSITION", 3, positions.count, bin, bin_size, arena, &invalid);
+    mesh->normals = beneath_mesh_import_glb_attribute(json, end, attributes, "NORMAL", 3, positions.count, bin, bin_size, arena, &invalid);
+    mesh->uvs = beneath_mesh_import_glb_attribute(json, end, attributes, "TEXCOORD_0", 2, positions.count, bin, bin_size, arena, &invalid);
+    mesh->colors = beneath_mesh_import_glb_attribute(json, end, attributes, "COLOR_0", 3, positions.count, bin, bin_size, arena, &invalid);
+    mesh->tangents = beneath_mesh_import_glb_attribute(json, end, attributes, "TANGENT", 3, positions.count, bin, bin_size, arena, &invalid);
+
+    /* Bitangents from the normal, the tangent and the handedness in tangent.w */
+    if (mesh->tangents && mesh->normals && !invalid)
+    {
+        mesh->bitangents = BENEATH_ARENA_PUSH_ARRAY(arena, float, positions.count * 3);
+
+        if (!mesh->bitangents ||
+            !beneath_mesh_import_json_member_uint(attributes, end, "TANGENT", BENEATH_MESH_IMPORT_NONE, &tangent_index) ||
+            !beneath_mesh_import_accessor_get(json, end, tangent_index, bin, bin_size, &tangents) || tangents.components != 4)
+        {
+            invalid = true;
+        }
+
+        for (i = 0; i < positions.count && !invalid; ++i)
+        {
+            float *n = mesh->normals + i * 3;
+            float *t = mesh->tangents + i * 3;
+            float w = beneath_mesh_import_accessor_float(&tangents, i, 3) < 0.0f ? -1.0f : 1.0f;
+
+            mesh->bitangents[i * 3 + 0] = (n[1] * t[2] - n[2] * t[1]) * w;
+            mesh->bitangents[i * 3 + 1] = (n[2] * t[0] - n[0] * t[2]) * w;
+            mesh->bitangents[i * 3 + 2] = (n[0] * t[1] - n[1] * t[0]) * w;
+        }
+    }
+
+    /* Non indexed primitives draw the vertices in order */
+    if (beneath_mesh_import_json_object_get(primitive, end, "indices"))
+    {
+        if (invalid ||
+            !beneath_mesh_import_json_member_uint(primitive, end, "indices", BENEATH_MESH_IMPORT_NONE, &indices_index) ||
+            !beneath_mesh_import_accessor_get(json, end, indices_index, bin, bin_size, &indices) || indices.components != 1 ||
+            (mesh->indices = BENEATH_ARENA_PUSH_ARRAY(arena, unsigned int, indices.count)) == 0)
+        {
+            invalid = true;
+        }
+
+        mesh->indices_count = invalid ? 0 : indices.count;
+
+        for (i = 0; i < mesh->indices_count && !invalid; ++i)
+        {
+            mesh->indices[i] = beneath_mesh_import_accessor_uint(&indices, i);
+            invalid = mesh->indices[i] >= positions.count;
+        }
+    }
+    else if (!invalid && (mesh->indices = BENEATH_ARENA_PUSH_ARRAY(arena, unsigned int, positions.count)) != 0)
+    {
+        mesh->indices_count = positions.count;
+
+        for (i = 0; i < positions.count; ++i)
+        {
+            mesh->indices[i] = i;
+        }
+    }
+
+    if (invalid || !mesh->vertices || !mesh->indices || mesh->indices_count % 3 != 0)
+    {
+        beneath_mesh_import_clear(mesh);
+        beneath_arena_temp_end(arena_temp);
+        return false;
+    }
+
+    mesh->vertices_count = positions.count * 3;
+    mesh->normals_count = mesh->normals ? positions.count * 3 : 0;
+    mesh->uvs_count = mesh->uvs ? positions.count * 2 : 0;
+    mesh->colors_count = mesh->colors ? positions.count * 3 : 0;
+    mesh->tangents_count = mesh->tangents ? positions.count * 3 : 0;
+    mesh->bitangents_count = mesh->bitangents ? positions.count * 3 : 0;
+
+    return true;
+}
+
+#endif /* BENEATH_MESH_IMPORT_H */
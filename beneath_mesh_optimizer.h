@@ -0,0 +1,794 @@
+#ifndef BENEATH_MESH_OPTIMIZER_H
+#define BENEATH_MESH_OPTIMIZER_H
+
+#include "beneath.h"
+#include "deps/vm.h" /* Temporary for prototype: Vector math */
+
+/* CPU mesh processing for beneath_mesh, run once at load time.
+ *
+ * - Deduplication of bitwise identical vertices over all attribute arrays
+ * - Triangle order for the post transform vertex cache (Tipsify, Sander et al. 2007)
+ * - Cluster order against overdraw: the vertex cache order is cut into clusters where
+ *   it costs at most 'threshold' times the ACMR, clusters facing away from the mesh
+ *   center are drawn first
+ * - Vertex order by first use in the index buffer for vertex fetch locality,
+ *   unreferenced vertices are dropped
+ *
+ * ACMR (average cache miss ratio) is transformed vertices per triangle, 0.5 - 3.0.
+ * ATVR (average transformed vertex ratio) is transformed vertices per referenced vertex, 1.0 is ideal.
+ * Both are measured with a FIFO cache of 'cache_size' entries.
+ *
+ * All steps work on the separate float arrays and the 32 bit indices, so they run before
+ * beneath_mesh_interleave and beneath_mesh_indices_narrow. Scratch memory comes from the
+ * given arena and is released before returning.
+ */
+#define BENEATH_MESH_OPTIMIZER_CACHE_SIZE 16           /* FIFO entries, a conservative guess for current GPUs */
+#define BENEATH_MESH_OPTIMIZER_OVERDRAW_THRESHOLD 1.05f /* Allowed ACMR increase for overdraw clusters */
+#define BENEATH_MESH_OPTIMIZER_NONE 0xFFFFFFFFu
+
+typedef struct beneath_mesh_optimizer_stats
+{
+    unsigned int vertices_before;
+    unsigned int vertices_after;
+    float acmr_before;
+    float acmr_after;
+    float atvr_before;
+    float atvr_after;
+
+} beneath_mesh_optimizer_stats;
+
+/* The present attribute arrays of a mesh */
+typedef struct beneath_mesh_optimizer_streams
+{
+    unsigned int count;
+    float *data[BENEATH_VERTEX_ATTRIBUTE_COUNT];
+    unsigned int *data_count[BENEATH_VERTEX_ATTRIBUTE_COUNT]; /* The mesh *_count field */
+    unsigned int components[BENEATH_VERTEX_ATTRIBUTE_COUNT];
+
+} beneath_mesh_optimizer_streams;
+
+BENEATH_API BENEATH_INLINE void beneath_mesh_optimizer_stream_add(beneath_mesh_optimizer_streams *streams, float *data, unsigned int *data_count, unsigned int components)
+{
+    if (data && *data_count > 0)
+    {
+        streams->data[streams->count] = data;
+        streams->data_count[streams->count] = data_count;
+        streams->components[streams->count] = components;
+        streams->count++;
+    }
+}
+
+/* Returns the vertex count, 0 if the mesh can not be processed */
+BENEATH_API BENEATH_INLINE unsigned int beneath_mesh_optimizer_streams_get(beneath_mesh *mesh, beneath_mesh_optimizer_streams *streams)
+{
+    unsigned int vertex_count = mesh->vertices_count / 3;
+    unsigned int i;
+
+    streams->count = 0;
+
+    if (!mesh->vertices || !mesh->indices || mesh->indices16 || mesh->interleaved || vertex_count == 0 || mesh->indices_count % 3 != 0)
+    {
+        return 0;
+    }
+
+    beneath_mesh_optimizer_stream_add(streams, mesh->vertices, &mesh->vertices_count, 3);
+    beneath_mesh_optimizer_stream_add(streams, mesh->uvs, &mesh->uvs_count, 2);
+    beneath_mesh_optimizer_stream_add(streams, mesh->normals, &mesh->normals_count, 3);
+    beneath_mesh_optimizer_stream_add(streams, mesh->tangents, &mesh->tangents_count, 3);
+    beneath_mesh_optimizer_stream_add(streams, mesh->bitangents, &mesh->bitangents_count, 3);
+    beneath_mesh_optimizer_stream_add(streams, mesh->colors, &mesh->colors_count, 3);
+
+    for (i = 0; i < streams->count; ++i)
+    {
+        if (*streams->data_count[i] != vertex_count * streams->components[i])
+        {
+            return 0;
+        }
+    }
+
+    for (i = 0; i < mesh->indices_count; ++i)
+    {
+        if (mesh->indices[i] >= vertex_count)
+        {
+            return 0;
+        }
+    }
+
+    return vertex_count;
+}
+
+BENEATH_API BENEATH_INLINE unsigned int beneath_mesh_optimizer_float_bits(float value)
+{
+    union
+    {
+        float f;
+        unsigned int u;
+    } bits;
+
+    bits.f = value;
+
+    return bits.u;
+}
+
+/* FIFO cache simulation by timestamps, a vertex is cached if it was transformed in the last cache_size misses */
+BENEATH_API BENEATH_INLINE unsigned int beneath_mesh_optimizer_cache_update(unsigned int *cache_time, unsigned int cache_size, unsigned int *timestamp, unsigned int *triangle)
+{
+    unsigned int misses = 0;
+    unsigned int k;
+
+    for (k = 0; k < 3; ++k)
+    {
+        if (*timestamp - cache_time[triangle[k]] > cache_size)
+        {
+            cache_time[triangle[k]] = (*timestamp)++;
+            misses++;
+        }
+    }
+
+    return misses;
+}
+
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_optimizer_analyze(beneath_mesh *mesh, unsigned int cache_size, beneath_arena *scratch, float *acmr, float *atvr)
+{
+    beneath_mesh_optimizer_streams streams;
+    beneath_arena_temp temp = beneath_arena_temp_begin(scratch);
+    unsigned int vertex_count = beneath_mesh_optimizer_streams_get(mesh, &streams);
+    unsigned int triangle_count = mesh->indices_count / 3;
+    unsigned int *cache_time;
+    unsigned int timestamp = cache_size + 1;
+    unsigned int misses = 0;
+    unsigned int referenced = 0;
+    unsigned int i;
+
+    *acmr = 0.0f;
+    *atvr = 0.0f;
+
+    if (vertex_count == 0 || triangle_count == 0)
+    {
+        return false;
+    }
+
+    cache_time = BENEATH_ARENA_PUSH_ARRAY(scratch, unsigned int, vertex_count);
+
+    if (!cache_time)
+    {
+        return false;
+    }
+
+    for (i = 0; i < vertex_count; ++i)
+    {
+        cache_time[i] = 0;
+    }
+
+    for (i = 0; i < triangle_count; ++i)
+    {
+        misses += beneath_mesh_optimizer_cache_update(cache_time, cache_size, &timestamp, &mesh->indices[i * 3]);
+    }
+
+    for (i = 0; i < vertex_count; ++i)
+    {
+        referenced += cache_time[i] != 0 ? 1u : 0u;
+    }
+
+    *acmr = (float)misses / (float)triangle_count;
+    *atvr = (float)misses / (float)referenced;
+
+    beneath_arena_temp_end(temp);
+
+    return true;
+}
+
+/* Merges bitwise identical vertices (all attributes), the first occurrence keeps its place */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_optimizer_deduplicate(beneath_mesh *mesh, beneath_arena *scratch)
+{
+    beneath_mesh_optimizer_streams streams;
+    beneath_arena_temp temp = beneath_arena_temp_begin(scratch);
+    unsigned int vertex_count = beneath_mesh_optimizer_streams_get(mesh, &streams);
+    unsigned int capacity = 1;
+    unsigned int *slots;
+    unsigned int *remap;
+    unsigned int unique = 0;
+    unsigned int v;
+    unsigned int i;
+
+    if (vertex_count == 0)
+    {
+        return false;
+    }
+
+    /* Open addressing, at most half full, a slot holds the unique index + 1 (0 = empty) */
+    while (capacity < vertex_count * 2)
+    {
+        capacity *= 2;
+    }
+
+    slots = (unsigned int *)beneath_arena_push_zero(scratch, capacity * (unsigned int)sizeof(unsigned int), BENEATH_ARENA_ALIGNMENT_DEFAULT);
+    remap = BENEATH_ARENA_PUSH_ARRAY(scratch, unsigned int, vertex_count);
+
+    if (!slots || !remap)
+    {
+        beneath_arena_temp_end(temp);
+        return false;
+    }
+
+    for (v = 0; v < vertex_count; ++v)
+    {
+        unsigned int hash = 2166136261u;
+        unsigned int slot;
+        unsigned int s;
+        unsigned int c;
+
+        for (s = 0; s < streams.count; ++s)
+        {
+            for (c = 0; c < streams.components[s]; ++c)
+            {
+                hash ^= beneath_mesh_optimizer_float_bits(streams.data[s][v * streams.components[s] + c]);
+                hash *= 16777619u;
+            }
+        }
+
+        slot = hash & (capacity - 1);
+
+        while (slots[slot])
+        {
+            unsigned int other = slots[slot] - 1;
+            beneath_bool equal = true;
+
+            for (s = 0; s < streams.count && equal; ++s)
+            {
+                for (c = 0; c < streams.components[s] && equal; ++c)
+                {
+                    equal = beneath_mesh_optimizer_float_bits(streams.data[s][v * streams.components[s] + c]) ==
+                            beneath_mesh_optimizer_float_bits(streams.data[s][other * streams.components[s] + c]);
+                }
+            }
+
+            if (equal)
+            {
+                break;
+            }
+
+            slot = (slot + 1) & (capacity - 1);
+        }
+
+        if (slots[slot])
+        {
+            remap[v] = slots[slot] - 1;
+            continue;
+        }
+
+        /* Compact in place, unique <= v so no unread vertex gets overwritten */
+        for (s = 0; s < streams.count; ++s)
+        {
+            for (c = 0; c < streams.components[s]; ++c)
+            {
+                streams.data[s][unique * streams.components[s] + c] = streams.data[s][v * streams.components[s] + c];
+            }
+        }
+
+        slots[slot] = unique + 1;
+        remap[v] = unique++;
+    }
+
+    for (i = 0; i < mesh->indices_count; ++i)
+    {
+        mesh->indices[i] = remap[mesh->indices[i]];
+    }
+
+    for (i = 0; i < streams.count; ++i)
+    {
+        *streams.data_count[i] = unique * streams.components[i];
+    }
+
+    mesh->changed = true;
+
+    beneath_arena_temp_end(temp);
+
+    return true;
+}
+
+/* Tipsify: fans around the last vertex while its neighbours are likely in the cache,
+ * falls back to recently used vertices (dead end stack) and then to the input order.
+ */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_optimizer_vertex_cache(beneath_mesh *mesh, unsigned int cache_size, beneath_arena *scratch)
+{
+    beneath_mesh_optimizer_streams streams;
+    beneath_arena_temp temp = beneath_arena_temp_begin(scratch);
+    unsigned int vertex_count = beneath_mesh_optimizer_streams_get(mesh, &streams);
+    unsigned int index_count = mesh->indices_count;
+    unsigned int triangle_count = index_count / 3;
+    unsigned int *indices = mesh->indices;
+    unsigned int *offsets;
+    unsigned int *adjacency;
+    unsigned int *live;
+    unsigned int *cache_time;
+    unsigned int *dead_end;
+    unsigned int *candidates;
+    unsigned int *output;
+    unsigned char *emitted;
+    unsigned int dead_end_size = 0;
+    unsigned int output_size = 0;
+    unsigned int timestamp = cache_size + 1;
+    unsigned int cursor = 1;
+    unsigned int fanning = 0;
+    unsigned int i;
+
+    if (vertex_count == 0 || triangle_count == 0)
+    {
+        return false;
+    }
+
+    offsets = (unsigned int *)beneath_arena_push_zero(scratch, (vertex_count + 1) * (unsigned int)sizeof(unsigned int), BENEATH_ARENA_ALIGNMENT_DEFAULT);
+    live = (unsigned int *)beneath_arena_push_zero(scratch, vertex_count * (unsigned int)sizeof(unsigned int), BENEATH_ARENA_ALIGNMENT_DEFAULT);
+    cache_time = (unsigned int *)beneath_arena_push_zero(scratch, vertex_count * (unsigned int)sizeof(unsigned int), BENEATH_ARENA_ALIGNMENT_DEFAULT);
+    emitted = (unsigned char *)beneath_arena_push_zero(scratch, triangle_count, BENEATH_ARENA_ALIGNMENT_DEFAULT);
+    adjacency = BENEATH_ARENA_PUSH_ARRAY(scratch, unsigned int, index_count);
+    dead_end = BENEATH_ARENA_PUSH_ARRAY(scratch, unsigned int, index_count);
+    candidates = BENEATH_ARENA_PUSH_ARRAY(scratch, unsigned int, index_count);
+    output = BENEATH_ARENA_PUSH_ARRAY(scratch, unsigned int, index_count);
+
+    if (!offsets || !live || !cache_time || !emitted || !adjacency || !dead_end || !candidates || !output)
+    {
+        beneath_arena_temp_end(temp);
+        return false;
+    }
+
+    /* Vertex to triangle adjacency, live holds the triangles not yet emitted per vertex */
+    for (i = 0; i < index_count; ++i)
+    {
+        live[indices[i]]++;
+    }
+
+    for (i = 0; i < vertex_count; ++i)
+    {
+        offsets[i + 1] = offsets[i] + live[i];
+    }
+
+    for (i = 0; i < index_count; ++i)
+    {
+        adjacency[offsets[indices[i]]++] = i / 3;
+    }
+
+    /* The fill moved every offset to the start of the next vertex */
+    for (i = vertex_count; i > 0; --i)
+    {
+        offsets[i] = offsets[i - 1];
+    }
+
+    offsets[0] = 0;
+
+    while (fanning != BENEATH_MESH_OPTIMIZER_NONE)
+    {
+        unsigned int candidates_size = 0;
+        unsigned int best = BENEATH_MESH_OPTIMIZER_NONE;
+        unsigned int best_priority = 0;
+
+        for (i = offsets[fanning]; i < offsets[fanning + 1]; ++i)
+        {
+            unsigned int triangle = adjacency[i];
+            unsigned int k;
+
+            if (emitted[triangle])
+            {
+                continue;
+            }
+
+            for (k = 0; k < 3; ++k)
+            {
+                unsigned int v = indices[triangle * 3 + k];
+
+                output[output_size++] = v;
+                dead_end[dead_end_size++] = v;
+                candidates[candidates_size++] = v;
+                live[v]--;
+
+                if (timestamp - cache_time[v] > cache_size)
+                {
+                    cache_time[v] = timestamp++;
+                }
+            }
+
+            emitted[triangle] = 1;
+        }
+
+        /* Prefer the oldest candidate that is still cached after its remaining triangles */
+        for (i = 0; i < candidates_size; ++i)
+        {
+            unsigned int v = candidates[i];
+            unsigned int priority = 0;
+
+            if (live[v] == 0)
+            {
+                continue;
+            }
+
+            if (timestamp - cache_time[v] + 2 * live[v] <= cache_size)
+            {
+                priority = timestamp - cache_time[v];
+            }
+
+            if (best == BENEATH_MESH_OPTIMIZER_NONE || priority > best_priority)
+            {
+                best = v;
+                best_priority = priority;
+            }
+        }
+
+        while (best == BENEATH_MESH_OPTIMIZER_NONE && dead_end_size > 0)
+        {
+            unsigned int v = dead_end[--dead_end_size];
+
+            if (live[v] > 0)
+            {
+                best = v;
+            }
+        }
+
+        while (best == BENEATH_MESH_OPTIMIZER_NONE && cursor < vertex_count)
+        {
+            if (live[cursor] > 0)
+            {
+                best = cursor;
+            }
+
+            cursor++;
+        }
+
+        fanning = best;
+    }
+
+    for (i = 0; i < index_count; ++i)
+    {
+        indices[i] = output[i];
+    }
+
+    mesh->changed = true;
+
+    beneath_arena_temp_end(temp);
+
+    return true;
+}
+
+/* Reorders clusters of the (vertex cache optimized) triangle order so that outward
+ * facing clusters come first, which lets the depth test reject more hidden fragments.
+ */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_optimizer_overdraw(beneath_mesh *mesh, unsigned int cache_size, float threshold, beneath_arena *scratch)
+{
+    beneath_mesh_optimizer_streams streams;
+    beneath_arena_temp temp = beneath_arena_temp_begin(scratch);
+    unsigned int vertex_count = beneath_mesh_optimizer_streams_get(mesh, &streams);
+    unsigned int triangle_count = mesh->indices_count / 3;
+    unsigned int *indices = mesh->indices;
+    float *positions = mesh->vertices;
+    unsigned int *cache_time;
+    unsigned int *hard;
+    unsigned int *clusters;
+    unsigned int *keys;
+    unsigned int *order;
+    unsigned int *order_swap;
+    unsigned int *output;
+    unsigned int hard_count = 0;
+    unsigned int cluster_count = 0;
+    unsigned int timestamp = 0;
+    unsigned int output_size = 0;
+    float mesh_center[3] = {0.0f, 0.0f, 0.0f};
+    unsigned int shift;
+    unsigned int i;
+
+    if (vertex_count == 0 || triangle_count == 0)
+    {
+        return false;
+    }
+
+    cache_time = (unsigned int *)beneath_arena_push_zero(scratch, vertex_count * (unsigned int)sizeof(unsigned int), BENEATH_ARENA_ALIGNMENT_DEFAULT);
+    hard = BENEATH_ARENA_PUSH_ARRAY(scratch, unsigned int, triangle_count);
+    clusters = BENEATH_ARENA_PUSH_ARRAY(scratch, unsigned int, triangle_count + 1);
+    keys = BENEATH_ARENA_PUSH_ARRAY(scratch, unsigned int, triangle_count + 1);
+    order = BENEATH_ARENA_PUSH_ARRAY(scratch, unsigned int, triangle_count + 1);
+    order_swap = BENEATH_ARENA_PUSH_ARRAY(scratch, unsigned int, triangle_count + 1);
+    output = BENEATH_ARENA_PUSH_ARRAY(scratch, unsigned int, mesh->indices_count);
+
+    if (!cache_time || !hard || !clusters || !keys || !order || !order_swap || !output)
+    {
+        beneath_arena_temp_end(temp);
+        return false;
+    }
+
+    /* Hard boundaries: a triangle missing all three vertices starts a new patch */
+    timestamp = cache_size + 1;
+
+    for (i = 0; i < triangle_count; ++i)
+    {
+        if (beneath_mesh_optimizer_cache_update(cache_time, cache_size, &timestamp, &indices[i * 3]) == 3 || i == 0)
+        {
+            hard[hard_count++] = i;
+        }
+    }
+
+    /* Soft boundaries: cut a patch as soon as the running ACMR reaches threshold * patch ACMR */
+    for (i = 0; i < hard_count; ++i)
+    {
+        unsigned int start = hard[i];
+        unsigned int end = i + 1 < hard_count ? hard[i + 1] : triangle_count;
+        unsigned int running_misses = 0;
+        unsigned int running_triangles = 0;
+        unsigned int misses = 0;
+        float cluster_threshold;
+        unsigned int t;
+
+        timestamp += cache_size + 1;
+
+        for (t = start; t < end; ++t)
+        {
+            misses += beneath_mesh_optimizer_cache_update(cache_time, cache_size, &timestamp, &indices[t * 3]);
+        }
+
+        cluster_threshold = threshold * (float)misses / (float)(end - start);
+        clusters[cluster_count++] = start;
+        timestamp += cache_size + 1;
+
+        for (t = start; t < end; ++t)
+        {
+            running_misses += beneath_mesh_optimizer_cache_update(cache_time, cache_size, &timestamp, &indices[t * 3]);
+            running_triangles++;
+
+            if ((float)running_misses / (float)running_triangles <= cluster_threshold)
+            {
+                clusters[cluster_count++] = t + 1;
+                timestamp += cache_size + 1;
+                running_misses = 0;
+                running_triangles = 0;
+            }
+        }
+
+        /* The last cut leaves a short bad cluster (or an empty one at end), merge it into the previous */
+        if (clusters[cluster_count - 1] != start)
+        {
+            cluster_count--;
+        }
+    }
+
+    for (i = 0; i < mesh->indices_count; ++i)
+    {
+        mesh_center[0] += positions[indices[i] * 3 + 0];
+        mesh_center[1] += positions[indices[i] * 3 + 1];
+        mesh_center[2] += positions[indices[i] * 3 + 2];
+    }
+
+    mesh_center[0] /= (float)mesh->indices_count;
+    mesh_center[1] /= (float)mesh->indices_count;
+    mesh_center[2] /= (float)mesh->indices_count;
+
+    /* Sort key: how far the area weighted cluster center lies along the average cluster normal */
+    for (i = 0; i < cluster_count; ++i)
+    {
+        unsigned int start = clusters[i];
+        unsigned int end = i + 1 < cluster_count ? clusters[i + 1] : triangle_count;
+        float center[3] = {0.0f, 0.0f, 0.0f};
+        float normal[3] = {0.0f, 0.0f, 0.0f};
+        float area_sum = 0.0f;
+        float normal_length;
+        float dot;
+        unsigned int bits;
+        unsigned int t;
+        unsigned int c;
+
+        for (t = start; t < end; ++t)
+        {
+            float *p0 = &positions[indices[t * 3 + 0] * 3];
+            float *p1 = &positions[indices[t * 3 + 1] * 3];
+            float *p2 = &positions[indices[t * 3 + 2] * 3];
+            float e1[3];
+            float e2[3];
+            float n[3];
+            float area;
+
+            for (c = 0; c < 3; ++c)
+            {
+                e1[c] = p1[c] - p0[c];
+                e2[c] = p2[c] - p0[c];
+            }
+
+            n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+            n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+            n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+            area = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];
+            area = area > 0.0f ? vm_sqrtf(area) : 0.0f;
+
+            for (c = 0; c < 3; ++c)
+            {
+                center[c] += (p0[c] + p1[c] + p2[c]) * (area / 3.0f);
+                normal[c] += n[c];
+            }
+
+            area_sum += area;
+        }
+
+        normal_length = normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2];
+        normal_length = normal_length > 0.0f ? vm_sqrtf(normal_length) : 0.0f;
+        dot = 0.0f;
+
+        for (c = 0; c < 3; ++c)
+        {
+            center[c] = area_sum > 0.0f ? center[c] / area_sum : 0.0f;
+            dot += (center[c] - mesh_center[c]) * (normal_length > 0.0f ? normal[c] / normal_length : 0.0f);
+        }
+
+        /* Float to order preserving unsigned, inverted for a descending sort */
+        bits = beneath_mesh_optimizer_float_bits(dot);
+        bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+        keys[i] = ~bits;
+        order[i] = i;
+    }
+
+    /* Stable LSD radix sort of the cluster order, 8 bits per pass */
+    for (shift = 0; shift < 32; shift += 8)
+    {
+        unsigned int histogram[256];
+        unsigned int sum = 0;
+        unsigned int *swap;
+
+        for (i = 0; i < 256; ++i)
+        {
+            histogram[i] = 0;
+        }
+
+        for (i = 0; i < cluster_count; ++i)
+        {
+            histogram[(keys[order[i]] >> shift) & 0xFFu]++;
+        }
+
+        for (i = 0; i < 256; ++i)
+        {
+            unsigned int count = histogram[i];
+            histogram[i] = sum;
+            sum += count;
+        }
+
+        for (i = 0; i < cluster_count; ++i)
+        {
+            order_swap[histogram[(keys[order[i]] >> shift) & 0xFFu]++] = order[i];
+        }
+
+        swap = order;
+        order = order_swap;
+        order_swap = swap;
+    }
+
+    for (i = 0; i < cluster_count; ++i)
+    {
+        unsigned int cluster = order[i];
+        unsigned int start = clusters[cluster] * 3;
+        unsigned int end = cluster + 1 < cluster_count ? clusters[cluster + 1] * 3 : mesh->indices_count;
+        unsigned int j;
+
+        for (j = start; j < end; ++j)
+        {
+            output[output_size++] = indices[j];
+        }
+    }
+
+    for (i = 0; i < mesh->indices_count; ++i)
+    {
+        indices[i] = output[i];
+    }
+
+    mesh->changed = true;
+
+    beneath_arena_temp_end(temp);
+
+    return true;
+}
+
+/* Renumbers vertices in first use order of the index buffer, unreferenced vertices are dropped */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_optimizer_vertex_fetch(beneath_mesh *mesh, beneath_arena *scratch)
+{
+    beneath_mesh_optimizer_streams streams;
+    beneath_arena_temp temp = beneath_arena_temp_begin(scratch);
+    unsigned int vertex_count = beneath_mesh_optimizer_streams_get(mesh, &streams);
+    unsigned int *remap;
+    unsigned int next = 0;
+    unsigned int i;
+    unsigned int s;
+
+    if (vertex_count == 0)
+    {
+        return false;
+    }
+
+    remap = BENEATH_ARENA_PUSH_ARRAY(scratch, unsigned int, vertex_count);
+
+    if (!remap)
+    {
+        beneath_arena_temp_end(temp);
+        return false;
+    }
+
+    for (i = 0; i < vertex_count; ++i)
+    {
+        remap[i] = BENEATH_MESH_OPTIMIZER_NONE;
+    }
+
+    for (i = 0; i < mesh->indices_count; ++i)
+    {
+        unsigned int v = mesh->indices[i];
+
+        if (remap[v] == BENEATH_MESH_OPTIMIZER_NONE)
+        {
+            remap[v] = next++;
+        }
+
+        mesh->indices[i] = remap[v];
+    }
+
+    for (s = 0; s < streams.count; ++s)
+    {
+        unsigned int components = streams.components[s];
+        unsigned int size = vertex_count * components;
+        float *copy = BENEATH_ARENA_PUSH_ARRAY(scratch, float, size);
+        unsigned int c;
+
+        if (!copy)
+        {
+            /* Indices are already remapped, a partial result would be corrupt */
+            beneath_arena_temp_end(temp);
+            return false;
+        }
+
+        for (i = 0; i < size; ++i)
+        {
+            copy[i] = streams.data[s][i];
+        }
+
+        for (i = 0; i < vertex_count; ++i)
+        {
+            if (remap[i] == BENEATH_MESH_OPTIMIZER_NONE)
+            {
+                continue;
+            }
+
+            for (c = 0; c < components; ++c)
+            {
+                streams.data[s][remap[i] * components + c] = copy[i * components + c];
+            }
+        }
+
+        *streams.data_count[s] = next * components;
+    }
+
+    mesh->changed = true;
+
+    beneath_arena_temp_end(temp);
+
+    return true;
+}
+
+/* Runs the whole pipeline, stats (optional) receives the vertex counts and ACMR/ATVR before and after */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_optimize(beneath_mesh *mesh, beneath_arena *scratch, beneath_mesh_optimizer_stats *stats)
+{
+    beneath_mesh_optimizer_stats result;
+    unsigned int cache_size = BENEATH_MESH_OPTIMIZER_CACHE_SIZE;
+
+    result.vertices_before = mesh->vertices_count / 3;
+
+    if (!beneath_mesh_optimizer_analyze(mesh, cache_size, scratch, &result.acmr_before, &result.atvr_before) ||
+        !beneath_mesh_optimizer_deduplicate(mesh, scratch) ||
+        !beneath_mesh_optimizer_vertex_cache(mesh, cache_size, scratch) ||
+        !beneath_mesh_optimizer_overdraw(mesh, cache_size, BENEATH_MESH_OPTIMIZER_OVERDRAW_THRESHOLD, scratch) ||
+        !beneath_mesh_optimizer_vertex_fetch(mesh, scratch) ||
+        !beneath_mesh_optimizer_analyze(mesh, cache_size, scratch, &result.acmr_after, &result.atvr_after))
+    {
+        return false;
+    }
+
+    result.vertices_after = mesh->vertices_count / 3;
+
+    if (stats)
+    {
+        *stats = result;
+    }
+
+    return true;
+}
+
+#endif /* BENEATH_MESH_OPTIMIZER_H */
@@ -0,0 +1,505 @@
+#ifndef BENEATH_MESH_SIMPLIFIER_H
+#define BENEATH_MESH_SIMPLIFIER_H
+
+#include "beneath.h"
+#include "beneath_mesh_optimizer.h"
+
+/* Quadric edge collapse simplification for LOD chains (Garland and Heckbert 1997).
+ *
+ * Every vertex position holds the sum of the plane quadrics of its triangles. Collapsing an
+ * edge moves one vertex onto the other and costs the quadric error of both at the kept position.
+ * Collapses run in passes: the edges are sorted by cost and taken greedily, the vertices around
+ * a collapse are frozen until the next pass so the adjacency stays valid. Collapses that flip
+ * a triangle are rejected.
+ *
+ * Vertices on open borders and attribute seams (the same position with other uvs, normals, ...)
+ * never move, others may collapse onto them. Vertices only move onto existing vertices, so the
+ * result stays inside the bounds of the source mesh and keeps its attributes.
+ *
+ * The error is the square root of the largest accepted quadric error, a distance in object units
+ * (the sum of squared distances to the original planes around the vertex, so an upper estimate).
+ *
+ * Works on the separate float arrays and the 32 bit indices like beneath_mesh_optimize.
+ * Scratch memory comes from the given arena and is released before returning.
+ */
+#define BENEATH_MESH_SIMPLIFIER_PASSES_MAX 64
+#define BENEATH_MESH_SIMPLIFIER_LOCKED 1u /* Border or seam vertex */
+#define BENEATH_MESH_SIMPLIFIER_FROZEN 2u /* Touched by a collapse in this pass */
+
+typedef struct beneath_mesh_simplifier_collapse
+{
+    unsigned int from;
+    unsigned int to;
+    float cost;
+
+} beneath_mesh_simplifier_collapse;
+
+/* Adds the plane ax + by + cz + d = 0 to the symmetric quadric a2 ab ac ad b2 bc bd c2 cd d2 */
+BENEATH_API BENEATH_INLINE void beneath_mesh_simplifier_quadric_add(double *q, double a, double b, double c, double d)
+{
+    q[0] += a * a;
+    q[1] += a * b;
+    q[2] += a * c;
+    q[3] += a * d;
+    q[4] += b * b;
+    q[5] += b * c;
+    q[6] += b * d;
+    q[7] += c * c;
+    q[8] += c * d;
+    q[9] += d * d;
+}
+
+/* Error of the summed quadrics q0 + q1 at the position p */
+BENEATH_API BENEATH_INLINE double beneath_mesh_simplifier_quadric_error(double *q0, double *q1, float *p)
+{
+    double q[10];
+    double x = (double)p[0];
+    double y = (double)p[1];
+    double z = (double)p[2];
+    double error;
+    int i;
+
+    for (i = 0; i < 10; ++i)
+    {
+        q[i] = q0[i] + q1[i];
+    }
+
+    error = q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x +
+            q[4] * y * y + 2.0 * q[5] * y * z + 2.0 * q[6] * y +
+            q[7] * z * z + 2.0 * q[8] * z +
+            q[9];
+
+    /* Rounding can go slightly below zero for exact fits */
+    return error > 0.0 ? error : 0.0;
+}
+
+/* Unnormalized normal of the triangle a b c */
+BENEATH_API BENEATH_INLINE void beneath_mesh_simplifier_normal(float *a, float *b, float *c, float normal[3])
+{
+    float u[3];
+    float v[3];
+    int i;
+
+    for (i = 0; i < 3; ++i)
+    {
+        u[i] = b[i] - a[i];
+        v[i] = c[i] - a[i];
+    }
+
+    normal[0] = u[1] * v[2] - u[2] * v[1];
+    normal[1] = u[2] * v[0] - u[0] * v[2];
+    normal[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+/* Vertex to triangle adjacency in offsets (vertex_count + 1) and adjacency (index_count) */
+BENEATH_API BENEATH_INLINE void beneath_mesh_simplifier_adjacency(unsigned int *indices, unsigned int index_count, unsigned int vertex_count, unsigned int *offsets, unsigned int *adjacency)
+{
+    unsigned int i;
+
+    for (i = 0; i <= vertex_count; ++i)
+    {
+        offsets[i] = 0;
+    }
+
+    for (i = 0; i < index_count; ++i)
+    {
+        offsets[indices[i] + 1]++;
+    }
+
+    for (i = 0; i < vertex_count; ++i)
+    {
+        offsets[i + 1] += offsets[i];
+    }
+
+    for (i = 0; i < index_count; ++i)
+    {
+        adjacency[offsets[indices[i]]++] = i / 3;
+    }
+
+    /* The fill moved every offset to the start of the next vertex */
+    for (i = vertex_count; i > 0; --i)
+    {
+        offsets[i] = offsets[i - 1];
+    }
+
+    offsets[0] = 0;
+}
+
+/* Sorts the collapses by cost, LSD radix sort over the float bits (costs are never negative) */
+BENEATH_API BENEATH_INLINE void beneath_mesh_simplifier_sort(beneath_mesh_simplifier_collapse *collapses, beneath_mesh_simplifier_collapse *temp, unsigned int count)
+{
+    unsigned int histogram[256];
+    unsigned int shift;
+    unsigned int i;
+
+    for (shift = 0; shift < 32; shift += 8)
+    {
+        beneath_mesh_simplifier_collapse *swap;
+        unsigned int sum = 0;
+
+        for (i = 0; i < 256; ++i)
+        {
+            histogram[i] = 0;
+        }
+
+        for (i = 0; i < count; ++i)
+        {
+            histogram[(beneath_mesh_optimizer_float_bits(collapses[i].cost) >> shift) & 0xFF]++;
+        }
+
+        for (i = 0; i < 256; ++i)
+        {
+            unsigned int bucket = histogram[i];
+            histogram[i] = sum;
+            sum += bucket;
+        }
+
+        for (i = 0; i < count; ++i)
+        {
+            temp[histogram[(beneath_mesh_optimizer_float_bits(collapses[i].cost) >> shift) & 0xFF]++] = collapses[i];
+        }
+
+        /* Four passes, the sorted result ends up back in collapses */
+        swap = collapses;
+        collapses = temp;
+        temp = swap;
+    }
+}
+
+/* Reduces the mesh to at most target_indices_count indices where the error stays within
+ * target_error (object units). Stops earlier if no edge can collapse anymore, so the result
+ * can stay above the target. lod_error receives the error, unreferenced vertices are dropped.
+ */
+BENEATH_API BENEATH_INLINE beneath_bool beneath_mesh_simplify(beneath_mesh *mesh, unsigned int target_indices_count, float target_error, beneath_arena *scratch)
+{
+    beneath_mesh_optimizer_streams streams;
+    beneath_arena_temp temp = beneath_arena_temp_begin(scratch);
+    unsigned int vertex_count = beneath_mesh_optimizer_streams_get(mesh, &streams);
+    unsigned int index_count = mesh->indices_count;
+    unsigned int *indices = mesh->indices;
+    float *positions = mesh->vertices;
+    double error_limit = (double)target_error * (double)target_error;
+    double error_max = 0.0;
+    float error;
+    double *quadrics;
+    unsigned int *positions_first; /* First vertex with the same position, owns the quadric */
+    unsigned int *remap;
+    unsigned int *offsets;
+    unsigned int *adjacency;
+    unsigned int *slots;
+    unsigned char *flags;
+    beneath_mesh_simplifier_collapse *collapses;
+    beneath_mesh_simplifier_collapse *collapses_temp;
+    unsigned int capacity = 1;
+    unsigned int pass;
+    unsigned int v;
+    unsigned int i;
+
+    if (vertex_count == 0 || index_count == 0)
+    {
+        return false;
+    }
+
+    while (capacity < vertex_count * 2)
+    {
+        capacity *= 2;
+    }
+
+    quadrics = (double *)beneath_arena_push_zero(scratch, vertex_count * 10 * (unsigned int)sizeof(double), BENEATH_ARENA_ALIGNMENT_DEFAULT);
+    slots = (unsigned int *)beneath_arena_push_zero(scratch, capacity * (unsigned int)sizeof(unsigned int), BENEATH_ARENA_ALIGNMENT_DEFAULT);
+    flags = (unsigned char *)beneath_arena_push_zero(scratch, vertex_count, BENEATH_ARENA_ALIGNMENT_DEFAULT);
+    positions_first = BENEATH_ARENA_PUSH_ARRAY(scratch, unsigned int, vertex_count);
+    remap = BENEATH_ARENA_PUSH_ARRAY(scratch, unsigned int, vertex_count);
+    offsets = BENEATH_ARENA_PUSH_ARRAY(scratch, unsigned int, vertex_count + 1);
+    adjacency = BENEATH_ARENA_PUSH_ARRAY(scratch, unsigned int, index_count);
+    collapses = BENEATH_ARENA_PUSH_ARRAY(scratch, beneath_mesh_simplifier_collapse, index_count);
+    collapses_temp = BENEATH_ARENA_PUSH_ARRAY(scratch, beneath_mesh_simplifier_collapse, index_count);
+
+    if (!quadrics || !slots || !flags || !positions_first || !remap || !offsets || !adjacency || !collapses || !collapses_temp)
+    {
+        beneath_arena_temp_end(temp);
+        return false;
+    }
+
+    /* Seams: vertices sharing a position (open addressing like the deduplication, slot = vertex + 1) */
+    for (v = 0; v < vertex_count; ++v)
+    {
+        float *p = &positions[v * 3];
+        unsigned int hash = 2166136261u;
+        unsigned int slot;
+
+        for (i = 0; i < 3; ++i)
+        {
+            hash ^= beneath_mesh_optimizer_float_bits(p[i]);
+            hash *= 16777619u;
+        }
+
+        slot = hash & (capacity - 1);
+
+        while (slots[slot])
+        {
+            float *other = &positions[(slots[slot] - 1) * 3];
+
+            if (beneath_mesh_optimizer_float_bits(p[0]) == beneath_mesh_optimizer_float_bits(other[0]) &&
+                beneath_mesh_optimizer_float_bits(p[1]) == beneath_mesh_optimizer_float_bits(other[1]) &&
+                beneath_mesh_optimizer_float_bits(p[2]) == beneath_mesh_optimizer_float_bits(other[2]))
+            {
+                break;
+            }
+
+            slot = (slot + 1) & (capacity - 1);
+        }
+
+        if (slots[slot])
+        {
+            positions_first[v] = slots[slot] - 1;
+            flags[v] |= BENEATH_MESH_SIMPLIFIER_LOCKED;
+            flags[positions_first[v]] |= BENEATH_MESH_SIMPLIFIER_LOCKED;
+        }
+        else
+        {
+            slots[slot] = v + 1;
+            positions_first[v] = v;
+        }
+
+        remap[v] = v;
+    }
+
+    /* Plane quadrics, summed per position so seam vertices see the triangles of all their copies */
+    for (i = 0; i + 2 < index_count; i += 3)
+    {
+        float *p = &positions[indices[i] * 3];
+        float normal[3];
+        float length;
+        double d;
+        unsigned int k;
+
+        beneath_mesh_simplifier_normal(&positions[indices[i] * 3], &positions[indices[i + 1] * 3], &positions[indices[i + 2] * 3], normal);
+        length = normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2];
+
+        if (length <= 0.0f)
+        {
+            continue;
+        }
+
+        length = vm_sqrtf(length);
+        normal[0] /= length;
+        normal[1] /= length;
+        normal[2] /= length;
+        d = -(double)(normal[0] * p[0] + normal[1] * p[1] + normal[2] * p[2]);
+
+        for (k = 0; k < 3; ++k)
+        {
+            beneath_mesh_simplifier_quadric_add(&quadrics[positions_first[indices[i + k]] * 10], (double)normal[0], (double)normal[1], (double)normal[2], d);
+        }
+    }
+
+    /* Borders: an edge used by a single triangle of the vertex */
+    beneath_mesh_simplifier_adjacency(indices, index_count, vertex_count, offsets, adjacency);
+
+    for (v = 0; v < vertex_count; ++v)
+    {
+        unsigned int a;
+
+        for (a = offsets[v]; a < offsets[v + 1] && !(flags[v] & BENEATH_MESH_SIMPLIFIER_LOCKED); ++a)
+        {
+            unsigned int *triangle = &indices[adjacency[a] * 3];
+            unsigned int k;
+
+            for (k = 0; k < 3; ++k)
+            {
+                unsigned int uses = 0;
+                unsigned int b;
+
+                if (triangle[k] == v)
+                {
+                    continue;
+                }
+
+                for (b = offsets[v]; b < offsets[v + 1]; ++b)
+                {
+                    unsigned int *other = &indices[adjacency[b] * 3];
+                    uses += (other[0] == triangle[k] || other[1] == triangle[k] || other[2] == triangle[k]) ? 1u : 0u;
+                }
+
+                if (uses == 1)
+                {
+                    flags[v] |= BENEATH_MESH_SIMPLIFIER_LOCKED;
+                }
+            }
+        }
+    }
+
+    for (pass = 0; pass < BENEATH_MESH_SIMPLIFIER_PASSES_MAX && index_count > target_indices_count; ++pass)
+    {
+        unsigned int collapses_count = 0;
+        unsigned int triangles_removed = 0;
+        unsigned int triangles_excess = (index_count - target_indices_count + 2) / 3;
+        unsigned int collapsed = 0;
+        unsigned int kept = 0;
+        unsigned int j;
+
+        if (pass > 0)
+        {
+            beneath_mesh_simplifier_adjacency(indices, index_count, vertex_count, offsets, adjacency);
+        }
+
+        /* One candidate per edge (the triangle holding it in ascending order), the cheaper movable direction */
+        for (i = 0; i < index_count; ++i)
+        {
+            unsigned int a = indices[i];
+            unsigned int b = indices[i % 3 == 2 ? i - 2 : i + 1];
+            double cost_ab;
+            double cost_ba;
+
+            if (a > b || ((flags[a] & flags[b]) & BENEATH_MESH_SIMPLIFIER_LOCKED))
+            {
+                continue;
+            }
+
+            cost_ab = (flags[a] & BENEATH_MESH_SIMPLIFIER_LOCKED) ? -1.0 : beneath_mesh_simplifier_quadric_error(&quadrics[positions_first[a] * 10], &quadrics[positions_first[b] * 10], &positions[b * 3]);
+            cost_ba = (flags[b] & BENEATH_MESH_SIMPLIFIER_LOCKED) ? -1.0 : beneath_mesh_simplifier_quadric_error(&quadrics[positions_first[b] * 10], &quadrics[positions_first[a] * 10], &positions[a * 3]);
+
+            if (cost_ba < 0.0 || (cost_ab >= 0.0 && cost_ab <= cost_ba))
+            {
+                collapses[collapses_count].from = a;
+                collapses[collapses_count].to = b;
+                collapses[collapses_count].cost = (float)cost_ab;
+            }
+            else
+            {
+                collapses[collapses_count].from = b;
+                collapses[collapses_count].to = a;
+                collapses[collapses_count].cost = (float)cost_ba;
+            }
+
+            collapses_count++;
+        }
+
+        beneath_mesh_simplifier_sort(collapses, collapses_temp, collapses_count);
+
+        for (j = 0; j < collapses_count && triangles_removed < triangles_excess; ++j)
+        {
+            beneath_mesh_simplifier_collapse *collapse = &collapses[j];
+            unsigned int from = collapse->from;
+            unsigned int to = collapse->to;
+            unsigned int removed = 0;
+            beneath_bool flips = false;
+            unsigned int a;
+            unsigned int k;
+
+            if ((double)collapse->cost > error_limit)
+            {
+                break;
+            }
+
+            if ((flags[from] | flags[to]) & BENEATH_MESH_SIMPLIFIER_FROZEN)
+            {
+                continue;
+            }
+
+            for (a = offsets[from]; a < offsets[from + 1] && !flips; ++a)
+            {
+                unsigned int *triangle = &indices[adjacency[a] * 3];
+                float *p[3];
+                float before[3];
+                float after[3];
+
+                /* Triangles on the edge vanish */
+                if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+                {
+                    removed++;
+                    continue;
+                }
+
+                for (k = 0; k < 3; ++k)
+                {
+                    p[k] = &positions[triangle[k] * 3];
+                }
+
+                beneath_mesh_simplifier_normal(p[0], p[1], p[2], before);
+
+                for (k = 0; k < 3; ++k)
+                {
+                    p[k] = &positions[(triangle[k] == from ? to : triangle[k]) * 3];
+                }
+
+                beneath_mesh_simplifier_normal(p[0], p[1], p[2], after);
+
+                {
+                    float dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+                    float length_after = after[0] * after[0] + after[1] * after[1] + after[2] * after[2];
+                    float length_before = before[0] * before[0] + before[1] * before[1] + before[2] * before[2];
+
+                    flips = dot < 0.0f || (length_after <= 0.0f && length_before > 0.0f);
+                }
+            }
+
+            if (flips)
+            {
+                continue;
+            }
+
+            /* from is not on a seam, its quadric is its own */
+            for (k = 0; k < 10; ++k)
+            {
+                quadrics[positions_first[to] * 10 + k] += quadrics[from * 10 + k];
+            }
+
+            for (a = offsets[from]; a < offsets[from + 1]; ++a)
+            {
+                unsigned int *triangle = &indices[adjacency[a] * 3];
+
+                flags[triangle[0]] |= BENEATH_MESH_SIMPLIFIER_FROZEN;
+                flags[triangle[1]] |= BENEATH_MESH_SIMPLIFIER_FROZEN;
+                flags[triangle[2]] |= BENEATH_MESH_SIMPLIFIER_FROZEN;
+            }
+
+            remap[from] = to;
+            error_max = (double)collapse->cost > error_max ? (double)collapse->cost : error_max;
+            triangles_removed += removed;
+            collapsed++;
+        }
+
+        if (collapsed == 0)
+        {
+            break;
+        }
+
+        /* Apply the collapses and drop the triangles that became degenerate */
+        for (i = 0; i + 2 < index_count; i += 3)
+        {
+            unsigned int a = remap[indices[i]];
+            unsigned int b = remap[indices[i + 1]];
+            unsigned int c = remap[indices[i + 2]];
+
+            if (a == b || b == c || a == c)
+            {
+                continue;
+            }
+
+            indices[kept++] = a;
+            indices[kept++] = b;
+            indices[kept++] = c;
+        }
+
+        index_count = kept;
+
+        for (v = 0; v < vertex_count; ++v)
+        {
+            remap[v] = v;
+            flags[v] &= (unsigned char)~BENEATH_MESH_SIMPLIFIER_FROZEN;
+        }
+    }
+
+    mesh->indices_count = index_count;
+    error = error_max > 0.0 ? vm_sqrtf((float)error_max) : 0.0f;
+    mesh->lod_error = error > mesh->lod_error ? error : mesh->lod_error;
+    mesh->changed = true;
+
+    beneath_arena_temp_end(temp);
+
+    return beneath_mesh_optimizer_vertex_fetch(mesh, scratch) && beneath_mesh_bounds_compute(mesh);
+}
+
+#endif /* BENEATH_MESH_SIMPLIFIER_H */
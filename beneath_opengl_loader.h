@@ -0,0 +1,409 @@
+#ifndef BENEATH_OPENGL_LOADER_H
+#define BENEATH_OPENGL_LOADER_H
+
+/* Platform independent OpenGL 3.3 core definitions and function pointers.
+ * The platform layer provides a function that resolves a single symbol by name
+ * (wglGetProcAddress, eglGetProcAddress, ...) and passes it to beneath_opengl_load_functions.
+ */
+#ifndef NULL
+#define NULL ((void *)0)
+#endif
+
+/* #############################################################################
+ * # [Section] OpenGL Functions
+ * #############################################################################
+ */
+#define GL_DEPTH_COMPONENT 0x1902
+#define GL_ALPHA 0x1906
+#define GL_RGB 0x1907
+#define GL_RGBA 0x1908
+#define GL_FRAMEBUFFER_UNDEFINED 0x8219
+#define GL_DEPTH_STENCIL_ATTACHMENT 0x821A
+#define GL_DEPTH24_STENCIL8 0x88F0
+#define GL_VENDOR 0x1F00
+#define GL_RENDERER 0x1F01
+#define GL_VERSION 0x1F02
+#define GL_EXTENSIONS 0x1F03
+#define GL_COLOR_BUFFER_BIT 0x00004000
+#define GL_SAMPLES_PASSED 0x8914
+#define GL_ANY_SAMPLES_PASSED 0x8C2F
+#define GL_QUERY_RESULT 0x8866
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_LINK_STATUS 0x8B82
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_STATIC_DRAW 0x88E4
+#define GL_DYNAMIC_DRAW 0x88E8
+#define GL_INT 0x1404
+#define GL_FLOAT 0x1406
+#define GL_HALF_FLOAT 0x140B
+#define GL_INT_2_10_10_10_REV 0x8D9F
+#define GL_TRUE 1
+#define GL_FALSE 0
+#define GL_TRIANGLES 0x0004
+#define GL_TRIANGLE_STRIP 0x0005
+#define GL_DEPTH_TEST 0x0B71
+#define GL_MULTISAMPLE 0x809D
+#define GL_DEPTH_BUFFER_BIT 0x00000100
+#define GL_FRONT_AND_BACK 0x0408
+#define GL_LINE 0x1B01
+#define GL_FILL 0x1B02
+#define GL_CULL_FACE 0x0B44
+#define GL_FRONT 0x0404
+#define GL_BACK 0x0405
+#define GL_CCW 0x0901
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_UNIFORM_BUFFER 0x8A11
+#define GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT 0x8A34
+#define GL_INVALID_INDEX 0xFFFFFFFFu
+#define GL_UNSIGNED_SHORT 0x1403
+#define GL_UNSIGNED_INT 0x1405
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_FRAMEBUFFER 0x8D40
+#define GL_DEPTH_ATTACHMENT 0x8D00
+#define GL_DEPTH_COMPONENT 0x1902
+#define GL_TEXTURE_2D 0x0DE1
+#define GL_RGBA 0x1908
+#define GL_RED 0x1903
+#define GL_UNSIGNED_BYTE 0x1401
+#define GL_TEXTURE_MIN_FILTER 0x2801
+#define GL_TEXTURE_MAG_FILTER 0x2800
+#define GL_LINEAR 0x2601
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#define GL_RENDERBUFFER 0x8D41
+#define GL_DEPTH_COMPONENT24 0x81A6
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#define GL_NEAREST 0x2600
+#define GL_NONE 0
+#define GL_TEXTURE_WRAP_S 0x2802
+#define GL_TEXTURE_WRAP_T 0x2803
+#define GL_CLAMP_TO_BORDER 0x812D
+#define GL_CLAMP_TO_EDGE 0x812F
+#define GL_TEXTURE_BORDER_COLOR 0x1004
+#define GL_TEXTURE0 0x84C0
+#define GL_TEXTURE1 0x84C1
+#define GL_TEXTURE2 0x84C2
+#define GL_TEXTURE3 0x84C3
+#define GL_TEXTURE4 0x84C4
+#define GL_BLEND 0x0BE2
+#define GL_SRC_ALPHA 0x0302
+#define GL_ONE_MINUS_SRC_ALPHA 0x0303
+#define GL_RGBA8 0x8058
+#define GL_TIME_ELAPSED 0x88BF
+#define GL_STREAM_DRAW 0x88E0
+#define GL_MAP_WRITE_BIT 0x0002
+#define GL_MAP_INVALIDATE_RANGE_BIT 0x0004
+#define GL_MAP_UNSYNCHRONIZED_BIT 0x0020
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define GL_TIMEOUT_EXPIRED 0x911B
+#define GL_WAIT_FAILED 0x911D
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_R32F 0x822E
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#define GL_STREAM_READ 0x88E1
+#define GL_MAP_READ_BIT 0x0001
+#define GL_ALREADY_SIGNALED 0x911A
+#define GL_CONDITION_SATISFIED 0x911C
+
+/* GLintptr/GLsizeiptr are pointer sized (long is 32 bit on win64) */
+#ifdef _WIN64
+typedef long long beneath_gl_intptr;
+#else
+typedef long beneath_gl_intptr;
+#endif
+
+typedef unsigned char *(*PFNGLGETSTRINGPROC)(unsigned int name);
+typedef void (*PFNGLCLEARCOLORPROC)(float red, float green, float blue, float alpha);
+typedef void (*PFNGLCLEARPROC)(unsigned int mask);
+typedef unsigned int (*PFNGLGETERRORPROC)(void);
+typedef void (*PFNGLENABLEPROC)(unsigned int cap);
+typedef void (*PFNGLDISABLEPROC)(unsigned int cap);
+typedef void (*PFNGLBLENDFUNCPROC)(unsigned int sfactor, unsigned int dfactor);
+typedef void (*PFNGLPOLYGONMODEPROC)(unsigned int face, unsigned int mode);
+typedef void (*PFNGLCULLFACEPROC)(unsigned int mode);
+typedef void (*PFNGLFRONTFACEPROC)(unsigned int mode);
+typedef void (*PFNGLVIEWPORTPROC)(int x, int y, int width, int height);
+typedef void (*PFNGLDRAWELEMENTSPROC)(unsigned int mode, int count, unsigned int type, void *indices);
+typedef void (*PFNGLCOLORMASKPROC)(unsigned char red, unsigned char green, unsigned char blue, unsigned char alpha);
+typedef void (*PFNGLDEPTHMASKPROC)(unsigned char flag);
+typedef void (*PFNGLREADBUFFERPROC)(unsigned int mode);
+typedef void (*PFNGLDRAWBUFFERPROC)(unsigned int mode);
+typedef void (*PFNGLREADPIXELSPROC)(int x, int y, int width, int height, unsigned int format, unsigned int type, void *pixels);
+typedef void (*PFNGLGENTEXTURESPROC)(int n, unsigned int *textures);
+typedef void (*PFNGLBINDTEXTUREPROC)(unsigned int target, unsigned int texture);
+typedef void (*PFNGLTEXIMAGE2DPROC)(unsigned int target, int level, int internalformat, int width, int height, int border, int format, unsigned int type, void *pixels);
+typedef void (*PFNGLTEXPARAMETERIPROC)(unsigned int target, unsigned int pname, int param);
+typedef void (*PFNGLTEXPARAMETERFVPROC)(unsigned int target, unsigned int pname, float *params);
+typedef unsigned int (*PFNGLCREATESHADERPROC)(unsigned int shaderType);
+typedef unsigned int (*PFNGLCREATEPROGRAMPROC)(void);
+typedef void (*PFNGLATTACHSHADERPROC)(unsigned int program, unsigned int shader);
+typedef void (*PFNGLSHADERSOURCEPROC)(unsigned int shader, int count, char **string, int *length);
+typedef void (*PFNGLCOMPILESHADERPROC)(unsigned int shader);
+typedef void (*PFNGLGETSHADERIVPROC)(unsigned int shader, unsigned int pname, int *params);
+typedef void (*PFNGLGETSHADERINFOLOGPROC)(unsigned int shader, int maxLength, int *length, char *infoLog);
+typedef void (*PFNGLLINKPROGRAMPROC)(unsigned int program);
+typedef void (*PFNGLGETPROGRAMIVPROC)(unsigned int program, unsigned int pname, int *params);
+typedef void (*PFNGLGETPROGRAMINFOLOGPROC)(unsigned int program, int maxLength, int *length, char *infoLog);
+typedef void (*PFNGLDELETESHADERPROC)(unsigned int shader);
+typedef void (*PFNGLGENVERTEXARRAYSPROC)(int n, unsigned int *arrays);
+typedef void (*PFNGLGENBUFFERSPROC)(int n, unsigned int *buffers);
+typedef void (*PFNGLBINDVERTEXARRAYPROC)(unsigned int array);
+typedef void (*PFNGLBINDBUFFERPROC)(unsigned int target, unsigned int buffer);
+typedef void (*PFNGLBUFFERDATAPROC)(unsigned int target, int size, void *data, unsigned int usage);
+typedef void (*PFNGLBUFFERSUBDATAPROC)(unsigned int target, int offset, int size, void *data);
+typedef void (*PFNGLVERTEXATTRIBPOINTERPROC)(unsigned int index, int size, unsigned int type, unsigned char normalized, int stride, void *pointer);
+typedef void (*PFNGLENABLEVERTEXATTRIBARRAYPROC)(unsigned int index);
+typedef void (*PFNGLDISABLEVERTEXATTRIBARRAYPROC)(unsigned int index);
+typedef void (*PFNGLDELETEPROGRAMPROC)(unsigned int program);
+typedef void (*PFNGLUSEPROGRAMPROC)(unsigned int program);
+typedef void (*PFNGLDRAWARRAYSPROC)(unsigned int mode, int first, int count);
+typedef void (*PFNGLDELETEVERTEXARRAYSPROC)(int n, unsigned int *arrays);
+typedef void (*PFNGLDELETEBUFFERSPROC)(int n, unsigned int *buffers);
+typedef int (*PFNGLGETUNIFORMLOCATIONPROC)(unsigned int program, char *name);
+typedef unsigned int (*PFNGLGETUNIFORMBLOCKINDEXPROC)(unsigned int program, char *uniformBlockName);
+typedef void (*PFNGLUNIFORMBLOCKBINDINGPROC)(unsigned int program, unsigned int uniformBlockIndex, unsigned int uniformBlockBinding);
+typedef void (*PFNGLBINDBUFFERRANGEPROC)(unsigned int target, unsigned int index, unsigned int buffer, beneath_gl_intptr offset, beneath_gl_intptr size);
+typedef void (*PFNGLGETINTEGERVPROC)(unsigned int pname, int *data);
+typedef void (*PFNGLUNIFORMMATRIX4FVPROC)(int location, int count, unsigned char transpose, float *value);
+typedef void (*PFNGLUNIFORM1FPROC)(int location, float v0);
+typedef void (*PFNGLUNIFORM2FPROC)(int location, float v0, float v1);
+typedef void (*PFNGLUNIFORM3FPROC)(int location, float v0, float v1, float v2);
+typedef void (*PFNGLGENFRAMEBUFFERSPROC)(int n, unsigned int *ids);
+typedef void (*PFNGLBINDFRAMEBUFFERPROC)(unsigned int target, unsigned int framebuffer);
+typedef void (*PFNGLFRAMEBUFFERTEXTURE2DPROC)(unsigned int target, unsigned int attachment, unsigned int textarget, unsigned int texture, int level);
+typedef void (*PFNGLGENRENDERBUFFERSPROC)(int n, unsigned int *renderbuffers);
+typedef void (*PFNGLBINDRENDERBUFFERPROC)(unsigned int target, unsigned int renderbuffer);
+typedef void (*PFNGLRENDERBUFFERSTORAGEPROC)(unsigned int target, unsigned int internalformat, int width, int height);
+typedef void (*PFNGLFRAMEBUFFERRENDERBUFFERPROC)(unsigned int target, unsigned int attachment, unsigned int renderbuffertarget, unsigned int renderbuffer);
+typedef unsigned int (*PFNGLCHECKFRAMEBUFFERSTATUSPROC)(unsigned int target);
+typedef void (*PFNGLDRAWELEMENTSINSTANCEDPROC)(unsigned int mode, int count, unsigned int type, void *indices, int primcount);
+typedef void (*PFNGLVERTEXATTRIBDIVISORPROC)(unsigned int index, unsigned int divisor);
+typedef void (*PFNGLVERTEXATTRIBIPOINTERPROC)(unsigned int index, int size, unsigned int type, int stride, void *pointer);
+typedef void (*PFNGLUNIFORM1IPROC)(int location, int v0);
+typedef void (*PFNGLACTIVETEXTUREPROC)(unsigned int texture);
+typedef void (*PFNGLFINISHPROC)(void);
+typedef void (*PFNGLGENQUERIESPROC)(int n, unsigned int *ids);
+typedef void (*PFNGLDELETEQUERIESPROC)(int n, unsigned int *ids);
+typedef void (*PFNGLBEGINQUERYPROC)(unsigned int target, unsigned int id);
+typedef void (*PFNGLENDQUERYPROC)(unsigned int target);
+typedef void (*PFNGLGETQUERYOBJECTUIVPROC)(unsigned int id, unsigned int pname, unsigned int *params);
+typedef void (*PFNGLGETQUERYOBJECTUI64VPROC)(unsigned int id, unsigned int pname, unsigned long long *params);
+typedef void *(*PFNGLMAPBUFFERRANGEPROC)(unsigned int target, beneath_gl_intptr offset, beneath_gl_intptr length, unsigned int access);
+typedef unsigned char (*PFNGLUNMAPBUFFERPROC)(unsigned int target);
+typedef void *(*PFNGLFENCESYNCPROC)(unsigned int condition, unsigned int flags);
+typedef unsigned int (*PFNGLCLIENTWAITSYNCPROC)(void *sync, unsigned int flags, unsigned long long timeout);
+typedef void (*PFNGLDELETESYNCPROC)(void *sync);
+typedef void (*PFNGLBUFFERSTORAGEPROC)(unsigned int target, beneath_gl_intptr size, void *data, unsigned int flags);
+typedef void (*PFNGLGETPROGRAMBINARYPROC)(unsigned int program, int bufSize, int *length, unsigned int *binaryFormat, void *binary);
+typedef void (*PFNGLPROGRAMBINARYPROC)(unsigned int program, unsigned int binaryFormat, void *binary, int length);
+typedef void (*PFNGLPROGRAMPARAMETERIPROC)(unsigned int program, unsigned int pname, int value);
+
+static PFNGLGETSTRINGPROC glGetString;
+static PFNGLCLEARCOLORPROC glClearColor;
+static PFNGLCLEARPROC glClear;
+static PFNGLGETERRORPROC glGetError;
+static PFNGLENABLEPROC glEnable;
+static PFNGLDISABLEPROC glDisable;
+static PFNGLBLENDFUNCPROC glBlendFunc;
+static PFNGLPOLYGONMODEPROC glPolygonMode;
+static PFNGLCULLFACEPROC glCullFace;
+static PFNGLFRONTFACEPROC glFrontFace;
+static PFNGLVIEWPORTPROC glViewport;
+static PFNGLDRAWELEMENTSPROC glDrawElements;
+static PFNGLCOLORMASKPROC glColorMask;
+static PFNGLDEPTHMASKPROC glDepthMask;
+static PFNGLREADBUFFERPROC glReadBuffer;
+static PFNGLDRAWBUFFERPROC glDrawBuffer;
+static PFNGLREADPIXELSPROC glReadPixels;
+static PFNGLGENTEXTURESPROC glGenTextures;
+static PFNGLBINDTEXTUREPROC glBindTexture;
+static PFNGLTEXIMAGE2DPROC glTexImage2D;
+static PFNGLTEXPARAMETERIPROC glTexParameteri;
+static PFNGLTEXPARAMETERFVPROC glTexParameterfv;
+static PFNGLCREATESHADERPROC glCreateShader;
+static PFNGLCREATEPROGRAMPROC glCreateProgram;
+static PFNGLATTACHSHADERPROC glAttachShader;
+static PFNGLSHADERSOURCEPROC glShaderSource;
+static PFNGLCOMPILESHADERPROC glCompileShader;
+static PFNGLGETSHADERIVPROC glGetShaderiv;
+static PFNGLGETSHADERINFOLOGPROC glGetShaderInfoLog;
+static PFNGLLINKPROGRAMPROC glLinkProgram;
+static PFNGLGETPROGRAMIVPROC glGetProgramiv;
+static PFNGLGETPROGRAMINFOLOGPROC glGetProgramInfoLog;
+static PFNGLDELETESHADERPROC glDeleteShader;
+static PFNGLGENVERTEXARRAYSPROC glGenVertexArrays;
+static PFNGLGENBUFFERSPROC glGenBuffers;
+static PFNGLBINDVERTEXARRAYPROC glBindVertexArray;
+static PFNGLBINDBUFFERPROC glBindBuffer;
+static PFNGLBUFFERDATAPROC glBufferData;
+static PFNGLBUFFERSUBDATAPROC glBufferSubData;
+static PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointer;
+static PFNGLENABLEVERTEXATTRIBARRAYPROC glEnableVertexAttribArray;
+static PFNGLDISABLEVERTEXATTRIBARRAYPROC glDisableVertexAttribArray;
+static PFNGLDELETEPROGRAMPROC glDeleteProgram;
+static PFNGLUSEPROGRAMPROC glUseProgram;
+static PFNGLDRAWARRAYSPROC glDrawArrays;
+static PFNGLDELETEVERTEXARRAYSPROC glDeleteVertexArrays;
+static PFNGLDELETEBUFFERSPROC glDeleteBuffers;
+static PFNGLGETUNIFORMLOCATIONPROC glGetUniformLocation;
+static PFNGLGETUNIFORMBLOCKINDEXPROC glGetUniformBlockIndex;
+static PFNGLUNIFORMBLOCKBINDINGPROC glUniformBlockBinding;
+static PFNGLBINDBUFFERRANGEPROC glBindBufferRange;
+static PFNGLGETINTEGERVPROC glGetIntegerv;
+static PFNGLUNIFORMMATRIX4FVPROC glUniformMatrix4fv;
+static PFNGLUNIFORM1FPROC glUniform1f;
+static PFNGLUNIFORM2FPROC glUniform2f;
+static PFNGLUNIFORM3FPROC glUniform3f;
+static PFNGLGENFRAMEBUFFERSPROC glGenFramebuffers;
+static PFNGLBINDFRAMEBUFFERPROC glBindFramebuffer;
+static PFNGLFRAMEBUFFERTEXTURE2DPROC glFramebufferTexture2D;
+static PFNGLGENRENDERBUFFERSPROC glGenRenderbuffers;
+static PFNGLBINDRENDERBUFFERPROC glBindRenderbuffer;
+static PFNGLRENDERBUFFERSTORAGEPROC glRenderbufferStorage;
+static PFNGLFRAMEBUFFERRENDERBUFFERPROC glFramebufferRenderbuffer;
+static PFNGLCHECKFRAMEBUFFERSTATUSPROC glCheckFramebufferStatus;
+static PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstanced;
+static PFNGLVERTEXATTRIBDIVISORPROC glVertexAttribDivisor;
+static PFNGLVERTEXATTRIBIPOINTERPROC glVertexAttribIPointer;
+static PFNGLUNIFORM1IPROC glUniform1i;
+static PFNGLACTIVETEXTUREPROC glActiveTexture;
+static PFNGLFINISHPROC glFinish;
+static PFNGLGENQUERIESPROC glGenQueries;
+static PFNGLDELETEQUERIESPROC glDeleteQueries;
+static PFNGLBEGINQUERYPROC glBeginQuery;
+static PFNGLENDQUERYPROC glEndQuery;
+static PFNGLGETQUERYOBJECTUIVPROC glGetQueryObjectuiv;
+static PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64v;
+static PFNGLMAPBUFFERRANGEPROC glMapBufferRange;
+static PFNGLUNMAPBUFFERPROC glUnmapBuffer;
+static PFNGLFENCESYNCPROC glFenceSync;
+static PFNGLCLIENTWAITSYNCPROC glClientWaitSync;
+static PFNGLDELETESYNCPROC glDeleteSync;
+static PFNGLBUFFERSTORAGEPROC glBufferStorage; /* OpenGL 4.4, optional */
+static PFNGLGETPROGRAMBINARYPROC glGetProgramBinary;   /* OpenGL 4.1, optional */
+static PFNGLPROGRAMBINARYPROC glProgramBinary;         /* OpenGL 4.1, optional */
+static PFNGLPROGRAMPARAMETERIPROC glProgramParameteri; /* OpenGL 4.1, optional */
+
+/* #############################################################################
+ * # [Section] Loader Implementation
+ * #############################################################################
+ */
+typedef void *(*beneath_opengl_load_function_proc)(char *gl_function_name);
+
+#define BENEATH_FUNC_FROM_PTR(type, p) ((union { void *obj; type fn; }){(p)}.fn)
+#define BENEATH_OPENGL_MAX_REPORTED_FAILURES 8
+
+static char *beneath_opengl_failed_loads[BENEATH_OPENGL_MAX_REPORTED_FAILURES + 1];
+static unsigned int beneath_opengl_failed_loads_count = 0;
+
+#define BENEATH_OPENGL_FUNCTION(load, type, name)                                          \
+    name = BENEATH_FUNC_FROM_PTR(type, load(#name));                                       \
+    if (!name && beneath_opengl_failed_loads_count < BENEATH_OPENGL_MAX_REPORTED_FAILURES) \
+    {                                                                                      \
+        beneath_opengl_failed_loads[beneath_opengl_failed_loads_count++] = #name;          \
+    }
+
+static int beneath_opengl_load_functions(beneath_opengl_load_function_proc load)
+{
+    /* OpenGL until 1.1 */
+    BENEATH_OPENGL_FUNCTION(load, PFNGLGETSTRINGPROC, glGetString);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLCLEARCOLORPROC, glClearColor);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLCLEARPROC, glClear);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLGETERRORPROC, glGetError);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLENABLEPROC, glEnable);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLDISABLEPROC, glDisable);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLBLENDFUNCPROC, glBlendFunc);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLPOLYGONMODEPROC, glPolygonMode);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLCULLFACEPROC, glCullFace);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLFRONTFACEPROC, glFrontFace);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLVIEWPORTPROC, glViewport);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLDRAWELEMENTSPROC, glDrawElements);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLCOLORMASKPROC, glColorMask);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLDEPTHMASKPROC, glDepthMask);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLREADBUFFERPROC, glReadBuffer);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLDRAWBUFFERPROC, glDrawBuffer);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLREADPIXELSPROC, glReadPixels);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLGENTEXTURESPROC, glGenTextures);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLBINDTEXTUREPROC, glBindTexture);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLTEXIMAGE2DPROC, glTexImage2D);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLTEXPARAMETERIPROC, glTexParameteri);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLTEXPARAMETERFVPROC, glTexParameterfv);
+
+    /* OpenGL 1.1 forward */
+    BENEATH_OPENGL_FUNCTION(load, PFNGLCREATESHADERPROC, glCreateShader);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLCREATEPROGRAMPROC, glCreateProgram);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLATTACHSHADERPROC, glAttachShader);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLSHADERSOURCEPROC, glShaderSource);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLCOMPILESHADERPROC, glCompileShader);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLGETSHADERIVPROC, glGetShaderiv);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLGETSHADERINFOLOGPROC, glGetShaderInfoLog);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLLINKPROGRAMPROC, glLinkProgram);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLGETPROGRAMIVPROC, glGetProgramiv);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLGETPROGRAMINFOLOGPROC, glGetProgramInfoLog);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLDELETESHADERPROC, glDeleteShader);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLGENVERTEXARRAYSPROC, glGenVertexArrays);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLGENBUFFERSPROC, glGenBuffers);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLBINDVERTEXARRAYPROC, glBindVertexArray);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLBINDBUFFERPROC, glBindBuffer);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLBUFFERDATAPROC, glBufferData);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLBUFFERSUBDATAPROC, glBufferSubData);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLVERTEXATTRIBPOINTERPROC, glVertexAttribPointer);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLENABLEVERTEXATTRIBARRAYPROC, glEnableVertexAttribArray);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLDISABLEVERTEXATTRIBARRAYPROC, glDisableVertexAttribArray);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLDELETEPROGRAMPROC, glDeleteProgram);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLUSEPROGRAMPROC, glUseProgram);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLDRAWARRAYSPROC, glDrawArrays);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLDELETEVERTEXARRAYSPROC, glDeleteVertexArrays);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLDELETEBUFFERSPROC, glDeleteBuffers);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLGETUNIFORMLOCATIONPROC, glGetUniformLocation);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLGETUNIFORMBLOCKINDEXPROC, glGetUniformBlockIndex);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLUNIFORMBLOCKBINDINGPROC, glUniformBlockBinding);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLBINDBUFFERRANGEPROC, glBindBufferRange);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLGETINTEGERVPROC, glGetIntegerv);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLUNIFORMMATRIX4FVPROC, glUniformMatrix4fv);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLUNIFORM1FPROC, glUniform1f);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLUNIFORM2FPROC, glUniform2f);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLUNIFORM3FPROC, glUniform3f);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLGENFRAMEBUFFERSPROC, glGenFramebuffers);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLBINDFRAMEBUFFERPROC, glBindFramebuffer);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLFRAMEBUFFERTEXTURE2DPROC, glFramebufferTexture2D);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLGENRENDERBUFFERSPROC, glGenRenderbuffers);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLBINDRENDERBUFFERPROC, glBindRenderbuffer);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLRENDERBUFFERSTORAGEPROC, glRenderbufferStorage);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLFRAMEBUFFERRENDERBUFFERPROC, glFramebufferRenderbuffer);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLCHECKFRAMEBUFFERSTATUSPROC, glCheckFramebufferStatus);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLDRAWELEMENTSINSTANCEDPROC, glDrawElementsInstanced);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLVERTEXATTRIBDIVISORPROC, glVertexAttribDivisor);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLVERTEXATTRIBIPOINTERPROC, glVertexAttribIPointer);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLUNIFORM1IPROC, glUniform1i);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLACTIVETEXTUREPROC, glActiveTexture);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLFINISHPROC, glFinish);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLGENQUERIESPROC, glGenQueries);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLDELETEQUERIESPROC, glDeleteQueries);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLBEGINQUERYPROC, glBeginQuery);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLENDQUERYPROC, glEndQuery);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLGETQUERYOBJECTUIVPROC, glGetQueryObjectuiv);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLGETQUERYOBJECTUI64VPROC, glGetQueryObjectui64v);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLMAPBUFFERRANGEPROC, glMapBufferRange);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLUNMAPBUFFERPROC, glUnmapBuffer);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLFENCESYNCPROC, glFenceSync);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLCLIENTWAITSYNCPROC, glClientWaitSync);
+    BENEATH_OPENGL_FUNCTION(load, PFNGLDELETESYNCPROC, glDeleteSync);
+
+    /* Optional, only used if the context version is 4.4+ (see beneath_opengl_stream_initialize) */
+    glBufferStorage = BENEATH_FUNC_FROM_PTR(PFNGLBUFFERSTORAGEPROC, load("glBufferStorage"));
+
+    /* Optional, the program binary cache is disabled without them (see beneath_opengl_shader_create_cached) */
+    glGetProgramBinary = BENEATH_FUNC_FROM_PTR(PFNGLGETPROGRAMBINARYPROC, load("glGetProgramBinary"));
+    glProgramBinary = BENEATH_FUNC_FROM_PTR(PFNGLPROGRAMBINARYPROC, load("glProgramBinary"));
+    glProgramParameteri = BENEATH_FUNC_FROM_PTR(PFNGLPROGRAMPARAMETERIPROC, load("glProgramParameteri"));
+
+    return beneath_opengl_failed_loads_count < 1;
+}
+
+#endif /* BENEATH_OPENGL_LOADER_H */
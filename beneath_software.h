@@ -0,0 +1,1046 @@
+#ifndef BENEATH_SOFTWARE_H
+#define BENEATH_SOFTWARE_H
+
+#include "beneath.h"
+#include "deps/vm.h" /* Temporary for prototype: Vector math */
+
+/* CPU reference renderer for beneath_draw_call (no GPU required).
+ *
+ * - Triangles are transformed, clipped (near/far + guard band) and set up once per draw call
+ * - Set up triangles are binned into screen tiles and the tiles are rasterized in parallel
+ * - Coverage uses exact integer edge functions (28.4 fixed point, top-left fill rule),
+ *   four pixels at a time with SSE2 (scalar fallback on other architectures)
+ * - Depth buffer (less), back face culling and the same directional Blinn-Phong term
+ *   that beneath_opengl_shader_generate emits (no shadow map or post processing)
+ *
+ * The color buffer is RGBA8 (R in the lowest byte), rows are top to bottom and
+ * 'pitch' pixels wide.
+ */
+#if (defined(__SSE2__) || defined(_M_X64)) && !defined(BENEATH_SOFTWARE_NO_SIMD)
+#define BENEATH_SOFTWARE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BENEATH_SOFTWARE_ATOMIC_FETCH_INCREMENT(p) __sync_fetch_and_add((p), 1u)
+#else
+/* No atomics available, only a single threaded dispatch is valid */
+#define BENEATH_SOFTWARE_ATOMIC_FETCH_INCREMENT(p) ((*(p))++)
+#endif
+
+#define BENEATH_SOFTWARE_TILE_SIZE 64
+#define BENEATH_SOFTWARE_SUBPIXEL_BITS 4
+#define BENEATH_SOFTWARE_SUBPIXEL_ONE (1 << BENEATH_SOFTWARE_SUBPIXEL_BITS)
+#define BENEATH_SOFTWARE_GUARD_BAND 8.0f                                     /* Clip x/y at 8x the viewport, keeps edge steps in 32 bit */
+#define BENEATH_SOFTWARE_TRIANGLES_MAX 16384                                 /* Set up triangles before the tiles are flushed */
+#define BENEATH_SOFTWARE_BIN_ENTRIES_MAX (BENEATH_SOFTWARE_TRIANGLES_MAX * 8) /* Triangle references over all tiles */
+#define BENEATH_SOFTWARE_DRAWS_MAX 64                                        /* Draw calls before the tiles are flushed */
+#define BENEATH_SOFTWARE_ATTRIBUTES 9                                        /* World position, normal, color */
+#define BENEATH_SOFTWARE_PLANES (2 + BENEATH_SOFTWARE_ATTRIBUTES)            /* Depth, 1/w, attributes/w */
+
+/* Runs work(data) on every worker thread (the calling thread included) and
+ * returns once all of them returned. NULL renders on the calling thread only.
+ */
+typedef void (*beneath_software_work)(void *data);
+typedef void (*beneath_software_dispatch)(beneath_software_work work, void *data);
+
+typedef struct beneath_software_vertex
+{
+    float position[4]; /* Clip space */
+    float attributes[BENEATH_SOFTWARE_ATTRIBUTES];
+
+} beneath_software_vertex;
+
+typedef struct beneath_software_triangle
+{
+    int x[3]; /* Screen position in 28.4 fixed point */
+    int y[3];
+    int bias[3]; /* Top-left fill rule, 1 for edges that must not own pixel centers on them */
+
+    int min_x; /* Pixel bounding box, clamped to the framebuffer */
+    int min_y;
+    int max_x;
+    int max_y;
+
+    float origin_x; /* Interpolation planes relative to vertex 0 */
+    float origin_y;
+    float planes[BENEATH_SOFTWARE_PLANES][3]; /* value, d/dx, d/dy */
+
+    unsigned int draw_index;
+
+} beneath_software_triangle;
+
+typedef struct beneath_software_draw_state
+{
+    beneath_bool lit;
+    beneath_light_directional light;
+    float light_dir[3]; /* normalize(-light.direction) */
+    float camera_position[3];
+
+} beneath_software_draw_state;
+
+typedef struct beneath_software_context
+{
+    beneath_bool initialized;
+
+    unsigned int width;
+    unsigned int height;
+    unsigned int pitch; /* Row length in pixels, multiple of 4 */
+
+    unsigned int *color;
+    float *depth;
+
+    /* Frame clear, executed by the tiles on the next flush */
+    beneath_bool clear_pending;
+    unsigned int clear_color;
+
+    /* Tiles */
+    unsigned int tiles_x;
+    unsigned int tiles_y;
+    unsigned int tiles_count;
+    unsigned int tile_next; /* Shared tile counter of the workers */
+
+    /* Set up triangles and draw states waiting for the next flush */
+    beneath_software_triangle *triangles;
+    unsigned int triangles_count;
+    beneath_software_draw_state draws[BENEATH_SOFTWARE_DRAWS_MAX];
+    unsigned int draws_count;
+
+    /* Per tile triangle lists (counting sort, preserves submission order) */
+    unsigned int *bin_offsets; /* tiles_count + 1 */
+    unsigned int *bin_entries;
+    unsigned int bin_entries_count;
+
+    beneath_software_dispatch dispatch;
+
+    /* Statistics of the last frame */
+    unsigned int stats_triangles;
+    unsigned int stats_flushes;
+
+} beneath_software_context;
+
+BENEATH_API BENEATH_INLINE unsigned int beneath_software_pitch(unsigned int width)
+{
+    return (width + 3u) & ~3u;
+}
+
+BENEATH_API BENEATH_INLINE unsigned int beneath_software_tiles(unsigned int size)
+{
+    return (size + BENEATH_SOFTWARE_TILE_SIZE - 1) / BENEATH_SOFTWARE_TILE_SIZE;
+}
+
+/* Memory the platform has to provide for a width x height framebuffer */
+BENEATH_API unsigned long beneath_software_memory_size(unsigned int width, unsigned int height)
+{
+    unsigned long pixels = (unsigned long)beneath_software_pitch(width) * height;
+    unsigned long tiles = (unsigned long)beneath_software_tiles(width) * beneath_software_tiles(height);
+
+    return pixels * sizeof(unsigned int) +
+           pixels * sizeof(float) +
+           BENEATH_SOFTWARE_TRIANGLES_MAX * sizeof(beneath_software_triangle) +
+           (tiles + 1) * sizeof(unsigned int) +
+           BENEATH_SOFTWARE_BIN_ENTRIES_MAX * sizeof(unsigned int);
+}
+
+BENEATH_API beneath_bool beneath_software_initialize(
+    beneath_software_context *ctx,
+    void *memory,
+    unsigned long memory_size,
+    unsigned int width,
+    unsigned int height,
+    beneath_software_dispatch dispatch)
+{
+    unsigned char *at = (unsigned char *)memory;
+    unsigned long pixels;
+
+    if (!memory || width == 0 || height == 0 || memory_size < beneath_software_memory_size(width, height))
+    {
+        return false;
+    }
+
+    ctx->width = width;
+    ctx->height = height;
+    ctx->pitch = beneath_software_pitch(width);
+    ctx->tiles_x = beneath_software_tiles(width);
+    ctx->tiles_y = beneath_software_tiles(height);
+    ctx->tiles_count = ctx->tiles_x * ctx->tiles_y;
+    ctx->dispatch = dispatch;
+
+    pixels = (unsigned long)ctx->pitch * height;
+
+    /* Largest alignment first */
+    ctx->triangles = (beneath_software_triangle *)at;
+    at += BENEATH_SOFTWARE_TRIANGLES_MAX * sizeof(beneath_software_triangle);
+    ctx->color = (unsigned int *)at;
+    at += pixels * sizeof(unsigned int);
+    ctx->depth = (float *)at;
+    at += pixels * sizeof(float);
+    ctx->bin_offsets = (unsigned int *)at;
+    at += (ctx->tiles_count + 1) * sizeof(unsigned int);
+    ctx->bin_entries = (unsigned int *)at;
+
+    ctx->triangles_count = 0;
+    ctx->draws_count = 0;
+    ctx->bin_entries_count = 0;
+    ctx->clear_pending = false;
+    ctx->initialized = true;
+
+    return true;
+}
+
+BENEATH_API BENEATH_INLINE unsigned int beneath_software_pack_color(float r, float g, float b, float a)
+{
+    unsigned int ri = (unsigned int)(vm_clamp01f(r) * 255.0f + 0.5f);
+    unsigned int gi = (unsigned int)(vm_clamp01f(g) * 255.0f + 0.5f);
+    unsigned int bi = (unsigned int)(vm_clamp01f(b) * 255.0f + 0.5f);
+    unsigned int ai = (unsigned int)(vm_clamp01f(a) * 255.0f + 0.5f);
+
+    return ri | (gi << 8) | (bi << 16) | (ai << 24);
+}
+
+/******************************/
+/* Tile Rasterization         */
+/******************************/
+BENEATH_API BENEATH_INLINE float beneath_software_plane(beneath_software_triangle *t, int plane, float px, float py)
+{
+    return t->planes[plane][0] + t->planes[plane][1] * (px - t->origin_x) + t->planes[plane][2] * (py - t->origin_y);
+}
+
+#ifndef BENEATH_SOFTWARE_SSE2
+BENEATH_API void beneath_software_shade(beneath_software_context *ctx, beneath_software_triangle *t, int x, int y, unsigned int *pixel)
+{
+    beneath_software_draw_state *draw = &ctx->draws[t->draw_index];
+    float attributes[BENEATH_SOFTWARE_ATTRIBUTES];
+    float px = (float)x + 0.5f;
+    float py = (float)y + 0.5f;
+    float w = 1.0f / beneath_software_plane(t, 1, px, py);
+    float r, g, b;
+    int i;
+
+    /* Perspective correct attributes */
+    for (i = 0; i < BENEATH_SOFTWARE_ATTRIBUTES; ++i)
+    {
+        attributes[i] = beneath_software_plane(t, 2 + i, px, py) * w;
+    }
+
+    r = attributes[6];
+    g = attributes[7];
+    b = attributes[8];
+
+    if (draw->lit)
+    {
+        /* Blinn-Phong from a directional light, see CalcDirectionalLight in the generated GLSL */
+        v3 normal = vm_v3_normalize(vm_v3(attributes[3], attributes[4], attributes[5]));
+        v3 view_dir = vm_v3_normalize(vm_v3(draw->camera_position[0] - attributes[0], draw->camera_position[1] - attributes[1], draw->camera_position[2] - attributes[2]));
+        v3 light_dir = vm_v3(draw->light_dir[0], draw->light_dir[1], draw->light_dir[2]);
+        v3 halfway_dir = vm_v3_normalize(vm_v3_add(light_dir, view_dir));
+        float diff = vm_maxf(vm_v3_dot(normal, light_dir), 0.0f);
+        float spec = vm_maxf(vm_v3_dot(normal, halfway_dir), 0.0f);
+
+        /* pow(spec, 32.0) */
+        spec *= spec;
+        spec *= spec;
+        spec *= spec;
+        spec *= spec;
+        spec *= spec;
+
+        r = draw->light.ambient[0] * r + draw->light.diffuse[0] * diff * r + draw->light.specular[0] * spec;
+        g = draw->light.ambient[1] * g + draw->light.diffuse[1] * diff * g + draw->light.specular[1] * spec;
+        b = draw->light.ambient[2] * b + draw->light.diffuse[2] * diff * b + draw->light.specular[2] * spec;
+    }
+
+    *pixel = beneath_software_pack_color(r, g, b, 1.0f);
+}
+#endif
+
+#ifdef BENEATH_SOFTWARE_SSE2
+BENEATH_API BENEATH_INLINE __m128 beneath_software_plane4(beneath_software_triangle *t, int plane, __m128 px, __m128 py)
+{
+    return _mm_add_ps(
+        _mm_set1_ps(t->planes[plane][0]),
+        _mm_add_ps(
+            _mm_mul_ps(_mm_set1_ps(t->planes[plane][1]), _mm_sub_ps(px, _mm_set1_ps(t->origin_x))),
+            _mm_mul_ps(_mm_set1_ps(t->planes[plane][2]), _mm_sub_ps(py, _mm_set1_ps(t->origin_y)))));
+}
+
+BENEATH_API BENEATH_INLINE void beneath_software_normalize4(__m128 *x, __m128 *y, __m128 *z)
+{
+    __m128 length_squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(*x, *x), _mm_mul_ps(*y, *y)), _mm_mul_ps(*z, *z));
+    __m128 nonzero = _mm_cmpgt_ps(length_squared, _mm_setzero_ps());
+    __m128 scalar = _mm_and_ps(nonzero, _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(length_squared)));
+
+    *x = _mm_mul_ps(*x, scalar);
+    *y = _mm_mul_ps(*y, scalar);
+    *z = _mm_mul_ps(*z, scalar);
+}
+
+/* Four pixel version of beneath_software_shade, writes the lanes set in mask */
+BENEATH_API void beneath_software_shade4(beneath_software_context *ctx, beneath_software_triangle *t, int x, int y, __m128 mask, unsigned int *pixels)
+{
+    beneath_software_draw_state *draw = &ctx->draws[t->draw_index];
+    __m128 px = _mm_add_ps(_mm_set1_ps((float)x + 0.5f), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+    __m128 py = _mm_set1_ps((float)y + 0.5f);
+    __m128 w = _mm_div_ps(_mm_set1_ps(1.0f), beneath_software_plane4(t, 1, px, py));
+    __m128 r = _mm_mul_ps(beneath_software_plane4(t, 8, px, py), w);
+    __m128 g = _mm_mul_ps(beneath_software_plane4(t, 9, px, py), w);
+    __m128 b = _mm_mul_ps(beneath_software_plane4(t, 10, px, py), w);
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128i color;
+
+    if (draw->lit)
+    {
+        __m128 nx = _mm_mul_ps(beneath_software_plane4(t, 5, px, py), w);
+        __m128 ny = _mm_mul_ps(beneath_software_plane4(t, 6, px, py), w);
+        __m128 nz = _mm_mul_ps(beneath_software_plane4(t, 7, px, py), w);
+        __m128 vx = _mm_sub_ps(_mm_set1_ps(draw->camera_position[0]), _mm_mul_ps(beneath_software_plane4(t, 2, px, py), w));
+        __m128 vy = _mm_sub_ps(_mm_set1_ps(draw->camera_position[1]), _mm_mul_ps(beneath_software_plane4(t, 3, px, py), w));
+        __m128 vz = _mm_sub_ps(_mm_set1_ps(draw->camera_position[2]), _mm_mul_ps(beneath_software_plane4(t, 4, px, py), w));
+        __m128 lx = _mm_set1_ps(draw->light_dir[0]);
+        __m128 ly = _mm_set1_ps(draw->light_dir[1]);
+        __m128 lz = _mm_set1_ps(draw->light_dir[2]);
+        __m128 hx, hy, hz, diff, spec;
+
+        beneath_software_normalize4(&nx, &ny, &nz);
+        beneath_software_normalize4(&vx, &vy, &vz);
+
+        hx = _mm_add_ps(lx, vx);
+        hy = _mm_add_ps(ly, vy);
+        hz = _mm_add_ps(lz, vz);
+        beneath_software_normalize4(&hx, &hy, &hz);
+
+        diff = _mm_max_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, lx), _mm_mul_ps(ny, ly)), _mm_mul_ps(nz, lz)), zero);
+        spec = _mm_max_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, hx), _mm_mul_ps(ny, hy)), _mm_mul_ps(nz, hz)), zero);
+
+        /* pow(spec, 32.0) */
+        spec = _mm_mul_ps(spec, spec);
+        spec = _mm_mul_ps(spec, spec);
+        spec = _mm_mul_ps(spec, spec);
+        spec = _mm_mul_ps(spec, spec);
+        spec = _mm_mul_ps(spec, spec);
+
+        r = _mm_add_ps(_mm_mul_ps(r, _mm_add_ps(_mm_set1_ps(draw->light.ambient[0]), _mm_mul_ps(_mm_set1_ps(draw->light.diffuse[0]), diff))), _mm_mul_ps(_mm_set1_ps(draw->light.specular[0]), spec));
+        g = _mm_add_ps(_mm_mul_ps(g, _mm_add_ps(_mm_set1_ps(draw->light.ambient[1]), _mm_mul_ps(_mm_set1_ps(draw->light.diffuse[1]), diff))), _mm_mul_ps(_mm_set1_ps(draw->light.specular[1]), spec));
+        b = _mm_add_ps(_mm_mul_ps(b, _mm_add_ps(_mm_set1_ps(draw->light.ambient[2]), _mm_mul_ps(_mm_set1_ps(draw->light.diffuse[2]), diff))), _mm_mul_ps(_mm_set1_ps(draw->light.specular[2]), spec));
+    }
+
+    /* Pack to RGBA8, same rounding as beneath_software_pack_color */
+    {
+        __m128 scale = _mm_set1_ps(255.0f);
+        __m128 half = _mm_set1_ps(0.5f);
+        __m128i ri = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(r, zero), one), scale), half));
+        __m128i gi = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(g, zero), one), scale), half));
+        __m128i bi = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(b, zero), one), scale), half));
+        __m128i keep = _mm_castps_si128(mask);
+
+        color = _mm_or_si128(_mm_or_si128(ri, _mm_slli_epi32(gi, 8)), _mm_or_si128(_mm_slli_epi32(bi, 16), _mm_set1_epi32((int)0xFF000000)));
+        color = _mm_or_si128(_mm_and_si128(keep, color), _mm_andnot_si128(keep, _mm_loadu_si128((__m128i *)pixels)));
+
+        _mm_storeu_si128((__m128i *)pixels, color);
+    }
+}
+#endif
+
+/* Rasterizes one triangle into the pixel rectangle [x0,x1]x[y0,y1] of a tile */
+BENEATH_API void beneath_software_triangle_rasterize(beneath_software_context *ctx, beneath_software_triangle *t, int tile_x0, int tile_y0, int tile_x1, int tile_y1)
+{
+    int x0 = vm_maxi(t->min_x, tile_x0);
+    int y0 = vm_maxi(t->min_y, tile_y0);
+    int x1 = vm_mini(t->max_x, tile_x1);
+    int y1 = vm_mini(t->max_y, tile_y1);
+    int block_x0;
+    int block_x1;
+    int e_row[3];
+    int step_x[3];
+    int step_y[3];
+    int x, y, k;
+    float dzdx = t->planes[0][1];
+
+    if (x0 > x1 || y0 > y1)
+    {
+        return;
+    }
+
+    /* Work in groups of four pixels starting at a 4 aligned column (rows are padded to a multiple of 4) */
+    block_x0 = x0 & ~3;
+    block_x1 = x1 | 3;
+
+    /* Edge functions at the block origin. Values are computed exactly in double (products exceed
+     * 32 bit), edges that reject or accept the whole block are resolved here so the per pixel
+     * stepping below stays in 32 bit.
+     */
+    for (k = 0; k < 3; ++k)
+    {
+        int a = k;
+        int b = (k + 1) % 3;
+        int dx = t->x[b] - t->x[a];
+        int dy = t->y[b] - t->y[a];
+        double e = (double)dx * (double)(y0 * BENEATH_SOFTWARE_SUBPIXEL_ONE + BENEATH_SOFTWARE_SUBPIXEL_ONE / 2 - t->y[a]) -
+                   (double)dy * (double)(block_x0 * BENEATH_SOFTWARE_SUBPIXEL_ONE + BENEATH_SOFTWARE_SUBPIXEL_ONE / 2 - t->x[a]) -
+                   (double)t->bias[k];
+        double range_x = (double)(-dy * BENEATH_SOFTWARE_SUBPIXEL_ONE) * (double)(block_x1 - block_x0);
+        double range_y = (double)(dx * BENEATH_SOFTWARE_SUBPIXEL_ONE) * (double)(y1 - y0);
+        double e_min = e + (range_x < 0.0 ? range_x : 0.0) + (range_y < 0.0 ? range_y : 0.0);
+        double e_max = e + (range_x > 0.0 ? range_x : 0.0) + (range_y > 0.0 ? range_y : 0.0);
+
+        if (e_max < 0.0)
+        {
+            return;
+        }
+
+        if (e_min >= 0.0)
+        {
+            e_row[k] = 0;
+            step_x[k] = 0;
+            step_y[k] = 0;
+        }
+        else
+        {
+            e_row[k] = (int)e;
+            step_x[k] = -dy * BENEATH_SOFTWARE_SUBPIXEL_ONE;
+            step_y[k] = dx * BENEATH_SOFTWARE_SUBPIXEL_ONE;
+        }
+    }
+
+    for (y = y0; y <= y1; ++y)
+    {
+        unsigned int row = (unsigned int)y * ctx->pitch;
+        float py = (float)y + 0.5f;
+        float z = beneath_software_plane(t, 0, (float)block_x0 + 0.5f, py);
+        int e0 = e_row[0];
+        int e1 = e_row[1];
+        int e2 = e_row[2];
+
+#ifdef BENEATH_SOFTWARE_SSE2
+        __m128i lanes = _mm_set_epi32(3, 2, 1, 0);
+        __m128i e0_offsets = _mm_set_epi32(3 * step_x[0], 2 * step_x[0], step_x[0], 0);
+        __m128i e1_offsets = _mm_set_epi32(3 * step_x[1], 2 * step_x[1], step_x[1], 0);
+        __m128i e2_offsets = _mm_set_epi32(3 * step_x[2], 2 * step_x[2], step_x[2], 0);
+        __m128 z_offsets = _mm_set_ps(3.0f * dzdx, 2.0f * dzdx, dzdx, 0.0f);
+        __m128i minus_one = _mm_set1_epi32(-1);
+
+        for (x = block_x0; x <= block_x1; x += 4)
+        {
+            __m128i e0v = _mm_add_epi32(_mm_set1_epi32(e0), e0_offsets);
+            __m128i e1v = _mm_add_epi32(_mm_set1_epi32(e1), e1_offsets);
+            __m128i e2v = _mm_add_epi32(_mm_set1_epi32(e2), e2_offsets);
+
+            /* Inside if all three edge functions are >= 0 (sign bits of the or) */
+            __m128i inside = _mm_cmpgt_epi32(_mm_or_si128(_mm_or_si128(e0v, e1v), e2v), minus_one);
+
+            /* Only columns in [x0, x1] */
+            __m128i columns = _mm_and_si128(
+                _mm_cmpgt_epi32(_mm_set1_epi32(x1 - x + 1), lanes),
+                _mm_cmpgt_epi32(lanes, _mm_set1_epi32(x0 - x - 1)));
+
+            int mask;
+
+            inside = _mm_and_si128(inside, columns);
+
+            if (_mm_movemask_epi8(inside))
+            {
+                float *depth = ctx->depth + row + (unsigned int)x;
+                __m128 zv = _mm_add_ps(_mm_set1_ps(z), z_offsets);
+                __m128 depth_old = _mm_loadu_ps(depth);
+                __m128 pass = _mm_and_ps(_mm_cmplt_ps(zv, depth_old), _mm_castsi128_ps(inside));
+
+                mask = _mm_movemask_ps(pass);
+
+                if (mask)
+                {
+                    _mm_storeu_ps(depth, _mm_or_ps(_mm_and_ps(pass, zv), _mm_andnot_ps(pass, depth_old)));
+                    beneath_software_shade4(ctx, t, x, y, pass, ctx->color + row + (unsigned int)x);
+                }
+            }
+
+            e0 += 4 * step_x[0];
+            e1 += 4 * step_x[1];
+            e2 += 4 * step_x[2];
+            z += 4.0f * dzdx;
+        }
+#else
+        for (x = block_x0; x <= block_x1; ++x)
+        {
+            if (x >= x0 && x <= x1 && (e0 | e1 | e2) >= 0)
+            {
+                unsigned int index = row + (unsigned int)x;
+
+                if (z < ctx->depth[index])
+                {
+                    ctx->depth[index] = z;
+                    beneath_software_shade(ctx, t, x, y, ctx->color + index);
+                }
+            }
+
+            e0 += step_x[0];
+            e1 += step_x[1];
+            e2 += step_x[2];
+            z += dzdx;
+        }
+#endif
+
+        e_row[0] += step_y[0];
+        e_row[1] += step_y[1];
+        e_row[2] += step_y[2];
+    }
+}
+
+BENEATH_API void beneath_software_tile_render(beneath_software_context *ctx, unsigned int tile)
+{
+    int tile_x0 = (int)((tile % ctx->tiles_x) * BENEATH_SOFTWARE_TILE_SIZE);
+    int tile_y0 = (int)((tile / ctx->tiles_x) * BENEATH_SOFTWARE_TILE_SIZE);
+    int tile_x1 = vm_mini(tile_x0 + BENEATH_SOFTWARE_TILE_SIZE, (int)ctx->width) - 1;
+    int tile_y1 = vm_mini(tile_y0 + BENEATH_SOFTWARE_TILE_SIZE, (int)ctx->height) - 1;
+    unsigned int i;
+
+    if (ctx->clear_pending)
+    {
+        int x, y;
+
+        for (y = tile_y0; y <= tile_y1; ++y)
+        {
+            unsigned int row = (unsigned int)y * ctx->pitch;
+
+            for (x = tile_x0; x <= tile_x1; ++x)
+            {
+                ctx->color[row + (unsigned int)x] = ctx->clear_color;
+                ctx->depth[row + (unsigned int)x] = 1.0f;
+            }
+        }
+    }
+
+    for (i = ctx->bin_offsets[tile]; i < ctx->bin_offsets[tile + 1]; ++i)
+    {
+        beneath_software_triangle_rasterize(ctx, &ctx->triangles[ctx->bin_entries[i]], tile_x0, tile_y0, tile_x1, tile_y1);
+    }
+}
+
+/* Worker entry point, every thread pulls tiles until none are left */
+BENEATH_API void beneath_software_tiles_work(void *data)
+{
+    beneath_software_context *ctx = (beneath_software_context *)data;
+
+    for (;;)
+    {
+        unsigned int tile = BENEATH_SOFTWARE_ATOMIC_FETCH_INCREMENT(&ctx->tile_next);
+
+        if (tile >= ctx->tiles_count)
+        {
+            break;
+        }
+
+        beneath_software_tile_render(ctx, tile);
+    }
+}
+
+/* Bins the set up triangles to tiles and rasterizes all tiles */
+BENEATH_API void beneath_software_flush(beneath_software_context *ctx)
+{
+    unsigned int i;
+    unsigned int tx, ty;
+    unsigned int offset = 0;
+
+    if (ctx->triangles_count == 0 && !ctx->clear_pending)
+    {
+        return;
+    }
+
+    /* Count, prefix sum, fill (bin_offsets[tile + 1] is used as the write cursor) */
+    for (i = 0; i <= ctx->tiles_count; ++i)
+    {
+        ctx->bin_offsets[i] = 0;
+    }
+
+    for (i = 0; i < ctx->triangles_count; ++i)
+    {
+        beneath_software_triangle *t = &ctx->triangles[i];
+
+        for (ty = (unsigned int)t->min_y / BENEATH_SOFTWARE_TILE_SIZE; ty <= (unsigned int)t->max_y / BENEATH_SOFTWARE_TILE_SIZE; ++ty)
+        {
+            for (tx = (unsigned int)t->min_x / BENEATH_SOFTWARE_TILE_SIZE; tx <= (unsigned int)t->max_x / BENEATH_SOFTWARE_TILE_SIZE; ++tx)
+            {
+                ctx->bin_offsets[ty * ctx->tiles_x + tx + 1]++;
+            }
+        }
+    }
+
+    for (i = 1; i <= ctx->tiles_count; ++i)
+    {
+        unsigned int count = ctx->bin_offsets[i];
+        ctx->bin_offsets[i] = offset;
+        offset += count;
+    }
+
+    for (i = 0; i < ctx->triangles_count; ++i)
+    {
+        beneath_software_triangle *t = &ctx->triangles[i];
+
+        for (ty = (unsigned int)t->min_y / BENEATH_SOFTWARE_TILE_SIZE; ty <= (unsigned int)t->max_y / BENEATH_SOFTWARE_TILE_SIZE; ++ty)
+        {
+            for (tx = (unsigned int)t->min_x / BENEATH_SOFTWARE_TILE_SIZE; tx <= (unsigned int)t->max_x / BENEATH_SOFTWARE_TILE_SIZE; ++tx)
+            {
+                ctx->bin_entries[ctx->bin_offsets[ty * ctx->tiles_x + tx + 1]++] = i;
+            }
+        }
+    }
+
+    /* Rasterize */
+    ctx->tile_next = 0;
+
+    if (ctx->dispatch)
+    {
+        ctx->dispatch(beneath_software_tiles_work, ctx);
+    }
+    else
+    {
+        beneath_software_tiles_work(ctx);
+    }
+
+    ctx->stats_flushes++;
+    ctx->triangles_count = 0;
+    ctx->draws_count = 0;
+    ctx->bin_entries_count = 0;
+    ctx->clear_pending = false;
+}
+
+/******************************/
+/* Triangle Setup             */
+/******************************/
+BENEATH_API BENEATH_INLINE float beneath_software_clip_distance(float *position, int plane)
+{
+    switch (plane)
+    {
+    case 0:
+        return position[3] + position[2]; /* Near */
+    case 1:
+        return position[3] - position[2]; /* Far */
+    case 2:
+        return BENEATH_SOFTWARE_GUARD_BAND * position[3] + position[0];
+    case 3:
+        return BENEATH_SOFTWARE_GUARD_BAND * position[3] - position[0];
+    case 4:
+        return BENEATH_SOFTWARE_GUARD_BAND * position[3] + position[1];
+    default:
+        return BENEATH_SOFTWARE_GUARD_BAND * position[3] - position[1];
+    }
+}
+
+BENEATH_API BENEATH_INLINE int beneath_software_pixel_min(int fixed)
+{
+    /* First pixel center (x + 0.5) at or after the fixed point coordinate */
+    int offset = fixed - BENEATH_SOFTWARE_SUBPIXEL_ONE / 2;
+    return offset <= 0 ? 0 : (offset + BENEATH_SOFTWARE_SUBPIXEL_ONE - 1) / BENEATH_SOFTWARE_SUBPIXEL_ONE;
+}
+
+BENEATH_API BENEATH_INLINE int beneath_software_pixel_max(int fixed)
+{
+    /* Last pixel center at or before the fixed point coordinate */
+    int offset = fixed - BENEATH_SOFTWARE_SUBPIXEL_ONE / 2;
+    return offset < 0 ? -1 : offset / BENEATH_SOFTWARE_SUBPIXEL_ONE;
+}
+
+BENEATH_API void beneath_software_triangle_setup(beneath_software_context *ctx, beneath_software_vertex *v0, beneath_software_vertex *v1, beneath_software_vertex *v2)
+{
+    beneath_software_vertex *v[3];
+    beneath_software_triangle *t;
+    float sx[3], sy[3];
+    float q[BENEATH_SOFTWARE_PLANES][3];
+    float area_inv;
+    double area;
+    int fixed_x[3], fixed_y[3];
+    int i, p;
+
+    v[0] = v0;
+    v[1] = v1;
+    v[2] = v2;
+
+    for (i = 0; i < 3; ++i)
+    {
+        float inv_w = 1.0f / v[i]->position[3];
+        float ndc_x = v[i]->position[0] * inv_w;
+        float ndc_y = v[i]->position[1] * inv_w;
+
+        fixed_x[i] = (int)vm_floorf((ndc_x * 0.5f + 0.5f) * (float)ctx->width * (float)BENEATH_SOFTWARE_SUBPIXEL_ONE + 0.5f);
+        fixed_y[i] = (int)vm_floorf((0.5f - ndc_y * 0.5f) * (float)ctx->height * (float)BENEATH_SOFTWARE_SUBPIXEL_ONE + 0.5f);
+    }
+
+    /* Counter clockwise in NDC is clockwise on the y-down screen (negative area) */
+    area = (double)(fixed_x[1] - fixed_x[0]) * (double)(fixed_y[2] - fixed_y[0]) -
+           (double)(fixed_y[1] - fixed_y[0]) * (double)(fixed_x[2] - fixed_x[0]);
+
+    /* Back face culling (GL_BACK, GL_CCW) and degenerate triangles */
+    if (area >= 0.0)
+    {
+        return;
+    }
+
+    /* Swap to positive orientation so inside means all edge functions >= 0 */
+    {
+        beneath_software_vertex *tmp_vertex = v[1];
+        int tmp_x = fixed_x[1];
+        int tmp_y = fixed_y[1];
+        v[1] = v[2];
+        v[2] = tmp_vertex;
+        fixed_x[1] = fixed_x[2];
+        fixed_y[1] = fixed_y[2];
+        fixed_x[2] = tmp_x;
+        fixed_y[2] = tmp_y;
+    }
+
+    if (ctx->triangles_count >= BENEATH_SOFTWARE_TRIANGLES_MAX)
+    {
+        beneath_software_flush(ctx);
+    }
+
+    t = &ctx->triangles[ctx->triangles_count];
+
+    t->min_x = vm_maxi(beneath_software_pixel_min(vm_mini(fixed_x[0], vm_mini(fixed_x[1], fixed_x[2]))), 0);
+    t->min_y = vm_maxi(beneath_software_pixel_min(vm_mini(fixed_y[0], vm_mini(fixed_y[1], fixed_y[2]))), 0);
+    t->max_x = vm_mini(beneath_software_pixel_max(vm_maxi(fixed_x[0], vm_maxi(fixed_x[1], fixed_x[2]))), (int)ctx->width - 1);
+    t->max_y = vm_mini(beneath_software_pixel_max(vm_maxi(fixed_y[0], vm_maxi(fixed_y[1], fixed_y[2]))), (int)ctx->height - 1);
+
+    if (t->min_x > t->max_x || t->min_y > t->max_y)
+    {
+        return;
+    }
+
+    /* Bins are limited as well, a single triangle never covers more than all tiles */
+    {
+        unsigned int tiles = (unsigned int)(t->max_x / BENEATH_SOFTWARE_TILE_SIZE - t->min_x / BENEATH_SOFTWARE_TILE_SIZE + 1) *
+                             (unsigned int)(t->max_y / BENEATH_SOFTWARE_TILE_SIZE - t->min_y / BENEATH_SOFTWARE_TILE_SIZE + 1);
+
+        if (ctx->bin_entries_count + tiles > BENEATH_SOFTWARE_BIN_ENTRIES_MAX)
+        {
+            int min_x = t->min_x, min_y = t->min_y, max_x = t->max_x, max_y = t->max_y;
+            unsigned int draw_index = ctx->draws_count - 1;
+            beneath_software_draw_state draw = ctx->draws[draw_index];
+
+            beneath_software_flush(ctx);
+
+            /* Keep the draw state of the triangle in flight */
+            ctx->draws[0] = draw;
+            ctx->draws_count = 1;
+
+            t = &ctx->triangles[0];
+            t->min_x = min_x;
+            t->min_y = min_y;
+            t->max_x = max_x;
+            t->max_y = max_y;
+        }
+
+        ctx->bin_entries_count += tiles;
+    }
+
+    for (i = 0; i < 3; ++i)
+    {
+        int a = i;
+        int b = (i + 1) % 3;
+        int dx = fixed_x[b] - fixed_x[a];
+        int dy = fixed_y[b] - fixed_y[a];
+
+        t->x[i] = fixed_x[i];
+        t->y[i] = fixed_y[i];
+
+        /* Top edge (horizontal, going right) or left edge (going up on the y-down screen) */
+        t->bias[i] = ((dy == 0 && dx > 0) || dy < 0) ? 0 : 1;
+
+        sx[i] = (float)fixed_x[i] / (float)BENEATH_SOFTWARE_SUBPIXEL_ONE;
+        sy[i] = (float)fixed_y[i] / (float)BENEATH_SOFTWARE_SUBPIXEL_ONE;
+
+        /* Values that are affine in screen space */
+        {
+            float inv_w = 1.0f / v[i]->position[3];
+
+            q[0][i] = v[i]->position[2] * inv_w * 0.5f + 0.5f;
+            q[1][i] = inv_w;
+
+            for (p = 0; p < BENEATH_SOFTWARE_ATTRIBUTES; ++p)
+            {
+                q[2 + p][i] = v[i]->attributes[p] * inv_w;
+            }
+        }
+    }
+
+    area_inv = 1.0f / ((sx[1] - sx[0]) * (sy[2] - sy[0]) - (sx[2] - sx[0]) * (sy[1] - sy[0]));
+
+    t->origin_x = sx[0];
+    t->origin_y = sy[0];
+
+    for (p = 0; p < BENEATH_SOFTWARE_PLANES; ++p)
+    {
+        float d1 = q[p][1] - q[p][0];
+        float d2 = q[p][2] - q[p][0];
+
+        t->planes[p][0] = q[p][0];
+        t->planes[p][1] = (d1 * (sy[2] - sy[0]) - d2 * (sy[1] - sy[0])) * area_inv;
+        t->planes[p][2] = (d2 * (sx[1] - sx[0]) - d1 * (sx[2] - sx[0])) * area_inv;
+    }
+
+    t->draw_index = ctx->draws_count - 1;
+
+    ctx->triangles_count++;
+    ctx->stats_triangles++;
+}
+
+/* Sutherland-Hodgman against near/far and the guard band, then fan triangulation */
+BENEATH_API void beneath_software_triangle_clip(beneath_software_context *ctx, beneath_software_vertex *v0, beneath_software_vertex *v1, beneath_software_vertex *v2)
+{
+    beneath_software_vertex polygon_a[9];
+    beneath_software_vertex polygon_b[9];
+    beneath_software_vertex *in = polygon_a;
+    beneath_software_vertex *out = polygon_b;
+    int in_count = 3;
+    int plane;
+    int i;
+    int outside_mask = 0;
+
+    /* Fast path, nothing to clip */
+    for (plane = 0; plane < 6; ++plane)
+    {
+        if (beneath_software_clip_distance(v0->position, plane) < 0.0f ||
+            beneath_software_clip_distance(v1->position, plane) < 0.0f ||
+            beneath_software_clip_distance(v2->position, plane) < 0.0f)
+        {
+            outside_mask |= 1 << plane;
+        }
+    }
+
+    if (!outside_mask)
+    {
+        beneath_software_triangle_setup(ctx, v0, v1, v2);
+        return;
+    }
+
+    polygon_a[0] = *v0;
+    polygon_a[1] = *v1;
+    polygon_a[2] = *v2;
+
+    for (plane = 0; plane < 6; ++plane)
+    {
+        int out_count = 0;
+        beneath_software_vertex *swap;
+
+        if (!(outside_mask & (1 << plane)))
+        {
+            continue;
+        }
+
+        for (i = 0; i < in_count; ++i)
+        {
+            beneath_software_vertex *a = &in[i];
+            beneath_software_vertex *b = &in[(i + 1) % in_count];
+            float da = beneath_software_clip_distance(a->position, plane);
+            float db = beneath_software_clip_distance(b->position, plane);
+
+            if (da >= 0.0f)
+            {
+                out[out_count++] = *a;
+            }
+
+            if ((da >= 0.0f) != (db >= 0.0f))
+            {
+                float s = da / (da - db);
+                beneath_software_vertex *o = &out[out_count++];
+                int k;
+
+                for (k = 0; k < 4; ++k)
+                {
+                    o->position[k] = a->position[k] + (b->position[k] - a->position[k]) * s;
+                }
+
+                for (k = 0; k < BENEATH_SOFTWARE_ATTRIBUTES; ++k)
+                {
+                    o->attributes[k] = a->attributes[k] + (b->attributes[k] - a->attributes[k]) * s;
+                }
+            }
+        }
+
+        if (out_count < 3)
+        {
+            return;
+        }
+
+        swap = in;
+        in = out;
+        out = swap;
+        in_count = out_count;
+    }
+
+    for (i = 1; i + 1 < in_count; ++i)
+    {
+        beneath_software_triangle_setup(ctx, &in[0], &in[i], &in[i + 1]);
+    }
+}
+
+/******************************/
+/* Frame & Draw               */
+/******************************/
+BENEATH_API void beneath_software_frame_begin(beneath_software_context *ctx, float r, float g, float b, float a)
+{
+    ctx->clear_pending = true;
+    ctx->clear_color = beneath_software_pack_color(r, g, b, a);
+    ctx->stats_triangles = 0;
+    ctx->stats_flushes = 0;
+}
+
+/* Rasterizes everything submitted since the last flush, the color buffer is complete afterwards */
+BENEATH_API void beneath_software_frame_end(beneath_software_context *ctx)
+{
+    beneath_software_flush(ctx);
+}
+
+BENEATH_API beneath_bool beneath_software_draw(
+    beneath_software_context *ctx, /* The software renderer */
+    beneath_state *state,          /* The state */
+    beneath_draw_call *draw_call,  /* The draw call instanced objects */
+    float projection_view[16],     /* The projection view matrix */
+    float projection_inverse[16],  /* The projection matrix inversed (post processing only, unused) */
+    float view_inverse[16],        /* The view matrix inversed (post processing only, unused) */
+    float camera_position[3],      /* The camera x,y,z position */
+    beneath_api_io_print print)
+{
+    beneath_mesh *mesh;
+    beneath_software_draw_state *draw;
+    beneath_bool use_mesh_color;
+    unsigned int instance;
+    float pixels_per_unit;
+
+    (void)view_inverse;
+
+    if (!draw_call || draw_call->models_count == 0 || !draw_call->mesh)
+    {
+        return false;
+    }
+
+    if (!ctx->initialized)
+    {
+        print(__FILE__, __LINE__, "[software] renderer is not initialized!\n");
+        return false;
+    }
+
+    mesh = draw_call->mesh;
+
+    /* The LOD selection needs the bounds of the draw call mesh */
+    if (draw_call->lods_count > 0 && !mesh->bounds_valid)
+    {
+        beneath_mesh_bounds_compute(mesh);
+    }
+
+    pixels_per_unit = (float)state->window_height * 0.5f / projection_inverse[5];
+    use_mesh_color = mesh->colors_count > 0 && draw_call->colors_count == 0 && draw_call->texture_indices_count == 0;
+
+    if (ctx->draws_count >= BENEATH_SOFTWARE_DRAWS_MAX)
+    {
+        beneath_software_flush(ctx);
+    }
+
+    draw = &ctx->draws[ctx->draws_count++];
+    draw->lit = draw_call->lightning && mesh->normals_count > 0;
+    draw->camera_position[0] = camera_position[0];
+    draw->camera_position[1] = camera_position[1];
+    draw->camera_position[2] = camera_position[2];
+
+    if (draw_call->lightning)
+    {
+        v3 light_dir;
+
+        draw->light = draw_call->lightning->directional;
+
+        light_dir = vm_v3_normalize(vm_v3(-draw->light.direction[0], -draw->light.direction[1], -draw->light.direction[2]));
+        draw->light_dir[0] = light_dir.x;
+        draw->light_dir[1] = light_dir.y;
+        draw->light_dir[2] = light_dir.z;
+    }
+
+    for (instance = 0; instance < draw_call->models_count; ++instance)
+    {
+        m4x4 model;
+        m4x4 model_inverse;
+        float instance_color[3] = {1.0f, 1.0f, 1.0f};
+        unsigned int i;
+
+        /* Coarser meshes of the LOD chain for distant instances, they share the attributes of the draw call mesh */
+        mesh = beneath_draw_call_lod_mesh(draw_call, beneath_draw_call_lod_select(draw_call, draw_call->models + instance * 16, camera_position, pixels_per_unit));
+
+        for (i = 0; i < 16; ++i)
+        {
+            model.e[i] = draw_call->models[instance * 16 + i];
+        }
+
+        model_inverse = vm_m4x4_inverse(model);
+
+        if (!use_mesh_color && draw_call->colors_count > 0)
+        {
+            unsigned int color_index = draw_call->colors_count == 1 ? 0 : instance;
+            instance_color[0] = draw_call->colors[color_index * 3 + 0];
+            instance_color[1] = draw_call->colors[color_index * 3 + 1];
+            instance_color[2] = draw_call->colors[color_index * 3 + 2];
+        }
+
+        for (i = 0; i + 2 < mesh->indices_count; i += 3)
+        {
+            beneath_software_vertex v[3];
+            int corner;
+
+            for (corner = 0; corner < 3; ++corner)
+            {
+                unsigned int index = beneath_mesh_index(mesh, i + (unsigned int)corner);
+                float *p = &mesh->vertices[index * 3];
+                float world[3];
+                int r;
+
+                /* world = model * vec4(position, 1.0) */
+                for (r = 0; r < 3; ++r)
+                {
+                    world[r] = model.e[VM_M4X4_AT(r, 0)] * p[0] + model.e[VM_M4X4_AT(r, 1)] * p[1] + model.e[VM_M4X4_AT(r, 2)] * p[2] + model.e[VM_M4X4_AT(r, 3)];
+                    v[corner].attributes[r] = world[r];
+                }
+
+                /* gl_Position = pv * world_pos */
+                for (r = 0; r < 4; ++r)
+                {
+                    v[corner].position[r] = projection_view[VM_M4X4_AT(r, 0)] * world[0] + projection_view[VM_M4X4_AT(r, 1)] * world[1] + projection_view[VM_M4X4_AT(r, 2)] * world[2] + projection_view[VM_M4X4_AT(r, 3)];
+                }
+
+                /* v_normal = mat3(transpose(inverse(model))) * normal */
+                if (mesh->normals_count > 0)
+                {
+                    float *n = &mesh->normals[index * 3];
+
+                    for (r = 0; r < 3; ++r)
+                    {
+                        v[corner].attributes[3 + r] = model_inverse.e[VM_M4X4_AT(0, r)] * n[0] + model_inverse.e[VM_M4X4_AT(1, r)] * n[1] + model_inverse.e[VM_M4X4_AT(2, r)] * n[2];
+                    }
+                }
+                else
+                {
+                    v[corner].attributes[3] = 0.0f;
+                    v[corner].attributes[4] = 1.0f;
+                    v[corner].attributes[5] = 0.0f;
+                }
+
+                if (use_mesh_color)
+                {
+                    v[corner].attributes[6] = mesh->colors[index * 3 + 0];
+                    v[corner].attributes[7] = mesh->colors[index * 3 + 1];
+                    v[corner].attributes[8] = mesh->colors[index * 3 + 2];
+                }
+                else
+                {
+                    v[corner].attributes[6] = instance_color[0];
+                    v[corner].attributes[7] = instance_color[1];
+                    v[corner].attributes[8] = instance_color[2];
+                }
+            }
+
+            beneath_software_triangle_clip(ctx, &v[0], &v[1], &v[2]);
+        }
+    }
+
+    draw_call->changed = false;
+    draw_call->mesh->changed = false;
+
+    return true;
+}
+
+#endif /* BENEATH_SOFTWARE_H */
@@ -178,10 +178,11 @@ VM_API VM_INLINE float vm_invsqrt(float number)
 
     return _mm_cvtss_f32(y);
 #else
+    /* int and not long, long is 64 bit on LP64 and its upper half would be uninitialized */
     union
     {
         float f;
-        long i;
+        int i;
     } conv;
 
     float x2, y;
@@ -2050,6 +2051,134 @@ VM_API VM_INLINE int vm_frustum_is_sphere_in(frustum frustum, v3 center, float r
     return (1); /* Intersects or inside */
 }
 
+/* Batch sphere test over structure of arrays input (center x, y, z and radius arrays).
+ * out_mask[i] is 1 if sphere i intersects or lies inside the frustum and 0 if it is
+ * completely outside. Every sphere is tested against all six planes without early
+ * outs so that the SIMD lanes stay in lock step.
+ *
+ * AVX (8 spheres per step) or SSE (4 spheres per step) is used when the compiler
+ * targets it, the remaining spheres and all other platforms use the scalar loop.
+ */
+#if defined(__AVX__)
+#define VM_FRUSTUM_CULL_AVX
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define VM_FRUSTUM_CULL_SSE
+#include <xmmintrin.h>
+#endif
+
+VM_API VM_INLINE void vm_frustum_cull_spheres_scalar(frustum *frustum, const float *cx, const float *cy, const float *cz, const float *r, int count, unsigned char *out_mask)
+{
+    v4 *frustum_data = vm_frustum_data(frustum);
+    int i;
+
+    for (i = 0; i < count; ++i)
+    {
+        int inside = 1;
+        int j;
+
+        for (j = 0; j < VM_FRUSTUM_PLANE_SIZE; ++j)
+        {
+            float distance = frustum_data[j].x * cx[i] + frustum_data[j].y * cy[i] + frustum_data[j].z * cz[i] + frustum_data[j].w;
+
+            inside &= (distance >= -r[i]);
+        }
+
+        out_mask[i] = (unsigned char)inside;
+    }
+}
+
+VM_API VM_INLINE void vm_frustum_cull_spheres(frustum *frustum, const float *cx, const float *cy, const float *cz, const float *r, int count, unsigned char *out_mask)
+{
+    int i = 0;
+
+#if defined(VM_FRUSTUM_CULL_AVX)
+    v4 *frustum_data = vm_frustum_data(frustum);
+    __m256 px[VM_FRUSTUM_PLANE_SIZE];
+    __m256 py[VM_FRUSTUM_PLANE_SIZE];
+    __m256 pz[VM_FRUSTUM_PLANE_SIZE];
+    __m256 pw[VM_FRUSTUM_PLANE_SIZE];
+    int j;
+
+    /* Planes broadcast once, one register per plane component */
+    for (j = 0; j < VM_FRUSTUM_PLANE_SIZE; ++j)
+    {
+        px[j] = _mm256_set1_ps(frustum_data[j].x);
+        py[j] = _mm256_set1_ps(frustum_data[j].y);
+        pz[j] = _mm256_set1_ps(frustum_data[j].z);
+        pw[j] = _mm256_set1_ps(frustum_data[j].w);
+    }
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(cx + i);
+        __m256 y = _mm256_loadu_ps(cy + i);
+        __m256 z = _mm256_loadu_ps(cz + i);
+        __m256 radius_negated = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(r + i));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        int bits;
+        int k;
+
+        for (j = 0; j < VM_FRUSTUM_PLANE_SIZE; ++j)
+        {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px[j], x), _mm256_mul_ps(py[j], y)), _mm256_add_ps(_mm256_mul_ps(pz[j], z), pw[j]));
+
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, radius_negated, _CMP_GE_OQ));
+        }
+
+        bits = _mm256_movemask_ps(inside);
+
+        for (k = 0; k < 8; ++k)
+        {
+            out_mask[i + k] = (unsigned char)((bits >> k) & 1);
+        }
+    }
+#elif defined(VM_FRUSTUM_CULL_SSE)
+    v4 *frustum_data = vm_frustum_data(frustum);
+    __m128 px[VM_FRUSTUM_PLANE_SIZE];
+    __m128 py[VM_FRUSTUM_PLANE_SIZE];
+    __m128 pz[VM_FRUSTUM_PLANE_SIZE];
+    __m128 pw[VM_FRUSTUM_PLANE_SIZE];
+    int j;
+
+    /* Planes broadcast once, one register per plane component */
+    for (j = 0; j < VM_FRUSTUM_PLANE_SIZE; ++j)
+    {
+        px[j] = _mm_set1_ps(frustum_data[j].x);
+        py[j] = _mm_set1_ps(frustum_data[j].y);
+        pz[j] = _mm_set1_ps(frustum_data[j].z);
+        pw[j] = _mm_set1_ps(frustum_data[j].w);
+    }
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(cx + i);
+        __m128 y = _mm_loadu_ps(cy + i);
+        __m128 z = _mm_loadu_ps(cz + i);
+        __m128 radius_negated = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(r + i));
+        __m128 inside = _mm_cmpeq_ps(x, x);
+        int bits;
+
+        for (j = 0; j < VM_FRUSTUM_PLANE_SIZE; ++j)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px[j], x), _mm_mul_ps(py[j], y)), _mm_add_ps(_mm_mul_ps(pz[j], z), pw[j]));
+
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, radius_negated));
+        }
+
+        bits = _mm_movemask_ps(inside);
+
+        out_mask[i + 0] = (unsigned char)(bits & 1);
+        out_mask[i + 1] = (unsigned char)((bits >> 1) & 1);
+        out_mask[i + 2] = (unsigned char)((bits >> 2) & 1);
+        out_mask[i + 3] = (unsigned char)((bits >> 3) & 1);
+    }
+#endif
+
+    /* Remaining spheres (or all of them without SIMD) */
+    vm_frustum_cull_spheres_scalar(frustum, cx + i, cy + i, cz + i, r + i, count - i, out_mask + i);
+}
+
 /* #############################################################################
  * # TRANSFORMATION FUNCTIONS
  * #############################################################################
@@ -0,0 +1,364 @@
+#ifndef LINUX_API_H
+#define LINUX_API_H
+
+/* Raw linux syscall interface (no C Standard Library, no libc startup) */
+#if !defined(__x86_64__) && !defined(__aarch64__)
+#error "linux_api.h: only x86_64 and aarch64 syscall conventions are implemented!"
+#endif
+
+/* Check if using C99 or later (inline is supported) */
+#if __STDC_VERSION__ >= 199901L
+#define LINUX_INLINE inline
+#else
+#define LINUX_INLINE __inline__
+#endif
+
+#define LINUX_API static
+
+#ifndef NULL
+#define NULL ((void *)0)
+#endif
+
+/* #############################################################################
+ * # Syscall numbers
+ * #############################################################################
+ */
+#ifdef __x86_64__
+#define LINUX_SYS_READ 0
+#define LINUX_SYS_WRITE 1
+#define LINUX_SYS_CLOSE 3
+#define LINUX_SYS_LSEEK 8
+#define LINUX_SYS_MMAP 9
+#define LINUX_SYS_MPROTECT 10
+#define LINUX_SYS_MUNMAP 11
+#define LINUX_SYS_NANOSLEEP 35
+#define LINUX_SYS_CLONE 56
+#define LINUX_SYS_EXIT 60
+#define LINUX_SYS_FUTEX 202
+#define LINUX_SYS_SCHED_GETAFFINITY 204
+#define LINUX_SYS_CLOCK_GETTIME 228
+#define LINUX_SYS_EXIT_GROUP 231
+#define LINUX_SYS_OPENAT 257
+#else /* __aarch64__ */
+#define LINUX_SYS_CLOSE 57
+#define LINUX_SYS_LSEEK 62
+#define LINUX_SYS_READ 63
+#define LINUX_SYS_WRITE 64
+#define LINUX_SYS_NANOSLEEP 101
+#define LINUX_SYS_CLOCK_GETTIME 113
+#define LINUX_SYS_EXIT_GROUP 94
+#define LINUX_SYS_OPENAT 56
+#define LINUX_SYS_MUNMAP 215
+#define LINUX_SYS_MMAP 222
+#define LINUX_SYS_MPROTECT 226
+#define LINUX_SYS_EXIT 93
+#define LINUX_SYS_FUTEX 98
+#define LINUX_SYS_SCHED_GETAFFINITY 123
+#define LINUX_SYS_CLONE 220
+#endif
+
+/* #############################################################################
+ * # Constants
+ * #############################################################################
+ */
+#define LINUX_STDOUT 1
+#define LINUX_STDERR 2
+
+#define LINUX_AT_FDCWD -100
+
+#define LINUX_O_RDONLY 00
+#define LINUX_O_WRONLY 01
+#define LINUX_O_CREAT 0100
+#define LINUX_O_TRUNC 01000
+#define LINUX_O_CLOEXEC 02000000
+
+#define LINUX_SEEK_SET 0
+#define LINUX_SEEK_END 2
+
+#define LINUX_PROT_NONE 0x0
+#define LINUX_PROT_READ 0x1
+#define LINUX_PROT_WRITE 0x2
+
+#define LINUX_MAP_PRIVATE 0x02
+#define LINUX_MAP_ANONYMOUS 0x20
+#define LINUX_MAP_NORESERVE 0x4000
+#define LINUX_MAP_FAILED ((void *)-1)
+
+#define LINUX_CLOCK_MONOTONIC 1
+
+#define LINUX_MAP_STACK 0x20000
+
+#define LINUX_FUTEX_WAIT_PRIVATE 128
+#define LINUX_FUTEX_WAKE_PRIVATE 129
+
+/* CLONE_VM | CLONE_FS | CLONE_FILES | CLONE_SIGHAND | CLONE_THREAD | CLONE_SYSVSEM */
+#define LINUX_CLONE_THREAD_FLAGS 0x50F00
+
+/* Syscalls return -errno on failure in the range [-4095, -1] */
+#define LINUX_IS_ERROR(r) ((unsigned long)(r) > (unsigned long)-4096L)
+
+typedef struct linux_timespec
+{
+    long tv_sec;
+    long tv_nsec;
+
+} linux_timespec;
+
+/* #############################################################################
+ * # Syscall entry
+ * #############################################################################
+ */
+LINUX_API LINUX_INLINE long linux_syscall6(long n, long a1, long a2, long a3, long a4, long a5, long a6)
+{
+    long ret;
+#ifdef __x86_64__
+    register long r10 __asm__("r10") = a4;
+    register long r8 __asm__("r8") = a5;
+    register long r9 __asm__("r9") = a6;
+
+    __asm__ __volatile__(
+        "syscall"
+        : "=a"(ret)
+        : "a"(n), "D"(a1), "S"(a2), "d"(a3), "r"(r10), "r"(r8), "r"(r9)
+        : "rcx", "r11", "memory");
+#else
+    register long x8 __asm__("x8") = n;
+    register long x0 __asm__("x0") = a1;
+    register long x1 __asm__("x1") = a2;
+    register long x2 __asm__("x2") = a3;
+    register long x3 __asm__("x3") = a4;
+    register long x4 __asm__("x4") = a5;
+    register long x5 __asm__("x5") = a6;
+
+    __asm__ __volatile__(
+        "svc 0"
+        : "+r"(x0)
+        : "r"(x8), "r"(x1), "r"(x2), "r"(x3), "r"(x4), "r"(x5)
+        : "memory");
+
+    ret = x0;
+#endif
+    return ret;
+}
+
+#define linux_syscall3(n, a1, a2, a3) linux_syscall6((n), (long)(a1), (long)(a2), (long)(a3), 0, 0, 0)
+
+/* #############################################################################
+ * # Syscall wrappers
+ * #############################################################################
+ */
+LINUX_API LINUX_INLINE long linux_read(int fd, void *buffer, unsigned long count)
+{
+    return linux_syscall3(LINUX_SYS_READ, fd, buffer, count);
+}
+
+LINUX_API LINUX_INLINE long linux_write(int fd, void *buffer, unsigned long count)
+{
+    return linux_syscall3(LINUX_SYS_WRITE, fd, buffer, count);
+}
+
+LINUX_API LINUX_INLINE int linux_open(char *pathname, int flags, int mode)
+{
+    return (int)linux_syscall6(LINUX_SYS_OPENAT, LINUX_AT_FDCWD, (long)pathname, flags, mode, 0, 0);
+}
+
+LINUX_API LINUX_INLINE int linux_close(int fd)
+{
+    return (int)linux_syscall3(LINUX_SYS_CLOSE, fd, 0, 0);
+}
+
+LINUX_API LINUX_INLINE long linux_lseek(int fd, long offset, int whence)
+{
+    return linux_syscall3(LINUX_SYS_LSEEK, fd, offset, whence);
+}
+
+LINUX_API LINUX_INLINE void *linux_mmap(void *address, unsigned long length, int prot, int flags, int fd, long offset)
+{
+    long ret = linux_syscall6(LINUX_SYS_MMAP, (long)address, (long)length, prot, flags, fd, offset);
+    return LINUX_IS_ERROR(ret) ? LINUX_MAP_FAILED : (void *)ret;
+}
+
+LINUX_API LINUX_INLINE int linux_munmap(void *address, unsigned long length)
+{
+    return (int)linux_syscall3(LINUX_SYS_MUNMAP, address, length, 0);
+}
+
+LINUX_API LINUX_INLINE int linux_mprotect(void *address, unsigned long length, int prot)
+{
+    return (int)linux_syscall3(LINUX_SYS_MPROTECT, address, length, prot);
+}
+
+LINUX_API LINUX_INLINE int linux_clock_gettime(int clock_id, linux_timespec *ts)
+{
+    return (int)linux_syscall3(LINUX_SYS_CLOCK_GETTIME, clock_id, ts, 0);
+}
+
+LINUX_API LINUX_INLINE int linux_nanosleep(linux_timespec *duration, linux_timespec *remaining)
+{
+    return (int)linux_syscall3(LINUX_SYS_NANOSLEEP, duration, remaining, 0);
+}
+
+LINUX_API LINUX_INLINE void linux_exit_group(int status)
+{
+    for (;;)
+    {
+        linux_syscall3(LINUX_SYS_EXIT_GROUP, status, 0, 0);
+    }
+}
+
+LINUX_API LINUX_INLINE int linux_futex_wait(int *address, int expected)
+{
+    return (int)linux_syscall6(LINUX_SYS_FUTEX, (long)address, LINUX_FUTEX_WAIT_PRIVATE, expected, 0, 0, 0);
+}
+
+LINUX_API LINUX_INLINE int linux_futex_wake(int *address, int count)
+{
+    return (int)linux_syscall6(LINUX_SYS_FUTEX, (long)address, LINUX_FUTEX_WAKE_PRIVATE, count, 0, 0, 0);
+}
+
+/* Number of CPUs the process may run on (1 if the query fails) */
+LINUX_API LINUX_INLINE unsigned int linux_cpu_count(void)
+{
+    unsigned long mask[16];
+    unsigned int count = 0;
+    long bytes = linux_syscall3(LINUX_SYS_SCHED_GETAFFINITY, 0, sizeof(mask), mask);
+    long i;
+
+    if (LINUX_IS_ERROR(bytes))
+    {
+        return 1;
+    }
+
+    for (i = 0; i < bytes / (long)sizeof(unsigned long); ++i)
+    {
+        unsigned long bits = mask[i];
+
+        while (bits)
+        {
+            bits &= bits - 1;
+            count++;
+        }
+    }
+
+    return count ? count : 1;
+}
+
+typedef void (*linux_thread_proc)(void *arg);
+
+/* Laid out at the top of a new thread stack, popped by the child */
+typedef struct linux_thread_start
+{
+    linux_thread_proc proc;
+    void *arg;
+
+} linux_thread_start;
+
+/* Starts proc(arg) on a new thread running on the 16 byte aligned stack_top.
+ * The thread exits when proc returns. Returns the thread id or -errno.
+ *
+ * clone() continues the child on the new stack, so the child side is written
+ * in assembly: proc and arg are placed on the child stack, popped and called.
+ */
+LINUX_API LINUX_INLINE long linux_thread_create(void *stack_top, linux_thread_proc proc, void *arg)
+{
+    linux_thread_start *stack = (linux_thread_start *)stack_top - 1;
+    long ret;
+
+    stack->proc = proc;
+    stack->arg = arg;
+
+#ifdef __x86_64__
+    {
+        register long r10 __asm__("r10") = 0;
+        register long r8 __asm__("r8") = 0;
+
+        __asm__ __volatile__(
+            "syscall\n"
+            "test %%rax, %%rax\n"
+            "jnz 1f\n"
+            "xor %%ebp, %%ebp\n"
+            "pop %%rax\n"
+            "pop %%rdi\n"
+            "call *%%rax\n"
+            "mov %[sys_exit], %%eax\n"
+            "xor %%edi, %%edi\n"
+            "syscall\n"
+            "hlt\n"
+            "1:\n"
+            : "=a"(ret)
+            : "a"((long)LINUX_SYS_CLONE), "D"((long)LINUX_CLONE_THREAD_FLAGS), "S"(stack), "d"(0L), "r"(r10), "r"(r8), [sys_exit] "i"(LINUX_SYS_EXIT)
+            : "rcx", "r11", "memory");
+    }
+#else
+    {
+        register long x8 __asm__("x8") = LINUX_SYS_CLONE;
+        register long x0 __asm__("x0") = LINUX_CLONE_THREAD_FLAGS;
+        register long x1 __asm__("x1") = (long)stack;
+        register long x2 __asm__("x2") = 0;
+        register long x3 __asm__("x3") = 0;
+        register long x4 __asm__("x4") = 0;
+
+        __asm__ __volatile__(
+            "svc 0\n"
+            "cbnz x0, 1f\n"
+            "ldp x1, x0, [sp], #16\n"
+            "mov x29, #0\n"
+            "blr x1\n"
+            "mov x8, %[sys_exit]\n"
+            "mov x0, #0\n"
+            "svc 0\n"
+            "1:\n"
+            : "+r"(x0)
+            : "r"(x8), "r"(x1), "r"(x2), "r"(x3), "r"(x4), [sys_exit] "i"(LINUX_SYS_EXIT)
+            : "x30", "memory");
+
+        ret = x0;
+    }
+#endif
+
+    return ret;
+}
+
+#endif /* LINUX_API_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+*/
@@ -0,0 +1,1768 @@
+#define BENEATH_PLATFORM_LAYER
+#define BENEATH_PLATFORM_LAYER_NAME "linux_beneath"
+#ifdef BENEATH_OPENGL_HEADLESS
+#define BENEATH_USE_CRT /* libEGL and the GL driver require the libc runtime */
+#endif
+#include "beneath.h"
+
+#include "linux_api.h" /* raw syscalls instead of libc */
+
+#include "beneath_jobs.h" /* work stealing job scheduler */
+
+#ifdef BENEATH_OPENGL_HEADLESS
+#include "linux_beneath_opengl_loader.h" /* EGL context and opengl loading */
+#include "win32_beneath_opengl.h"        /* beneath opengl renderer        */
+#endif
+
+#ifdef BENEATH_RENDER_THREAD
+#ifndef BENEATH_OPENGL_HEADLESS
+#error "linux_beneath: 'BENEATH_RENDER_THREAD' needs the GL context of 'BENEATH_OPENGL_HEADLESS'!"
+#endif
+#include <pthread.h> /* The GL driver uses thread local storage, only libc threads set it up */
+#endif
+
+#ifdef BENEATH_SOFTWARE
+#include "beneath_software.h" /* CPU tiled rasterizer */
+#endif
+
+#if defined(BENEATH_SOFTWARE) && defined(BENEATH_OPENGL_HEADLESS)
+#error "linux_beneath: 'BENEATH_SOFTWARE' and 'BENEATH_OPENGL_HEADLESS' are exclusive renderers!"
+#endif
+
+#ifdef BENEATH_LIB
+#error "linux_beneath: 'BENEATH_LIB' is not supported. Loading a shared library requires the libc dynamic loader, link the application statically!"
+#endif
+
+BENEATH_API BENEATH_INLINE unsigned int linux_beneath_api_strlen(char *str)
+{
+    unsigned int length = 0;
+    while (str[length] != '\0')
+    {
+        length++;
+    }
+    return length;
+}
+
+BENEATH_API BENEATH_INLINE unsigned int linux_beneath_api_append_uint(char *dest, unsigned int value)
+{
+    char digits[10];
+    unsigned int count = 0;
+    unsigned int i;
+
+    do
+    {
+        digits[count++] = (char)('0' + (value % 10));
+        value /= 10;
+    } while (value > 0);
+
+    for (i = 0; i < count; ++i)
+    {
+        dest[i] = digits[count - 1 - i];
+    }
+
+    return count;
+}
+
+BENEATH_API BENEATH_INLINE void linux_beneath_api_io_print(
+    char *filename, /* The current compilation unit filename (usualy __FILE__)*/
+    int line,       /* The current compilation unit line number (usually __LINE__)*/
+    char *string    /* The string to print to the console */
+)
+{
+    char output[8192];
+    unsigned int len = 0;
+
+    /* Write filename:line prefix */
+    while (filename[len] && len < 4096)
+    {
+        output[len] = filename[len];
+        len++;
+    }
+    output[len++] = ':';
+    len += linux_beneath_api_append_uint(output + len, (unsigned int)line);
+    output[len++] = ' ';
+
+    /* Copy string safely, truncating if needed */
+    {
+        unsigned int i;
+        for (i = 0; i + len < sizeof(output) - 1 && string[i]; i++)
+        {
+            output[len + i] = string[i];
+        }
+        len += i;
+    }
+
+    linux_write(LINUX_STDOUT, output, len);
+}
+
+BENEATH_API BENEATH_INLINE beneath_bool linux_beneath_api_io_file_size(
+    char *filename,         /* The filename/path of which to return the file size */
+    unsigned int *file_size /* The gathered file size in bytes */
+)
+{
+    long size;
+    int fd = linux_open(filename, LINUX_O_RDONLY | LINUX_O_CLOEXEC, 0);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    size = linux_lseek(fd, 0, LINUX_SEEK_END);
+    linux_close(fd);
+
+    if (size < 0 || size > 0xFFFFFFFFL)
+    {
+        return false;
+    }
+
+    *file_size = (unsigned int)size;
+
+    return true;
+}
+
+BENEATH_API BENEATH_INLINE beneath_bool linux_beneath_api_io_file_read(
+    char *filename,                    /* The filename/path to read into the file_buffer */
+    unsigned char *file_buffer,        /* The user provided file_buffer large enough to hold the file contents */
+    unsigned int file_buffer_capacity, /* The capacity/max site of the file_buffer */
+    unsigned int *file_buffer_size     /* The total number of bytes read by this function */
+)
+{
+    long file_size;
+    unsigned long bytes_read = 0;
+    int fd = linux_open(filename, LINUX_O_RDONLY | LINUX_O_CLOEXEC, 0);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    file_size = linux_lseek(fd, 0, LINUX_SEEK_END);
+
+    if (file_size < 0 || (unsigned long)file_buffer_capacity < (unsigned long)file_size + 1 || linux_lseek(fd, 0, LINUX_SEEK_SET) != 0)
+    {
+        linux_close(fd);
+        return false;
+    }
+
+    /* read() may return less than requested, loop until the whole file is in */
+    while (bytes_read < (unsigned long)file_size)
+    {
+        long r = linux_read(fd, file_buffer + bytes_read, (unsigned long)file_size - bytes_read);
+
+        if (r <= 0)
+        {
+            linux_close(fd);
+            return false;
+        }
+
+        bytes_read += (unsigned long)r;
+    }
+
+    file_buffer[file_size] = '\0';
+    *file_buffer_size = (unsigned int)file_size;
+
+    linux_close(fd);
+
+    return true;
+}
+
+BENEATH_API BENEATH_INLINE beneath_bool linux_beneath_api_io_file_write(
+    char *filename,          /* The filename/path to write the file_buffer to */
+    unsigned char *buffer,   /* The file content to be written */
+    unsigned int buffer_size /* The size of the file content buffer */
+)
+{
+    unsigned long bytes_written = 0;
+    int fd = linux_open(filename, LINUX_O_WRONLY | LINUX_O_CREAT | LINUX_O_TRUNC | LINUX_O_CLOEXEC, 0644);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    while (bytes_written < buffer_size)
+    {
+        long w = linux_write(fd, buffer + bytes_written, buffer_size - bytes_written);
+
+        if (w <= 0)
+        {
+            break;
+        }
+
+        bytes_written += (unsigned long)w;
+    }
+
+    return (linux_close(fd) == 0 && bytes_written == buffer_size);
+}
+
+BENEATH_API BENEATH_INLINE beneath_bool linux_beneath_api_io_file_map(
+    char *filename,         /* The filename/path to map */
+    void **file_data,       /* The start of the mapped file contents */
+    unsigned int *file_size /* The size of the mapping in bytes */
+)
+{
+    long size;
+    void *data;
+    int fd = linux_open(filename, LINUX_O_RDONLY | LINUX_O_CLOEXEC, 0);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    size = linux_lseek(fd, 0, LINUX_SEEK_END);
+
+    /* mmap rejects empty files */
+    if (size <= 0 || size > 0xFFFFFFFFL)
+    {
+        linux_close(fd);
+        return false;
+    }
+
+    data = linux_mmap(0, (unsigned long)size, LINUX_PROT_READ, LINUX_MAP_PRIVATE, fd, 0);
+
+    /* The mapping keeps its own reference to the file */
+    linux_close(fd);
+
+    if (data == LINUX_MAP_FAILED)
+    {
+        return false;
+    }
+
+    *file_data = data;
+    *file_size = (unsigned int)size;
+
+    return true;
+}
+
+BENEATH_API BENEATH_INLINE beneath_bool linux_beneath_api_io_file_unmap(
+    void *file_data,       /* The file_data returned by io_file_map */
+    unsigned int file_size /* The file_size returned by io_file_map */
+)
+{
+    return linux_munmap(file_data, file_size) == 0;
+}
+
+/* #############################################################################
+ * # Asynchronous file io (one io thread via raw clone/futex)
+ * #############################################################################
+ *
+ * The main thread is the only producer and the io thread the only consumer of the
+ * submission ring. A request slot belongs to the main thread while its status is
+ * INVALID, to the io thread while PENDING and back to the main thread afterwards.
+ */
+#define LINUX_BENEATH_IO_REQUESTS_MAX 64 /* Slots, the handle keeps the slot in its low 7 bits */
+#define LINUX_BENEATH_IO_THREAD_STACK_SIZE (64 * 1024)
+
+typedef struct linux_beneath_io_request
+{
+    int status; /* beneath_io_status */
+    unsigned int generation;
+    unsigned char *buffer;
+    unsigned int capacity;
+    unsigned int size;
+    char filename[BENEATH_IO_FILENAME_MAX];
+
+} linux_beneath_io_request;
+
+typedef struct linux_beneath_io_queue
+{
+    int submitted;          /* Futex, number of submitted requests */
+    unsigned int consumed;  /* Requests taken by the io thread */
+    beneath_bool started;   /* The io thread runs */
+    beneath_bool fallback;  /* No io thread could be started, reads are synchronous */
+    unsigned int ring[LINUX_BENEATH_IO_REQUESTS_MAX];
+    linux_beneath_io_request requests[LINUX_BENEATH_IO_REQUESTS_MAX];
+
+} linux_beneath_io_queue;
+
+static linux_beneath_io_queue io_queue;
+
+BENEATH_API void linux_beneath_io_request_execute(linux_beneath_io_request *request)
+{
+    beneath_bool success = linux_beneath_api_io_file_read(request->filename, request->buffer, request->capacity, &request->size);
+
+    /* Publishes size and buffer contents before the status */
+    __sync_synchronize();
+    request->status = success ? BENEATH_IO_STATUS_COMPLETED : BENEATH_IO_STATUS_FAILED;
+}
+
+BENEATH_API void linux_beneath_io_worker(void *arg)
+{
+    (void)arg;
+
+    for (;;)
+    {
+        int submitted = __sync_fetch_and_add(&io_queue.submitted, 0);
+
+        if ((unsigned int)submitted == io_queue.consumed)
+        {
+            linux_futex_wait(&io_queue.submitted, submitted);
+            continue;
+        }
+
+        linux_beneath_io_request_execute(&io_queue.requests[io_queue.ring[io_queue.consumed % LINUX_BENEATH_IO_REQUESTS_MAX]]);
+        io_queue.consumed++;
+    }
+}
+
+BENEATH_API beneath_bool linux_beneath_io_thread_start(void)
+{
+    void *stack = linux_mmap(NULL, LINUX_BENEATH_IO_THREAD_STACK_SIZE, LINUX_PROT_READ | LINUX_PROT_WRITE, LINUX_MAP_PRIVATE | LINUX_MAP_ANONYMOUS | LINUX_MAP_STACK, -1, 0);
+
+    if (stack == LINUX_MAP_FAILED)
+    {
+        return false;
+    }
+
+    if (LINUX_IS_ERROR(linux_thread_create((unsigned char *)stack + LINUX_BENEATH_IO_THREAD_STACK_SIZE, linux_beneath_io_worker, NULL)))
+    {
+        linux_munmap(stack, LINUX_BENEATH_IO_THREAD_STACK_SIZE);
+        return false;
+    }
+
+    return true;
+}
+
+BENEATH_API beneath_io_handle linux_beneath_api_io_file_read_async(
+    char *filename,                   /* The filename/path to read, copied (at most BENEATH_IO_FILENAME_MAX - 1 characters) */
+    unsigned char *file_buffer,       /* The user provided file_buffer large enough to hold the file contents */
+    unsigned int file_buffer_capacity /* The capacity/max site of the file_buffer */
+)
+{
+    linux_beneath_io_request *request = NULL;
+    unsigned int slot;
+    unsigned int i;
+
+    for (slot = 0; slot < LINUX_BENEATH_IO_REQUESTS_MAX; ++slot)
+    {
+        if (io_queue.requests[slot].status == BENEATH_IO_STATUS_INVALID)
+        {
+            request = &io_queue.requests[slot];
+            break;
+        }
+    }
+
+    if (!request || linux_beneath_api_strlen(filename) >= BENEATH_IO_FILENAME_MAX)
+    {
+        return 0;
+    }
+
+    /* Started on first use, applications without streaming do not pay for the thread */
+    if (!io_queue.started && !io_queue.fallback)
+    {
+        io_queue.started = linux_beneath_io_thread_start();
+        io_queue.fallback = !io_queue.started;
+    }
+
+    for (i = 0; filename[i]; ++i)
+    {
+        request->filename[i] = filename[i];
+    }
+
+    request->filename[i] = '\0';
+    request->buffer = file_buffer;
+    request->capacity = file_buffer_capacity;
+    request->size = 0;
+    request->status = BENEATH_IO_STATUS_PENDING;
+
+    if (io_queue.fallback)
+    {
+        linux_beneath_io_request_execute(request);
+    }
+    else
+    {
+        io_queue.ring[(unsigned int)io_queue.submitted % LINUX_BENEATH_IO_REQUESTS_MAX] = slot;
+        __sync_fetch_and_add(&io_queue.submitted, 1);
+        linux_futex_wake(&io_queue.submitted, 1);
+    }
+
+    return ((request->generation & 0x1FFFFFFu) << 7) | (slot + 1);
+}
+
+BENEATH_API beneath_io_status linux_beneath_api_io_file_read_poll(
+    beneath_io_handle handle,      /* The handle returned by io_file_read_async */
+    unsigned int *file_buffer_size /* The total number of bytes read once COMPLETED */
+)
+{
+    unsigned int slot = (handle & 0x7Fu) - 1;
+    linux_beneath_io_request *request;
+    int status;
+
+    if (handle == 0 || slot >= LINUX_BENEATH_IO_REQUESTS_MAX)
+    {
+        return BENEATH_IO_STATUS_INVALID;
+    }
+
+    request = &io_queue.requests[slot];
+    status = __sync_fetch_and_add(&request->status, 0);
+
+    if (status == BENEATH_IO_STATUS_INVALID || (request->generation & 0x1FFFFFFu) != handle >> 7)
+    {
+        return BENEATH_IO_STATUS_INVALID;
+    }
+
+    if (status == BENEATH_IO_STATUS_PENDING)
+    {
+        return BENEATH_IO_STATUS_PENDING;
+    }
+
+    /* Finished, release the slot */
+    *file_buffer_size = request->size;
+    request->generation++;
+    request->status = BENEATH_IO_STATUS_INVALID;
+
+    return (beneath_io_status)status;
+}
+
+/* #############################################################################
+ * # Jobs (work stealing workers via raw clone/futex)
+ * #############################################################################
+ */
+#define LINUX_BENEATH_JOBS_THREAD_STACK_SIZE (256 * 1024)
+
+static beneath_jobs jobs;
+static unsigned char *jobs_stacks; /* One contiguous mapping, worker i runs on stack i - 1 */
+
+/* Workers are found by the stack their locals live on, the main thread is 0 */
+BENEATH_API unsigned int linux_beneath_jobs_thread_index(void)
+{
+    unsigned char local = 0;
+    unsigned char *address = &local;
+
+    if (jobs_stacks && address >= jobs_stacks && address < jobs_stacks + (unsigned long)(jobs.threads_count - 1) * LINUX_BENEATH_JOBS_THREAD_STACK_SIZE)
+    {
+        return (unsigned int)((unsigned long)(address - jobs_stacks) / LINUX_BENEATH_JOBS_THREAD_STACK_SIZE) + 1;
+    }
+
+    return 0;
+}
+
+BENEATH_API void linux_beneath_jobs_wait(int *address, int expected)
+{
+    linux_futex_wait(address, expected);
+}
+
+BENEATH_API void linux_beneath_jobs_wake(int *address, int count)
+{
+    linux_futex_wake(address, count);
+}
+
+BENEATH_API void linux_beneath_jobs_worker(void *arg)
+{
+    beneath_jobs_worker(&jobs, linux_beneath_jobs_thread_index());
+
+    (void)arg;
+}
+
+/* One worker per available CPU besides the main thread, without workers jobs run on the caller */
+BENEATH_API void linux_beneath_jobs_threads_start(void)
+{
+    unsigned int threads_count = linux_cpu_count();
+    unsigned int started = 1;
+    unsigned char *stacks;
+    unsigned int i;
+
+    beneath_jobs_initialize(&jobs, threads_count, linux_beneath_jobs_thread_index, linux_beneath_jobs_wait, linux_beneath_jobs_wake);
+
+    if (jobs.threads_count == 1)
+    {
+        return;
+    }
+
+    stacks = (unsigned char *)linux_mmap(NULL, (unsigned long)(jobs.threads_count - 1) * LINUX_BENEATH_JOBS_THREAD_STACK_SIZE, LINUX_PROT_READ | LINUX_PROT_WRITE, LINUX_MAP_PRIVATE | LINUX_MAP_ANONYMOUS | LINUX_MAP_STACK, -1, 0);
+
+    if (stacks == LINUX_MAP_FAILED)
+    {
+        jobs.threads_count = 1;
+        return;
+    }
+
+    /* Set before the first worker starts, workers compute their index from it */
+    jobs_stacks = stacks;
+
+    for (i = 1; i < jobs.threads_count; ++i)
+    {
+        void *stack_top = stacks + (unsigned long)i * LINUX_BENEATH_JOBS_THREAD_STACK_SIZE;
+
+        if (LINUX_IS_ERROR(linux_thread_create(stack_top, linux_beneath_jobs_worker, NULL)))
+        {
+            break;
+        }
+
+        started++;
+    }
+
+    /* Deques of workers that did not start are never filled, thieves only scan the started ones */
+    jobs.threads_count = started;
+}
+
+BENEATH_API void linux_beneath_api_job_run(beneath_job_function function, void *data, unsigned int count, beneath_job_counter *counter)
+{
+    beneath_jobs_run(&jobs, function, data, count, counter);
+}
+
+BENEATH_API void linux_beneath_api_job_wait(beneath_job_counter *counter)
+{
+    beneath_jobs_wait_counter(&jobs, counter);
+}
+
+BENEATH_API void linux_beneath_api_job_parallel_for(beneath_job_range_function function, void *data, unsigned int count, unsigned int batch_size)
+{
+    beneath_jobs_parallel_for(&jobs, function, data, count, batch_size);
+}
+
+BENEATH_API unsigned int linux_beneath_api_job_threads_count(void)
+{
+    return jobs.threads_count;
+}
+
+/* Commits reserved pages of the application memory (beneath_arena_commit) */
+BENEATH_API beneath_bool linux_beneath_memory_commit(void *address, unsigned int size)
+{
+    unsigned long page_mask = 4096 - 1;
+    unsigned long start = (unsigned long)address & ~page_mask;
+    unsigned long end = ((unsigned long)address + size + page_mask) & ~page_mask;
+
+    return linux_mprotect((void *)start, end - start, LINUX_PROT_READ | LINUX_PROT_WRITE) == 0;
+}
+
+BENEATH_API BENEATH_INLINE unsigned int linux_beneath_api_perf_cycle_count(void)
+{
+#ifdef __x86_64__
+    unsigned int low_part = 0;
+    unsigned int high_part = 0;
+    __asm__ __volatile__("rdtsc" : "=a"(low_part), "=d"(high_part));
+    return ((unsigned int)((double)high_part * 4294967296.0 + (double)low_part));
+#else
+    unsigned long counter;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(counter));
+    return (unsigned int)counter;
+#endif
+}
+
+BENEATH_API BENEATH_INLINE double linux_beneath_api_perf_time_nanoseconds(void)
+{
+    linux_timespec ts = {0, 0};
+
+    linux_clock_gettime(LINUX_CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec * 1000000000.0 + (double)ts.tv_nsec;
+}
+
+BENEATH_API BENEATH_INLINE void linux_beneath_precise_sleep(double seconds)
+{
+    linux_timespec ts;
+
+    if (seconds <= 0.0)
+    {
+        return;
+    }
+
+    ts.tv_sec = (long)seconds;
+    ts.tv_nsec = (long)((seconds - (double)ts.tv_sec) * 1000000000.0);
+
+    linux_nanosleep(&ts, NULL);
+}
+
+#if defined(BENEATH_OPENGL_HEADLESS) || defined(BENEATH_SOFTWARE)
+/* Writes RGBA8 pixels as binary PPM so CI can archive/diff rendered frames */
+BENEATH_API beneath_bool linux_beneath_write_ppm(
+    char *filename,        /* The output file */
+    unsigned char *pixels, /* RGBA8 pixels */
+    unsigned int width,    /* Width in pixels */
+    unsigned int height,   /* Height in pixels */
+    unsigned int pitch,    /* Row length in pixels */
+    beneath_bool bottom_up /* Rows start at the bottom (OpenGL) */
+)
+{
+    unsigned long file_capacity = 64 + (unsigned long)width * height * 3;
+    unsigned char *file;
+    unsigned char *dst;
+    unsigned int header_len;
+    beneath_bool result;
+    unsigned int x, y;
+
+    file = (unsigned char *)linux_mmap(NULL, file_capacity, LINUX_PROT_READ | LINUX_PROT_WRITE, LINUX_MAP_PRIVATE | LINUX_MAP_ANONYMOUS, -1, 0);
+
+    if (file == LINUX_MAP_FAILED)
+    {
+        return false;
+    }
+
+    beneath_strcpy((char *)file, "P6\n", 64);
+    header_len = linux_beneath_api_strlen((char *)file);
+    header_len += linux_beneath_api_append_uint((char *)file + header_len, width);
+    file[header_len++] = ' ';
+    header_len += linux_beneath_api_append_uint((char *)file + header_len, height);
+    beneath_strcpy((char *)file + header_len, "\n255\n", (int)(64 - header_len));
+    header_len = linux_beneath_api_strlen((char *)file);
+
+    dst = file + header_len;
+
+    for (y = 0; y < height; ++y)
+    {
+        unsigned char *src = pixels + (unsigned long)(bottom_up ? height - 1 - y : y) * pitch * 4;
+
+        for (x = 0; x < width; ++x)
+        {
+            *dst++ = src[x * 4 + 0];
+            *dst++ = src[x * 4 + 1];
+            *dst++ = src[x * 4 + 2];
+        }
+    }
+
+    result = linux_beneath_api_io_file_write(filename, file, header_len + width * height * 3);
+
+    linux_munmap(file, file_capacity);
+
+    return result;
+}
+#endif
+
+typedef struct linux_beneath_graphics_stats
+{
+    unsigned int draw_calls;
+    unsigned int instances;
+
+} linux_beneath_graphics_stats;
+
+static linux_beneath_graphics_stats graphics_stats;
+
+#ifdef BENEATH_RENDER_THREAD
+/* The command list beneath_update records into, swapped on every submit */
+static beneath_opengl_command_list *render_commands;
+#endif
+
+#ifdef BENEATH_SOFTWARE
+/* #############################################################################
+ * # Software Renderer (worker threads via raw clone/futex)
+ * #############################################################################
+ */
+#define LINUX_BENEATH_SOFTWARE_THREADS_MAX 64
+#define LINUX_BENEATH_SOFTWARE_THREAD_STACK_SIZE (256 * 1024)
+
+typedef struct linux_beneath_software_pool
+{
+    int generation; /* Futex, incremented for every dispatched job */
+    int pending;    /* Futex, workers still running the current job */
+    unsigned int threads_count;
+    beneath_software_work work;
+    void *data;
+
+} linux_beneath_software_pool;
+
+static linux_beneath_software_pool software_pool;
+static beneath_software_context software;
+
+BENEATH_API void linux_beneath_software_worker(void *arg)
+{
+    int generation_seen = 0;
+
+    (void)arg;
+
+    for (;;)
+    {
+        int generation = __sync_fetch_and_add(&software_pool.generation, 0);
+
+        if (generation == generation_seen)
+        {
+            linux_futex_wait(&software_pool.generation, generation);
+            continue;
+        }
+
+        generation_seen = generation;
+
+        software_pool.work(software_pool.data);
+
+        if (__sync_sub_and_fetch(&software_pool.pending, 1) == 0)
+        {
+            linux_futex_wake(&software_pool.pending, 1);
+        }
+    }
+}
+
+/* Runs work on all workers and the calling thread, returns when every thread is done */
+BENEATH_API void linux_beneath_software_dispatch(beneath_software_work work, void *data)
+{
+    int pending;
+
+    software_pool.work = work;
+    software_pool.data = data;
+    software_pool.pending = (int)software_pool.threads_count;
+
+    __sync_fetch_and_add(&software_pool.generation, 1);
+    linux_futex_wake(&software_pool.generation, (int)software_pool.threads_count);
+
+    work(data);
+
+    while ((pending = __sync_fetch_and_add(&software_pool.pending, 0)) != 0)
+    {
+        linux_futex_wait(&software_pool.pending, pending);
+    }
+}
+
+/* One worker per available CPU besides the main thread */
+BENEATH_API beneath_bool linux_beneath_software_threads_start(void)
+{
+    unsigned int threads_count = linux_cpu_count() - 1;
+    unsigned char *stacks;
+    unsigned int i;
+
+    if (threads_count > LINUX_BENEATH_SOFTWARE_THREADS_MAX)
+    {
+        threads_count = LINUX_BENEATH_SOFTWARE_THREADS_MAX;
+    }
+
+    if (threads_count == 0)
+    {
+        return true;
+    }
+
+    stacks = (unsigned char *)linux_mmap(NULL, (unsigned long)threads_count * LINUX_BENEATH_SOFTWARE_THREAD_STACK_SIZE, LINUX_PROT_READ | LINUX_PROT_WRITE, LINUX_MAP_PRIVATE | LINUX_MAP_ANONYMOUS | LINUX_MAP_STACK, -1, 0);
+
+    if (stacks == LINUX_MAP_FAILED)
+    {
+        return false;
+    }
+
+    for (i = 0; i < threads_count; ++i)
+    {
+        void *stack_top = stacks + (unsigned long)(i + 1) * LINUX_BENEATH_SOFTWARE_THREAD_STACK_SIZE;
+
+        if (LINUX_IS_ERROR(linux_thread_create(stack_top, linux_beneath_software_worker, NULL)))
+        {
+            break;
+        }
+
+        software_pool.threads_count++;
+    }
+
+    return true;
+}
+
+/* (Re)creates the software framebuffer for the window size */
+BENEATH_API beneath_bool linux_beneath_software_resize(void **memory, unsigned long *memory_size, unsigned int width, unsigned int height)
+{
+    unsigned long required = beneath_software_memory_size(width, height);
+
+    if (required > *memory_size)
+    {
+        if (*memory)
+        {
+            linux_munmap(*memory, *memory_size);
+        }
+
+        *memory = linux_mmap(NULL, required, LINUX_PROT_READ | LINUX_PROT_WRITE, LINUX_MAP_PRIVATE | LINUX_MAP_ANONYMOUS, -1, 0);
+
+        if (*memory == LINUX_MAP_FAILED)
+        {
+            *memory = NULL;
+            *memory_size = 0;
+            return false;
+        }
+
+        *memory_size = required;
+    }
+
+    return beneath_software_initialize(&software, *memory, *memory_size, width, height, software_pool.threads_count > 0 ? linux_beneath_software_dispatch : NULL);
+}
+#endif /* BENEATH_SOFTWARE */
+
+/* There is no window system without libc (X11/Wayland client libraries), so draw
+ * calls are only validated and counted. This keeps the frame loop and the
+ * application code measurable under perf without any driver time mixed in.
+ * With BENEATH_OPENGL_HEADLESS the draw calls go through the opengl renderer
+ * into an offscreen framebuffer instead, with BENEATH_SOFTWARE through the CPU
+ * rasterizer (no GPU, no libc).
+ */
+BENEATH_API beneath_bool linux_beneath_api_graphics_draw(
+    beneath_state *state,         /* The state */
+    beneath_draw_call *draw_call, /* The draw call instanced objects */
+    float projection_view[16],    /* The projection view matrix */
+    float projection_inverse[16], /* The projection matrix inversed */
+    float view_inverse[16],       /* The view matrix inversed */
+    float camera_position[3]      /* The camera x,y,z position */
+)
+{
+    if (!draw_call || draw_call->models_count == 0 || !draw_call->mesh)
+    {
+        return false;
+    }
+
+    graphics_stats.draw_calls++;
+    graphics_stats.instances += draw_call->models_count;
+
+#if defined(BENEATH_OPENGL_HEADLESS) && defined(BENEATH_RENDER_THREAD)
+    (void)state;
+
+    return beneath_opengl_command_list_record(
+        render_commands,
+        draw_call,
+        projection_view,
+        projection_inverse,
+        view_inverse,
+        camera_position,
+        linux_beneath_api_io_print);
+#elif defined(BENEATH_OPENGL_HEADLESS)
+    return beneath_opengl_draw(
+        state,
+        draw_call,
+        projection_view,
+        projection_inverse,
+        view_inverse,
+        camera_position,
+        linux_beneath_api_io_print);
+#elif defined(BENEATH_SOFTWARE)
+    return beneath_software_draw(
+        &software,
+        state,
+        draw_call,
+        projection_view,
+        projection_inverse,
+        view_inverse,
+        camera_position,
+        linux_beneath_api_io_print);
+#else
+    (void)state;
+    (void)projection_view;
+    (void)projection_inverse;
+    (void)view_inverse;
+    (void)camera_position;
+
+    draw_call->changed = false;
+    draw_call->mesh->changed = false;
+
+    return true;
+#endif
+}
+
+BENEATH_API BENEATH_INLINE unsigned int linux_beneath_parse_uint(char *str)
+{
+    unsigned int value = 0;
+
+    while (str && *str >= '0' && *str <= '9')
+    {
+        value = value * 10 + (unsigned int)(*str - '0');
+        str++;
+    }
+
+    return value;
+}
+
+#ifdef BENEATH_OPENGL_HEADLESS
+/* #############################################################################
+ * # Headless OpenGL (EGL surfaceless/pbuffer context, rendering into an FBO)
+ * #############################################################################
+ */
+#define LINUX_BENEATH_HEADLESS_FRAMES_DEFAULT 300
+#define LINUX_BENEATH_HEADLESS_QUERIES 4 /* Frames in flight, GL times are read back this many frames late */
+#define LINUX_BENEATH_HEADLESS_WARMUP 1  /* First frames compile shaders and upload meshes, excluded from the summary */
+
+#ifdef BENEATH_RENDER_THREAD
+#define LINUX_BENEATH_HEADLESS_OUTPUT "linux_beneath_headless_render_thread" /* Report file name prefix */
+#else
+#define LINUX_BENEATH_HEADLESS_OUTPUT "linux_beneath_headless"
+#endif
+
+typedef struct linux_beneath_headless
+{
+    void *display;
+    void *context;
+    void *surface;
+
+    /* Offscreen output the renderer draws into instead of a window */
+    unsigned int fbo;
+    unsigned int fbo_color;
+    unsigned int fbo_depth;
+    unsigned int fbo_width;
+    unsigned int fbo_height;
+
+    /* GL_TIME_ELAPSED queries, one per frame in flight */
+    unsigned int queries[LINUX_BENEATH_HEADLESS_QUERIES];
+
+} linux_beneath_headless;
+
+BENEATH_API beneath_bool linux_beneath_headless_initialize(linux_beneath_headless *headless)
+{
+    int config_attributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE};
+
+    int context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE};
+
+    int pbuffer_attributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+
+    void *config = NULL;
+    int config_count = 0;
+
+    /* Prefer the mesa surfaceless platform, it needs neither X11/Wayland nor a GPU (llvmpipe) */
+    PFNEGLGETPLATFORMDISPLAYEXTPROC eglGetPlatformDisplayEXT = BENEATH_FUNC_FROM_PTR(PFNEGLGETPLATFORMDISPLAYEXTPROC, eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+    if (eglGetPlatformDisplayEXT)
+    {
+        headless->display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+
+    if (!headless->display || !eglInitialize(headless->display, NULL, NULL))
+    {
+        headless->display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+        if (!headless->display || !eglInitialize(headless->display, NULL, NULL))
+        {
+            linux_beneath_api_io_print(__FILE__, __LINE__, "[headless] cannot initialize EGL display!\n");
+            return false;
+        }
+    }
+
+    if (!eglChooseConfig(headless->display, config_attributes, &config, 1, &config_count) || config_count < 1)
+    {
+        linux_beneath_api_io_print(__FILE__, __LINE__, "[headless] no matching EGL config!\n");
+        return false;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+        linux_beneath_api_io_print(__FILE__, __LINE__, "[headless] cannot bind the OpenGL API!\n");
+        return false;
+    }
+
+    headless->context = eglCreateContext(headless->display, config, EGL_NO_CONTEXT, context_attributes);
+
+    if (!headless->context)
+    {
+        linux_beneath_api_io_print(__FILE__, __LINE__, "[headless] cannot create an OpenGL 3.3 core context!\n");
+        return false;
+    }
+
+    /* Surfaceless first (EGL_KHR_surfaceless_context), otherwise a 1x1 pbuffer.
+     * Either way the frames are rendered into our own FBO.
+     */
+    if (!eglMakeCurrent(headless->display, EGL_NO_SURFACE, EGL_NO_SURFACE, headless->context))
+    {
+        headless->surface = eglCreatePbufferSurface(headless->display, config, pbuffer_attributes);
+
+        if (!headless->surface || !eglMakeCurrent(headless->display, headless->surface, headless->surface, headless->context))
+        {
+            linux_beneath_api_io_print(__FILE__, __LINE__, "[headless] cannot make the EGL context current!\n");
+            return false;
+        }
+    }
+
+    if (!linux_beneath_opengl_load_functions())
+    {
+        unsigned int i;
+
+        for (i = 0; i < beneath_opengl_failed_loads_count; ++i)
+        {
+            linux_beneath_api_io_print(__FILE__, __LINE__, "[headless] cannot load opengl function: ");
+            linux_beneath_api_io_print(__FILE__, __LINE__, beneath_opengl_failed_loads[i]);
+            linux_beneath_api_io_print(__FILE__, __LINE__, "\n");
+        }
+
+        return false;
+    }
+
+    {
+        char buffer[256];
+        sb tmp = {0};
+        sb_init(&tmp, buffer, 256);
+        sb_append_cstr(&tmp, "[headless] renderer: ");
+        sb_append_cstr(&tmp, (char *)glGetString(GL_RENDERER));
+        sb_append_cstr(&tmp, "\n");
+        sb_term(&tmp);
+        linux_beneath_api_io_print(__FILE__, __LINE__, buffer);
+    }
+
+    glGenQueries(LINUX_BENEATH_HEADLESS_QUERIES, headless->queries);
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+    glFrontFace(GL_CCW);
+
+    return true;
+}
+
+BENEATH_API beneath_bool linux_beneath_headless_framebuffer_resize(linux_beneath_headless *headless, unsigned int width, unsigned int height)
+{
+    if (!headless->fbo)
+    {
+        glGenFramebuffers(1, &headless->fbo);
+        glGenRenderbuffers(1, &headless->fbo_color);
+        glGenRenderbuffers(1, &headless->fbo_depth);
+    }
+
+    glBindRenderbuffer(GL_RENDERBUFFER, headless->fbo_color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, (int)width, (int)height);
+    glBindRenderbuffer(GL_RENDERBUFFER, headless->fbo_depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, (int)width, (int)height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, headless->fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, headless->fbo_color);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, headless->fbo_depth);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        linux_beneath_api_io_print(__FILE__, __LINE__, "[headless] output FBO incomplete!\n");
+        return false;
+    }
+
+    beneath_opengl_framebuffer_output_set(headless->fbo);
+    glViewport(0, 0, (int)width, (int)height);
+
+    headless->fbo_width = width;
+    headless->fbo_height = height;
+
+    return true;
+}
+
+/* Binds the output, starts the GPU timer of the frame and clears it. The output follows the window size */
+BENEATH_API beneath_bool linux_beneath_headless_frame_begin(linux_beneath_headless *headless, beneath_state *state, unsigned int frame)
+{
+    if (state->window_width != headless->fbo_width || state->window_height != headless->fbo_height)
+    {
+        if (!linux_beneath_headless_framebuffer_resize(headless, state->window_width, state->window_height))
+        {
+            return false;
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, headless->fbo);
+    glBeginQuery(GL_TIME_ELAPSED, headless->queries[frame % LINUX_BENEATH_HEADLESS_QUERIES]);
+    glClearColor(state->window_clear_color_r, state->window_clear_color_g, state->window_clear_color_b, state->window_clear_color_a);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    beneath_opengl_frame_begin();
+
+    return true;
+}
+
+/* Renders the queued draw calls and stops the GPU timer of the frame */
+BENEATH_API void linux_beneath_headless_frame_end(void)
+{
+    beneath_opengl_frame_end(linux_beneath_api_io_print);
+    glEndQuery(GL_TIME_ELAPSED);
+}
+
+/* Reads the GPU time of the oldest frame in flight, this also bounds how far the CPU runs ahead like a swapchain would */
+BENEATH_API void linux_beneath_headless_frame_timing(linux_beneath_headless *headless, unsigned int frame, double *frame_gl_ms)
+{
+    if (frame + 1 >= LINUX_BENEATH_HEADLESS_QUERIES)
+    {
+        unsigned long long gl_ns = 0;
+        glGetQueryObjectui64v(headless->queries[(frame + 1) % LINUX_BENEATH_HEADLESS_QUERIES], GL_QUERY_RESULT, &gl_ns);
+        frame_gl_ms[frame + 1 - LINUX_BENEATH_HEADLESS_QUERIES] = (double)gl_ns * 1e-6;
+    }
+}
+
+/* Dump the output FBO as binary PPM so CI can archive/diff the last frame */
+BENEATH_API beneath_bool linux_beneath_headless_write_ppm(linux_beneath_headless *headless, char *filename)
+{
+    unsigned long pixels_size = (unsigned long)headless->fbo_width * headless->fbo_height * 4;
+    unsigned char *pixels;
+    beneath_bool result;
+
+    pixels = (unsigned char *)linux_mmap(NULL, pixels_size, LINUX_PROT_READ | LINUX_PROT_WRITE, LINUX_MAP_PRIVATE | LINUX_MAP_ANONYMOUS, -1, 0);
+
+    if (pixels == LINUX_MAP_FAILED)
+    {
+        return false;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, headless->fbo);
+    glReadPixels(0, 0, (int)headless->fbo_width, (int)headless->fbo_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    result = linux_beneath_write_ppm(filename, pixels, headless->fbo_width, headless->fbo_height, headless->fbo_width, true);
+
+    linux_munmap(pixels, pixels_size);
+
+    return result;
+}
+
+/* Prints min/avg/max of a per frame timing series in milliseconds */
+BENEATH_API void linux_beneath_headless_report(char *name, double *times_ms, unsigned int count)
+{
+    char buffer[256];
+    sb tmp = {0};
+    double min = 0.0;
+    double max = 0.0;
+    double sum = 0.0;
+    unsigned int i;
+
+    for (i = 0; i < count; ++i)
+    {
+        min = (i == 0 || times_ms[i] < min) ? times_ms[i] : min;
+        max = (i == 0 || times_ms[i] > max) ? times_ms[i] : max;
+        sum += times_ms[i];
+    }
+
+    sb_init(&tmp, buffer, 256);
+    sb_append_cstr(&tmp, "[headless] ");
+    sb_append_cstr(&tmp, name);
+    sb_append_cstr(&tmp, " (ms) min: ");
+    sb_append_double(&tmp, min, 0, 3, SB_PAD_NONE);
+    sb_append_cstr(&tmp, ", avg: ");
+    sb_append_double(&tmp, count > 0 ? sum / (double)count : 0.0, 0, 3, SB_PAD_NONE);
+    sb_append_cstr(&tmp, ", max: ");
+    sb_append_double(&tmp, max, 0, 3, SB_PAD_NONE);
+    sb_append_cstr(&tmp, "\n");
+    sb_term(&tmp);
+
+    linux_beneath_api_io_print(__FILE__, __LINE__, buffer);
+}
+
+/* frame,cpu_ms,gl_ms per line for the regression pipeline */
+BENEATH_API beneath_bool linux_beneath_headless_write_csv(char *filename, double *cpu_ms, double *gl_ms, unsigned int count)
+{
+    unsigned long capacity = 64 + (unsigned long)count * 64;
+    char *buffer = (char *)linux_mmap(NULL, capacity, LINUX_PROT_READ | LINUX_PROT_WRITE, LINUX_MAP_PRIVATE | LINUX_MAP_ANONYMOUS, -1, 0);
+    beneath_bool result;
+    unsigned int i;
+    sb csv = {0};
+
+    if (buffer == LINUX_MAP_FAILED)
+    {
+        return false;
+    }
+
+    sb_init(&csv, buffer, (int)capacity);
+    sb_append_cstr(&csv, "frame,cpu_ms,gl_ms\n");
+
+    for (i = 0; i < count; ++i)
+    {
+        sb_append_ulong_direct(&csv, i);
+        sb_append_cstr(&csv, ",");
+        sb_append_double(&csv, cpu_ms[i], 0, 4, SB_PAD_NONE);
+        sb_append_cstr(&csv, ",");
+        sb_append_double(&csv, gl_ms[i], 0, 4, SB_PAD_NONE);
+        sb_append_cstr(&csv, "\n");
+    }
+
+    result = linux_beneath_api_io_file_write(filename, (unsigned char *)buffer, (unsigned int)csv.len);
+
+    linux_munmap(buffer, capacity);
+
+    return result;
+}
+
+BENEATH_API void linux_beneath_headless_destroy(linux_beneath_headless *headless)
+{
+    eglMakeCurrent(headless->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+    if (headless->surface)
+    {
+        eglDestroySurface(headless->display, headless->surface);
+    }
+
+    eglDestroyContext(headless->display, headless->context);
+    eglTerminate(headless->display);
+}
+
+#ifdef BENEATH_RENDER_THREAD
+/* #############################################################################
+ * # Render Thread (owns the EGL context, replays the command lists)
+ * #############################################################################
+ *
+ * beneath_update records frame N + 1 into one command list while the render thread
+ * replays frame N from the other. Submitting a list waits until the previous one was
+ * replayed, so the application runs at most one frame ahead of the render thread.
+ */
+typedef struct linux_beneath_render_thread
+{
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t condition; /* submitted or quit changed */
+
+    linux_beneath_headless *headless;
+    double *frame_gl_ms;
+
+    beneath_opengl_command_list lists[2];
+    beneath_opengl_command_list *submitted; /* Owned by the render thread until it is reset to NULL */
+    unsigned int submitted_frame;
+    beneath_bool quit;
+    beneath_bool failed;
+
+} linux_beneath_render_thread;
+
+static linux_beneath_render_thread render_thread;
+
+BENEATH_API void *linux_beneath_render_thread_main(void *arg)
+{
+    linux_beneath_render_thread *render = (linux_beneath_render_thread *)arg;
+    linux_beneath_headless *headless = render->headless;
+
+    eglMakeCurrent(headless->display, headless->surface, headless->surface, headless->context);
+
+    pthread_mutex_lock(&render->mutex);
+
+    for (;;)
+    {
+        beneath_opengl_command_list *list;
+        unsigned int frame;
+        beneath_bool rendered;
+
+        while (!render->submitted && !render->quit)
+        {
+            pthread_cond_wait(&render->condition, &render->mutex);
+        }
+
+        if (!render->submitted)
+        {
+            break;
+        }
+
+        list = render->submitted;
+        frame = render->submitted_frame;
+
+        pthread_mutex_unlock(&render->mutex);
+
+        rendered = linux_beneath_headless_frame_begin(headless, &list->state, frame);
+
+        if (rendered)
+        {
+            beneath_opengl_command_list_replay(list, linux_beneath_api_io_print);
+            linux_beneath_headless_frame_end();
+            linux_beneath_headless_frame_timing(headless, frame, render->frame_gl_ms);
+        }
+
+        pthread_mutex_lock(&render->mutex);
+
+        render->failed = render->failed || !rendered;
+        render->submitted = NULL;
+        pthread_cond_broadcast(&render->condition);
+    }
+
+    pthread_mutex_unlock(&render->mutex);
+
+    eglMakeCurrent(headless->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+    return NULL;
+}
+
+/* Hands the GL context over to a new render thread */
+BENEATH_API beneath_bool linux_beneath_render_thread_start(linux_beneath_render_thread *render, linux_beneath_headless *headless, double *frame_gl_ms)
+{
+    unsigned char *memory = (unsigned char *)linux_mmap(NULL, 2 * (unsigned long)BENEATH_OPENGL_COMMAND_LIST_MEMORY_SIZE, LINUX_PROT_NONE, LINUX_MAP_PRIVATE | LINUX_MAP_ANONYMOUS | LINUX_MAP_NORESERVE, -1, 0);
+
+    if (memory == LINUX_MAP_FAILED)
+    {
+        return false;
+    }
+
+    beneath_opengl_command_list_initialize(&render->lists[0], memory, BENEATH_OPENGL_COMMAND_LIST_MEMORY_SIZE, linux_beneath_memory_commit);
+    beneath_opengl_command_list_initialize(&render->lists[1], memory + BENEATH_OPENGL_COMMAND_LIST_MEMORY_SIZE, BENEATH_OPENGL_COMMAND_LIST_MEMORY_SIZE, linux_beneath_memory_commit);
+
+    render->headless = headless;
+    render->frame_gl_ms = frame_gl_ms;
+    render->submitted = NULL;
+    render->quit = false;
+    render->failed = false;
+    render_commands = &render->lists[0];
+
+    if (pthread_mutex_init(&render->mutex, NULL) != 0 || pthread_cond_init(&render->condition, NULL) != 0)
+    {
+        return false;
+    }
+
+    /* A context is current on one thread at a time */
+    eglMakeCurrent(headless->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+    if (pthread_create(&render->thread, NULL, linux_beneath_render_thread_main, render) != 0)
+    {
+        eglMakeCurrent(headless->display, headless->surface, headless->surface, headless->context);
+        return false;
+    }
+
+    return true;
+}
+
+/* Submits the recorded frame and starts recording into the other list. False if the previous frame failed to render */
+BENEATH_API beneath_bool linux_beneath_render_thread_submit(linux_beneath_render_thread *render, beneath_state *state, unsigned int frame)
+{
+    beneath_opengl_command_list *list = render_commands;
+
+    beneath_opengl_command_list_end(list, state);
+
+    pthread_mutex_lock(&render->mutex);
+
+    /* The render thread is done with the previous frame and therefore with the other list */
+    while (render->submitted)
+    {
+        pthread_cond_wait(&render->condition, &render->mutex);
+    }
+
+    if (render->failed)
+    {
+        pthread_mutex_unlock(&render->mutex);
+        return false;
+    }
+
+    render->submitted = list;
+    render->submitted_frame = frame;
+    pthread_cond_broadcast(&render->condition);
+
+    pthread_mutex_unlock(&render->mutex);
+
+    render_commands = list == &render->lists[0] ? &render->lists[1] : &render->lists[0];
+    beneath_opengl_command_list_begin(render_commands);
+
+    return true;
+}
+
+/* Waits for the last frame, ends the render thread and makes the GL context current again */
+BENEATH_API void linux_beneath_render_thread_stop(linux_beneath_render_thread *render)
+{
+    pthread_mutex_lock(&render->mutex);
+
+    while (render->submitted)
+    {
+        pthread_cond_wait(&render->condition, &render->mutex);
+    }
+
+    render->quit = true;
+    pthread_cond_broadcast(&render->condition);
+
+    pthread_mutex_unlock(&render->mutex);
+
+    pthread_join(render->thread, NULL);
+
+    eglMakeCurrent(render->headless->display, render->headless->surface, render->headless->surface, render->headless->context);
+}
+#endif /* BENEATH_RENDER_THREAD */
+#endif /* BENEATH_OPENGL_HEADLESS */
+
+int linux_beneath_main(int argc, char **argv)
+{
+    double last_time;
+    double start_time;
+    unsigned long memory_size = BENEATH_MEMORY_RESERVE_SIZE; /* Reserved only, committed as the arenas grow */
+    unsigned int frames_max = 0;                 /* 0 = run until the application stops */
+    unsigned int frames = 0;
+
+    beneath_memory memory = {0};
+    beneath_api api = {0};
+    beneath_state *state;
+    beneath_controller_input input = {0};
+
+#ifdef BENEATH_OPENGL_HEADLESS
+    linux_beneath_headless headless = {0};
+    double *frame_cpu_ms;
+    double *frame_gl_ms;
+#endif
+
+#ifdef BENEATH_SOFTWARE
+    void *software_memory = NULL;
+    unsigned long software_memory_size = 0;
+    double software_raster_ms = 0.0;
+#endif
+
+    /* Optional: linux_beneath <frames> to run a fixed number of frames (benchmarking) */
+    if (argc > 1)
+    {
+        frames_max = linux_beneath_parse_uint(argv[1]);
+    }
+
+#ifdef BENEATH_OPENGL_HEADLESS
+    /* Headless runs always end, otherwise there is no report */
+    if (frames_max == 0)
+    {
+        frames_max = LINUX_BENEATH_HEADLESS_FRAMES_DEFAULT;
+    }
+
+    frame_cpu_ms = (double *)linux_mmap(NULL, sizeof(double) * 2 * frames_max, LINUX_PROT_READ | LINUX_PROT_WRITE, LINUX_MAP_PRIVATE | LINUX_MAP_ANONYMOUS, -1, 0);
+
+    if ((void *)frame_cpu_ms == LINUX_MAP_FAILED)
+    {
+        return 1;
+    }
+
+    frame_gl_ms = frame_cpu_ms + frames_max;
+#endif
+
+    memory.memory_offset = sizeof(beneath_state);
+    memory.memory = linux_mmap(NULL, memory_size, LINUX_PROT_NONE, LINUX_MAP_PRIVATE | LINUX_MAP_ANONYMOUS | LINUX_MAP_NORESERVE, -1, 0);
+    memory.memory_size = (unsigned int)memory_size;
+
+    if (memory.memory == LINUX_MAP_FAILED ||
+        !linux_beneath_memory_commit(memory.memory, memory.memory_offset) ||
+        !beneath_memory_arenas_initialize(&memory, BENEATH_MEMORY_FRAME_SIZE, linux_beneath_memory_commit))
+    {
+        return 1;
+    }
+
+#ifdef BENEATH_OPENGL_HEADLESS
+    /* Renderer memory, separate from the application memory */
+    {
+        void *renderer_memory = linux_mmap(NULL, BENEATH_OPENGL_MEMORY_SIZE, LINUX_PROT_NONE, LINUX_MAP_PRIVATE | LINUX_MAP_ANONYMOUS | LINUX_MAP_NORESERVE, -1, 0);
+
+        if (renderer_memory == LINUX_MAP_FAILED)
+        {
+            return 1;
+        }
+
+        beneath_opengl_memory_initialize(renderer_memory, BENEATH_OPENGL_MEMORY_SIZE, linux_beneath_memory_commit);
+    }
+#endif
+
+    /* Default state before application call */
+    state = (beneath_state *)memory.memory;
+    state->window_width = 800;
+    state->window_height = 600;
+    state->window_clear_color_r = 0.157f;
+    state->window_clear_color_g = 0.157f;
+    state->window_clear_color_b = 0.157f;
+    state->window_clear_color_a = 1.0f;
+    state->running = true;
+    state->frames_per_second_target = BENEATH_STATE_FRAMES_PER_SECOND_VSYNC;
+
+    /* Assign platform specific api function exposed to the application */
+    api.io_print = linux_beneath_api_io_print;
+    api.io_file_size = linux_beneath_api_io_file_size;
+    api.io_file_read = linux_beneath_api_io_file_read;
+    api.io_file_write = linux_beneath_api_io_file_write;
+    api.io_file_map = linux_beneath_api_io_file_map;
+    api.io_file_unmap = linux_beneath_api_io_file_unmap;
+    api.io_file_read_async = linux_beneath_api_io_file_read_async;
+    api.io_file_read_poll = linux_beneath_api_io_file_read_poll;
+    api.perf_cycle_count = linux_beneath_api_perf_cycle_count;
+    api.perf_time_nanoseconds = linux_beneath_api_perf_time_nanoseconds;
+    api.job_run = linux_beneath_api_job_run;
+    api.job_wait = linux_beneath_api_job_wait;
+    api.job_parallel_for = linux_beneath_api_job_parallel_for;
+    api.job_threads_count = linux_beneath_api_job_threads_count;
+    api.graphics_draw = linux_beneath_api_graphics_draw;
+
+#ifdef BENEATH_OPENGL_HEADLESS
+    /* The renderer stores its program binary cache through the same file io */
+    beneath_opengl_io_initialize(api.io_file_size, api.io_file_read, api.io_file_write);
+#endif
+
+    linux_beneath_jobs_threads_start();
+
+    /* No display to sync to, vsync falls back to a fixed 60 Hz */
+    if (state->frames_per_second_target < 0)
+    {
+        state->frames_per_second_target = 60;
+    }
+
+#ifdef BENEATH_OPENGL_HEADLESS
+    if (!linux_beneath_headless_initialize(&headless) ||
+        !linux_beneath_headless_framebuffer_resize(&headless, state->window_width, state->window_height))
+    {
+        return 1;
+    }
+
+#ifdef BENEATH_RENDER_THREAD
+    if (!linux_beneath_render_thread_start(&render_thread, &headless, frame_gl_ms))
+    {
+        linux_beneath_api_io_print(__FILE__, __LINE__, "[headless] cannot start the render thread!\n");
+        return 1;
+    }
+#endif
+#endif
+
+#ifdef BENEATH_SOFTWARE
+    if (!linux_beneath_software_threads_start() ||
+        !linux_beneath_software_resize(&software_memory, &software_memory_size, state->window_width, state->window_height))
+    {
+        return 1;
+    }
+#endif
+
+    start_time = linux_beneath_api_perf_time_nanoseconds();
+    last_time = start_time;
+
+    while (state->running && (frames_max == 0 || frames < frames_max))
+    {
+        /******************************/
+        /* Delta & Timing Metrics     */
+        /******************************/
+        double now = linux_beneath_api_perf_time_nanoseconds();
+        double delta = now - last_time;
+
+        last_time = now;
+        state->delta_time = delta * 1e-9;
+        state->time += state->delta_time;
+        state->frames_per_second = state->delta_time > 0.0 ? (unsigned int)(1.0 / state->delta_time) : 0;
+
+        /******************************/
+        /* Update State if Needed     */
+        /******************************/
+        if (state->changed_flags & BENEATH_STATE_CHANGED_FLAG_FRAMES_PER_SECOND_TARGET)
+        {
+            if (state->frames_per_second_target < 0)
+            {
+                state->frames_per_second_target = 60;
+            }
+        }
+
+#if defined(BENEATH_OPENGL_HEADLESS) && !defined(BENEATH_RENDER_THREAD)
+        /* The window size is the size of the offscreen output */
+        if (!linux_beneath_headless_frame_begin(&headless, state, frames))
+        {
+            break;
+        }
+#endif
+
+#ifdef BENEATH_SOFTWARE
+        /* The window size is the size of the software framebuffer */
+        if ((state->changed_flags & BENEATH_STATE_CHANGED_FLAG_WINDOW) &&
+            (state->window_width != software.width || state->window_height != software.height))
+        {
+            if (!linux_beneath_software_resize(&software_memory, &software_memory_size, state->window_width, state->window_height))
+            {
+                break;
+            }
+        }
+
+        beneath_software_frame_begin(&software, state->window_clear_color_r, state->window_clear_color_g, state->window_clear_color_b, state->window_clear_color_a);
+#endif
+
+        /* Window changes have no effect without a display */
+        state->changed_flags = BENEATH_STATE_CHANGED_FLAG_NOTHING;
+
+        /******************************/
+        /* Call Application           */
+        /******************************/
+        beneath_arena_reset(&memory.frame);
+
+        beneath_update(
+            &memory, /* Memory From Platform     */
+            &input,  /* Keyboard/Mouse/etc input */
+            &api     /* Platform API calls       */
+        );
+
+#ifdef BENEATH_OPENGL_HEADLESS
+#ifdef BENEATH_RENDER_THREAD
+        /* The render thread replays the recorded frame while the next one is simulated, cpu is the simulation only */
+        frame_cpu_ms[frames] = (linux_beneath_api_perf_time_nanoseconds() - now) * 1e-6;
+
+        if (!linux_beneath_render_thread_submit(&render_thread, state, frames))
+        {
+            break;
+        }
+#else
+        /* Render the queued draw calls */
+        linux_beneath_headless_frame_end();
+        frame_cpu_ms[frames] = (linux_beneath_api_perf_time_nanoseconds() - now) * 1e-6;
+        linux_beneath_headless_frame_timing(&headless, frames, frame_gl_ms);
+#endif
+
+        /* Headless renders as fast as possible, no frame rate limiting */
+        frames++;
+#else
+#ifdef BENEATH_SOFTWARE
+        {
+            double raster_start = linux_beneath_api_perf_time_nanoseconds();
+            beneath_software_frame_end(&software);
+            software_raster_ms += (linux_beneath_api_perf_time_nanoseconds() - raster_start) * 1e-6;
+        }
+#endif
+        frames++;
+
+        /******************************/
+        /* Frame Rate Limiting        */
+        /******************************/
+        if (state->frames_per_second_target > 0)
+        {
+            double target_frame_time = 1.0 / (double)state->frames_per_second_target;
+            double frame_time = (linux_beneath_api_perf_time_nanoseconds() - now) * 1e-9;
+            linux_beneath_precise_sleep(target_frame_time - frame_time);
+        }
+#endif
+    }
+
+    /* Frame summary */
+    {
+        char buffer[256];
+        unsigned int len = 0;
+        double total_ms = (linux_beneath_api_perf_time_nanoseconds() - start_time) * 1e-6;
+        unsigned int average_us = frames > 0 ? (unsigned int)(total_ms * 1000.0 / (double)frames) : 0;
+
+        beneath_strcpy(buffer, "[linux] ended after ", sizeof(buffer));
+        len = linux_beneath_api_strlen(buffer);
+        len += linux_beneath_api_append_uint(buffer + len, frames);
+        beneath_strcpy(buffer + len, " frames, avg frame (us): ", (int)(sizeof(buffer) - len));
+        len = linux_beneath_api_strlen(buffer);
+        len += linux_beneath_api_append_uint(buffer + len, average_us);
+        beneath_strcpy(buffer + len, ", draw calls: ", (int)(sizeof(buffer) - len));
+        len = linux_beneath_api_strlen(buffer);
+        len += linux_beneath_api_append_uint(buffer + len, graphics_stats.draw_calls);
+        beneath_strcpy(buffer + len, ", permanent arena (bytes): ", (int)(sizeof(buffer) - len));
+        len = linux_beneath_api_strlen(buffer);
+        len += linux_beneath_api_append_uint(buffer + len, memory.permanent.offset_max);
+        beneath_strcpy(buffer + len, ", frame arena peak (bytes): ", (int)(sizeof(buffer) - len));
+        len = linux_beneath_api_strlen(buffer);
+        len += linux_beneath_api_append_uint(buffer + len, memory.frame.offset_max);
+        beneath_strcpy(buffer + len, ", committed (KB): ", (int)(sizeof(buffer) - len));
+        len = linux_beneath_api_strlen(buffer);
+        len += linux_beneath_api_append_uint(buffer + len, (memory.permanent.committed + memory.frame.committed) / 1024);
+        beneath_strcpy(buffer + len, "\n", (int)(sizeof(buffer) - len));
+
+        linux_beneath_api_io_print(__FILE__, __LINE__, buffer);
+    }
+
+#ifdef BENEATH_OPENGL_HEADLESS
+#ifdef BENEATH_RENDER_THREAD
+    linux_beneath_render_thread_stop(&render_thread);
+#endif
+
+    /* Drain the frames still in flight */
+    {
+        unsigned int i = frames >= LINUX_BENEATH_HEADLESS_QUERIES - 1 ? frames - (LINUX_BENEATH_HEADLESS_QUERIES - 1) : 0;
+
+        for (; i < frames; ++i)
+        {
+            unsigned long long gl_ns = 0;
+            glGetQueryObjectui64v(headless.queries[i % LINUX_BENEATH_HEADLESS_QUERIES], GL_QUERY_RESULT, &gl_ns);
+            frame_gl_ms[i] = (double)gl_ns * 1e-6;
+        }
+    }
+
+    if (frames > LINUX_BENEATH_HEADLESS_WARMUP)
+    {
+        linux_beneath_headless_report("cpu", frame_cpu_ms + LINUX_BENEATH_HEADLESS_WARMUP, frames - LINUX_BENEATH_HEADLESS_WARMUP);
+        linux_beneath_headless_report("gl ", frame_gl_ms + LINUX_BENEATH_HEADLESS_WARMUP, frames - LINUX_BENEATH_HEADLESS_WARMUP);
+    }
+
+    {
+        char buffer[256];
+        unsigned int len = 0;
+
+        beneath_strcpy(buffer, "[headless] render queue (last frame) draws: ", sizeof(buffer));
+        len = linux_beneath_api_strlen(buffer);
+        len += linux_beneath_api_append_uint(buffer + len, ctx.queue_draws);
+        beneath_strcpy(buffer + len, ", gl state calls issued: ", (int)(sizeof(buffer) - len));
+        len = linux_beneath_api_strlen(buffer);
+        len += linux_beneath_api_append_uint(buffer + len, ctx.state_calls_issued);
+        beneath_strcpy(buffer + len, ", elided: ", (int)(sizeof(buffer) - len));
+        len = linux_beneath_api_strlen(buffer);
+        len += linux_beneath_api_append_uint(buffer + len, ctx.state_calls_elided);
+        beneath_strcpy(buffer + len, ", program binaries loaded: ", (int)(sizeof(buffer) - len));
+        len = linux_beneath_api_strlen(buffer);
+        len += linux_beneath_api_append_uint(buffer + len, ctx.program_cache_hits);
+        beneath_strcpy(buffer + len, ", compiled: ", (int)(sizeof(buffer) - len));
+        len = linux_beneath_api_strlen(buffer);
+        len += linux_beneath_api_append_uint(buffer + len, ctx.program_cache_misses);
+        beneath_strcpy(buffer + len, "\n", (int)(sizeof(buffer) - len));
+
+        linux_beneath_api_io_print(__FILE__, __LINE__, buffer);
+    }
+
+    {
+        char buffer[256];
+        unsigned int len = 0;
+
+        beneath_strcpy(buffer, "[headless] instances (last frame) submitted: ", sizeof(buffer));
+        len = linux_beneath_api_strlen(buffer);
+        len += linux_beneath_api_append_uint(buffer + len, ctx.instances_submitted);
+        beneath_strcpy(buffer + len, ", drawn after culling: ", (int)(sizeof(buffer) - len));
+        len = linux_beneath_api_strlen(buffer);
+        len += linux_beneath_api_append_uint(buffer + len, ctx.instances_drawn);
+        beneath_strcpy(buffer + len, ", occluded: ", (int)(sizeof(buffer) - len));
+        len = linux_beneath_api_strlen(buffer);
+        len += linux_beneath_api_append_uint(buffer + len, ctx.instances_occluded);
+        beneath_strcpy(buffer + len, ", shadow casters drawn: ", (int)(sizeof(buffer) - len));
+        len = linux_beneath_api_strlen(buffer);
+        len += linux_beneath_api_append_uint(buffer + len, ctx.instances_shadow_drawn);
+        beneath_strcpy(buffer + len, ", triangles drawn: ", (int)(sizeof(buffer) - len));
+        len = linux_beneath_api_strlen(buffer);
+        len += linux_beneath_api_append_uint(buffer + len, ctx.triangles_drawn);
+        beneath_strcpy(buffer + len, "\n", (int)(sizeof(buffer) - len));
+
+        linux_beneath_api_io_print(__FILE__, __LINE__, buffer);
+    }
+
+    if (!linux_beneath_headless_write_csv(LINUX_BENEATH_HEADLESS_OUTPUT "_frames.csv", frame_cpu_ms, frame_gl_ms, frames) ||
+        !linux_beneath_headless_write_ppm(&headless, LINUX_BENEATH_HEADLESS_OUTPUT "_last_frame.ppm"))
+    {
+        linux_beneath_api_io_print(__FILE__, __LINE__, "[headless] cannot write frame report!\n");
+    }
+
+    linux_beneath_headless_destroy(&headless);
+#endif
+
+#ifdef BENEATH_SOFTWARE
+    {
+        char buffer[256];
+        unsigned int len = 0;
+
+        beneath_strcpy(buffer, "[software] threads: ", sizeof(buffer));
+        len = linux_beneath_api_strlen(buffer);
+        len += linux_beneath_api_append_uint(buffer + len, software_pool.threads_count + 1);
+        beneath_strcpy(buffer + len, ", triangles (last frame): ", (int)(sizeof(buffer) - len));
+        len = linux_beneath_api_strlen(buffer);
+        len += linux_beneath_api_append_uint(buffer + len, software.stats_triangles);
+        beneath_strcpy(buffer + len, ", avg final flush (us): ", (int)(sizeof(buffer) - len));
+        len = linux_beneath_api_strlen(buffer);
+        len += linux_beneath_api_append_uint(buffer + len, frames > 0 ? (unsigned int)(software_raster_ms * 1000.0 / (double)frames) : 0);
+        beneath_strcpy(buffer + len, "\n", (int)(sizeof(buffer) - len));
+
+        linux_beneath_api_io_print(__FILE__, __LINE__, buffer);
+    }
+
+    if (!linux_beneath_write_ppm("linux_beneath_software_last_frame.ppm", (unsigned char *)software.color, software.width, software.height, software.pitch, false))
+    {
+        linux_beneath_api_io_print(__FILE__, __LINE__, "[software] cannot write last frame!\n");
+    }
+#endif
+
+    return 0;
+}
+
+#ifdef BENEATH_OPENGL_HEADLESS
+/* libEGL needs the libc startup, use the regular entry point */
+int main(int argc, char **argv)
+{
+    return linux_beneath_main(argc, argv);
+}
+#else
+/* Process entry point. The kernel leaves argc, argv and envp on the stack */
+#ifdef __x86_64__
+__asm__(
+    ".text\n"
+    ".global _start\n"
+    "_start:\n"
+    "    xor %rbp, %rbp\n"
+    "    mov %rsp, %rdi\n"
+    "    and $-16, %rsp\n"
+    "    call linux_beneath_start\n"
+    "    hlt\n");
+#else
+__asm__(
+    ".text\n"
+    ".global _start\n"
+    "_start:\n"
+    "    mov x29, #0\n"
+    "    mov x30, #0\n"
+    "    mov x0, sp\n"
+    "    and sp, x0, #-16\n"
+    "    bl linux_beneath_start\n"
+    "    brk #0\n");
+#endif
+
+#ifdef __clang__
+#elif __GNUC__
+__attribute((externally_visible))
+#endif
+__attribute((used)) void
+linux_beneath_start(long *stack)
+{
+    int argc = (int)stack[0];
+    char **argv = (char **)(stack + 1);
+
+    linux_exit_group(linux_beneath_main(argc, argv));
+}
+#endif /* BENEATH_OPENGL_HEADLESS */
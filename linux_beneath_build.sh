@@ -0,0 +1,52 @@
+#!/bin/sh
+# Compiles the program without the C standard library
+
+PLATFORM_NAME=linux_beneath
+APP_NAME=beneath_application
+DIST_DIR=dist
+
+DEF_COMPILER_FLAGS="-march=native -mtune=native \
+-std=c89 -pedantic -nodefaultlibs -nostdlib -static -fno-pie -no-pie -fno-stack-protector \
+-fno-builtin -ffreestanding -fno-asynchronous-unwind-tables \
+-Wall -Wextra -Werror -Wvla -Wconversion -Wdouble-promotion -Wsign-conversion \
+-Wmissing-field-initializers -Wuninitialized -Winit-self -Wunused -Wunused-macros -Wunused-local-typedefs"
+
+mkdir -p $DIST_DIR
+
+# "[beneath] Static Builds" (shared library hot reloading needs the libc dynamic loader)
+cc -g3 -DBENEATH_APPLICATION_LAYER_NAME=$APP_NAME $DEF_COMPILER_FLAGS $PLATFORM_NAME.c -o $DIST_DIR/${PLATFORM_NAME}_static_debug || exit 1
+cc -s -O2 -DBENEATH_APPLICATION_LAYER_NAME=$APP_NAME $DEF_COMPILER_FLAGS $PLATFORM_NAME.c -o $DIST_DIR/${PLATFORM_NAME}_static_release || exit 1
+
+# "[beneath] Software Renderer Build" (CPU tiled rasterizer on all cores, still without libc)
+cc -s -O2 -DBENEATH_APPLICATION_LAYER_NAME=$APP_NAME -DBENEATH_SOFTWARE $DEF_COMPILER_FLAGS $PLATFORM_NAME.c -o $DIST_DIR/${PLATFORM_NAME}_software_release || exit 1
+
+# "[beneath] Headless OpenGL Build" (EGL surfaceless/pbuffer, renders offscreen, needs libc + libEGL, e.g. mesa llvmpipe on CI)
+HEADLESS_COMPILER_FLAGS="-march=native -mtune=native -std=c99 -pedantic -DBENEATH_OPENGL_HEADLESS \
+-Wall -Wextra -Werror -Wvla -Wconversion -Wdouble-promotion -Wsign-conversion \
+-Wmissing-field-initializers -Wuninitialized -Winit-self -Wunused -Wunused-local-typedefs"
+cc -s -O2 -DBENEATH_APPLICATION_LAYER_NAME=$APP_NAME $HEADLESS_COMPILER_FLAGS $PLATFORM_NAME.c -o $DIST_DIR/${PLATFORM_NAME}_headless_release -lEGL || exit 1
+
+# "[beneath] Headless OpenGL Render Thread Build" (draw calls are recorded and replayed on a render thread owning the EGL context)
+cc -s -O2 -DBENEATH_APPLICATION_LAYER_NAME=$APP_NAME -DBENEATH_RENDER_THREAD $HEADLESS_COMPILER_FLAGS $PLATFORM_NAME.c -o $DIST_DIR/${PLATFORM_NAME}_headless_render_thread_release -lEGL -lpthread || exit 1
+
+# "[beneath] Mesh Cook Tool" (offline OBJ/glTF to .bmesh converter with an optional LOD chain, uses the C runtime for file access)
+COOK_COMPILER_FLAGS="-std=c89 -pedantic \
+-Wall -Wextra -Werror -Wvla -Wconversion -Wdouble-promotion -Wsign-conversion \
+-Wmissing-field-initializers -Wuninitialized -Winit-self -Wunused -Wunused-macros -Wunused-local-typedefs"
+cc -s -O2 $COOK_COMPILER_FLAGS beneath_cook.c -o $DIST_DIR/beneath_cook || exit 1
+
+# "[beneath] Cull Benchmark" (objects/ns of the vm.h sphere culling kernels, built once per SIMD path, uses the C runtime)
+cc -s -O2 -mavx $COOK_COMPILER_FLAGS beneath_cull_benchmark.c -o $DIST_DIR/beneath_cull_benchmark_avx || exit 1
+cc -s -O2 -mno-avx $COOK_COMPILER_FLAGS beneath_cull_benchmark.c -o $DIST_DIR/beneath_cull_benchmark_sse || exit 1
+
+cd $DIST_DIR
+./beneath_cook ../assets/beneath_cube.obj beneath_cube_obj.bmesh || exit 1
+# LOD chain smoke test, the tool fails unless every level is coarser and the selection walks down the chain with distance
+./beneath_cook ../assets/beneath_sphere.obj beneath_sphere.bmesh 3 || exit 1
+./beneath_cull_benchmark_sse || exit 1
+if grep -q " avx" /proc/cpuinfo; then ./beneath_cull_benchmark_avx || exit 1; fi
+./${PLATFORM_NAME}_static_release 120
+./${PLATFORM_NAME}_software_release 60
+./${PLATFORM_NAME}_headless_release 60
+./${PLATFORM_NAME}_headless_render_thread_release 60
+cd ..
@@ -0,0 +1,63 @@
+#ifndef LINUX_BENEATH_OPENGL_LOADER_H
+#define LINUX_BENEATH_OPENGL_LOADER_H
+
+#include "beneath_opengl_loader.h"
+
+/* #############################################################################
+ * # [Section] EGL Functions (libEGL, no system headers required)
+ * #############################################################################
+ */
+#define EGL_DEFAULT_DISPLAY ((void *)0)
+#define EGL_NO_DISPLAY ((void *)0)
+#define EGL_NO_CONTEXT ((void *)0)
+#define EGL_NO_SURFACE ((void *)0)
+#define EGL_NONE 0x3038
+#define EGL_ALPHA_SIZE 0x3021
+#define EGL_BLUE_SIZE 0x3022
+#define EGL_GREEN_SIZE 0x3023
+#define EGL_RED_SIZE 0x3024
+#define EGL_DEPTH_SIZE 0x3025
+#define EGL_SURFACE_TYPE 0x3033
+#define EGL_RENDERABLE_TYPE 0x3040
+#define EGL_PBUFFER_BIT 0x0001
+#define EGL_OPENGL_BIT 0x0008
+#define EGL_EXTENSIONS 0x3055
+#define EGL_HEIGHT 0x3056
+#define EGL_WIDTH 0x3057
+#define EGL_OPENGL_API 0x30A2
+#define EGL_CONTEXT_MAJOR_VERSION 0x3098
+#define EGL_CONTEXT_MINOR_VERSION 0x30FB
+#define EGL_CONTEXT_OPENGL_PROFILE_MASK 0x30FD
+#define EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT 0x00000001
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+
+extern void *eglGetDisplay(void *display_id);
+extern unsigned int eglInitialize(void *display, int *major, int *minor);
+extern unsigned int eglTerminate(void *display);
+extern char *eglQueryString(void *display, int name);
+extern unsigned int eglChooseConfig(void *display, int *attrib_list, void **configs, int config_size, int *num_config);
+extern unsigned int eglBindAPI(unsigned int api);
+extern void *eglCreateContext(void *display, void *config, void *share_context, int *attrib_list);
+extern unsigned int eglDestroyContext(void *display, void *context);
+extern void *eglCreatePbufferSurface(void *display, void *config, int *attrib_list);
+extern unsigned int eglDestroySurface(void *display, void *surface);
+extern unsigned int eglMakeCurrent(void *display, void *draw, void *read, void *context);
+extern void *eglGetProcAddress(char *procname);
+
+typedef void *(*PFNEGLGETPLATFORMDISPLAYEXTPROC)(unsigned int platform, void *native_display, int *attrib_list);
+
+/* #############################################################################
+ * # [Section] Loader Implementation
+ * #############################################################################
+ */
+static void *linux_beneath_opengl_load_function(char *gl_function_name)
+{
+    return eglGetProcAddress(gl_function_name);
+}
+
+static int linux_beneath_opengl_load_functions(void)
+{
+    return beneath_opengl_load_functions(linux_beneath_opengl_load_function);
+}
+
+#endif /* LINUX_BENEATH_OPENGL_LOADER_H */
@@ -68,6 +68,15 @@ typedef struct WIN32_FILE_ATTRIBUTE_DATA
     unsigned long nFileSizeLow;
 } WIN32_FILE_ATTRIBUTE_DATA;
 
+typedef struct OVERLAPPED
+{
+    UINT_PTR Internal;
+    UINT_PTR InternalHigh;
+    unsigned long Offset;
+    unsigned long OffsetHigh;
+    void *hEvent;
+} OVERLAPPED;
+
 typedef enum GET_FILEEX_INFO_LEVELS
 {
     GetFileExInfoStandard,
@@ -240,6 +249,8 @@ typedef struct tagCREATESTRUCTA
 #define ES_CONTINUOUS ((unsigned long)0x80000000)
 
 #define INFINITE 0xffffffff
+#define ALL_PROCESSOR_GROUPS 0xffff
+#define TLS_OUT_OF_INDEXES ((unsigned long)0xFFFFFFFF)
 
 #define VREFRESH 116
 #define RIM_TYPEMOUSE 0
@@ -270,13 +281,18 @@ typedef struct tagCREATESTRUCTA
 #define CREATE_ALWAYS 2
 #define MEM_COMMIT 0x00001000
 #define MEM_RESERVE 0x00002000
+#define PAGE_NOACCESS 0x01
+#define PAGE_READONLY 0x02
 #define PAGE_READWRITE 0x04
 #define INVALID_HANDLE_VALUE ((void *)(LONG_PTR) - 1)
 #define GENERIC_READ (0x80000000L)
 #define FILE_SHARE_READ 0x00000001
 #define OPEN_EXISTING 3
 #define FILE_ATTRIBUTE_NORMAL 0x00000080
+#define FILE_MAP_READ 0x0004
 #define FILE_FLAG_OVERLAPPED 0x40000000
+#define ERROR_IO_INCOMPLETE 996
+#define ERROR_IO_PENDING 997
 #define INVALID_FILE_SIZE ((unsigned long)0xFFFFFFFF)
 #define STD_OUTPUT_HANDLE ((unsigned long)-11)
 #define PM_REMOVE 0x0001
@@ -482,6 +498,30 @@ ReadFile(void *hFile, void *lpBuffer, unsigned long nNumberOfBytesToRead, unsign
 WIN32_API(unsigned long)
 GetFileSize(void *hFile, unsigned long *lpFileSizeHigh);
 WIN32_API(void *)
+CreateFileMappingA(void *hFile, void *lpFileMappingAttributes, unsigned long flProtect, unsigned long dwMaximumSizeHigh, unsigned long dwMaximumSizeLow, char *lpName);
+WIN32_API(void *)
+MapViewOfFile(void *hFileMappingObject, unsigned long dwDesiredAccess, unsigned long dwFileOffsetHigh, unsigned long dwFileOffsetLow, UINT_PTR dwNumberOfBytesToMap);
+WIN32_API(int)
+UnmapViewOfFile(void *lpBaseAddress);
+WIN32_API(int)
+GetOverlappedResult(void *hFile, OVERLAPPED *lpOverlapped, unsigned long *lpNumberOfBytesTransferred, int bWait);
+WIN32_API(unsigned long)
+GetLastError(void);
+WIN32_API(unsigned long)
+GetActiveProcessorCount(unsigned short GroupNumber);
+WIN32_API(void *)
+CreateThread(void *lpThreadAttributes, UINT_PTR dwStackSize, unsigned long(WIN32_API_CALLBACK *lpStartAddress)(void *), void *lpParameter, unsigned long dwCreationFlags, unsigned long *lpThreadId);
+WIN32_API(void *)
+CreateSemaphoreA(void *lpSemaphoreAttributes, long lInitialCount, long lMaximumCount, char *lpName);
+WIN32_API(int)
+ReleaseSemaphore(void *hSemaphore, long lReleaseCount, long *lpPreviousCount);
+WIN32_API(unsigned long)
+TlsAlloc(void);
+WIN32_API(void *)
+TlsGetValue(unsigned long dwTlsIndex);
+WIN32_API(int)
+TlsSetValue(unsigned long dwTlsIndex, void *lpTlsValue);
+WIN32_API(void *)
 VirtualAlloc(void *lpAddress, UINT_PTR dwSize, unsigned longflAllocationType, unsigned longflProtect);
 WIN32_API(void *)
 GetStdHandle(unsigned long nStdHandle);
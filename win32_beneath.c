@@ -3,6 +3,7 @@
 #include "beneath.h"
 
 #include "win32_api.h"                   /* windows.h replacement   */
+#include "beneath_jobs.h"                /* work stealing jobs      */
 #include "win32_beneath_opengl_loader.h" /* opengl loading function */
 #include "win32_beneath_opengl.h"        /* beneath opengl renderer */
 
@@ -133,12 +134,312 @@ BENEATH_API BENEATH_INLINE beneath_bool win32_beneath_api_io_file_write(
     return (success && (bytes_written == buffer_size));
 }
 
+BENEATH_API BENEATH_INLINE beneath_bool win32_beneath_api_io_file_map(
+    char *filename,         /* The filename/path to map */
+    void **file_data,       /* The start of the mapped file contents */
+    unsigned int *file_size /* The size of the mapping in bytes */
+)
+{
+    void *hFile;
+    void *hMapping;
+    void *view;
+    unsigned long fileSize;
+
+    hFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+
+    if (hFile == INVALID_HANDLE)
+    {
+        return false;
+    }
+
+    fileSize = GetFileSize(hFile, 0);
+
+    /* Empty files cannot be mapped */
+    if (fileSize == INVALID_FILE_SIZE || fileSize == 0)
+    {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    hMapping = CreateFileMappingA(hFile, 0, PAGE_READONLY, 0, 0, 0);
+    CloseHandle(hFile);
+
+    if (!hMapping)
+    {
+        return false;
+    }
+
+    /* The view keeps the mapping object alive */
+    view = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(hMapping);
+
+    if (!view)
+    {
+        return false;
+    }
+
+    *file_data = view;
+    *file_size = fileSize;
+
+    return true;
+}
+
+BENEATH_API BENEATH_INLINE beneath_bool win32_beneath_api_io_file_unmap(
+    void *file_data,       /* The file_data returned by io_file_map */
+    unsigned int file_size /* The file_size returned by io_file_map */
+)
+{
+    (void)file_size;
+    return UnmapViewOfFile(file_data) != 0;
+}
+
+/* #############################################################################
+ * # Asynchronous file io (overlapped ReadFile, polled without waiting)
+ * #############################################################################
+ *
+ * Opening the file and queueing the read happen on the calling thread, the kernel
+ * fills the buffer in the background. The OVERLAPPED has to stay in place while the
+ * read runs, so requests live in a static slot table.
+ */
+#define WIN32_BENEATH_IO_REQUESTS_MAX 64 /* Slots, the handle keeps the slot in its low 7 bits */
+
+typedef struct win32_beneath_io_request
+{
+    beneath_io_status status;
+    unsigned int generation;
+    void *hFile;
+    OVERLAPPED overlapped;
+    unsigned char *buffer;
+    unsigned int size;
+
+} win32_beneath_io_request;
+
+static win32_beneath_io_request win32_io_requests[WIN32_BENEATH_IO_REQUESTS_MAX];
+
+BENEATH_API BENEATH_INLINE beneath_io_handle win32_beneath_api_io_file_read_async(
+    char *filename,                   /* The filename/path to read, copied (at most BENEATH_IO_FILENAME_MAX - 1 characters) */
+    unsigned char *file_buffer,       /* The user provided file_buffer large enough to hold the file contents */
+    unsigned int file_buffer_capacity /* The capacity/max site of the file_buffer */
+)
+{
+    win32_beneath_io_request *request = NULL;
+    unsigned long fileSize;
+    unsigned int slot;
+    int i;
+
+    for (slot = 0; slot < WIN32_BENEATH_IO_REQUESTS_MAX; ++slot)
+    {
+        if (win32_io_requests[slot].status == BENEATH_IO_STATUS_INVALID)
+        {
+            request = &win32_io_requests[slot];
+            break;
+        }
+    }
+
+    if (!request || win32_beneath_api_strlen(filename) >= BENEATH_IO_FILENAME_MAX)
+    {
+        return 0;
+    }
+
+    request->hFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, 0);
+
+    if (request->hFile == INVALID_HANDLE)
+    {
+        return 0;
+    }
+
+    fileSize = GetFileSize(request->hFile, 0);
+
+    if (fileSize == INVALID_FILE_SIZE || file_buffer_capacity < fileSize + 1)
+    {
+        CloseHandle(request->hFile);
+        return 0;
+    }
+
+    for (i = 0; i < (int)sizeof(OVERLAPPED); ++i)
+    {
+        ((unsigned char *)&request->overlapped)[i] = 0;
+    }
+
+    request->buffer = file_buffer;
+    request->size = fileSize;
+    request->status = BENEATH_IO_STATUS_PENDING;
+
+    /* Cached reads may complete right away, poll reports them as usual */
+    if (!ReadFile(request->hFile, file_buffer, fileSize, 0, &request->overlapped) && GetLastError() != ERROR_IO_PENDING)
+    {
+        CloseHandle(request->hFile);
+        request->status = BENEATH_IO_STATUS_INVALID;
+        return 0;
+    }
+
+    return ((request->generation & 0x1FFFFFFu) << 7) | (slot + 1);
+}
+
+BENEATH_API BENEATH_INLINE beneath_io_status win32_beneath_api_io_file_read_poll(
+    beneath_io_handle handle,      /* The handle returned by io_file_read_async */
+    unsigned int *file_buffer_size /* The total number of bytes read once COMPLETED */
+)
+{
+    unsigned int slot = (handle & 0x7Fu) - 1;
+    win32_beneath_io_request *request;
+    beneath_io_status status;
+    unsigned long bytesRead = 0;
+
+    if (handle == 0 || slot >= WIN32_BENEATH_IO_REQUESTS_MAX)
+    {
+        return BENEATH_IO_STATUS_INVALID;
+    }
+
+    request = &win32_io_requests[slot];
+
+    if (request->status == BENEATH_IO_STATUS_INVALID || (request->generation & 0x1FFFFFFu) != handle >> 7)
+    {
+        return BENEATH_IO_STATUS_INVALID;
+    }
+
+    if (GetOverlappedResult(request->hFile, &request->overlapped, &bytesRead, 0))
+    {
+        status = bytesRead == request->size ? BENEATH_IO_STATUS_COMPLETED : BENEATH_IO_STATUS_FAILED;
+    }
+    else if (GetLastError() == ERROR_IO_INCOMPLETE)
+    {
+        return BENEATH_IO_STATUS_PENDING;
+    }
+    else
+    {
+        status = BENEATH_IO_STATUS_FAILED;
+    }
+
+    /* Finished, release the slot */
+    CloseHandle(request->hFile);
+
+    if (status == BENEATH_IO_STATUS_COMPLETED)
+    {
+        request->buffer[request->size] = '\0';
+        *file_buffer_size = request->size;
+    }
+
+    request->generation++;
+    request->status = BENEATH_IO_STATUS_INVALID;
+
+    return status;
+}
+
+/* #############################################################################
+ * # Jobs (work stealing worker threads)
+ * #############################################################################
+ *
+ * Idle workers sleep on a semaphore instead of a futex. A wake that happens before
+ * the wait stays in the semaphore count, the worker then only returns spuriously.
+ */
+#define WIN32_BENEATH_JOBS_THREAD_STACK_SIZE (256 * 1024)
+
+static beneath_jobs jobs;
+static void *jobs_semaphore;
+static unsigned long jobs_tls_index;
+
+BENEATH_API unsigned int win32_beneath_jobs_thread_index(void)
+{
+    /* Zero (the main thread) until a worker stored its index */
+    return (unsigned int)(UINT_PTR)TlsGetValue(jobs_tls_index);
+}
+
+BENEATH_API void win32_beneath_jobs_wait(int *address, int expected)
+{
+    if (*(volatile int *)address == expected)
+    {
+        WaitForSingleObject(jobs_semaphore, INFINITE);
+    }
+}
+
+BENEATH_API void win32_beneath_jobs_wake(int *address, int count)
+{
+    (void)address;
+    ReleaseSemaphore(jobs_semaphore, count, NULL);
+}
+
+BENEATH_API unsigned long WIN32_API_CALLBACK win32_beneath_jobs_worker(void *parameter)
+{
+    unsigned int index = (unsigned int)(UINT_PTR)parameter;
+
+    TlsSetValue(jobs_tls_index, parameter);
+    beneath_jobs_worker(&jobs, index);
+
+    return 0;
+}
+
+/* One worker per logical processor besides the main thread, without workers jobs run on the caller */
+BENEATH_API void win32_beneath_jobs_threads_start(void)
+{
+    unsigned int started = 1;
+    unsigned int i;
+
+    beneath_jobs_initialize(&jobs, GetActiveProcessorCount(ALL_PROCESSOR_GROUPS), win32_beneath_jobs_thread_index, win32_beneath_jobs_wait, win32_beneath_jobs_wake);
+
+    if (jobs.threads_count == 1)
+    {
+        return;
+    }
+
+    jobs_tls_index = TlsAlloc();
+    jobs_semaphore = CreateSemaphoreA(NULL, 0, 0x7FFFFFFF, NULL);
+
+    if (jobs_tls_index == TLS_OUT_OF_INDEXES || !jobs_semaphore)
+    {
+        jobs.threads_count = 1;
+        return;
+    }
+
+    for (i = 1; i < jobs.threads_count; ++i)
+    {
+        void *thread = CreateThread(NULL, WIN32_BENEATH_JOBS_THREAD_STACK_SIZE, win32_beneath_jobs_worker, (void *)(UINT_PTR)i, 0, NULL);
+
+        if (!thread)
+        {
+            break;
+        }
+
+        /* The thread keeps running, the handle is not needed */
+        CloseHandle(thread);
+        started++;
+    }
+
+    jobs.threads_count = started;
+}
+
+BENEATH_API void win32_beneath_api_job_run(beneath_job_function function, void *data, unsigned int count, beneath_job_counter *counter)
+{
+    beneath_jobs_run(&jobs, function, data, count, counter);
+}
+
+BENEATH_API void win32_beneath_api_job_wait(beneath_job_counter *counter)
+{
+    beneath_jobs_wait_counter(&jobs, counter);
+}
+
+BENEATH_API void win32_beneath_api_job_parallel_for(beneath_job_range_function function, void *data, unsigned int count, unsigned int batch_size)
+{
+    beneath_jobs_parallel_for(&jobs, function, data, count, batch_size);
+}
+
+BENEATH_API unsigned int win32_beneath_api_job_threads_count(void)
+{
+    return jobs.threads_count;
+}
+
 BENEATH_API BENEATH_INLINE beneath_bool win32_beneath_api_time_sleep(unsigned int milliseconds)
 {
     Sleep(milliseconds);
     return true;
 }
 
+/* Commits reserved pages of the application memory (beneath_arena_commit) */
+BENEATH_API beneath_bool win32_beneath_memory_commit(void *address, unsigned int size)
+{
+    return VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != 0;
+}
+
 BENEATH_API BENEATH_INLINE unsigned int win32_beneath_api_perf_cycle_count(void)
 {
     unsigned int low_part = 0;
@@ -593,7 +894,10 @@ BENEATH_API BENEATH_INLINE LONG_PTR WIN32_API_CALLBACK win32_beneath_window_call
         win32_state->state->window_width = (unsigned int)LOWORD((unsigned long)lParam);
         win32_state->state->window_height = (unsigned int)HIWORD((unsigned long)lParam);
 
+#ifndef BENEATH_RENDER_THREAD
+        /* With a render thread the context is not current here, it sets the viewport itself */
         glViewport(0, 0, (int)win32_state->state->window_width, (int)win32_state->state->window_height);
+#endif
     }
     break;
     case WM_SYSKEYDOWN:
@@ -1003,6 +1307,150 @@ BENEATH_API BENEATH_INLINE void win32_beneath_process_input(beneath_state *state
     }
 }
 
+#ifdef BENEATH_RENDER_THREAD
+/* #############################################################################
+ * # Render Thread (owns the wgl context, replays the command lists)
+ * #############################################################################
+ *
+ * beneath_update records frame N + 1 into one command list while the render thread
+ * replays frame N from the other and presents it. Submitting a list waits until the
+ * previous one was presented, the application runs at most one frame ahead.
+ */
+#define WIN32_BENEATH_RENDER_THREAD_STACK_SIZE (1024 * 1024)
+
+typedef struct win32_beneath_render_thread
+{
+    void *thread;
+    void *submit_semaphore; /* Released by the main thread for every frame and to quit */
+    void *idle_semaphore;   /* Released by the render thread once a frame is presented */
+    void *dc;
+    void *rc;
+
+    beneath_opengl_command_list lists[2];
+    beneath_opengl_command_list *submitted;
+    beneath_bool quit;
+
+} win32_beneath_render_thread;
+
+static win32_beneath_render_thread render_thread;
+static beneath_opengl_command_list *render_commands; /* The list beneath_update records into */
+
+BENEATH_API unsigned long WIN32_API_CALLBACK win32_beneath_render_thread_main(void *parameter)
+{
+    win32_beneath_render_thread *render = (win32_beneath_render_thread *)parameter;
+    unsigned int viewport_width = 0;
+    unsigned int viewport_height = 0;
+
+    wglMakeCurrent(render->dc, render->rc);
+
+    for (;;)
+    {
+        beneath_opengl_command_list *list;
+
+        WaitForSingleObject(render->submit_semaphore, INFINITE);
+
+        if (render->quit)
+        {
+            break;
+        }
+
+        list = render->submitted;
+
+        /* WM_SIZE arrives on the main thread, the viewport follows the recorded window size */
+        if (list->state.window_width != viewport_width || list->state.window_height != viewport_height)
+        {
+            viewport_width = list->state.window_width;
+            viewport_height = list->state.window_height;
+            glViewport(0, 0, (int)viewport_width, (int)viewport_height);
+        }
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        beneath_opengl_frame_begin();
+        beneath_opengl_command_list_replay(list, win32_beneath_api_io_print);
+        beneath_opengl_frame_end(win32_beneath_api_io_print);
+
+        SwapBuffers(render->dc);
+
+        ReleaseSemaphore(render->idle_semaphore, 1, NULL);
+    }
+
+    wglMakeCurrent(0, 0);
+
+    return 0;
+}
+
+/* Hands the current wgl context over to a new render thread */
+BENEATH_API beneath_bool win32_beneath_render_thread_start(win32_beneath_render_thread *render, void *dc)
+{
+    unsigned char *memory = (unsigned char *)VirtualAlloc(0, 2 * (UINT_PTR)BENEATH_OPENGL_COMMAND_LIST_MEMORY_SIZE, MEM_RESERVE, PAGE_NOACCESS);
+
+    if (!memory)
+    {
+        return false;
+    }
+
+    beneath_opengl_command_list_initialize(&render->lists[0], memory, BENEATH_OPENGL_COMMAND_LIST_MEMORY_SIZE, win32_beneath_memory_commit);
+    beneath_opengl_command_list_initialize(&render->lists[1], memory + BENEATH_OPENGL_COMMAND_LIST_MEMORY_SIZE, BENEATH_OPENGL_COMMAND_LIST_MEMORY_SIZE, win32_beneath_memory_commit);
+
+    render->dc = dc;
+    render->rc = wglGetCurrentContext();
+    render->submitted = NULL;
+    render->quit = false;
+    render_commands = &render->lists[0];
+
+    /* The render thread starts idle */
+    render->submit_semaphore = CreateSemaphoreA(NULL, 0, 1, NULL);
+    render->idle_semaphore = CreateSemaphoreA(NULL, 1, 1, NULL);
+
+    if (!render->rc || !render->submit_semaphore || !render->idle_semaphore)
+    {
+        return false;
+    }
+
+    /* A context is current on one thread at a time */
+    wglMakeCurrent(0, 0);
+
+    render->thread = CreateThread(NULL, WIN32_BENEATH_RENDER_THREAD_STACK_SIZE, win32_beneath_render_thread_main, render, 0, NULL);
+
+    if (!render->thread)
+    {
+        wglMakeCurrent(dc, render->rc);
+        return false;
+    }
+
+    return true;
+}
+
+/* Submits the recorded frame and starts recording into the other list */
+BENEATH_API void win32_beneath_render_thread_submit(win32_beneath_render_thread *render, beneath_state *state)
+{
+    beneath_opengl_command_list *list = render_commands;
+
+    beneath_opengl_command_list_end(list, state);
+
+    /* The render thread is done with the previous frame and therefore with the other list */
+    WaitForSingleObject(render->idle_semaphore, INFINITE);
+
+    render->submitted = list;
+    ReleaseSemaphore(render->submit_semaphore, 1, NULL);
+
+    render_commands = list == &render->lists[0] ? &render->lists[1] : &render->lists[0];
+    beneath_opengl_command_list_begin(render_commands);
+}
+
+/* Waits for the last frame and ends the render thread */
+BENEATH_API void win32_beneath_render_thread_stop(win32_beneath_render_thread *render)
+{
+    WaitForSingleObject(render->idle_semaphore, INFINITE);
+
+    render->quit = true;
+    ReleaseSemaphore(render->submit_semaphore, 1, NULL);
+
+    WaitForSingleObject(render->thread, INFINITE);
+    CloseHandle(render->thread);
+}
+#endif /* BENEATH_RENDER_THREAD */
+
 BENEATH_API beneath_bool win32_beneath_api_graphics_draw(
     beneath_state *state,         /* The state */
     beneath_draw_call *draw_call, /* The draw call instanced objects */
@@ -1012,6 +1460,18 @@ BENEATH_API beneath_bool win32_beneath_api_graphics_draw(
     float camera_position[3]      /* The camera x,y,z position */
 )
 {
+#ifdef BENEATH_RENDER_THREAD
+    (void)state;
+
+    return beneath_opengl_command_list_record(
+        render_commands,
+        draw_call,
+        projection_view,
+        projection_inverse,
+        view_inverse,
+        camera_position,
+        win32_beneath_api_io_print);
+#else
     return beneath_opengl_draw(
         state,
         draw_call,
@@ -1020,6 +1480,7 @@ BENEATH_API beneath_bool win32_beneath_api_graphics_draw(
         view_inverse,
         camera_position,
         win32_beneath_api_io_print);
+#endif
 }
 
 #ifdef __clang__
@@ -1032,7 +1493,7 @@ __attribute((force_align_arg_pointer))
 int mainCRTStartup(void)
 {
     double last_time;
-    unsigned int memory_size = 1024 * 1024 * 1; /* 1 MB */
+    unsigned int memory_size = BENEATH_MEMORY_RESERVE_SIZE; /* Reserved only, committed as the arenas grow */
 
     beneath_memory memory = {0};
     beneath_api api = {0};
@@ -1087,13 +1548,28 @@ int mainCRTStartup(void)
     }
 
     memory.memory_offset = sizeof(beneath_state);
-    memory.memory = VirtualAlloc(0, memory_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    memory.memory = VirtualAlloc(0, memory_size, MEM_RESERVE, PAGE_NOACCESS);
+    memory.memory_size = memory_size;
 
-    if (!memory.memory)
+    if (!memory.memory ||
+        !win32_beneath_memory_commit(memory.memory, memory.memory_offset) ||
+        !beneath_memory_arenas_initialize(&memory, BENEATH_MEMORY_FRAME_SIZE, win32_beneath_memory_commit))
     {
         return 1;
     }
 
+    /* Renderer memory, separate from the application memory */
+    {
+        void *renderer_memory = VirtualAlloc(0, BENEATH_OPENGL_MEMORY_SIZE, MEM_RESERVE, PAGE_NOACCESS);
+
+        if (!renderer_memory)
+        {
+            return 1;
+        }
+
+        beneath_opengl_memory_initialize(renderer_memory, BENEATH_OPENGL_MEMORY_SIZE, win32_beneath_memory_commit);
+    }
+
     /* Default state before application call */
     state = (beneath_state *)memory.memory;
     state->window_width = 800;
@@ -1113,10 +1589,23 @@ int mainCRTStartup(void)
     api.io_file_size = win32_beneath_api_io_file_size;
     api.io_file_read = win32_beneath_api_io_file_read;
     api.io_file_write = win32_beneath_api_io_file_write;
+    api.io_file_map = win32_beneath_api_io_file_map;
+    api.io_file_unmap = win32_beneath_api_io_file_unmap;
+    api.io_file_read_async = win32_beneath_api_io_file_read_async;
+    api.io_file_read_poll = win32_beneath_api_io_file_read_poll;
     api.perf_cycle_count = win32_beneath_api_perf_cycle_count;
     api.perf_time_nanoseconds = win32_beneath_api_perf_time_nanoseconds;
+    api.job_run = win32_beneath_api_job_run;
+    api.job_wait = win32_beneath_api_job_wait;
+    api.job_parallel_for = win32_beneath_api_job_parallel_for;
+    api.job_threads_count = win32_beneath_api_job_threads_count;
     api.graphics_draw = win32_beneath_api_graphics_draw;
 
+    /* The renderer stores its program binary cache through the same file io */
+    beneath_opengl_io_initialize(api.io_file_size, api.io_file_read, api.io_file_write);
+
+    win32_beneath_jobs_threads_start();
+
     /* Load window and initialize opengl 3.3 */
     timer = CreateWaitableTimerA(NULL, true, NULL);
 
@@ -1131,6 +1620,15 @@ int mainCRTStartup(void)
         return 1;
     }
 
+#ifdef BENEATH_RENDER_THREAD
+    if (!win32_beneath_render_thread_start(&render_thread, dc))
+    {
+        win32_beneath_api_io_print(__FILE__, __LINE__, "[win32] cannot start the render thread!\n");
+        ExitProcess(1);
+        return 1;
+    }
+#endif
+
     /* TODO: proper vsync */
     if (state->frames_per_second_target != BENEATH_STATE_FRAMES_PER_SECOND_UNLIMITED)
     {
@@ -1189,21 +1687,34 @@ int mainCRTStartup(void)
         /******************************/
         win32_beneath_process_input(state, &input);
 
+#ifndef BENEATH_RENDER_THREAD
         /******************************/
         /* Rendering                  */
         /******************************/
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        beneath_opengl_frame_begin();
+#endif
 
         /******************************/
         /* Call Application           */
         /******************************/
+        beneath_arena_reset(&memory.frame);
+
         beneath_update(
             &memory, /* Memory From Platform     */
             &input,  /* Keyboard/Mouse/etc input */
             &api     /* Platform API calls       */
         );
 
+#ifdef BENEATH_RENDER_THREAD
+        /* The render thread replays and presents this frame while the next one is simulated */
+        win32_beneath_render_thread_submit(&render_thread, state);
+#else
+        /* Render the queued draw calls */
+        beneath_opengl_frame_end(win32_beneath_api_io_print);
+
         SwapBuffers(dc);
+#endif
 
         /******************************/
         /* Frame Rate Limiting        */
@@ -1215,6 +1726,10 @@ int mainCRTStartup(void)
         }
     }
 
+#ifdef BENEATH_RENDER_THREAD
+    win32_beneath_render_thread_stop(&render_thread);
+#endif
+
     win32_beneath_api_io_print(__FILE__, __LINE__, "[win32] ended\n");
 
     SetThreadExecutionState(ES_CONTINUOUS);
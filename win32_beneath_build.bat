@@ -25,7 +25,21 @@ cc -g3 -shared -DBENEATH_LIB %DEF_COMPILER_FLAGS% %APP_NAME%.c -o %DIST_DIR%/%AP
 REM cc -s -O2 -DBENEATH_LIB -DBENEATH_APPLICATION_LAYER_NAME=%APP_NAME%_dynamic_release %DEF_COMPILER_FLAGS% %PLATFORM_NAME%.c -o %DIST_DIR%/%PLATFORM_NAME%_dynamic_release.exe %DEF_FLAGS_LINKER%
 REM cc -s -O2 -shared -DBENEATH_LIB %DEF_COMPILER_FLAGS% %APP_NAME%.c -o %DIST_DIR%/%APP_NAME%_dynamic_release.dll
 
+REM "[beneath] Render Thread Build" (draw calls are recorded and replayed on a render thread owning the wgl context)
+REM cc -s -O2 -DBENEATH_RENDER_THREAD -DBENEATH_APPLICATION_LAYER_NAME=%APP_NAME% %DEF_COMPILER_FLAGS% %PLATFORM_NAME%.c -o %DIST_DIR%/%PLATFORM_NAME%_render_thread_release.exe %DEF_FLAGS_LINKER%
+
+REM "[beneath] Mesh Cook Tool" (offline OBJ/glTF to .bmesh converter, uses the C runtime for file access)
+cc -s -O2 -mconsole -std=c89 -pedantic -Wall -Wextra -Werror -Wvla -Wconversion -Wdouble-promotion -Wsign-conversion -Wmissing-field-initializers -Wuninitialized -Winit-self -Wunused -Wunused-macros -Wunused-local-typedefs beneath_cook.c -o %DIST_DIR%/beneath_cook.exe
+
+REM "[beneath] Cull Benchmark" (objects/ns of the vm.h sphere culling kernels, built once per SIMD path, uses the C runtime)
+cc -s -O2 -mconsole -mavx -std=c89 -pedantic -Wall -Wextra -Werror -Wvla -Wconversion -Wdouble-promotion -Wsign-conversion -Wmissing-field-initializers -Wuninitialized -Winit-self -Wunused -Wunused-macros -Wunused-local-typedefs beneath_cull_benchmark.c -o %DIST_DIR%/beneath_cull_benchmark_avx.exe
+cc -s -O2 -mconsole -mno-avx -std=c89 -pedantic -Wall -Wextra -Werror -Wvla -Wconversion -Wdouble-promotion -Wsign-conversion -Wmissing-field-initializers -Wuninitialized -Winit-self -Wunused -Wunused-macros -Wunused-local-typedefs beneath_cull_benchmark.c -o %DIST_DIR%/beneath_cull_benchmark_sse.exe
+
 cd %DIST_DIR%
+beneath_cook.exe ../assets/beneath_cube.obj beneath_cube_obj.bmesh
+beneath_cook.exe ../assets/beneath_sphere.obj beneath_sphere.bmesh 3
+beneath_cull_benchmark_sse.exe
+beneath_cull_benchmark_avx.exe
 REM %PLATFORM_NAME%_static_debug.exe
 REM %PLATFORM_NAME%_static_release.exe
 %PLATFORM_NAME%_dynamic_debug.exe
@@ -2,10 +2,10 @@
 #define WIN32_BENEATH_OPENGL
 
 #include "beneath.h"
-#include "win32_api.h"
-#include "win32_beneath_opengl_loader.h"
+#include "beneath_opengl_loader.h" /* Platform independent, the platform layer loads the functions */
 #include "deps/sb.h" /* Temporary for prototype: String builder */
 #include "deps/vm.h" /* Temporary for prototype: Vector math */
+#include "beneath_bvh.h"
 
 static char beneath_opengl_shader_shadow_vertex[] = {
     " /* Beneath ShadowMap Vertex Shader */                     \n"
@@ -105,6 +105,23 @@ char beneath_opengl_shader_volumetric_fragment_2[] = {
     " FragColor = vec4(color, 1.0);\n"
     "} \n"};
 
+/* Hi-Z reduction, the farthest depth of every 2x2 block. Levels round their size up,
+ * the texel fetches are clamped so the last row and column of odd sizes are kept.
+ */
+static char beneath_opengl_shader_hiz_fragment[] = {
+    "#version 330 core                                                      \n"
+    "out float depth;                                                       \n"
+    "uniform sampler2D source; /* Depth texture or the previous level */   \n"
+    "void main() {                                                          \n"
+    "    ivec2 last = textureSize(source, 0) - 1;                           \n"
+    "    ivec2 p = ivec2(gl_FragCoord.xy) * 2;                              \n"
+    "    float a = texelFetch(source, min(p, last), 0).r;                   \n"
+    "    float b = texelFetch(source, min(p + ivec2(1, 0), last), 0).r;     \n"
+    "    float c = texelFetch(source, min(p + ivec2(0, 1), last), 0).r;     \n"
+    "    float d = texelFetch(source, min(p + ivec2(1, 1), last), 0).r;     \n"
+    "    depth = max(max(a, b), max(c, d));                                 \n"
+    "}                                                                      \n"};
+
 static char beneath_opengl_shader_volumetric_fragment[] =
     "#version 330 core\n"
     "in vec2 vUV;\n"
@@ -266,29 +283,109 @@ static char *beneath_opengl_shader_layout_names[14] = {
     "texture_index" /* Instance Texture Index*/
 };
 
+/* Per draw uniforms, everything shared between draws lives in the uniform blocks below */
 typedef enum beneath_opengl_shader_uniform_locations
 {
-    BENEATH_OPENGL_SHADER_UNIFORM_LOCATION_TIME = 0,
-    BENEATH_OPENGL_SHADER_UNIFORM_LOCATION_DELTA_TIME,
-    BENEATH_OPENGL_SHADER_UNIFORM_LOCATION_RESOLUTION,
-    BENEATH_OPENGL_SHADER_UNIFORM_LOCATION_CAMERA_POSITION,
-    BENEATH_OPENGL_SHADER_UNIFORM_LOCATION_PROJECTION_VIEW,
-
-    BENEATH_OPENGL_SHADER_UNIFORM_LOCATION_INSTANCE_COLOR,
+    BENEATH_OPENGL_SHADER_UNIFORM_LOCATION_INSTANCE_COLOR = 0,
     BENEATH_OPENGL_SHADER_UNIFORM_LOCATION_INSTANCE_TEXTURE_INDEX,
+    BENEATH_OPENGL_SHADER_UNIFORM_LOCATION_SHADOW_MAP,
 
     BENEATH_OPENGL_SHADER_UNIFORM_LOCATION_COUNT
 
 } beneath_opengl_shader_uniform_locations;
 
-static char *beneath_opengl_shader_uniform_names[7] = {
-    "time",
-    "delta_time",
-    "resolution",
-    "camera_position",
-    "pv",
+/* Resolved once per program (beneath_opengl_shader_load), no string lookups while drawing */
+static char *beneath_opengl_shader_uniform_names[BENEATH_OPENGL_SHADER_UNIFORM_LOCATION_COUNT] = {
     "color",
-    "texture_index"};
+    "texture_index",
+    "shadow_map"};
+
+/* Texture units of the generated programs, set once when the program is loaded */
+#define BENEATH_OPENGL_SHADER_TEXTURE_UNIT_SHADOW_MAP 1
+
+/* Uniform blocks (std140) of the generated programs, written once per frame into the
+ * instance stream ring and bound by range. The binding points are fixed per block.
+ */
+typedef enum beneath_opengl_uniform_block
+{
+    BENEATH_OPENGL_UNIFORM_BLOCK_FRAME = 0,
+    BENEATH_OPENGL_UNIFORM_BLOCK_CAMERA,
+    BENEATH_OPENGL_UNIFORM_BLOCK_LIGHTING,
+
+    BENEATH_OPENGL_UNIFORM_BLOCK_COUNT
+
+} beneath_opengl_uniform_block;
+
+static char *beneath_opengl_uniform_block_names[BENEATH_OPENGL_UNIFORM_BLOCK_COUNT] = {
+    "beneath_frame",
+    "beneath_camera",
+    "beneath_lighting"};
+
+/* Distinct beneath_lightning per frame, each gets its own lighting block */
+#define BENEATH_OPENGL_UNIFORM_LIGHTS_MAX 16
+
+/* std140: vec3 occupies 16 bytes, mat4 64 bytes */
+typedef struct beneath_opengl_uniform_frame
+{
+    float time;          /* Elapsed seconds */
+    float delta_time;    /* Seconds since last frame */
+    float resolution[2]; /* Screen width and height */
+
+} beneath_opengl_uniform_frame;
+
+typedef struct beneath_opengl_uniform_camera
+{
+    float pv[16];             /* Projection view matrix */
+    float camera_position[3]; /* World space camera position */
+    float padding;
+
+} beneath_opengl_uniform_camera;
+
+typedef struct beneath_opengl_uniform_lighting
+{
+    float light_space_matrix[16]; /* Shadow map projection view */
+    float direction[3];
+    float padding0;
+    float ambient[3];
+    float padding1;
+    float diffuse[3];
+    float padding2;
+    float specular[3];
+    float padding3;
+
+} beneath_opengl_uniform_lighting;
+
+static char beneath_opengl_shader_uniform_blocks[] = {
+    "/* Uniform blocks (std140, see beneath_opengl_uniform_*) */\n"
+    "layout (std140) uniform beneath_frame\n"
+    "{\n"
+    "    float time;            /* Global Elapsed seconds             */\n"
+    "    float delta_time;      /* Global Seconds since last frame    */\n"
+    "    vec2  resolution;      /* Global Screen width and height     */\n"
+    "};\n"
+    "\n"
+    "layout (std140) uniform beneath_camera\n"
+    "{\n"
+    "    mat4  pv;              /* Global Projection View Matrix      */\n"
+    "    vec3  camera_position; /* Global World space camera position */\n"
+    "};\n"
+    "\n"};
+
+static char beneath_opengl_shader_uniform_block_lighting[] = {
+    "struct DirectionalLight\n"
+    "{\n"
+    "    vec3 direction;\n"
+    "    vec3 ambient;\n"
+    "    vec3 diffuse;\n"
+    "    vec3 specular;\n"
+    "};\n"
+    "\n"
+    "layout (std140) uniform beneath_lighting\n"
+    "{\n"
+    "    mat4 light_space_matrix;\n"
+    "    DirectionalLight dir_light;\n"
+    "};\n"
+    "\n"};
 
 typedef struct beneath_opengl_shader
 {
@@ -298,22 +395,213 @@ typedef struct beneath_opengl_shader
 
 } beneath_opengl_shader;
 
-#define BENEATH_OPENGL_SHADERS_MAX 16
+/* Renderer owned memory (shader cache, instance BVHs), reserved by the platform and committed as it grows */
+#ifndef BENEATH_OPENGL_MEMORY_SIZE
+#define BENEATH_OPENGL_MEMORY_SIZE (256u * 1024u * 1024u) /* 256 MB, a million instance BVH takes about 100 MB */
+#endif
+
+#define BENEATH_OPENGL_SHADERS_CAPACITY_INITIAL 16
+
+/* Program binary cache, one file per program in the working directory.
+ * Generated programs are keyed by their draw call hash, the fixed ones by these keys.
+ */
+#define BENEATH_OPENGL_PROGRAM_BINARY_MAGIC 0x42504E42u /* "BNPB" */
+#define BENEATH_OPENGL_PROGRAM_KEY_POST_PROCESS 1u
+#define BENEATH_OPENGL_PROGRAM_KEY_VOLUMETRIC 2u
+#define BENEATH_OPENGL_PROGRAM_KEY_PIXEL 3u
+#define BENEATH_OPENGL_PROGRAM_KEY_SHADOW 4u
+#define BENEATH_OPENGL_PROGRAM_KEY_HIZ 5u
+
+typedef struct beneath_opengl_program_binary_header
+{
+    unsigned int magic;
+    unsigned int driver_hash; /* GL vendor, renderer and version, a driver update invalidates the file */
+    unsigned int source_hash; /* Vertex and fragment source, a shader generator change invalidates the file */
+    unsigned int format;      /* binaryFormat of glGetProgramBinary */
+    unsigned int size;        /* Bytes of program binary following the header */
+
+} beneath_opengl_program_binary_header;
 #define BENEATH_OPENGL_MESHES_MAX 64
 
+/* Element type of the uploaded index buffer */
+#define BENEATH_OPENGL_INDEX_TYPE(mesh) ((mesh)->indices16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT)
+
+/* Per mesh storage buffer slot of the orphaned instance data (0 - 6 hold the mesh attributes and indices) */
+#define BENEATH_OPENGL_STORAGE_INSTANCE 7
+
+/* Instance data streaming ring, one region per frame in flight */
+#define BENEATH_OPENGL_STREAM_FRAMES 3
+#define BENEATH_OPENGL_STREAM_REGION_SIZE (4 * 1024 * 1024) /* 4 MB = 65536 model matrices per frame */
+#define BENEATH_OPENGL_STREAM_ALIGNMENT 64
+
+/* GL state cache, shadows the bindings the renderer changes per frame and skips no-op calls */
+#define BENEATH_OPENGL_STATE_UNKNOWN 0xFFFFFFFFu
+#define BENEATH_OPENGL_STATE_TEXTURE_UNITS 3 /* Screen color, screen depth/shadow map, shadow map */
+
+typedef struct beneath_opengl_state
+{
+    unsigned int program;
+    unsigned int vertex_array;
+    unsigned int array_buffer;
+    unsigned int framebuffer;
+    unsigned int texture_unit_active;
+    unsigned int textures[BENEATH_OPENGL_STATE_TEXTURE_UNITS]; /* GL_TEXTURE_2D per unit */
+    unsigned int cull_face;
+    int viewport_width;
+    int viewport_height;
+
+    /* Running counters, published per frame by beneath_opengl_frame_end */
+    unsigned int calls_issued;
+    unsigned int calls_elided;
+
+} beneath_opengl_state;
+
+/* Render queue, draw calls are collected during beneath_update and flushed once per frame */
+#define BENEATH_OPENGL_QUEUE_MAX 256
+
+typedef struct beneath_opengl_queue_entry
+{
+    unsigned long long key; /* Sort key: shader hash (32 bits) | mesh id (8 bits) | view depth (24 bits) */
+    beneath_draw_call *draw_call;
+    unsigned int shader_index;
+    unsigned int instance_buffer; /* Buffer holding the instance data (stream ring or orphaned per mesh buffer) */
+    unsigned long instance_base;  /* Byte offset of the instance data inside instance_buffer */
+    unsigned int instances_count; /* Instances inside the camera frustum */
+    unsigned long shadow_base;    /* Byte offset of the shadow casting model matrices inside instance_buffer */
+    unsigned int shadow_instances_count; /* Instances inside the light frustum */
+    unsigned int instances_occluded; /* Instances inside the camera frustum hidden by the Hi-Z pyramid */
+    unsigned int lod_counts[BENEATH_DRAW_CALL_LODS_MAX + 1];        /* Camera instances per LOD chain level, stored in level order */
+    unsigned int shadow_lod_counts[BENEATH_DRAW_CALL_LODS_MAX + 1]; /* Shadow casters per LOD chain level */
+    unsigned long lighting_base;  /* Byte offset of the lighting block inside the stream buffer */
+
+} beneath_opengl_queue_entry;
+
+/* Instances per call of the SIMD sphere test, the structure of arrays batch stays in the L1 cache */
+#define BENEATH_OPENGL_CULL_BATCH 256
+
+/* Draw calls with at least this many instances are culled through a BVH kept across frames */
+#define BENEATH_OPENGL_BVH_INSTANCES_MIN 1024
+#define BENEATH_OPENGL_BVH_DRAW_CALLS_MAX 16
+
+typedef struct beneath_opengl_instances_bvh
+{
+    unsigned int draw_call_id;
+    unsigned int instances_count; /* Instances in the tree */
+    float bounds_center[3];       /* Mesh bounds the leaf boxes were computed from */
+    float bounds_extents[3];
+    unsigned int *leaves; /* Leaf node per instance */
+    beneath_bvh bvh;
+
+} beneath_opengl_instances_bvh;
+
+/* Hi-Z occlusion culling. After the scene pass the depth of fbo_screen is max reduced on the
+ * GPU down to a level of at most BENEATH_OPENGL_HIZ_READBACK_SIZE texels per side (frames without
+ * post processing render into fbo_screen too while it has the window size). That level is
+ * read back without stalling (pixel pack buffers, polled by fence) and reduced further on the CPU.
+ * Instances are tested against the newest pyramid with the projection view it was rendered with,
+ * so it lags one to BENEATH_OPENGL_HIZ_READBACKS frames behind (a fast camera can pop in objects).
+ */
+#define BENEATH_OPENGL_HIZ_LEVELS_MAX 16
+#define BENEATH_OPENGL_HIZ_READBACK_SIZE 64
+#define BENEATH_OPENGL_HIZ_READBACKS 3
+
+typedef struct beneath_opengl_hiz
+{
+    /* GPU levels, level i has 2^(i + 1) fbo_screen pixels per texel side */
+    unsigned int program;
+    int uniform_source;
+    unsigned int textures[BENEATH_OPENGL_HIZ_LEVELS_MAX];
+    unsigned int fbos[BENEATH_OPENGL_HIZ_LEVELS_MAX];
+    int widths[BENEATH_OPENGL_HIZ_LEVELS_MAX];
+    int heights[BENEATH_OPENGL_HIZ_LEVELS_MAX];
+    unsigned int levels_count; /* 0 = occlusion culling disabled */
+
+    /* Readbacks of the last GPU level in flight, a ring ordered by frame */
+    unsigned int readback_buffers[BENEATH_OPENGL_HIZ_READBACKS];
+    void *readback_fences[BENEATH_OPENGL_HIZ_READBACKS];
+    float readback_projection_views[BENEATH_OPENGL_HIZ_READBACKS][16];
+    unsigned int readback_first; /* Oldest readback in flight */
+    unsigned int readback_pending;
+
+    /* CPU levels of the newest completed readback, level 0 is the last GPU level */
+    float depths[BENEATH_OPENGL_HIZ_READBACK_SIZE * BENEATH_OPENGL_HIZ_READBACK_SIZE * 2];
+    unsigned int depths_offsets[BENEATH_OPENGL_HIZ_LEVELS_MAX];
+    int depths_widths[BENEATH_OPENGL_HIZ_LEVELS_MAX];
+    int depths_heights[BENEATH_OPENGL_HIZ_LEVELS_MAX];
+    unsigned int depths_levels_count; /* 0 = no pyramid to test against */
+    float projection_view[16];
+
+} beneath_opengl_hiz;
+
 typedef struct beneath_opengl_context
 {
     beneath_bool initialized;
 
+    /* Renderer lifetime allocations */
+    beneath_arena arena;
+
     /* Pregenerated Buffers and Vertex Arrays */
     unsigned int storage_vertex_array[BENEATH_OPENGL_MESHES_MAX];
     unsigned int storage_buffer_object[BENEATH_OPENGL_MESHES_MAX * BENEATH_OPENGL_SHADER_LAYOUT_COUNT];
 
-    /* Shaders */
-    beneath_opengl_shader shaders[BENEATH_OPENGL_SHADERS_MAX];
+    /* Shaders, dense so indices stay valid when the cache grows (render queue entries keep them) */
+    beneath_opengl_shader *shaders;
     unsigned int shaders_size;
+    unsigned int shaders_capacity;
     unsigned int shaders_active_index;
 
+    /* Shader lookup by draw call hash, open addressing with linear probing.
+     * A slot holds the shader index + 1 (0 = empty), the table is kept at most half full.
+     */
+    unsigned int *shader_slots;
+    unsigned int shader_slots_capacity; /* Power of two */
+
+    /* Program binary cache, files go through the platform io api */
+    beneath_api_io_file_size io_file_size;
+    beneath_api_io_file_read io_file_read;
+    beneath_api_io_file_write io_file_write;
+    unsigned int program_cache_driver_hash; /* 0 = cache disabled */
+    unsigned int program_cache_hits;
+    unsigned int program_cache_misses;
+
+    /* Output FBO (0 = default framebuffer, headless platforms render into their own FBO) */
+    unsigned int fbo_output;
+
+    /* Bindings as last set through the beneath_opengl_state_* functions */
+    beneath_opengl_state state;
+
+    /* Instance data streaming ring (models, colors, texture indices) */
+    unsigned int stream_buffer;
+    unsigned char *stream_mapped; /* Persistent mapping (OpenGL 4.4), 0 = map unsynchronized per upload */
+    unsigned int stream_region;   /* Region written this frame */
+    unsigned int stream_offset;   /* Write offset inside the region */
+    void *stream_fences[BENEATH_OPENGL_STREAM_FRAMES];
+    unsigned int stream_waits; /* Frames that had to wait for the GPU to release a region */
+    unsigned int uniform_alignment; /* GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT for uniform blocks inside the stream */
+
+    /* Render queue (one camera per frame, the last submitted one wins) */
+    beneath_opengl_queue_entry queue[BENEATH_OPENGL_QUEUE_MAX];
+    unsigned int queue_size;
+    beneath_state *queue_state;
+    float queue_projection_view[16];
+    float queue_projection_inverse[16];
+    float queue_view_inverse[16];
+    float queue_camera_position[3];
+
+    /* Instance BVHs of large draw calls, found by draw call id */
+    beneath_opengl_instances_bvh instances_bvhs[BENEATH_OPENGL_BVH_DRAW_CALLS_MAX];
+    unsigned int instances_bvhs_count;
+
+    /* Statistics of the last flushed frame */
+    unsigned int queue_draws;
+    unsigned int instances_submitted;
+    unsigned int instances_drawn;
+    unsigned int instances_shadow_drawn;
+    unsigned int instances_occluded;
+    unsigned int triangles_drawn;
+    unsigned int state_calls_issued;
+    unsigned int state_calls_elided;
+
     /* Screen FBO */
     unsigned int fbo_screen;
     unsigned int fbo_screen_color_texture;
@@ -324,6 +612,9 @@ typedef struct beneath_opengl_context
     int fbo_screen_width;
     int fbo_screen_height;
 
+    /* Hi-Z pyramid of the fbo_screen depth */
+    beneath_opengl_hiz hiz;
+
     /* Shadow Shader */
     unsigned int shadow_program;
     int shadow_uniform_pv;
@@ -355,6 +646,132 @@ typedef struct beneath_opengl_context
 
 } beneath_opengl_context;
 
+/******************************/
+/* State Cache Functions      */
+/******************************/
+
+/* Forgets all cached bindings, the next call of each kind reaches the driver.
+ * Needed after GL calls that bypass the cache (initialization, platform code).
+ */
+BENEATH_API void beneath_opengl_state_invalidate(beneath_opengl_state *state)
+{
+    int i;
+
+    state->program = BENEATH_OPENGL_STATE_UNKNOWN;
+    state->vertex_array = BENEATH_OPENGL_STATE_UNKNOWN;
+    state->array_buffer = BENEATH_OPENGL_STATE_UNKNOWN;
+    state->framebuffer = BENEATH_OPENGL_STATE_UNKNOWN;
+    state->texture_unit_active = BENEATH_OPENGL_STATE_UNKNOWN;
+    state->cull_face = BENEATH_OPENGL_STATE_UNKNOWN;
+    state->viewport_width = -1;
+    state->viewport_height = -1;
+
+    for (i = 0; i < BENEATH_OPENGL_STATE_TEXTURE_UNITS; ++i)
+    {
+        state->textures[i] = BENEATH_OPENGL_STATE_UNKNOWN;
+    }
+}
+
+BENEATH_API void beneath_opengl_state_use_program(beneath_opengl_state *state, unsigned int program)
+{
+    if (state->program == program)
+    {
+        state->calls_elided++;
+        return;
+    }
+
+    state->program = program;
+    state->calls_issued++;
+    glUseProgram(program);
+}
+
+BENEATH_API void beneath_opengl_state_bind_vertex_array(beneath_opengl_state *state, unsigned int vertex_array)
+{
+    if (state->vertex_array == vertex_array)
+    {
+        state->calls_elided++;
+        return;
+    }
+
+    state->vertex_array = vertex_array;
+    state->calls_issued++;
+    glBindVertexArray(vertex_array);
+}
+
+BENEATH_API void beneath_opengl_state_bind_array_buffer(beneath_opengl_state *state, unsigned int buffer)
+{
+    if (state->array_buffer == buffer)
+    {
+        state->calls_elided++;
+        return;
+    }
+
+    state->array_buffer = buffer;
+    state->calls_issued++;
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+}
+
+BENEATH_API void beneath_opengl_state_bind_framebuffer(beneath_opengl_state *state, unsigned int framebuffer)
+{
+    if (state->framebuffer == framebuffer)
+    {
+        state->calls_elided++;
+        return;
+    }
+
+    state->framebuffer = framebuffer;
+    state->calls_issued++;
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+/* Binds a GL_TEXTURE_2D to unit, glActiveTexture is only issued if the texture changes */
+BENEATH_API void beneath_opengl_state_bind_texture(beneath_opengl_state *state, unsigned int unit, unsigned int texture)
+{
+    if (state->textures[unit] == texture)
+    {
+        state->calls_elided++;
+        return;
+    }
+
+    if (state->texture_unit_active != unit)
+    {
+        state->texture_unit_active = unit;
+        state->calls_issued++;
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    state->textures[unit] = texture;
+    state->calls_issued++;
+    glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+BENEATH_API void beneath_opengl_state_cull_face(beneath_opengl_state *state, unsigned int mode)
+{
+    if (state->cull_face == mode)
+    {
+        state->calls_elided++;
+        return;
+    }
+
+    state->cull_face = mode;
+    state->calls_issued++;
+    glCullFace(mode);
+}
+
+BENEATH_API void beneath_opengl_state_viewport(beneath_opengl_state *state, int width, int height)
+{
+    if (state->viewport_width == width && state->viewport_height == height)
+    {
+        state->calls_elided++;
+        return;
+    }
+
+    state->viewport_width = width;
+    state->viewport_height = height;
+    state->calls_issued++;
+    glViewport(0, 0, width, height);
+}
+
 /******************************/
 /* Shader Functions           */
 /******************************/
@@ -405,6 +822,13 @@ BENEATH_API beneath_bool beneath_opengl_shader_create(unsigned int *shader_progr
     *shader_program = glCreateProgram();
     glAttachShader(*shader_program, (unsigned int)vertex_shader_id);
     glAttachShader(*shader_program, (unsigned int)fragment_shader_id);
+
+    /* Keep the binary retrievable for the program binary cache */
+    if (glProgramParameteri)
+    {
+        glProgramParameteri(*shader_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
     glLinkProgram(*shader_program);
     glGetProgramiv(*shader_program, GL_LINK_STATUS, &success);
     glDeleteShader((unsigned int)vertex_shader_id);
@@ -424,6 +848,113 @@ BENEATH_API beneath_bool beneath_opengl_shader_create(unsigned int *shader_progr
     return true;
 }
 
+BENEATH_API unsigned int beneath_opengl_hash_cstr(unsigned int hash, char *string)
+{
+    /* FNV-1a, continues the given hash (start with 2166136261u) */
+    while (string && *string)
+    {
+        hash ^= (unsigned char)*string++;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/* Same as beneath_opengl_shader_create, but loads the linked program from the
+ * program binary cache if a previous run stored it and stores it otherwise.
+ */
+BENEATH_API beneath_bool beneath_opengl_shader_create_cached(
+    beneath_opengl_context *ctx,
+    unsigned int *shader_program,
+    unsigned int key,
+    char *shader_vertex_code,
+    char *shader_fragment_code,
+    beneath_api_io_print print)
+{
+    static char hex[] = "0123456789abcdef";
+    char filename[] = "beneath_program_00000000.bin";
+    unsigned int source_hash = beneath_opengl_hash_cstr(beneath_opengl_hash_cstr(2166136261u, shader_vertex_code), shader_fragment_code);
+    unsigned int header_size = (unsigned int)sizeof(beneath_opengl_program_binary_header);
+    beneath_opengl_program_binary_header *header;
+    beneath_arena_temp temp;
+    unsigned int file_size = 0;
+    int length = 0;
+    int i;
+
+    if (!ctx->program_cache_driver_hash)
+    {
+        return beneath_opengl_shader_create(shader_program, shader_vertex_code, shader_fragment_code, print);
+    }
+
+    for (i = 0; i < 8; ++i)
+    {
+        filename[16 + i] = hex[(key >> (28 - i * 4)) & 0xF];
+    }
+
+    temp = beneath_arena_temp_begin(&ctx->arena);
+
+    /* (1) Binary of a previous run, the file read needs one extra byte */
+    if (ctx->io_file_size(filename, &file_size) &&
+        file_size > header_size &&
+        (header = (beneath_opengl_program_binary_header *)beneath_arena_push(&ctx->arena, file_size + 1, BENEATH_ARENA_ALIGNMENT_DEFAULT)) != 0 &&
+        ctx->io_file_read(filename, (unsigned char *)header, file_size + 1, &file_size) &&
+        file_size > header_size &&
+        header->magic == BENEATH_OPENGL_PROGRAM_BINARY_MAGIC &&
+        header->driver_hash == ctx->program_cache_driver_hash &&
+        header->source_hash == source_hash &&
+        header->size == file_size - header_size)
+    {
+        int success = 0;
+
+        *shader_program = glCreateProgram();
+        glProgramBinary(*shader_program, header->format, header + 1, (int)header->size);
+        glGetProgramiv(*shader_program, GL_LINK_STATUS, &success);
+
+        if (success)
+        {
+            ctx->program_cache_hits++;
+            beneath_arena_temp_end(temp);
+            return true;
+        }
+
+        /* The driver can still reject its own binaries, compile from source instead */
+        glDeleteProgram(*shader_program);
+    }
+
+    beneath_arena_temp_end(temp);
+
+    ctx->program_cache_misses++;
+
+    if (!beneath_opengl_shader_create(shader_program, shader_vertex_code, shader_fragment_code, print))
+    {
+        return false;
+    }
+
+    /* (2) Store the binary for the next run, a failure only costs the next startup */
+    glGetProgramiv(*shader_program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+    if (length > 0 &&
+        (header = (beneath_opengl_program_binary_header *)beneath_arena_push(&ctx->arena, header_size + (unsigned int)length, BENEATH_ARENA_ALIGNMENT_DEFAULT)) != 0)
+    {
+        header->magic = BENEATH_OPENGL_PROGRAM_BINARY_MAGIC;
+        header->driver_hash = ctx->program_cache_driver_hash;
+        header->source_hash = source_hash;
+        header->format = 0;
+
+        glGetProgramBinary(*shader_program, length, &length, &header->format, header + 1);
+        header->size = (unsigned int)length;
+
+        if (!ctx->io_file_write(filename, (unsigned char *)header, header_size + header->size))
+        {
+            print(__FILE__, __LINE__, "[opengl] cannot write program binary cache file!\n");
+        }
+    }
+
+    beneath_arena_temp_end(temp);
+
+    return true;
+}
+
 BENEATH_API beneath_bool beneath_opengl_shader_generate(
     beneath_draw_call *draw_call,
     char *vertex_shader_code_buffer,
@@ -431,9 +962,9 @@ BENEATH_API beneath_bool beneath_opengl_shader_generate(
     char *fragment_shader_code_buffer,
     int fragment_shader_code_buffer_size)
 {
-    beneath_bool use_mesh_color = draw_call->mesh->colors_count > 0 && draw_call->colors_count == 0 && draw_call->texture_indices_count == 0;
+    beneath_bool use_mesh_color = beneath_mesh_has_attribute(draw_call->mesh, BENEATH_VERTEX_ATTRIBUTE_COLOR) && draw_call->colors_count == 0 && draw_call->texture_indices_count == 0;
     unsigned int hash = beneath_draw_call_hash(draw_call);
-    int layout_location_current;
+    long layout_location_current; /* sb_printf "%d" reads a long, an int breaks on LP64 (linux) */
 
     sb vc; /* Vertex Shader Code  */
     sb fc; /* Fragment Shader Code */
@@ -459,12 +990,14 @@ BENEATH_API beneath_bool beneath_opengl_shader_generate(
     sb_append_cstr(&fc, "\n");
 
     /* Uniforms */
+    sb_append_cstr(&fc, beneath_opengl_shader_uniform_blocks);
+
+    if (draw_call->lightning || draw_call->shadow)
+    {
+        sb_append_cstr(&fc, beneath_opengl_shader_uniform_block_lighting);
+    }
+
     sb_append_cstr(&fc, "/* Uniforms */\n");
-    sb_append_cstr(&fc, "uniform float time;            /* Global Elapsed seconds             */\n");
-    sb_append_cstr(&fc, "uniform float delta_time;      /* Global Seconds since last frame    */\n");
-    sb_append_cstr(&fc, "uniform vec2  resolution;      /* Global Screen width and height     */\n");
-    sb_append_cstr(&fc, "uniform vec3  camera_position; /* Global World space camera position */\n");
-    sb_append_cstr(&fc, "uniform mat4  pv;              /* Global Projection View Matrix      */\n");
 
     if (draw_call->shadow)
     {
@@ -530,17 +1063,6 @@ BENEATH_API beneath_bool beneath_opengl_shader_generate(
 
     if (draw_call->lightning)
     {
-        sb_append_cstr(&fc, "/* Lighting structures */ \n");
-        sb_append_cstr(&fc, "struct DirectionalLight { \n");
-        sb_append_cstr(&fc, "    vec3 direction;       \n");
-        sb_append_cstr(&fc, "    vec3 ambient;         \n");
-        sb_append_cstr(&fc, "    vec3 diffuse;         \n");
-        sb_append_cstr(&fc, "    vec3 specular;        \n");
-        sb_append_cstr(&fc, "};                        \n");
-        sb_append_cstr(&fc, "\n");
-        sb_append_cstr(&fc, "uniform DirectionalLight dir_light;\n");
-        sb_append_cstr(&fc, "\n");
-
         sb_append_cstr(&fc, "/* Function to calculate Blinn-Phong lighting from a directional light */     \n");
         sb_append_cstr(&fc, "vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 view_dir, float shadow) \n");
         sb_append_cstr(&fc, "{                                                                             \n");
@@ -594,24 +1116,24 @@ BENEATH_API beneath_bool beneath_opengl_shader_generate(
     layout_location_current = BENEATH_OPENGL_SHADER_LAYOUT_POSITION;
     sb_printf2(&vc, "layout (location = %d) in vec3 %s;       /* Mesh data      */\n", (char *)&layout_location_current, (char *)beneath_opengl_shader_layout_names[layout_location_current]);
 
-    if (draw_call->mesh->uvs_count > 0)
+    if (beneath_mesh_has_attribute(draw_call->mesh, BENEATH_VERTEX_ATTRIBUTE_UV))
     {
         layout_location_current = BENEATH_OPENGL_SHADER_LAYOUT_UV;
         sb_printf2(&vc, "layout (location = %d) in vec2 %s;             /* Mesh data      */\n", (char *)&layout_location_current, (char *)beneath_opengl_shader_layout_names[layout_location_current]);
     }
 
-    if (draw_call->mesh->normals_count > 0)
+    if (beneath_mesh_has_attribute(draw_call->mesh, BENEATH_VERTEX_ATTRIBUTE_NORMAL))
     {
         layout_location_current = BENEATH_OPENGL_SHADER_LAYOUT_NORMAL;
         sb_printf2(&vc, "layout (location = %d) in vec3 %s;         /* Mesh data      */\n", (char *)&layout_location_current, (char *)beneath_opengl_shader_layout_names[layout_location_current]);
     }
 
-    if (draw_call->mesh->tangents_count > 0)
+    if (beneath_mesh_has_attribute(draw_call->mesh, BENEATH_VERTEX_ATTRIBUTE_TANGENT))
     {
         layout_location_current = BENEATH_OPENGL_SHADER_LAYOUT_TANGENT;
         sb_printf2(&vc, "layout (location = %d) in vec3 %s;        /* Mesh data      */\n", (char *)&layout_location_current, (char *)beneath_opengl_shader_layout_names[layout_location_current]);
     }
-    if (draw_call->mesh->bitangents_count > 0)
+    if (beneath_mesh_has_attribute(draw_call->mesh, BENEATH_VERTEX_ATTRIBUTE_BITANGENT))
     {
         layout_location_current = BENEATH_OPENGL_SHADER_LAYOUT_BITANGENT;
         sb_printf2(&vc, "layout (location = %d) in vec3 %s;      /* Mesh data      */\n", (char *)&layout_location_current, (char *)beneath_opengl_shader_layout_names[layout_location_current]);
@@ -638,13 +1160,15 @@ BENEATH_API beneath_bool beneath_opengl_shader_generate(
     }
     sb_append_cstr(&vc, "\n");
 
-    /* Uniforms */
+    /* Uniforms, the blocks are declared identically in both stages */
+    sb_append_cstr(&vc, beneath_opengl_shader_uniform_blocks);
+
+    if (draw_call->lightning || draw_call->shadow)
+    {
+        sb_append_cstr(&vc, beneath_opengl_shader_uniform_block_lighting);
+    }
+
     sb_append_cstr(&vc, "/* Uniforms */\n");
-    sb_append_cstr(&vc, "uniform float time;            /* Global Elapsed seconds             */\n");
-    sb_append_cstr(&vc, "uniform float delta_time;      /* Global Seconds since last frame    */\n");
-    sb_append_cstr(&vc, "uniform vec2  resolution;      /* Global Screen width and height     */\n");
-    sb_append_cstr(&vc, "uniform vec3  camera_position; /* Global World space camera position */\n");
-    sb_append_cstr(&vc, "uniform mat4  pv;              /* Global Projection View Matrix      */\n");
 
     /* If there is only one color or texture index it is better to pass it as a uniform and not as a instanced layout */
     if (!use_mesh_color && draw_call->colors_count == 1)
@@ -659,11 +1183,6 @@ BENEATH_API beneath_bool beneath_opengl_shader_generate(
         sb_printf1(&vc, "uniform int   %s;   /* Instance Texture Index */\n", (char *)beneath_opengl_shader_layout_names[layout_location_current]);
     }
 
-    if (draw_call->shadow)
-    {
-        sb_append_cstr(&vc, "uniform mat4 light_space_matrix; \n");
-    }
-
     sb_append_cstr(&vc, "\n");
 
     /* Outputs */
@@ -711,6 +1230,43 @@ BENEATH_API beneath_bool beneath_opengl_shader_generate(
     return true;
 }
 
+/* Doubles the shader array and the lookup table from the renderer arena. The old
+ * arrays stay behind in the arena, with doubling that is at most the size of the live ones.
+ */
+BENEATH_API beneath_bool beneath_opengl_shader_cache_grow(beneath_opengl_context *ctx)
+{
+    unsigned int shaders_capacity = ctx->shaders_capacity ? ctx->shaders_capacity * 2 : BENEATH_OPENGL_SHADERS_CAPACITY_INITIAL;
+    unsigned int slots_capacity = shaders_capacity * 2;
+    beneath_opengl_shader *shaders = BENEATH_ARENA_PUSH_ARRAY(&ctx->arena, beneath_opengl_shader, shaders_capacity);
+    unsigned int *slots = (unsigned int *)beneath_arena_push_zero(&ctx->arena, slots_capacity * (unsigned int)sizeof(unsigned int), BENEATH_ARENA_ALIGNMENT_DEFAULT);
+    unsigned int i;
+
+    if (!shaders || !slots)
+    {
+        return false;
+    }
+
+    for (i = 0; i < ctx->shaders_size; ++i)
+    {
+        unsigned int slot = ctx->shaders[i].hash & (slots_capacity - 1);
+
+        while (slots[slot])
+        {
+            slot = (slot + 1) & (slots_capacity - 1);
+        }
+
+        shaders[i] = ctx->shaders[i];
+        slots[slot] = i + 1;
+    }
+
+    ctx->shaders = shaders;
+    ctx->shaders_capacity = shaders_capacity;
+    ctx->shader_slots = slots;
+    ctx->shader_slots_capacity = slots_capacity;
+
+    return true;
+}
+
 BENEATH_API beneath_bool beneath_opengl_shader_load(
     beneath_opengl_context *ctx,
     beneath_draw_call *draw_call,
@@ -722,19 +1278,34 @@ BENEATH_API beneath_bool beneath_opengl_shader_load(
     char code_vertex[8192];
     char code_fragment[8192];
 
-    /* Check if shader already exists */
-    /* TODO: load from hashmap in the future */
+    unsigned int slot;
     unsigned int i;
 
-    for (i = 0; i < ctx->shaders_size; ++i)
+    if (ctx->shader_slots_capacity > 0)
     {
-        if (ctx->shaders[i].hash == draw_call_hash)
+        slot = draw_call_hash & (ctx->shader_slots_capacity - 1);
+
+        while (ctx->shader_slots[slot])
         {
-            ctx->shaders_active_index = i;
-            return true;
+            if (ctx->shaders[ctx->shader_slots[slot] - 1].hash == draw_call_hash)
+            {
+                ctx->shaders_active_index = ctx->shader_slots[slot] - 1;
+                return true;
+            }
+
+            slot = (slot + 1) & (ctx->shader_slots_capacity - 1);
         }
     }
 
+    /* Nothing is evicted (programs stay referenced by queued draws), when the renderer arena
+     * is exhausted the new permutation fails to load and its draw calls are skipped.
+     */
+    if (ctx->shaders_size == ctx->shaders_capacity && !beneath_opengl_shader_cache_grow(ctx))
+    {
+        print(__FILE__, __LINE__, "[opengl] shader cache is out of memory!\n");
+        return false;
+    }
+
     /* shader.program_id = -1; */
     shader.hash = draw_call_hash;
 
@@ -747,7 +1318,7 @@ BENEATH_API beneath_bool beneath_opengl_shader_load(
         return false;
     }
 
-    if (!beneath_opengl_shader_create(&shader.program_id, code_vertex, code_fragment, print))
+    if (!beneath_opengl_shader_create_cached(ctx, &shader.program_id, draw_call_hash, code_vertex, code_fragment, print))
     {
         return false;
     }
@@ -759,9 +1330,31 @@ BENEATH_API beneath_bool beneath_opengl_shader_load(
         shader.uniform_locations[i] = glGetUniformLocation(shader.program_id, beneath_opengl_shader_uniform_names[i]);
     }
 
+    /* Uniform block bindings and sampler units are program state (also reset by glProgramBinary), set them once here */
+    for (i = 0; i < BENEATH_OPENGL_UNIFORM_BLOCK_COUNT; ++i)
+    {
+        unsigned int block_index = glGetUniformBlockIndex(shader.program_id, beneath_opengl_uniform_block_names[i]);
+
+        if (block_index != GL_INVALID_INDEX)
+        {
+            glUniformBlockBinding(shader.program_id, block_index, i);
+        }
+    }
+
+    beneath_opengl_state_use_program(&ctx->state, shader.program_id);
+    glUniform1i(shader.uniform_locations[BENEATH_OPENGL_SHADER_UNIFORM_LOCATION_SHADOW_MAP], BENEATH_OPENGL_SHADER_TEXTURE_UNIT_SHADOW_MAP);
+
+    slot = draw_call_hash & (ctx->shader_slots_capacity - 1);
+
+    while (ctx->shader_slots[slot])
+    {
+        slot = (slot + 1) & (ctx->shader_slots_capacity - 1);
+    }
+
     ctx->shaders[ctx->shaders_size] = shader;
     ctx->shaders_active_index = ctx->shaders_size;
     ctx->shaders_size++;
+    ctx->shader_slots[slot] = ctx->shaders_size;
 
     return true;
 }
@@ -801,7 +1394,7 @@ BENEATH_API beneath_bool beneath_opengl_framebuffer_screen_initialize(beneath_op
         print(__FILE__, __LINE__, "FBO incomplete!\n");
         return false;
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, ctx->fbo_output);
 
     return true;
 }
@@ -831,6 +1424,9 @@ BENEATH_API void beneath_opengl_draw_call_print(beneath_draw_call *draw_call, be
     sb_append_cstr(&tmp, "| mesh->indices_count             : ");
     sb_append_ulong_direct(&tmp, mesh->indices_count);
     sb_append_cstr(&tmp, "\n");
+    sb_append_cstr(&tmp, "| mesh->indices bits              : ");
+    sb_append_ulong_direct(&tmp, mesh->indices16 ? 16 : 32);
+    sb_append_cstr(&tmp, "\n");
     sb_append_cstr(&tmp, "| mesh->uvs_count                 : ");
     sb_append_ulong_direct(&tmp, mesh->uvs_count);
     sb_append_cstr(&tmp, "\n");
@@ -846,6 +1442,9 @@ BENEATH_API void beneath_opengl_draw_call_print(beneath_draw_call *draw_call, be
     sb_append_cstr(&tmp, "| mesh->colors_count              : ");
     sb_append_ulong_direct(&tmp, mesh->colors_count);
     sb_append_cstr(&tmp, "\n");
+    sb_append_cstr(&tmp, "| mesh->layout.stride             : ");
+    sb_append_ulong_direct(&tmp, mesh->interleaved ? mesh->layout.stride : 0);
+    sb_append_cstr(&tmp, "\n");
     sb_append_cstr(&tmp, "| draw_call->models_count         : ");
     sb_append_ulong_direct(&tmp, draw_call->models_count);
     sb_append_cstr(&tmp, "\n");
@@ -860,7 +1459,7 @@ BENEATH_API void beneath_opengl_draw_call_print(beneath_draw_call *draw_call, be
     {
         sb_append_cstr(&tmp, "| shader->uniform->");
         sb_printf1(&tmp, "%15s: ", beneath_opengl_shader_uniform_names[i]);
-        sb_append_ulong_direct(&tmp, (unsigned long)shader_active.uniform_locations[i]);
+        sb_append_long(&tmp, (long)shader_active.uniform_locations[i], 0, SB_PAD_NONE); /* -1 = not used by the shader */
         sb_append_cstr(&tmp, "\n");
     }
     sb_append_cstr(&tmp, "+-----------------------------------------------\n\n");
@@ -869,394 +1468,2084 @@ BENEATH_API void beneath_opengl_draw_call_print(beneath_draw_call *draw_call, be
     print(__FILE__, __LINE__, buffer);
 }
 
+/* Hands the renderer its memory, BENEATH_OPENGL_MEMORY_SIZE bytes reserved by the platform.
+ * commit == 0 for fully committed memory.
+ */
+BENEATH_API void beneath_opengl_memory_initialize(void *memory, unsigned int memory_size, beneath_arena_commit commit)
+{
+    beneath_arena_initialize(&ctx.arena, memory, memory_size, commit);
+}
+
+/* Hands the renderer the platform file io for the program binary cache (optional) */
+BENEATH_API void beneath_opengl_io_initialize(beneath_api_io_file_size file_size, beneath_api_io_file_read file_read, beneath_api_io_file_write file_write)
+{
+    ctx.io_file_size = file_size;
+    ctx.io_file_read = file_read;
+    ctx.io_file_write = file_write;
+}
+
+/* Redirect the final image into a user provided framebuffer (headless/offscreen rendering) */
+BENEATH_API void beneath_opengl_framebuffer_output_set(unsigned int fbo)
+{
+    ctx.fbo_output = fbo;
+}
+
 static m4x4 shadow_projection;
 static m4x4 shadow_view;
 static m4x4 shadow_pv;
+static frustum shadow_frustum; /* Planes of shadow_pv for culling the shadow casters */
 static v3 shadow_light_position;
 
-BENEATH_API beneath_bool beneath_opengl_draw(
-    beneath_state *state,         /* The state */
-    beneath_draw_call *draw_call, /* The draw call instanced objects */
-    float projection_view[16],    /* The projection view matrix */
-    float projection_inverse[16], /* The projection matrix inversed */
-    float view_inverse[16],       /* The view matrix inversed */
-    float camera_position[3],     /* The camera x,y,z position */
-    beneath_api_io_print print)
+/******************************/
+/* Instance Data Streaming    */
+/******************************/
+BENEATH_API void beneath_opengl_stream_initialize(beneath_opengl_context *ctx, beneath_api_io_print print)
 {
+    beneath_gl_intptr size = (beneath_gl_intptr)BENEATH_OPENGL_STREAM_FRAMES * BENEATH_OPENGL_STREAM_REGION_SIZE;
+    char *version = (char *)glGetString(GL_VERSION);
 
-    if (!draw_call || draw_call->models_count == 0 || !draw_call->mesh)
+    glGenBuffers(1, &ctx->stream_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, ctx->stream_buffer);
+
+    /* Persistent + coherent mapping needs 4.4 (GL_VERSION starts with "major.minor") */
+    if (glBufferStorage && version && (version[0] > '4' || (version[0] == '4' && version[2] >= '4')))
     {
-        return false;
+        unsigned int flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glBufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+        ctx->stream_mapped = (unsigned char *)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+    }
+
+    if (!ctx->stream_mapped)
+    {
+        glBufferData(GL_ARRAY_BUFFER, (int)size, NULL, GL_STREAM_DRAW);
     }
 
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    print(__FILE__, __LINE__, ctx->stream_mapped ? "[opengl] instance stream: persistent mapped ring\n" : "[opengl] instance stream: unsynchronized mapped ring\n");
+}
+
+/* Called once per frame by the platform before the application issues draw calls.
+ * Fences the region written last frame and moves on to the oldest region, waiting
+ * only if the GPU still reads from it (more than BENEATH_OPENGL_STREAM_FRAMES - 1 frames behind).
+ */
+BENEATH_API void beneath_opengl_frame_begin(void)
+{
+    void *fence;
+
     if (!ctx.initialized)
     {
-        if (!beneath_opengl_shader_load(&ctx, draw_call, print))
-        {
+        return;
+    }
 
-            print(__FILE__, __LINE__, "cannot load shaders!!!\n");
-            return false;
-        }
+    if (ctx.stream_offset > 0)
+    {
+        ctx.stream_fences[ctx.stream_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
 
-        glGenVertexArrays(BENEATH_OPENGL_MESHES_MAX, ctx.storage_vertex_array);
-        glGenBuffers(BENEATH_OPENGL_MESHES_MAX * BENEATH_OPENGL_SHADER_LAYOUT_COUNT, ctx.storage_buffer_object);
+    ctx.stream_region = (ctx.stream_region + 1) % BENEATH_OPENGL_STREAM_FRAMES;
+    ctx.stream_offset = 0;
 
-        ctx.initialized = true;
+    fence = ctx.stream_fences[ctx.stream_region];
 
-        /* Setup Screen Framebuffer and VAO,VBO */
+    if (fence)
+    {
+        unsigned int result = glClientWaitSync(fence, 0, 0);
+
+        if (result == GL_TIMEOUT_EXPIRED)
         {
-            float quad_vertices[] = {
-                /* pos, uv */
-                -1.0f, -1.0f, 0.0f, 0.0f,
-                1.0f, -1.0f, 1.0f, 0.0f,
-                -1.0f, 1.0f, 0.0f, 1.0f,
-                1.0f, 1.0f, 1.0f, 1.0f};
+            ctx.stream_waits++;
 
-            if (!beneath_opengl_framebuffer_screen_initialize(
-                    &ctx, print,
-                    (int)(draw_call->pixelize ? 300 : state->window_width),
-                    (int)(draw_call->pixelize ? 200 : state->window_height)))
+            do
+            {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+            } while (result == GL_TIMEOUT_EXPIRED);
+        }
+
+        glDeleteSync(fence);
+        ctx.stream_fences[ctx.stream_region] = 0;
+    }
+}
+
+BENEATH_API BENEATH_INLINE void beneath_opengl_stream_copy(unsigned char *dst, void *src, unsigned int size)
+{
+    unsigned char *s = (unsigned char *)src;
+    unsigned int i;
+
+    /* Byte wise since the sources are float/int arrays and uniform structs, char may alias them all */
+    for (i = 0; i < size; ++i)
+    {
+        dst[i] = s[i];
+    }
+}
+
+/* Reserves size bytes (aligned to alignment, a power of two) in this frames region of the
+ * stream ring and returns where to write them, 0 if the region is full. base receives the
+ * offset inside ctx->stream_buffer. A write is finished with beneath_opengl_stream_unmap.
+ */
+BENEATH_API unsigned char *beneath_opengl_stream_map(beneath_opengl_context *ctx, unsigned int size, unsigned int alignment, unsigned long *base)
+{
+    unsigned int offset = (ctx->stream_offset + (alignment - 1)) & ~(alignment - 1);
+
+    if (offset > BENEATH_OPENGL_STREAM_REGION_SIZE || size > BENEATH_OPENGL_STREAM_REGION_SIZE - offset)
+    {
+        return 0;
+    }
+
+    *base = (unsigned long)ctx->stream_region * BENEATH_OPENGL_STREAM_REGION_SIZE + offset;
+    ctx->stream_offset = offset + size;
+
+    /* The region is not in use by the GPU (fenced in beneath_opengl_frame_begin), no driver synchronization needed */
+    if (ctx->stream_mapped)
+    {
+        return ctx->stream_mapped + *base;
+    }
+
+    beneath_opengl_state_bind_array_buffer(&ctx->state, ctx->stream_buffer);
+
+    return (unsigned char *)glMapBufferRange(GL_ARRAY_BUFFER, (beneath_gl_intptr)*base, (beneath_gl_intptr)size, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+}
+
+BENEATH_API void beneath_opengl_stream_unmap(beneath_opengl_context *ctx)
+{
+    if (!ctx->stream_mapped)
+    {
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+}
+
+/* Writes the indices of the instances whose world space bounding sphere intersects the frustum
+ * and returns their count. The instances tested are the first count ones, or the count listed in
+ * indices (e.g. BVH candidates). BENEATH_OPENGL_CULL_BATCH instances at a time are gathered into
+ * structure of arrays form (center transformed, radius of the mesh box times the largest axis
+ * scale of the model matrix) and tested by vm_frustum_cull_spheres, 8 lanes with AVX and 4 with SSE.
+ */
+BENEATH_API unsigned int beneath_opengl_instances_cull(frustum *planes, beneath_mesh *mesh, float *models, unsigned int *indices, unsigned int count, unsigned int *visible)
+{
+    float cx[BENEATH_OPENGL_CULL_BATCH];
+    float cy[BENEATH_OPENGL_CULL_BATCH];
+    float cz[BENEATH_OPENGL_CULL_BATCH];
+    float radius[BENEATH_OPENGL_CULL_BATCH];
+    unsigned char inside[BENEATH_OPENGL_CULL_BATCH];
+    float *c = mesh->bounds_center;
+    float *e = mesh->bounds_extents;
+    float mesh_radius = e[0] * e[0] + e[1] * e[1] + e[2] * e[2];
+    unsigned int visible_count = 0;
+    unsigned int base;
+
+    /* Both vm_sqrtf results below can be up to 0.2% short (one Newton step), the margin keeps the spheres conservative */
+    mesh_radius = mesh_radius > 0.0f ? vm_sqrtf(mesh_radius) * 1.004f : 0.0f;
+
+    for (base = 0; base < count; base += BENEATH_OPENGL_CULL_BATCH)
+    {
+        unsigned int batch = count - base < BENEATH_OPENGL_CULL_BATCH ? count - base : BENEATH_OPENGL_CULL_BATCH;
+        unsigned int i;
+
+        for (i = 0; i < batch; ++i)
+        {
+            float *m = models + (unsigned long)(indices ? indices[base + i] : base + i) * 16;
+            float scale_x = m[0] * m[0] + m[1] * m[1] + m[2] * m[2];
+            float scale_y = m[4] * m[4] + m[5] * m[5] + m[6] * m[6];
+            float scale_z = m[8] * m[8] + m[9] * m[9] + m[10] * m[10];
+            float scale = vm_maxf(scale_x, vm_maxf(scale_y, scale_z));
+
+            cx[i] = m[0] * c[0] + m[4] * c[1] + m[8] * c[2] + m[12];
+            cy[i] = m[1] * c[0] + m[5] * c[1] + m[9] * c[2] + m[13];
+            cz[i] = m[2] * c[0] + m[6] * c[1] + m[10] * c[2] + m[14];
+            radius[i] = scale > 0.0f ? mesh_radius * vm_sqrtf(scale) : 0.0f;
+        }
+
+        vm_frustum_cull_spheres(planes, cx, cy, cz, radius, (int)batch, inside);
+
+        for (i = 0; i < batch; ++i)
+        {
+            visible[visible_count] = indices ? indices[base + i] : base + i;
+            visible_count += inside[i];
+        }
+    }
+
+    return visible_count;
+}
+
+/* World space bounding box of an instance: the mesh box center transformed, its extents
+ * through the absolute rotation/scale part of the model matrix.
+ */
+BENEATH_API void beneath_opengl_instance_bounds(beneath_mesh *mesh, float *m, float min[3], float max[3])
+{
+    float *c = mesh->bounds_center;
+    float *e = mesh->bounds_extents;
+    float center[3];
+    float extents[3];
+    int i;
+
+    for (i = 0; i < 3; ++i)
+    {
+        center[i] = m[i] * c[0] + m[4 + i] * c[1] + m[8 + i] * c[2] + m[12 + i];
+        extents[i] = vm_absf(m[i]) * e[0] + vm_absf(m[4 + i]) * e[1] + vm_absf(m[8 + i]) * e[2];
+        min[i] = center[i] - extents[i];
+        max[i] = center[i] + extents[i];
+    }
+}
+
+/* The BVH of a large draw call, kept in sync with its instances every frame. Moved instances
+ * refit the existing leaves, instances appended or dropped at the end are inserted or
+ * removed and other mesh bounds rebuild the tree. The trees live in the renderer arena,
+ * a grown one leaves the old nodes behind (doubling, like the shader cache).
+ * Returns 0 for small draw calls or when the arena is exhausted, those use the batch cull.
+ */
+BENEATH_API beneath_opengl_instances_bvh *beneath_opengl_instances_bvh_update(beneath_opengl_context *ctx, beneath_draw_call *draw_call)
+{
+    beneath_mesh *mesh = draw_call->mesh;
+    unsigned int count = draw_call->models_count;
+    beneath_opengl_instances_bvh *instances_bvh = 0;
+    beneath_bool rebuild = false;
+    beneath_bool moved = false;
+    unsigned int kept;
+    unsigned int i;
+    unsigned int axis;
+    float min[3];
+    float max[3];
+
+    if (count < BENEATH_OPENGL_BVH_INSTANCES_MIN)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < ctx->instances_bvhs_count; ++i)
+    {
+        if (ctx->instances_bvhs[i].draw_call_id == draw_call->id)
+        {
+            instances_bvh = &ctx->instances_bvhs[i];
+            break;
+        }
+    }
+
+    if (!instances_bvh)
+    {
+        if (ctx->instances_bvhs_count == BENEATH_OPENGL_BVH_DRAW_CALLS_MAX)
+        {
+            return 0;
+        }
+
+        instances_bvh = &ctx->instances_bvhs[ctx->instances_bvhs_count++];
+        instances_bvh->draw_call_id = draw_call->id;
+        instances_bvh->instances_count = 0;
+        instances_bvh->leaves = 0;
+        instances_bvh->bvh.leaves_capacity = 0;
+    }
+
+    if (count > instances_bvh->bvh.leaves_capacity)
+    {
+        unsigned int capacity = instances_bvh->bvh.leaves_capacity * 2 > count ? instances_bvh->bvh.leaves_capacity * 2 : count;
+
+        instances_bvh->instances_count = 0;
+        instances_bvh->leaves = BENEATH_ARENA_PUSH_ARRAY(&ctx->arena, unsigned int, capacity);
+
+        if (!instances_bvh->leaves || !beneath_bvh_initialize(&instances_bvh->bvh, &ctx->arena, capacity))
+        {
+            instances_bvh->bvh.leaves_capacity = 0;
+            return 0;
+        }
+
+        rebuild = true;
+    }
+
+    for (i = 0; i < 3; ++i)
+    {
+        rebuild |= instances_bvh->bounds_center[i] != mesh->bounds_center[i] || instances_bvh->bounds_extents[i] != mesh->bounds_extents[i];
+        instances_bvh->bounds_center[i] = mesh->bounds_center[i];
+        instances_bvh->bounds_extents[i] = mesh->bounds_extents[i];
+    }
+
+    if (rebuild)
+    {
+        beneath_bvh_clear(&instances_bvh->bvh);
+        instances_bvh->instances_count = 0;
+    }
+
+    kept = instances_bvh->instances_count < count ? instances_bvh->instances_count : count;
+
+    for (i = count; i < instances_bvh->instances_count; ++i)
+    {
+        beneath_bvh_remove(&instances_bvh->bvh, instances_bvh->leaves[i]);
+    }
+
+    /* The models are uploaded every frame whether or not the draw call is flagged changed, so every
+     * kept leaf is compared with its instance and the tree is only refit when one of them moved
+     */
+    for (i = 0; i < kept; ++i)
+    {
+        beneath_bvh_node *leaf = &instances_bvh->bvh.nodes[instances_bvh->leaves[i]];
+        beneath_bool leaf_moved = false;
+
+        beneath_opengl_instance_bounds(mesh, draw_call->models + (unsigned long)i * 16, min, max);
+
+        for (axis = 0; axis < 3; ++axis)
+        {
+            leaf_moved |= leaf->min[axis] != min[axis] || leaf->max[axis] != max[axis];
+        }
+
+        if (leaf_moved)
+        {
+            beneath_bvh_leaf_set(&instances_bvh->bvh, instances_bvh->leaves[i], min, max);
+            moved = true;
+        }
+    }
+
+    if (moved)
+    {
+        beneath_bvh_refit(&instances_bvh->bvh);
+    }
+
+    for (i = kept; i < count; ++i)
+    {
+        beneath_opengl_instance_bounds(mesh, draw_call->models + (unsigned long)i * 16, min, max);
+        instances_bvh->leaves[i] = beneath_bvh_insert(&instances_bvh->bvh, min, max, i);
+    }
+
+    /* Inserts and removes scatter the nodes, traversals want them in depth first order */
+    if (kept != count || kept != instances_bvh->instances_count)
+    {
+        beneath_bvh_compact(&instances_bvh->bvh, &ctx->arena, instances_bvh->leaves);
+    }
+
+    instances_bvh->instances_count = count;
+
+    return instances_bvh;
+}
+
+/******************************/
+/* Hi-Z Occlusion Culling     */
+/******************************/
+
+/* The reduction program and the GPU levels for the current fbo_screen size. Optional, on
+ * failure occlusion culling stays disabled and the renderer works as before.
+ */
+BENEATH_API beneath_bool beneath_opengl_hiz_initialize(beneath_opengl_context *ctx, beneath_api_io_print print)
+{
+    beneath_opengl_hiz *hiz = &ctx->hiz;
+    int width = ctx->fbo_screen_width;
+    int height = ctx->fbo_screen_height;
+    unsigned int i;
+
+    hiz->levels_count = 0;
+    hiz->depths_levels_count = 0;
+
+    if (!beneath_opengl_shader_create_cached(
+            ctx,
+            &hiz->program,
+            BENEATH_OPENGL_PROGRAM_KEY_HIZ,
+            beneath_opengl_shader_post_process_base_vertex,
+            beneath_opengl_shader_hiz_fragment,
+            print))
+    {
+        print(__FILE__, __LINE__, "[opengl] cannot compile the hi-z shader, occlusion culling is disabled\n");
+        return false;
+    }
+
+    hiz->uniform_source = glGetUniformLocation(hiz->program, "source");
+
+    for (i = 0; i < BENEATH_OPENGL_HIZ_LEVELS_MAX; ++i)
+    {
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+
+        hiz->widths[i] = width;
+        hiz->heights[i] = height;
+
+        glGenTextures(1, &hiz->textures[i]);
+        glBindTexture(GL_TEXTURE_2D, hiz->textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, width, height, 0, GL_RED, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        glGenFramebuffers(1, &hiz->fbos[i]);
+        glBindFramebuffer(GL_FRAMEBUFFER, hiz->fbos[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, hiz->textures[i], 0);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, ctx->fbo_output);
+            print(__FILE__, __LINE__, "[opengl] hi-z framebuffer incomplete, occlusion culling is disabled\n");
+            return false;
+        }
+
+        if (width <= BENEATH_OPENGL_HIZ_READBACK_SIZE && height <= BENEATH_OPENGL_HIZ_READBACK_SIZE)
+        {
+            break;
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, ctx->fbo_output);
+
+    if (i == BENEATH_OPENGL_HIZ_LEVELS_MAX)
+    {
+        print(__FILE__, __LINE__, "[opengl] screen too large for the hi-z levels, occlusion culling is disabled\n");
+        return false;
+    }
+
+    glGenBuffers(BENEATH_OPENGL_HIZ_READBACKS, hiz->readback_buffers);
+
+    for (i = 0; i < BENEATH_OPENGL_HIZ_READBACKS; ++i)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, hiz->readback_buffers[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, BENEATH_OPENGL_HIZ_READBACK_SIZE * BENEATH_OPENGL_HIZ_READBACK_SIZE * (int)sizeof(float), NULL, GL_STREAM_READ);
+        hiz->readback_fences[i] = 0;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    hiz->readback_first = 0;
+    hiz->readback_pending = 0;
+    hiz->levels_count = i + 1;
+
+    return true;
+}
+
+/* Reduces the readback level further on the CPU, down to a single texel */
+BENEATH_API void beneath_opengl_hiz_depths_reduce(beneath_opengl_hiz *hiz)
+{
+    unsigned int level = 0;
+
+    while (level + 1 < BENEATH_OPENGL_HIZ_LEVELS_MAX && (hiz->depths_widths[level] > 1 || hiz->depths_heights[level] > 1))
+    {
+        float *source = hiz->depths + hiz->depths_offsets[level];
+        int source_width = hiz->depths_widths[level];
+        int source_height = hiz->depths_heights[level];
+        int width = (source_width + 1) / 2;
+        int height = (source_height + 1) / 2;
+        float *target;
+        int x;
+        int y;
+
+        hiz->depths_offsets[level + 1] = hiz->depths_offsets[level] + (unsigned int)(source_width * source_height);
+        hiz->depths_widths[level + 1] = width;
+        hiz->depths_heights[level + 1] = height;
+        target = hiz->depths + hiz->depths_offsets[level + 1];
+
+        for (y = 0; y < height; ++y)
+        {
+            int y0 = y * 2;
+            int y1 = y0 + 1 < source_height ? y0 + 1 : y0;
+
+            for (x = 0; x < width; ++x)
+            {
+                int x0 = x * 2;
+                int x1 = x0 + 1 < source_width ? x0 + 1 : x0;
+                float a = vm_maxf(source[y0 * source_width + x0], source[y0 * source_width + x1]);
+                float b = vm_maxf(source[y1 * source_width + x0], source[y1 * source_width + x1]);
+
+                target[y * width + x] = vm_maxf(a, b);
+            }
+        }
+
+        level++;
+    }
+
+    hiz->depths_levels_count = level + 1;
+}
+
+/* Takes over the finished readbacks, oldest first, without waiting for the GPU */
+BENEATH_API void beneath_opengl_hiz_readback_poll(beneath_opengl_context *ctx)
+{
+    beneath_opengl_hiz *hiz = &ctx->hiz;
+    unsigned int last = hiz->levels_count - 1;
+
+    while (hiz->readback_pending > 0)
+    {
+        unsigned int slot = hiz->readback_first;
+        unsigned int result = glClientWaitSync(hiz->readback_fences[slot], 0, 0);
+        unsigned int size = (unsigned int)(hiz->widths[last] * hiz->heights[last]) * (unsigned int)sizeof(float);
+        float *mapped;
+        unsigned int i;
+
+        if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+        {
+            break;
+        }
+
+        glDeleteSync(hiz->readback_fences[slot]);
+        hiz->readback_fences[slot] = 0;
+        hiz->readback_first = (slot + 1) % BENEATH_OPENGL_HIZ_READBACKS;
+        hiz->readback_pending--;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, hiz->readback_buffers[slot]);
+        mapped = (float *)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (beneath_gl_intptr)size, GL_MAP_READ_BIT);
+
+        if (mapped)
+        {
+            beneath_opengl_stream_copy((unsigned char *)hiz->depths, mapped, size);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+            for (i = 0; i < 16; ++i)
+            {
+                hiz->projection_view[i] = hiz->readback_projection_views[slot][i];
+            }
+
+            hiz->depths_offsets[0] = 0;
+            hiz->depths_widths[0] = hiz->widths[last];
+            hiz->depths_heights[0] = hiz->heights[last];
+            beneath_opengl_hiz_depths_reduce(hiz);
+        }
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+}
+
+/* After the scene pass into fbo_screen: reduces its depth into the GPU levels and starts
+ * the readback of the last one (skipped while all pixel pack buffers are in flight).
+ */
+BENEATH_API void beneath_opengl_hiz_build(beneath_opengl_context *ctx)
+{
+    beneath_opengl_hiz *hiz = &ctx->hiz;
+    unsigned int last = hiz->levels_count - 1;
+    unsigned int i;
+
+    beneath_opengl_state_use_program(&ctx->state, hiz->program);
+    beneath_opengl_state_bind_vertex_array(&ctx->state, ctx->fbo_screen_vao);
+    glUniform1i(hiz->uniform_source, 0);
+
+    for (i = 0; i < hiz->levels_count; ++i)
+    {
+        beneath_opengl_state_bind_framebuffer(&ctx->state, hiz->fbos[i]);
+        beneath_opengl_state_viewport(&ctx->state, hiz->widths[i], hiz->heights[i]);
+        beneath_opengl_state_bind_texture(&ctx->state, 0, i == 0 ? ctx->fbo_screen_depth_texture : hiz->textures[i - 1]);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+
+    if (hiz->readback_pending < BENEATH_OPENGL_HIZ_READBACKS)
+    {
+        unsigned int slot = (hiz->readback_first + hiz->readback_pending) % BENEATH_OPENGL_HIZ_READBACKS;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, hiz->readback_buffers[slot]);
+        glReadPixels(0, 0, hiz->widths[last], hiz->heights[last], GL_RED, GL_FLOAT, (void *)0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        hiz->readback_fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        for (i = 0; i < 16; ++i)
+        {
+            hiz->readback_projection_views[slot][i] = ctx->queue_projection_view[i];
+        }
+
+        hiz->readback_pending++;
+    }
+}
+
+/* Frames without a scene pass into fbo_screen leave no depth, older pyramids are dropped */
+BENEATH_API void beneath_opengl_hiz_invalidate(beneath_opengl_context *ctx)
+{
+    beneath_opengl_hiz *hiz = &ctx->hiz;
+
+    while (hiz->readback_pending > 0)
+    {
+        glDeleteSync(hiz->readback_fences[hiz->readback_first]);
+        hiz->readback_fences[hiz->readback_first] = 0;
+        hiz->readback_first = (hiz->readback_first + 1) % BENEATH_OPENGL_HIZ_READBACKS;
+        hiz->readback_pending--;
+    }
+
+    hiz->depths_levels_count = 0;
+}
+
+/* True if the world space box of the instance lies behind the pyramid depth everywhere it
+ * covers. Boxes reaching behind the camera are never occluded. The rectangle of the projected
+ * corners is tested on the first CPU level where it spans at most 2x2 texels.
+ */
+BENEATH_API beneath_bool beneath_opengl_hiz_occluded(beneath_opengl_hiz *hiz, int screen_width, int screen_height, float min[3], float max[3])
+{
+    float *pv = hiz->projection_view;
+    float x_min = 1.0f;
+    float x_max = -1.0f;
+    float y_min = 1.0f;
+    float y_max = -1.0f;
+    float depth_near = 1.0f;
+    unsigned int shift = hiz->levels_count;
+    unsigned int level = 0;
+    int x0, x1, y0, y1;
+    int corner;
+    int x;
+    int y;
+
+    for (corner = 0; corner < 8; ++corner)
+    {
+        float px = (corner & 1) ? max[0] : min[0];
+        float py = (corner & 2) ? max[1] : min[1];
+        float pz = (corner & 4) ? max[2] : min[2];
+        float cx = pv[0] * px + pv[4] * py + pv[8] * pz + pv[12];
+        float cy = pv[1] * px + pv[5] * py + pv[9] * pz + pv[13];
+        float cz = pv[2] * px + pv[6] * py + pv[10] * pz + pv[14];
+        float cw = pv[3] * px + pv[7] * py + pv[11] * pz + pv[15];
+        float w_inverse;
+
+        if (cw <= 1e-5f)
+        {
+            return false;
+        }
+
+        w_inverse = 1.0f / cw;
+        x_min = vm_minf(x_min, cx * w_inverse);
+        x_max = vm_maxf(x_max, cx * w_inverse);
+        y_min = vm_minf(y_min, cy * w_inverse);
+        y_max = vm_maxf(y_max, cy * w_inverse);
+        depth_near = vm_minf(depth_near, cz * w_inverse * 0.5f + 0.5f);
+    }
+
+    /* fbo_screen pixels, then texels of the readback level (2^levels_count pixels per side) */
+    x0 = (int)vm_clampf((x_min * 0.5f + 0.5f) * (float)screen_width, 0.0f, (float)(screen_width - 1)) >> shift;
+    x1 = (int)vm_clampf((x_max * 0.5f + 0.5f) * (float)screen_width, 0.0f, (float)(screen_width - 1)) >> shift;
+    y0 = (int)vm_clampf((y_min * 0.5f + 0.5f) * (float)screen_height, 0.0f, (float)(screen_height - 1)) >> shift;
+    y1 = (int)vm_clampf((y_max * 0.5f + 0.5f) * (float)screen_height, 0.0f, (float)(screen_height - 1)) >> shift;
+
+    while ((x1 - x0 > 1 || y1 - y0 > 1) && level + 1 < hiz->depths_levels_count)
+    {
+        x0 >>= 1;
+        x1 >>= 1;
+        y0 >>= 1;
+        y1 >>= 1;
+        level++;
+    }
+
+    {
+        float *depths = hiz->depths + hiz->depths_offsets[level];
+        int width = hiz->depths_widths[level];
+
+        for (y = y0; y <= y1; ++y)
+        {
+            for (x = x0; x <= x1; ++x)
+            {
+                if (depth_near <= depths[y * width + x])
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+/* Drops the occluded instances from the visible list, returns the new count */
+BENEATH_API unsigned int beneath_opengl_hiz_cull(beneath_opengl_context *ctx, beneath_mesh *mesh, float *models, unsigned int *visible, unsigned int visible_count)
+{
+    unsigned int kept = 0;
+    unsigned int i;
+
+    for (i = 0; i < visible_count; ++i)
+    {
+        float min[3];
+        float max[3];
+
+        beneath_opengl_instance_bounds(mesh, models + (unsigned long)visible[i] * 16, min, max);
+
+        visible[kept] = visible[i];
+        kept += beneath_opengl_hiz_occluded(&ctx->hiz, ctx->fbo_screen_width, ctx->fbo_screen_height, min, max) ? 0u : 1u;
+    }
+
+    return kept;
+}
+
+/* Copies count elements of element_size bytes, the ones listed in indices or the first count if indices is 0 */
+BENEATH_API void beneath_opengl_instances_gather(unsigned char *dst, void *src, unsigned int element_size, unsigned int *indices, unsigned int count)
+{
+    unsigned char *s = (unsigned char *)src;
+    unsigned int i;
+
+    if (!indices)
+    {
+        beneath_opengl_stream_copy(dst, src, count * element_size);
+        return;
+    }
+
+    for (i = 0; i < count; ++i)
+    {
+        beneath_opengl_stream_copy(dst + (unsigned long)i * element_size, s + (unsigned long)indices[i] * element_size, element_size);
+    }
+}
+
+/* Reorders the instance indices by LOD chain level (stable counting sort) and writes the count
+ * per level. Without the scratch memory every instance stays at the full mesh.
+ */
+BENEATH_API void beneath_opengl_instances_lod_sort(
+    beneath_arena *arena,
+    beneath_draw_call *draw_call,
+    unsigned int *indices,
+    unsigned int count,
+    float camera_position[3],
+    float pixels_per_unit,
+    unsigned int lod_counts[BENEATH_DRAW_CALL_LODS_MAX + 1])
+{
+    beneath_arena_temp temp = beneath_arena_temp_begin(arena);
+    unsigned int *sorted = BENEATH_ARENA_PUSH_ARRAY(arena, unsigned int, count);
+    unsigned char *lods = BENEATH_ARENA_PUSH_ARRAY(arena, unsigned char, count);
+    unsigned int offsets[BENEATH_DRAW_CALL_LODS_MAX + 1];
+    unsigned int offset = 0;
+    unsigned int i;
+
+    for (i = 0; i <= BENEATH_DRAW_CALL_LODS_MAX; ++i)
+    {
+        lod_counts[i] = 0;
+    }
+
+    if (!sorted || !lods)
+    {
+        lod_counts[0] = count;
+        beneath_arena_temp_end(temp);
+        return;
+    }
+
+    for (i = 0; i < count; ++i)
+    {
+        lods[i] = (unsigned char)beneath_draw_call_lod_select(draw_call, draw_call->models + (unsigned long)indices[i] * 16, camera_position, pixels_per_unit);
+        lod_counts[lods[i]]++;
+    }
+
+    for (i = 0; i <= BENEATH_DRAW_CALL_LODS_MAX; ++i)
+    {
+        offsets[i] = offset;
+        offset += lod_counts[i];
+    }
+
+    for (i = 0; i < count; ++i)
+    {
+        sorted[offsets[lods[i]]++] = indices[i];
+    }
+
+    for (i = 0; i < count; ++i)
+    {
+        indices[i] = sorted[i];
+    }
+
+    beneath_arena_temp_end(temp);
+}
+
+/* Culls the instances of the draw call against the camera frustum and, for shadow casters,
+ * against the light frustum. Large draw calls go through their BVH, the leaves of partially
+ * visible nodes and all other draw calls through the SIMD batch cull. The visible instance
+ * data is uploaded compacted into this frames region and the entry records where it went,
+ * the attributes are pointed at it when the queue is flushed.
+ * The shadow pass gets its own list of model matrices behind the camera instances.
+ * Draw calls with a LOD chain get both lists ordered by level, one instanced draw per level.
+ */
+BENEATH_API beneath_bool beneath_opengl_instances_upload(
+    beneath_opengl_context *ctx,
+    beneath_opengl_queue_entry *entry,
+    float projection_view[16],
+    float camera_position[3],
+    float pixels_per_unit,
+    beneath_api_io_print print)
+{
+    beneath_draw_call *draw_call = entry->draw_call;
+    unsigned int count = draw_call->models_count;
+    beneath_bool colors = draw_call->colors_count > 1;
+    beneath_bool texture_indices = draw_call->texture_indices_count > 1;
+
+    /* Per instance colors or texture indices shorter than the models cannot be compacted, such draw calls are not culled */
+    beneath_bool cullable = draw_call->mesh->bounds_valid &&
+                            (!colors || draw_call->colors_count >= count) &&
+                            (!texture_indices || draw_call->texture_indices_count >= count);
+    beneath_opengl_instances_bvh *instances_bvh = cullable ? beneath_opengl_instances_bvh_update(ctx, draw_call) : 0;
+    beneath_arena_temp temp = beneath_arena_temp_begin(&ctx->arena);
+    unsigned int *visible = 0;
+    unsigned int *shadow_visible = 0;
+    unsigned int *candidates = 0;
+    unsigned int visible_count = count;
+    unsigned int shadow_count = draw_call->shadow ? count : 0;
+    unsigned int models_size;
+    unsigned int colors_size;
+    unsigned int texture_indices_size;
+    unsigned int shadow_size;
+    unsigned int size;
+    unsigned char *dst;
+    unsigned int i;
+
+    entry->instances_occluded = 0;
+
+    for (i = 0; i <= BENEATH_DRAW_CALL_LODS_MAX; ++i)
+    {
+        entry->lod_counts[i] = 0;
+        entry->shadow_lod_counts[i] = 0;
+    }
+
+    if (cullable)
+    {
+        visible = BENEATH_ARENA_PUSH_ARRAY(&ctx->arena, unsigned int, count);
+        shadow_visible = draw_call->shadow ? BENEATH_ARENA_PUSH_ARRAY(&ctx->arena, unsigned int, count) : 0;
+        candidates = instances_bvh ? BENEATH_ARENA_PUSH_ARRAY(&ctx->arena, unsigned int, count) : 0;
+
+        if (visible && (shadow_visible || !draw_call->shadow))
+        {
+            m4x4 pv;
+            frustum camera_frustum;
+
+            for (i = 0; i < 16; ++i)
+            {
+                pv.e[i] = projection_view[i];
+            }
+
+            camera_frustum = vm_frustum_extract_planes(pv);
+
+            if (candidates)
+            {
+                unsigned int candidates_count;
+
+                /* Subtrees inside the frustum are taken as they are, the leaves of partially visible nodes go through the batch cull */
+                visible_count = beneath_bvh_query_frustum_candidates(&instances_bvh->bvh, &camera_frustum, visible, candidates, count, &candidates_count);
+                visible_count += beneath_opengl_instances_cull(&camera_frustum, draw_call->mesh, draw_call->models, candidates, candidates_count, visible + visible_count);
+
+                if (shadow_visible)
+                {
+                    shadow_count = beneath_bvh_query_frustum_candidates(&instances_bvh->bvh, &shadow_frustum, shadow_visible, candidates, count, &candidates_count);
+                    shadow_count += beneath_opengl_instances_cull(&shadow_frustum, draw_call->mesh, draw_call->models, candidates, candidates_count, shadow_visible + shadow_count);
+                }
+                else
+                {
+                    shadow_count = 0;
+                }
+            }
+            else
+            {
+                visible_count = beneath_opengl_instances_cull(&camera_frustum, draw_call->mesh, draw_call->models, (unsigned int *)0, count, visible);
+                shadow_count = shadow_visible ? beneath_opengl_instances_cull(&shadow_frustum, draw_call->mesh, draw_call->models, (unsigned int *)0, count, shadow_visible) : 0;
+            }
+
+            /* Shadow casters stay, the pyramid only knows what the camera saw */
+            if (ctx->hiz.depths_levels_count > 0)
+            {
+                unsigned int unoccluded = beneath_opengl_hiz_cull(ctx, draw_call->mesh, draw_call->models, visible, visible_count);
+
+                entry->instances_occluded = visible_count - unoccluded;
+                visible_count = unoccluded;
+            }
+
+            /* Draw calls that cannot be culled cannot be reordered either, they stay at the full mesh */
+            if (draw_call->lods_count > 0)
+            {
+                beneath_opengl_instances_lod_sort(&ctx->arena, draw_call, visible, visible_count, camera_position, pixels_per_unit, entry->lod_counts);
+
+                if (shadow_visible)
+                {
+                    beneath_opengl_instances_lod_sort(&ctx->arena, draw_call, shadow_visible, shadow_count, camera_position, pixels_per_unit, entry->shadow_lod_counts);
+                }
+            }
+        }
+        else
+        {
+            visible = 0;
+            shadow_visible = 0;
+        }
+    }
+
+    models_size = visible_count * (unsigned int)sizeof(float) * 16;
+    colors_size = colors ? visible_count * (unsigned int)sizeof(float) * 3 : 0;
+    texture_indices_size = texture_indices ? visible_count * (unsigned int)sizeof(int) : 0;
+    shadow_size = shadow_visible ? shadow_count * (unsigned int)sizeof(float) * 16 : 0; /* Unculled shadows reuse the models */
+    size = models_size + colors_size + texture_indices_size + shadow_size;
+
+    entry->instances_count = visible_count;
+    entry->shadow_instances_count = shadow_count;
+
+    if (draw_call->lods_count == 0 || !visible)
+    {
+        entry->lod_counts[0] = visible_count;
+    }
+
+    if (draw_call->lods_count == 0 || !shadow_visible)
+    {
+        entry->shadow_lod_counts[0] = shadow_count;
+    }
+
+    entry->instance_buffer = ctx->stream_buffer;
+    entry->instance_base = 0;
+
+    if (size == 0)
+    {
+        beneath_arena_temp_end(temp);
+        return true;
+    }
+
+    dst = beneath_opengl_stream_map(ctx, size, BENEATH_OPENGL_STREAM_ALIGNMENT, &entry->instance_base);
+
+    if (!dst)
+    {
+        /* More instance data than the region holds, orphan the per mesh instance buffer instead.
+         * Only one oversized draw call per mesh and frame, a second one would overwrite it before the flush.
+         */
+        entry->instance_buffer = ctx->storage_buffer_object[draw_call->mesh->id * BENEATH_OPENGL_SHADER_LAYOUT_COUNT + BENEATH_OPENGL_STORAGE_INSTANCE];
+        entry->instance_base = 0;
+
+        beneath_opengl_state_bind_array_buffer(&ctx->state, entry->instance_buffer);
+        glBufferData(GL_ARRAY_BUFFER, (int)size, NULL, GL_STREAM_DRAW);
+
+        dst = (unsigned char *)glMapBufferRange(GL_ARRAY_BUFFER, 0, (beneath_gl_intptr)size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+
+        if (!dst)
+        {
+            print(__FILE__, __LINE__, "[opengl] cannot map instance data!\n");
+            beneath_arena_temp_end(temp);
+            return false;
+        }
+    }
+
+    beneath_opengl_instances_gather(dst, draw_call->models, sizeof(float) * 16, visible, visible_count);
+
+    if (colors)
+    {
+        beneath_opengl_instances_gather(dst + models_size, draw_call->colors, sizeof(float) * 3, visible, visible_count);
+    }
+
+    if (texture_indices)
+    {
+        beneath_opengl_instances_gather(dst + models_size + colors_size, draw_call->texture_indices, sizeof(int), visible, visible_count);
+    }
+
+    if (shadow_visible)
+    {
+        beneath_opengl_instances_gather(dst + models_size + colors_size + texture_indices_size, draw_call->models, sizeof(float) * 16, shadow_visible, shadow_count);
+    }
+
+    if (entry->instance_buffer == ctx->stream_buffer)
+    {
+        beneath_opengl_stream_unmap(ctx);
+    }
+    else
+    {
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+
+    entry->shadow_base = entry->instance_base + (shadow_visible ? models_size + colors_size + texture_indices_size : 0);
+
+    beneath_arena_temp_end(temp);
+
+    return true;
+}
+
+/* Uploads the interleaved vertex stream of the mesh into buffer and points the
+ * attributes of the bound mesh VAO into it. Packed formats are normalized by the
+ * vertex fetch, the shaders see the same float inputs as for separate arrays.
+ */
+BENEATH_API void beneath_opengl_mesh_interleaved_upload(beneath_opengl_state *state, beneath_mesh *mesh, unsigned int buffer)
+{
+    static int components[BENEATH_VERTEX_ATTRIBUTE_COUNT] = {3, 2, 3, 3, 3, 3};
+    beneath_vertex_layout *layout = &mesh->layout;
+    unsigned int i;
+
+    beneath_opengl_state_bind_array_buffer(state, buffer);
+    glBufferData(GL_ARRAY_BUFFER, (int)(mesh->interleaved_count * layout->stride), mesh->interleaved, GL_STATIC_DRAW);
+
+    /* The attribute enum follows the shader layout locations */
+    for (i = 0; i < BENEATH_VERTEX_ATTRIBUTE_COUNT; ++i)
+    {
+        void *offset = (void *)(unsigned long)layout->offsets[i];
+        int stride = (int)layout->stride;
+
+        switch (layout->formats[i])
+        {
+        case BENEATH_VERTEX_FORMAT_FLOAT32:
+            glVertexAttribPointer(i, components[i], GL_FLOAT, GL_FALSE, stride, offset);
+            break;
+        case BENEATH_VERTEX_FORMAT_FLOAT16:
+            glVertexAttribPointer(i, components[i], GL_HALF_FLOAT, GL_FALSE, stride, offset);
+            break;
+        case BENEATH_VERTEX_FORMAT_SNORM_10_10_10_2:
+            glVertexAttribPointer(i, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, offset);
+            break;
+        case BENEATH_VERTEX_FORMAT_UNORM8:
+            glVertexAttribPointer(i, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, offset);
+            break;
+        default:
+            glDisableVertexAttribArray(i);
+            continue;
+        }
+
+        glEnableVertexAttribArray(i);
+    }
+}
+
+/* Points the instanced attributes of the bound mesh VAO at the entries instance data, starting
+ * at instance first (the range of a LOD chain level). The shadow pass only reads the model
+ * matrices of the shadow casters. Several draw calls can share a mesh VAO, so this runs for
+ * every queued draw.
+ */
+BENEATH_API void beneath_opengl_instances_bind(beneath_opengl_state *state, beneath_opengl_queue_entry *entry, beneath_bool shadow, unsigned int first)
+{
+    beneath_draw_call *draw_call = entry->draw_call;
+    unsigned long models_size = (unsigned long)entry->instances_count * sizeof(float) * 16;
+    unsigned long colors_size = draw_call->colors_count > 1 && !shadow ? (unsigned long)entry->instances_count * sizeof(float) * 3 : 0;
+    unsigned long base = shadow ? entry->shadow_base : entry->instance_base;
+    int i;
+
+    beneath_opengl_state_bind_array_buffer(state, entry->instance_buffer);
+
+    /* Attribute pointers 6 - 9 for the model matrix (4 times vec4) */
+    for (i = 0; i < 4; ++i)
+    {
+        unsigned int model_location = (unsigned int)(BENEATH_OPENGL_SHADER_LAYOUT_INSTANCE_MODEL + i);
+        glEnableVertexAttribArray(model_location);
+        glVertexAttribPointer(model_location, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 16, (void *)(base + ((unsigned long)first * 4 + (unsigned long)i) * sizeof(float) * 4));
+        glVertexAttribDivisor(model_location, 1);
+    }
+
+    if (colors_size > 0)
+    {
+        glEnableVertexAttribArray(BENEATH_OPENGL_SHADER_LAYOUT_INSTANCE_COLOR);
+        glVertexAttribPointer(BENEATH_OPENGL_SHADER_LAYOUT_INSTANCE_COLOR, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 3, (void *)(base + models_size + (unsigned long)first * sizeof(float) * 3));
+        glVertexAttribDivisor(BENEATH_OPENGL_SHADER_LAYOUT_INSTANCE_COLOR, 1);
+    }
+    else
+    {
+        glDisableVertexAttribArray(BENEATH_OPENGL_SHADER_LAYOUT_INSTANCE_COLOR);
+    }
+
+    if (draw_call->texture_indices_count > 1 && !shadow)
+    {
+        glEnableVertexAttribArray(BENEATH_OPENGL_SHADER_LAYOUT_INSTANCE_TEXTURE_INDEX);
+        glVertexAttribIPointer(BENEATH_OPENGL_SHADER_LAYOUT_INSTANCE_TEXTURE_INDEX, 1, GL_INT, sizeof(int), (void *)(base + models_size + colors_size + (unsigned long)first * sizeof(int)));
+        glVertexAttribDivisor(BENEATH_OPENGL_SHADER_LAYOUT_INSTANCE_TEXTURE_INDEX, 1);
+    }
+    else
+    {
+        glDisableVertexAttribArray(BENEATH_OPENGL_SHADER_LAYOUT_INSTANCE_TEXTURE_INDEX);
+    }
+}
+
+/* 64 bit sort key: draws sharing a program end up next to each other, inside a
+ * program draws sharing a mesh VAO, inside a mesh front to back (less overdraw).
+ */
+BENEATH_API unsigned long long beneath_opengl_queue_key(unsigned int shader_hash, beneath_draw_call *draw_call, float camera_position[3])
+{
+    union
+    {
+        float f;
+        unsigned int u;
+    } depth;
+
+    /* The first instance stands in for the whole draw call */
+    float dx = draw_call->models[12] - camera_position[0];
+    float dy = draw_call->models[13] - camera_position[1];
+    float dz = draw_call->models[14] - camera_position[2];
+
+    /* Positive floats compare like unsigned integers, the top 24 bits are enough for ordering */
+    depth.f = dx * dx + dy * dy + dz * dz;
+
+    return ((unsigned long long)shader_hash << 32) |
+           ((unsigned long long)(draw_call->mesh->id & 0xFF) << 24) |
+           (unsigned long long)(depth.u >> 8);
+}
+
+/* The VAO and buffer slots of a mesh are indexed by its id */
+BENEATH_API beneath_bool beneath_opengl_mesh_id_valid(beneath_mesh *mesh, beneath_api_io_print print)
+{
+    if (mesh->id >= BENEATH_OPENGL_MESHES_MAX)
+    {
+        print(__FILE__, __LINE__, "[opengl] mesh id is not below BENEATH_OPENGL_MESHES_MAX!\n");
+        return false;
+    }
+
+    return true;
+}
+
+/* Uploads the vertex and index data of a changed mesh into its VAO and buffers */
+BENEATH_API beneath_bool beneath_opengl_mesh_upload(beneath_opengl_context *ctx, beneath_mesh *mesh, beneath_api_io_print print)
+{
+    unsigned int buffer_index = mesh->id * BENEATH_OPENGL_SHADER_LAYOUT_COUNT;
+
+    if (!beneath_opengl_mesh_id_valid(mesh, print))
+    {
+        return false;
+    }
+
+    /* Culling bounds for meshes that do not bring their own */
+    if (!mesh->bounds_valid)
+    {
+        beneath_mesh_bounds_compute(mesh);
+    }
+
+    beneath_opengl_state_bind_vertex_array(&ctx->state, ctx->storage_vertex_array[mesh->id]);
+
+    /* Index data */
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ctx->storage_buffer_object[buffer_index + 1]);
+    if (mesh->indices16)
+    {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (int)mesh->indices_count * (int)sizeof(unsigned short), mesh->indices16, GL_STATIC_DRAW);
+    }
+    else
+    {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (int)mesh->indices_count * (int)sizeof(unsigned int), mesh->indices, GL_STATIC_DRAW);
+    }
+
+    if (mesh->interleaved)
+    {
+        beneath_opengl_mesh_interleaved_upload(&ctx->state, mesh, ctx->storage_buffer_object[buffer_index]);
+    }
+    else
+    {
+        /* Vertex data */
+        beneath_opengl_state_bind_array_buffer(&ctx->state, ctx->storage_buffer_object[buffer_index]);
+        glBufferData(GL_ARRAY_BUFFER, (int)mesh->vertices_count * (int)sizeof(float), mesh->vertices, GL_STATIC_DRAW);
+        glVertexAttribPointer(BENEATH_OPENGL_SHADER_LAYOUT_POSITION, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+        glEnableVertexAttribArray(BENEATH_OPENGL_SHADER_LAYOUT_POSITION);
+
+        /* UV data */
+        if (mesh->uvs_count > 0)
+        {
+            beneath_opengl_state_bind_array_buffer(&ctx->state, ctx->storage_buffer_object[buffer_index + 2]);
+            glBufferData(GL_ARRAY_BUFFER, (int)mesh->uvs_count * (int)sizeof(float), mesh->uvs, GL_STATIC_DRAW);
+            glVertexAttribPointer(BENEATH_OPENGL_SHADER_LAYOUT_UV, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
+            glEnableVertexAttribArray(BENEATH_OPENGL_SHADER_LAYOUT_UV);
+        }
+
+        /* Normals data */
+        if (mesh->normals_count > 0)
+        {
+            beneath_opengl_state_bind_array_buffer(&ctx->state, ctx->storage_buffer_object[buffer_index + 3]);
+            glBufferData(GL_ARRAY_BUFFER, (int)mesh->normals_count * (int)sizeof(float), mesh->normals, GL_STATIC_DRAW);
+            glVertexAttribPointer(BENEATH_OPENGL_SHADER_LAYOUT_NORMAL, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+            glEnableVertexAttribArray(BENEATH_OPENGL_SHADER_LAYOUT_NORMAL);
+        }
+
+        /* Tangent data */
+        if (mesh->tangents_count > 0)
+        {
+            beneath_opengl_state_bind_array_buffer(&ctx->state, ctx->storage_buffer_object[buffer_index + 4]);
+            glBufferData(GL_ARRAY_BUFFER, (int)mesh->tangents_count * (int)sizeof(float), mesh->tangents, GL_STATIC_DRAW);
+            glVertexAttribPointer(BENEATH_OPENGL_SHADER_LAYOUT_TANGENT, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+            glEnableVertexAttribArray(BENEATH_OPENGL_SHADER_LAYOUT_TANGENT);
+        }
+
+        /* Bitangent data */
+        if (mesh->bitangents_count > 0)
+        {
+            beneath_opengl_state_bind_array_buffer(&ctx->state, ctx->storage_buffer_object[buffer_index + 5]);
+            glBufferData(GL_ARRAY_BUFFER, (int)mesh->bitangents_count * (int)sizeof(float), mesh->bitangents, GL_STATIC_DRAW);
+            glVertexAttribPointer(BENEATH_OPENGL_SHADER_LAYOUT_BITANGENT, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+            glEnableVertexAttribArray(BENEATH_OPENGL_SHADER_LAYOUT_BITANGENT);
+        }
+
+        /* Color data */
+        if (mesh->colors_count > 0)
+        {
+            beneath_opengl_state_bind_array_buffer(&ctx->state, ctx->storage_buffer_object[buffer_index + 6]);
+            glBufferData(GL_ARRAY_BUFFER, (int)mesh->colors_count * (int)sizeof(float), mesh->colors, GL_STATIC_DRAW);
+            glVertexAttribPointer(BENEATH_OPENGL_SHADER_LAYOUT_COLOR, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+            glEnableVertexAttribArray(BENEATH_OPENGL_SHADER_LAYOUT_COLOR);
+        }
+    }
+
+    return true;
+}
+
+/* Queues a draw call for beneath_opengl_frame_end. The draw call (mesh, lightning) has to
+ * stay valid until then, the instance data and the camera matrices are copied right away.
+ */
+BENEATH_API beneath_bool beneath_opengl_draw(
+    beneath_state *state,         /* The state */
+    beneath_draw_call *draw_call, /* The draw call instanced objects */
+    float projection_view[16],    /* The projection view matrix */
+    float projection_inverse[16], /* The projection matrix inversed */
+    float view_inverse[16],       /* The view matrix inversed */
+    float camera_position[3],     /* The camera x,y,z position */
+    beneath_api_io_print print)
+{
+    unsigned int lod;
+
+    if (!draw_call || draw_call->models_count == 0 || !draw_call->mesh || draw_call->lods_count > BENEATH_DRAW_CALL_LODS_MAX)
+    {
+        return false;
+    }
+
+    if (!beneath_opengl_mesh_id_valid(draw_call->mesh, print))
+    {
+        return false;
+    }
+
+    for (lod = 0; lod < draw_call->lods_count; ++lod)
+    {
+        if (!draw_call->lods[lod] || !beneath_opengl_mesh_id_valid(draw_call->lods[lod], print))
+        {
+            return false;
+        }
+    }
+
+    if (!ctx.initialized)
+    {
+        glGenVertexArrays(BENEATH_OPENGL_MESHES_MAX, ctx.storage_vertex_array);
+        glGenBuffers(BENEATH_OPENGL_MESHES_MAX * BENEATH_OPENGL_SHADER_LAYOUT_COUNT, ctx.storage_buffer_object);
+
+        beneath_opengl_stream_initialize(&ctx, print);
+
+        {
+            int alignment = 0;
+
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+            /* A power of two in practice, at least the instance alignment */
+            ctx.uniform_alignment = alignment > BENEATH_OPENGL_STREAM_ALIGNMENT ? (unsigned int)alignment : BENEATH_OPENGL_STREAM_ALIGNMENT;
+        }
+
+        /* Program binary cache, needs the optional 4.1 entry points and the platform file io */
+        if (glGetProgramBinary && glProgramBinary && glProgramParameteri && ctx.io_file_size && ctx.io_file_read && ctx.io_file_write)
+        {
+            unsigned int driver_hash = 2166136261u;
+
+            driver_hash = beneath_opengl_hash_cstr(driver_hash, (char *)glGetString(GL_VENDOR));
+            driver_hash = beneath_opengl_hash_cstr(driver_hash, (char *)glGetString(GL_RENDERER));
+            driver_hash = beneath_opengl_hash_cstr(driver_hash, (char *)glGetString(GL_VERSION));
+
+            ctx.program_cache_driver_hash = driver_hash ? driver_hash : 1;
+        }
+
+        ctx.initialized = true;
+
+        /* Setup Screen Framebuffer and VAO,VBO */
+        {
+            float quad_vertices[] = {
+                /* pos, uv */
+                -1.0f, -1.0f, 0.0f, 0.0f,
+                1.0f, -1.0f, 1.0f, 0.0f,
+                -1.0f, 1.0f, 0.0f, 1.0f,
+                1.0f, 1.0f, 1.0f, 1.0f};
+
+            if (!beneath_opengl_framebuffer_screen_initialize(
+                    &ctx, print,
+                    (int)(draw_call->pixelize ? 300 : state->window_width),
+                    (int)(draw_call->pixelize ? 200 : state->window_height)))
             {
                 print(__FILE__, __LINE__, "cannot initialize screen framebuffers!!!\n");
                 return false;
             }
 
-            glGenVertexArrays(1, &ctx.fbo_screen_vao);
-            glGenBuffers(1, &ctx.fbo_screen_vbo);
+            beneath_opengl_hiz_initialize(&ctx, print);
+
+            glGenVertexArrays(1, &ctx.fbo_screen_vao);
+            glGenBuffers(1, &ctx.fbo_screen_vbo);
+
+            glBindVertexArray(ctx.fbo_screen_vao);
+            glBindBuffer(GL_ARRAY_BUFFER, ctx.fbo_screen_vbo);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertices), quad_vertices, GL_STATIC_DRAW);
+
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)0);
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(2 * sizeof(float)));
+
+            glBindVertexArray(0);
+        }
+
+        /* Post processing shader */
+        {
+            if (!beneath_opengl_shader_create_cached(
+                    &ctx,
+                    &ctx.post_process_base_program,
+                    BENEATH_OPENGL_PROGRAM_KEY_POST_PROCESS,
+                    beneath_opengl_shader_post_process_base_vertex,
+                    beneath_opengl_shader_post_process_base_fragment,
+                    print))
+            {
+                print(__FILE__, __LINE__, "cannot compile post processing shader !!!\n");
+                return false;
+            }
+
+            ctx.post_process_base_uniform_screen_texture = glGetUniformLocation(ctx.post_process_base_program, "screen_texture");
+        }
+
+        /* Volumetric Shader */
+        {
+            if (!beneath_opengl_shader_create_cached(
+                    &ctx,
+                    &ctx.volumetric_program,
+                    BENEATH_OPENGL_PROGRAM_KEY_VOLUMETRIC,
+                    beneath_opengl_shader_post_process_base_vertex,
+                    beneath_opengl_shader_volumetric_fragment,
+                    print))
+            {
+                print(__FILE__, __LINE__, "cannot compile volumetric shader !!!\n");
+                return false;
+            }
+
+            ctx.volumetric_uniform_screen_texture = glGetUniformLocation(ctx.volumetric_program, "screen_texture");
+            ctx.volumetric_uniform_depth_texture = glGetUniformLocation(ctx.volumetric_program, "depth_texture");
+            ctx.volumetric_uniform_shadow_map = glGetUniformLocation(ctx.volumetric_program, "shadow_map");
+            ctx.volumetric_uniform_light_position = glGetUniformLocation(ctx.volumetric_program, "light_position");
+            ctx.volumetric_uniform_light_direction = glGetUniformLocation(ctx.volumetric_program, "light_direction");
+            ctx.volumetric_uniform_light_projection = glGetUniformLocation(ctx.volumetric_program, "light_projection");
+            ctx.volumetric_uniform_light_view = glGetUniformLocation(ctx.volumetric_program, "light_view");
+            ctx.volumetric_uniform_camera_position = glGetUniformLocation(ctx.volumetric_program, "camera_position");
+            ctx.volumetric_uniform_camera_projection_inverse = glGetUniformLocation(ctx.volumetric_program, "camera_projection_inverse");
+            ctx.volumetric_uniform_camera_view_inverse = glGetUniformLocation(ctx.volumetric_program, "camera_view_inverse");
+
+            /* Constant for the program lifetime, set once instead of every frame */
+            glUseProgram(ctx.volumetric_program);
+            glUniform1f(glGetUniformLocation(ctx.volumetric_program, "camera_far"), 100.0f);
+            glUniform1f(glGetUniformLocation(ctx.volumetric_program, "cone_angle"), 20.0f);
+            glUniform1f(glGetUniformLocation(ctx.volumetric_program, "shadow_bias"), 0.001f);
+            glUseProgram(0);
+        }
+
+        /* Pixel */
+        {
+            if (!beneath_opengl_shader_create_cached(
+                    &ctx,
+                    &ctx.blit_program,
+                    BENEATH_OPENGL_PROGRAM_KEY_PIXEL,
+                    beneath_opengl_shader_post_process_base_vertex,
+                    beneath_opengl_shader_pixel_fragment,
+                    print))
+            {
+                print(__FILE__, __LINE__, "cannot compile pixel shaders !!!\n");
+                return false;
+            }
+
+            ctx.blit_tex_uniform = glGetUniformLocation(ctx.blit_program, "screen_texture");
+            ctx.blit_texel_uniform = glGetUniformLocation(ctx.blit_program, "texel_size");
+        }
+
+        /* Shadow Map */
+        {
+#define SHADOW_SIZE 1024
+            float border_color[] = {1.0, 1.0, 1.0, 1.0};
+
+            v3 light_direction;
+            v3 center;
+            float distance;
+
+            if (!beneath_opengl_shader_create_cached(
+                    &ctx,
+                    &ctx.shadow_program,
+                    BENEATH_OPENGL_PROGRAM_KEY_SHADOW,
+                    beneath_opengl_shader_shadow_vertex,
+                    beneath_opengl_shader_shadow_fragment,
+                    print))
+            {
+                print(__FILE__, __LINE__, "cannot compile shadow shaders !!!\n");
+                return false;
+            }
+
+            ctx.shadow_uniform_pv = glGetUniformLocation(ctx.shadow_program, "pv");
+
+            glGenTextures(1, &ctx.shadow_texture_depth);
+            glBindTexture(GL_TEXTURE_2D, ctx.shadow_texture_depth);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SHADOW_SIZE, SHADOW_SIZE, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+            glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border_color);
+
+            glGenFramebuffers(1, &ctx.shadow_fbo);
+            glBindFramebuffer(GL_FRAMEBUFFER, ctx.shadow_fbo);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, ctx.shadow_texture_depth, 0);
+            glDrawBuffer(GL_NONE);
+            glReadBuffer(GL_NONE);
+            glBindFramebuffer(GL_FRAMEBUFFER, ctx.fbo_output);
+
+            light_direction = vm_v3_normalize(vm_v3(
+                draw_call->lightning->directional.direction[0],
+                draw_call->lightning->directional.direction[1],
+                draw_call->lightning->directional.direction[2]));
+
+            center = vm_v3_zero;
+            distance = 10.0f;
+
+            shadow_light_position = vm_v3_sub(center, vm_v3_mulf(light_direction, distance));
+            shadow_projection = vm_m4x4_orthographic(-10.0f, 10.0f, -10.0f, 10.0f, 1.0f, 50.0f);
+            shadow_view = vm_m4x4_lookAt(shadow_light_position, vm_v3_zero, vm_v3_up);
+            shadow_pv = vm_m4x4_mul(shadow_projection, shadow_view);
+            shadow_frustum = vm_frustum_extract_planes(shadow_pv);
+        }
+
+        /* Initialization bound objects directly */
+        beneath_opengl_state_invalidate(&ctx.state);
+    }
+
+    if (!beneath_opengl_shader_load(&ctx, draw_call, print))
+    {
+        print(__FILE__, __LINE__, "cannot load shaders!!!\n");
+        return false;
+    }
+
+    {
+        beneath_mesh *mesh = draw_call->mesh;
+        beneath_opengl_shader shader_active = ctx.shaders[ctx.shaders_active_index];
+        unsigned int i;
+
+        if (mesh->changed)
+        {
+            beneath_opengl_draw_call_print(draw_call, print);
+
+            if (!beneath_opengl_mesh_upload(&ctx, mesh, print))
+            {
+                return false;
+            }
+        }
+
+        for (i = 0; i < draw_call->lods_count; ++i)
+        {
+            if (draw_call->lods[i]->changed && !beneath_opengl_mesh_upload(&ctx, draw_call->lods[i], print))
+            {
+                return false;
+            }
+        }
+
+        /* Queue the draw call, the instance data is copied now so the application can reuse its buffers */
+        {
+            /* Screen size of one world unit at distance one, the LOD selection scales it by the instance distance */
+            int target_height = draw_call->pixelize ? ctx.fbo_screen_height : (int)state->window_height;
+            float pixels_per_unit = (float)target_height * 0.5f / projection_inverse[5];
+            beneath_opengl_queue_entry *entry;
+
+            if (ctx.queue_size == BENEATH_OPENGL_QUEUE_MAX)
+            {
+                print(__FILE__, __LINE__, "[opengl] render queue is full!\n");
+                return false;
+            }
+
+            entry = &ctx.queue[ctx.queue_size];
+            entry->draw_call = draw_call;
+            entry->shader_index = ctx.shaders_active_index;
+            entry->key = beneath_opengl_queue_key(shader_active.hash, draw_call, camera_position);
+
+            if (!beneath_opengl_instances_upload(&ctx, entry, projection_view, camera_position, pixels_per_unit, print))
+            {
+                return false;
+            }
+
+            ctx.queue_size++;
+        }
+
+        /* One camera per frame */
+        for (i = 0; i < 16; ++i)
+        {
+            ctx.queue_projection_view[i] = projection_view[i];
+            ctx.queue_projection_inverse[i] = projection_inverse[i];
+            ctx.queue_view_inverse[i] = view_inverse[i];
+        }
+
+        ctx.queue_camera_position[0] = camera_position[0];
+        ctx.queue_camera_position[1] = camera_position[1];
+        ctx.queue_camera_position[2] = camera_position[2];
+        ctx.queue_state = state;
+
+        draw_call->mesh->changed = false;
+
+        for (i = 0; i < draw_call->lods_count; ++i)
+        {
+            draw_call->lods[i]->changed = false;
+        }
+    }
+    return true;
+}
+
+/* Writes this frames uniform blocks into the stream ring, one frame and one camera block
+ * plus a lighting block per distinct beneath_lightning, and binds frame and camera.
+ * The queue entries get the offset of their lighting block.
+ */
+BENEATH_API beneath_bool beneath_opengl_uniforms_upload(beneath_opengl_context *ctx, beneath_api_io_print print)
+{
+    beneath_lightning *lights[BENEATH_OPENGL_UNIFORM_LIGHTS_MAX];
+    unsigned int lights_count = 0;
+    unsigned int alignment_mask = ctx->uniform_alignment - 1;
+    unsigned int frame_size = ((unsigned int)sizeof(beneath_opengl_uniform_frame) + alignment_mask) & ~alignment_mask;
+    unsigned int camera_size = ((unsigned int)sizeof(beneath_opengl_uniform_camera) + alignment_mask) & ~alignment_mask;
+    unsigned int lighting_size = ((unsigned int)sizeof(beneath_opengl_uniform_lighting) + alignment_mask) & ~alignment_mask;
+    unsigned long base;
+    unsigned char *dst;
+    unsigned int i;
+    unsigned int j;
+
+    /* Draw calls mostly share their lightning, a short linear search is enough */
+    for (i = 0; i < ctx->queue_size; ++i)
+    {
+        beneath_lightning *lightning = ctx->queue[i].draw_call->lightning;
+
+        for (j = 0; j < lights_count && lights[j] != lightning; ++j)
+        {
+        }
+
+        if (j == lights_count)
+        {
+            if (lights_count == BENEATH_OPENGL_UNIFORM_LIGHTS_MAX)
+            {
+                print(__FILE__, __LINE__, "[opengl] too many distinct lightnings in one frame!\n");
+                return false;
+            }
+
+            lights[lights_count++] = lightning;
+        }
+
+        ctx->queue[i].lighting_base = j; /* Index for now, turned into the offset below */
+    }
+
+    dst = beneath_opengl_stream_map(ctx, frame_size + camera_size + lights_count * lighting_size, ctx->uniform_alignment, &base);
+
+    if (!dst)
+    {
+        print(__FILE__, __LINE__, "[opengl] no stream space left for the uniform blocks!\n");
+        return false;
+    }
+
+    {
+        beneath_state *state = ctx->queue_state;
+        beneath_opengl_uniform_frame frame = {0};
+        beneath_opengl_uniform_camera camera = {0};
+
+        frame.time = (float)state->time;
+        frame.delta_time = (float)state->delta_time;
+        frame.resolution[0] = (float)state->window_width;
+        frame.resolution[1] = (float)state->window_height;
+
+        for (i = 0; i < 16; ++i)
+        {
+            camera.pv[i] = ctx->queue_projection_view[i];
+        }
+
+        camera.camera_position[0] = ctx->queue_camera_position[0];
+        camera.camera_position[1] = ctx->queue_camera_position[1];
+        camera.camera_position[2] = ctx->queue_camera_position[2];
+
+        beneath_opengl_stream_copy(dst, &frame, sizeof(frame));
+        beneath_opengl_stream_copy(dst + frame_size, &camera, sizeof(camera));
+    }
+
+    for (j = 0; j < lights_count; ++j)
+    {
+        beneath_opengl_uniform_lighting lighting = {0};
+
+        for (i = 0; i < 16; ++i)
+        {
+            lighting.light_space_matrix[i] = shadow_pv.e[i];
+        }
+
+        /* Draw calls without lightning still need the light space matrix for shadows */
+        if (lights[j])
+        {
+            beneath_light_directional *dl = &lights[j]->directional;
+
+            for (i = 0; i < 3; ++i)
+            {
+                lighting.direction[i] = dl->direction[i];
+                lighting.ambient[i] = dl->ambient[i];
+                lighting.diffuse[i] = dl->diffuse[i];
+                lighting.specular[i] = dl->specular[i];
+            }
+        }
+
+        beneath_opengl_stream_copy(dst + frame_size + camera_size + j * lighting_size, &lighting, sizeof(lighting));
+    }
+
+    beneath_opengl_stream_unmap(ctx);
+
+    for (i = 0; i < ctx->queue_size; ++i)
+    {
+        ctx->queue[i].lighting_base = base + frame_size + camera_size + ctx->queue[i].lighting_base * lighting_size;
+    }
+
+    glBindBufferRange(GL_UNIFORM_BUFFER, BENEATH_OPENGL_UNIFORM_BLOCK_FRAME, ctx->stream_buffer, (beneath_gl_intptr)base, (beneath_gl_intptr)sizeof(beneath_opengl_uniform_frame));
+    glBindBufferRange(GL_UNIFORM_BUFFER, BENEATH_OPENGL_UNIFORM_BLOCK_CAMERA, ctx->stream_buffer, (beneath_gl_intptr)(base + frame_size), (beneath_gl_intptr)sizeof(beneath_opengl_uniform_camera));
+
+    return true;
+}
+
+/* Called once per frame by the platform after the application issued its draw calls.
+ * Sorts the queue and renders it with a single shadow pass, a single scene pass and
+ * a single post processing pass.
+ */
+BENEATH_API void beneath_opengl_frame_end(beneath_api_io_print print)
+{
+    beneath_state *state = ctx.queue_state;
+    beneath_draw_call *volumetric_call = 0;
+    beneath_bool shadow = false;
+    beneath_bool pixelize = false;
+    beneath_bool offscreen;
+    unsigned long lighting_bound = ~0ul;
+    unsigned int i;
+
+    ctx.queue_draws = ctx.queue_size;
+    ctx.instances_submitted = 0;
+    ctx.instances_drawn = 0;
+    ctx.instances_shadow_drawn = 0;
+    ctx.instances_occluded = 0;
+    ctx.triangles_drawn = 0;
+
+    if (!ctx.initialized || ctx.queue_size == 0)
+    {
+        return;
+    }
+
+    /* The platform binds its own framebuffer and sets the viewport between frames */
+    ctx.state.framebuffer = BENEATH_OPENGL_STATE_UNKNOWN;
+    ctx.state.viewport_width = -1;
+    ctx.state.viewport_height = -1;
 
-            glBindVertexArray(ctx.fbo_screen_vao);
-            glBindBuffer(GL_ARRAY_BUFFER, ctx.fbo_screen_vbo);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertices), quad_vertices, GL_STATIC_DRAW);
+    /* Insertion sort, stable and fast for the few hundred mostly presorted entries of a frame */
+    for (i = 1; i < ctx.queue_size; ++i)
+    {
+        beneath_opengl_queue_entry entry = ctx.queue[i];
+        unsigned int j = i;
 
-            glEnableVertexAttribArray(0);
-            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)0);
-            glEnableVertexAttribArray(1);
-            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(2 * sizeof(float)));
+        while (j > 0 && ctx.queue[j - 1].key > entry.key)
+        {
+            ctx.queue[j] = ctx.queue[j - 1];
+            j--;
+        }
 
-            glBindVertexArray(0);
+        ctx.queue[j] = entry;
+    }
+
+    for (i = 0; i < ctx.queue_size; ++i)
+    {
+        beneath_draw_call *draw_call = ctx.queue[i].draw_call;
+
+        ctx.instances_submitted += draw_call->models_count;
+        ctx.instances_drawn += ctx.queue[i].instances_count;
+        ctx.instances_shadow_drawn += draw_call->shadow ? ctx.queue[i].shadow_instances_count : 0;
+        ctx.instances_occluded += ctx.queue[i].instances_occluded;
+
+        shadow = shadow || draw_call->shadow;
+        pixelize = pixelize || draw_call->pixelize;
+
+        if (draw_call->volumetric && draw_call->lightning && !volumetric_call)
+        {
+            volumetric_call = draw_call;
         }
+    }
 
-        /* Post processing shader */
+    if (!beneath_opengl_uniforms_upload(&ctx, print))
+    {
+        ctx.queue_size = 0;
+        return;
+    }
+
+    /* (1) Shadow Map Render Pass */
+    if (shadow)
+    {
+        beneath_opengl_state_cull_face(&ctx.state, GL_FRONT);
+        beneath_opengl_state_bind_framebuffer(&ctx.state, ctx.shadow_fbo);
+        beneath_opengl_state_viewport(&ctx.state, SHADOW_SIZE, SHADOW_SIZE);
+        glClear(GL_DEPTH_BUFFER_BIT);
+
+        beneath_opengl_state_use_program(&ctx.state, ctx.shadow_program);
+        glUniformMatrix4fv(ctx.shadow_uniform_pv, 1, GL_FALSE, shadow_pv.e);
+
+        for (i = 0; i < ctx.queue_size; ++i)
         {
-            if (!beneath_opengl_shader_create(
-                    &ctx.post_process_base_program,
-                    beneath_opengl_shader_post_process_base_vertex,
-                    beneath_opengl_shader_post_process_base_fragment,
-                    print))
+            beneath_opengl_queue_entry *entry = &ctx.queue[i];
+            unsigned int first = 0;
+            unsigned int lod;
+
+            if (!entry->draw_call->shadow || entry->shadow_instances_count == 0)
             {
-                print(__FILE__, __LINE__, "cannot compile post processing shader !!!\n");
-                return false;
+                continue;
             }
 
-            ctx.post_process_base_uniform_screen_texture = glGetUniformLocation(ctx.shadow_program, "screen_texture");
+            for (lod = 0; lod <= entry->draw_call->lods_count; ++lod)
+            {
+                beneath_mesh *mesh = beneath_draw_call_lod_mesh(entry->draw_call, lod);
+                unsigned int count = entry->shadow_lod_counts[lod];
+
+                if (count == 0)
+                {
+                    continue;
+                }
+
+                beneath_opengl_state_bind_vertex_array(&ctx.state, ctx.storage_vertex_array[mesh->id]);
+                beneath_opengl_instances_bind(&ctx.state, entry, true, first);
+                glDrawElementsInstanced(GL_TRIANGLES, (int)mesh->indices_count, BENEATH_OPENGL_INDEX_TYPE(mesh), 0, (int)count);
+
+                first += count;
+            }
         }
 
-        /* Volumetric Shader */
+        beneath_opengl_state_bind_framebuffer(&ctx.state, ctx.fbo_output);
+        beneath_opengl_state_viewport(&ctx.state, (int)state->window_width, (int)state->window_height);
+        beneath_opengl_state_cull_face(&ctx.state, GL_BACK);
+    }
+
+    /* Post processing and the Hi-Z pyramid both need the scene in fbo_screen. Without post
+     * processing it is used when it matches the window, the color is copied out afterwards.
+     */
+    offscreen = pixelize || volumetric_call ||
+                (ctx.hiz.levels_count > 0 && ctx.fbo_screen_width == (int)state->window_width && ctx.fbo_screen_height == (int)state->window_height);
+
+    if (offscreen)
+    {
+        beneath_opengl_state_bind_framebuffer(&ctx.state, ctx.fbo_screen);
+        beneath_opengl_state_viewport(&ctx.state, ctx.fbo_screen_width, ctx.fbo_screen_height);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+
+    /* (2) Scene Render Pass, program and VAO only change between differing keys */
+    beneath_opengl_state_bind_texture(&ctx.state, BENEATH_OPENGL_SHADER_TEXTURE_UNIT_SHADOW_MAP, ctx.shadow_texture_depth);
+
+    for (i = 0; i < ctx.queue_size; ++i)
+    {
+        beneath_opengl_queue_entry *entry = &ctx.queue[i];
+        beneath_draw_call *draw_call = entry->draw_call;
+        beneath_opengl_shader shader_active = ctx.shaders[entry->shader_index];
+        unsigned int first = 0;
+        unsigned int lod;
+
+        /* Every instance was culled */
+        if (entry->instances_count == 0)
         {
-            if (!beneath_opengl_shader_create(
-                    &ctx.volumetric_program,
-                    beneath_opengl_shader_post_process_base_vertex,
-                    beneath_opengl_shader_volumetric_fragment,
-                    print))
-            {
-                print(__FILE__, __LINE__, "cannot compile volumetric shader !!!\n");
-                return false;
-            }
+            draw_call->changed = false;
+            continue;
+        }
 
-            ctx.volumetric_uniform_screen_texture = glGetUniformLocation(ctx.volumetric_program, "screen_texture");
-            ctx.volumetric_uniform_depth_texture = glGetUniformLocation(ctx.volumetric_program, "depth_texture");
-            ctx.volumetric_uniform_shadow_map = glGetUniformLocation(ctx.volumetric_program, "shadow_map");
-            ctx.volumetric_uniform_light_position = glGetUniformLocation(ctx.volumetric_program, "light_position");
-            ctx.volumetric_uniform_light_direction = glGetUniformLocation(ctx.volumetric_program, "light_direction");
-            ctx.volumetric_uniform_light_projection = glGetUniformLocation(ctx.volumetric_program, "light_projection");
-            ctx.volumetric_uniform_light_view = glGetUniformLocation(ctx.volumetric_program, "light_view");
-            ctx.volumetric_uniform_camera_position = glGetUniformLocation(ctx.volumetric_program, "camera_position");
-            ctx.volumetric_uniform_camera_projection_inverse = glGetUniformLocation(ctx.volumetric_program, "camera_projection_inverse");
-            ctx.volumetric_uniform_camera_view_inverse = glGetUniformLocation(ctx.volumetric_program, "camera_view_inverse");
+        beneath_opengl_state_use_program(&ctx.state, shader_active.program_id);
+
+        if (lighting_bound != entry->lighting_base)
+        {
+            lighting_bound = entry->lighting_base;
+            glBindBufferRange(GL_UNIFORM_BUFFER, BENEATH_OPENGL_UNIFORM_BLOCK_LIGHTING, ctx.stream_buffer, (beneath_gl_intptr)lighting_bound, (beneath_gl_intptr)sizeof(beneath_opengl_uniform_lighting));
         }
 
-        /* Pixel */
+        /* Draw calls sharing a program can differ in color */
+        if (draw_call->colors_count > 0)
         {
-            if (!beneath_opengl_shader_create(
-                    &ctx.blit_program,
-                    beneath_opengl_shader_post_process_base_vertex,
-                    beneath_opengl_shader_pixel_fragment,
-                    print))
+            glUniform3f(shader_active.uniform_locations[BENEATH_OPENGL_SHADER_UNIFORM_LOCATION_INSTANCE_COLOR], draw_call->colors[0], draw_call->colors[1], draw_call->colors[2]);
+        }
+
+        /* One instanced draw per LOD chain level, the levels share the program */
+        for (lod = 0; lod <= draw_call->lods_count; ++lod)
+        {
+            beneath_mesh *mesh = beneath_draw_call_lod_mesh(draw_call, lod);
+            unsigned int count = entry->lod_counts[lod];
+
+            if (count == 0)
             {
-                print(__FILE__, __LINE__, "cannot compile pixel shaders !!!\n");
-                return false;
+                continue;
             }
 
-            ctx.blit_tex_uniform = glGetUniformLocation(ctx.blit_program, "screen_texture");
-            ctx.blit_texel_uniform = glGetUniformLocation(ctx.blit_program, "texel_size");
+            beneath_opengl_state_bind_vertex_array(&ctx.state, ctx.storage_vertex_array[mesh->id]);
+            beneath_opengl_instances_bind(&ctx.state, entry, false, first);
+            glDrawElementsInstanced(GL_TRIANGLES, (int)mesh->indices_count, BENEATH_OPENGL_INDEX_TYPE(mesh), 0, (int)count);
+
+            ctx.triangles_drawn += mesh->indices_count / 3 * count;
+            first += count;
         }
 
-        /* Shadow Map */
+        draw_call->changed = false;
+    }
+
+    /* Depth pyramid for the occlusion culling of the next frames, finished readbacks are taken over first */
+    if (ctx.hiz.levels_count > 0)
+    {
+        if (offscreen)
         {
-#define SHADOW_SIZE 1024
-            float border_color[] = {1.0, 1.0, 1.0, 1.0};
+            beneath_opengl_hiz_readback_poll(&ctx);
+            beneath_opengl_hiz_build(&ctx);
+        }
+        else
+        {
+            beneath_opengl_hiz_invalidate(&ctx);
+        }
+    }
 
-            v3 light_direction;
-            v3 center;
-            float distance;
+    /* (3) Post-processing */
+    if (offscreen)
+    {
+        beneath_opengl_state_bind_framebuffer(&ctx.state, ctx.fbo_output);
+        beneath_opengl_state_viewport(&ctx.state, (int)state->window_width, (int)state->window_height);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-            if (!beneath_opengl_shader_create(
-                    &ctx.shadow_program,
-                    beneath_opengl_shader_shadow_vertex,
-                    beneath_opengl_shader_shadow_fragment,
-                    print))
-            {
-                print(__FILE__, __LINE__, "cannot compile shadow shaders !!!\n");
-                return false;
-            }
+        if (pixelize)
+        {
+            /* Use the pixel shader program */
+            beneath_opengl_state_use_program(&ctx.state, ctx.blit_program);
+            beneath_opengl_state_bind_vertex_array(&ctx.state, ctx.fbo_screen_vao);
+            beneath_opengl_state_bind_texture(&ctx.state, 0, ctx.fbo_screen_color_texture);
+            glUniform1i(ctx.blit_tex_uniform, 0);
+            glUniform2f(ctx.blit_texel_uniform, 1.0f / (float)ctx.fbo_screen_width, 1.0f / (float)ctx.fbo_screen_height);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+        else if (volumetric_call)
+        {
+            /* Use volumetric program */
+            beneath_light_directional *dl = &volumetric_call->lightning->directional;
 
-            ctx.shadow_uniform_pv = glGetUniformLocation(ctx.shadow_program, "pv");
+            beneath_opengl_state_use_program(&ctx.state, ctx.volumetric_program);
+            beneath_opengl_state_bind_vertex_array(&ctx.state, ctx.fbo_screen_vao);
 
-            glGenTextures(1, &ctx.shadow_texture_depth);
-            glBindTexture(GL_TEXTURE_2D, ctx.shadow_texture_depth);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SHADOW_SIZE, SHADOW_SIZE, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-            glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border_color);
+            beneath_opengl_state_bind_texture(&ctx.state, 0, ctx.fbo_screen_color_texture);
+            glUniform1i(ctx.volumetric_uniform_screen_texture, 0);
 
-            glGenFramebuffers(1, &ctx.shadow_fbo);
-            glBindFramebuffer(GL_FRAMEBUFFER, ctx.shadow_fbo);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, ctx.shadow_texture_depth, 0);
-            glDrawBuffer(GL_NONE);
-            glReadBuffer(GL_NONE);
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            beneath_opengl_state_bind_texture(&ctx.state, 1, ctx.fbo_screen_depth_texture);
+            glUniform1i(ctx.volumetric_uniform_depth_texture, 1);
 
-            light_direction = vm_v3_normalize(vm_v3(
-                draw_call->lightning->directional.direction[0],
-                draw_call->lightning->directional.direction[1],
-                draw_call->lightning->directional.direction[2]));
+            beneath_opengl_state_bind_texture(&ctx.state, 2, ctx.shadow_texture_depth);
+            glUniform1i(ctx.volumetric_uniform_shadow_map, 2);
 
-            center = vm_v3_zero;
-            distance = 10.0f;
+            glUniform3f(ctx.volumetric_uniform_light_position, shadow_light_position.x, shadow_light_position.y, shadow_light_position.z);
+            glUniform3f(ctx.volumetric_uniform_light_direction, dl->direction[0], dl->direction[1], dl->direction[2]);
+            glUniformMatrix4fv(ctx.volumetric_uniform_light_projection, 1, GL_FALSE, shadow_projection.e);
+            glUniformMatrix4fv(ctx.volumetric_uniform_light_view, 1, GL_FALSE, shadow_view.e);
+            glUniform3f(ctx.volumetric_uniform_camera_position, ctx.queue_camera_position[0], ctx.queue_camera_position[1], ctx.queue_camera_position[2]);
+            glUniformMatrix4fv(ctx.volumetric_uniform_camera_projection_inverse, 1, GL_FALSE, ctx.queue_projection_inverse);
+            glUniformMatrix4fv(ctx.volumetric_uniform_camera_view_inverse, 1, GL_FALSE, ctx.queue_view_inverse);
 
-            shadow_light_position = vm_v3_sub(center, vm_v3_mulf(light_direction, distance));
-            shadow_projection = vm_m4x4_orthographic(-10.0f, 10.0f, -10.0f, 10.0f, 1.0f, 50.0f);
-            shadow_view = vm_m4x4_lookAt(shadow_light_position, vm_v3_zero, vm_v3_up);
-            shadow_pv = vm_m4x4_mul(shadow_projection, shadow_view);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+        else
+        {
+            /* Only rendered offscreen for the Hi-Z pyramid, copy the scene as it is */
+            beneath_opengl_state_use_program(&ctx.state, ctx.post_process_base_program);
+            beneath_opengl_state_bind_vertex_array(&ctx.state, ctx.fbo_screen_vao);
+            beneath_opengl_state_bind_texture(&ctx.state, 0, ctx.fbo_screen_color_texture);
+            glUniform1i(ctx.post_process_base_uniform_screen_texture, 0);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
         }
     }
 
-    {
-        beneath_mesh *mesh = draw_call->mesh;
-        beneath_opengl_shader shader_active = ctx.shaders[ctx.shaders_active_index];
+    ctx.queue_size = 0;
 
-        if (mesh->changed)
-        {
-            int sizeM4x4 = sizeof(float) * 16;
-            int i;
+    ctx.state_calls_issued = ctx.state.calls_issued;
+    ctx.state_calls_elided = ctx.state.calls_elided;
+    ctx.state.calls_issued = 0;
+    ctx.state.calls_elided = 0;
+}
 
-            unsigned int buffer_index = mesh->id * BENEATH_OPENGL_SHADER_LAYOUT_COUNT;
+#ifdef BENEATH_RENDER_THREAD
+/******************************/
+/* Command List               */
+/******************************/
 
-            beneath_opengl_draw_call_print(draw_call, print);
+/* With a render thread the platform does not call beneath_opengl_draw during beneath_update.
+ * graphics_draw records the draw calls into one of two command lists instead and the render
+ * thread, which owns the GL context, replays the list of frame N while the application
+ * simulates frame N + 1. Everything the application may change in the meantime (instance
+ * data, the draw call, its mesh and lighting structs, the state) is copied. The vertex and
+ * index arrays of a mesh are only referenced, they have to stay unchanged while a frame
+ * that uploads them is in flight (until the following beneath_update returned).
+ */
+#define BENEATH_OPENGL_COMMAND_LIST_MEMORY_SIZE (16u * 1024u * 1024u) /* Reserved per list, committed on demand */
+
+typedef struct beneath_opengl_command
+{
+    beneath_draw_call draw_call; /* Copy, points at the copied instance data, mesh and lighting */
+    float projection_view[16];
+    float projection_inverse[16];
+    float view_inverse[16];
+    float camera_position[3];
 
-            glBindVertexArray(ctx.storage_vertex_array[mesh->id]);
+} beneath_opengl_command;
 
-            /* Vertex data */
-            glBindBuffer(GL_ARRAY_BUFFER, ctx.storage_buffer_object[buffer_index]);
-            glBufferData(GL_ARRAY_BUFFER, (int)mesh->vertices_count * (int)sizeof(float), mesh->vertices, GL_STATIC_DRAW);
-            glVertexAttribPointer(BENEATH_OPENGL_SHADER_LAYOUT_POSITION, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-            glEnableVertexAttribArray(BENEATH_OPENGL_SHADER_LAYOUT_POSITION);
+typedef struct beneath_opengl_command_list
+{
+    beneath_arena arena; /* Instance data, reset when recording starts */
 
-            /* Index data */
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ctx.storage_buffer_object[buffer_index + 1]);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, (int)mesh->indices_count * (int)sizeof(unsigned int), mesh->indices, GL_STATIC_DRAW);
+    beneath_opengl_command commands[BENEATH_OPENGL_QUEUE_MAX];
+    unsigned int commands_count;
 
-            /* UV data */
-            if (mesh->uvs_count > 0)
-            {
-                glBindBuffer(GL_ARRAY_BUFFER, ctx.storage_buffer_object[buffer_index + 2]);
-                glBufferData(GL_ARRAY_BUFFER, (int)mesh->uvs_count * (int)sizeof(float), mesh->uvs, GL_STATIC_DRAW);
-                glVertexAttribPointer(BENEATH_OPENGL_SHADER_LAYOUT_UV, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
-                glEnableVertexAttribArray(BENEATH_OPENGL_SHADER_LAYOUT_UV);
-            }
+    beneath_state state; /* Copied when recording ends */
 
-            /* Normals data */
-            if (mesh->normals_count > 0)
-            {
-                glBindBuffer(GL_ARRAY_BUFFER, ctx.storage_buffer_object[buffer_index + 3]);
-                glBufferData(GL_ARRAY_BUFFER, (int)mesh->normals_count * (int)sizeof(float), mesh->normals, GL_STATIC_DRAW);
-                glVertexAttribPointer(BENEATH_OPENGL_SHADER_LAYOUT_NORMAL, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-                glEnableVertexAttribArray(BENEATH_OPENGL_SHADER_LAYOUT_NORMAL);
-            }
+    /* Each application mesh/lighting is copied once per frame */
+    beneath_mesh *meshes_source[BENEATH_OPENGL_MESHES_MAX];
+    beneath_mesh meshes[BENEATH_OPENGL_MESHES_MAX];
+    unsigned int meshes_count;
+    beneath_lightning *lightnings_source[BENEATH_OPENGL_UNIFORM_LIGHTS_MAX];
+    beneath_lightning lightnings[BENEATH_OPENGL_UNIFORM_LIGHTS_MAX];
+    unsigned int lightnings_count;
 
-            /* Tangent data */
-            if (mesh->tangents_count > 0)
-            {
-                glBindBuffer(GL_ARRAY_BUFFER, ctx.storage_buffer_object[buffer_index + 4]);
-                glBufferData(GL_ARRAY_BUFFER, (int)mesh->tangents_count * (int)sizeof(float), mesh->tangents, GL_STATIC_DRAW);
-                glVertexAttribPointer(BENEATH_OPENGL_SHADER_LAYOUT_TANGENT, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-                glEnableVertexAttribArray(BENEATH_OPENGL_SHADER_LAYOUT_TANGENT);
-            }
+} beneath_opengl_command_list;
 
-            /* Bitangent data */
-            if (mesh->bitangents_count > 0)
-            {
-                glBindBuffer(GL_ARRAY_BUFFER, ctx.storage_buffer_object[buffer_index + 5]);
-                glBufferData(GL_ARRAY_BUFFER, (int)mesh->bitangents_count * (int)sizeof(float), mesh->bitangents, GL_STATIC_DRAW);
-                glVertexAttribPointer(BENEATH_OPENGL_SHADER_LAYOUT_BITANGENT, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-                glEnableVertexAttribArray(BENEATH_OPENGL_SHADER_LAYOUT_BITANGENT);
-            }
+BENEATH_API void beneath_opengl_command_list_initialize(beneath_opengl_command_list *list, void *memory, unsigned int memory_size, beneath_arena_commit commit)
+{
+    beneath_arena_initialize(&list->arena, memory, memory_size, commit);
+    list->commands_count = 0;
+    list->meshes_count = 0;
+    list->lightnings_count = 0;
+}
 
-            /* Color data */
-            if (mesh->colors_count > 0)
-            {
-                glBindBuffer(GL_ARRAY_BUFFER, ctx.storage_buffer_object[buffer_index + 6]);
-                glBufferData(GL_ARRAY_BUFFER, (int)mesh->colors_count * (int)sizeof(float), mesh->colors, GL_STATIC_DRAW);
-                glVertexAttribPointer(BENEATH_OPENGL_SHADER_LAYOUT_COLOR, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-                glEnableVertexAttribArray(BENEATH_OPENGL_SHADER_LAYOUT_COLOR);
-            }
+/* Main thread, before beneath_update. The list must not be replayed anymore */
+BENEATH_API void beneath_opengl_command_list_begin(beneath_opengl_command_list *list)
+{
+    beneath_arena_reset(&list->arena);
+    list->commands_count = 0;
+    list->meshes_count = 0;
+    list->lightnings_count = 0;
+}
 
-            /* Instanced model */
-            glBindBuffer(GL_ARRAY_BUFFER, ctx.storage_buffer_object[buffer_index + 7]);
-            glBufferData(GL_ARRAY_BUFFER, (int)draw_call->models_count * sizeM4x4, &draw_call->models[0], GL_STATIC_DRAW);
+/* Main thread, after beneath_update. The list can be handed to the render thread afterwards */
+BENEATH_API void beneath_opengl_command_list_end(beneath_opengl_command_list *list, beneath_state *state)
+{
+    list->state = *state;
+}
 
-            /* set attribute pointers 6 - 9 for model matrix (4 times vec4) */
-            for (i = 0; i < 4; ++i)
-            {
-                int model_location = BENEATH_OPENGL_SHADER_LAYOUT_INSTANCE_MODEL;
-                glEnableVertexAttribArray((unsigned int)(model_location + i));
-                glVertexAttribPointer((unsigned int)(model_location + i), 4, GL_FLOAT, GL_FALSE, sizeM4x4, (void *)((unsigned long)i * sizeof(float) * 4));
-                glVertexAttribDivisor((unsigned int)(model_location + i), 1);
-            }
+BENEATH_API beneath_bool beneath_opengl_command_list_copy(beneath_opengl_command_list *list, void **destination, void *source, unsigned int size)
+{
+    unsigned char *copy;
 
-            glBindVertexArray(0);
-        }
+    if (!source || size == 0)
+    {
+        *destination = source;
+        return true;
+    }
 
-        /* (1) Shadow Map Render Pass */
-        if (draw_call->shadow)
-        {
-            glCullFace(GL_FRONT);
-            glBindFramebuffer(GL_FRAMEBUFFER, ctx.shadow_fbo);
-            glViewport(0, 0, SHADOW_SIZE, SHADOW_SIZE);
-            glClear(GL_DEPTH_BUFFER_BIT);
+    copy = (unsigned char *)beneath_arena_push(&list->arena, size, BENEATH_ARENA_ALIGNMENT_DEFAULT);
 
-            glUseProgram(ctx.shadow_program);
-            glUniformMatrix4fv(ctx.shadow_uniform_pv, 1, GL_FALSE, shadow_pv.e);
-            glBindVertexArray(ctx.storage_vertex_array[mesh->id]);
-            glDrawElementsInstanced(GL_TRIANGLES, (int)mesh->indices_count, GL_UNSIGNED_INT, 0, (int)draw_call->models_count);
-            glBindVertexArray(0);
+    if (!copy)
+    {
+        return false;
+    }
 
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
-            glViewport(0, 0, (int)state->window_width, (int)state->window_height);
-            glCullFace(GL_BACK);
-        }
+    beneath_opengl_stream_copy(copy, source, size);
+    *destination = copy;
+
+    return true;
+}
 
-        /* Post processing enabled. Render to fbo_screen */
-        if (draw_call->pixelize || draw_call->volumetric)
+/* The per frame copy of an application mesh, the upload flag moves into the copy so the next frame does not upload again */
+BENEATH_API beneath_mesh *beneath_opengl_command_list_mesh(beneath_opengl_command_list *list, beneath_mesh *mesh, beneath_api_io_print print)
+{
+    unsigned int i;
+
+    for (i = 0; i < list->meshes_count && list->meshes_source[i] != mesh; ++i)
+    {
+    }
+
+    if (i == list->meshes_count)
+    {
+        if (i == BENEATH_OPENGL_MESHES_MAX)
         {
-            glBindFramebuffer(GL_FRAMEBUFFER, ctx.fbo_screen);
-            glViewport(0, 0, ctx.fbo_screen_width, ctx.fbo_screen_height);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            print(__FILE__, __LINE__, "[opengl] too many meshes in the command list!\n");
+            return 0;
         }
+
+        /* The render thread works on the copy, bounds computed there would be lost */
+        if (mesh->changed && !mesh->bounds_valid)
         {
-            glUseProgram(shader_active.program_id);
-            glBindVertexArray(ctx.storage_vertex_array[mesh->id]);
+            beneath_mesh_bounds_compute(mesh);
+        }
 
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, ctx.shadow_texture_depth);
-            glUniform1i(glGetUniformLocation(shader_active.program_id, "shadow_map"), 1);
-            glUniformMatrix4fv(shader_active.uniform_locations[BENEATH_OPENGL_SHADER_UNIFORM_LOCATION_PROJECTION_VIEW], 1, GL_FALSE, projection_view);
-            glUniformMatrix4fv(glGetUniformLocation(shader_active.program_id, "light_space_matrix"), 1, GL_FALSE, shadow_pv.e);
-            glUniform3f(shader_active.uniform_locations[BENEATH_OPENGL_SHADER_UNIFORM_LOCATION_CAMERA_POSITION], camera_position[0], camera_position[1], camera_position[2]);
+        list->meshes_source[i] = mesh;
+        list->meshes[i] = *mesh;
+        list->meshes_count++;
+        mesh->changed = false;
+    }
 
-            if (draw_call->changed)
-            {
-                glUniform1f(shader_active.uniform_locations[BENEATH_OPENGL_SHADER_UNIFORM_LOCATION_TIME], (float)state->time);
-                glUniform1f(shader_active.uniform_locations[BENEATH_OPENGL_SHADER_UNIFORM_LOCATION_DELTA_TIME], (float)state->delta_time);
-                glUniform2f(shader_active.uniform_locations[BENEATH_OPENGL_SHADER_UNIFORM_LOCATION_RESOLUTION], (float)state->window_width, (float)state->window_height);
+    return &list->meshes[i];
+}
 
-                if (draw_call->colors_count > 0)
-                {
-                    glUniform3f(shader_active.uniform_locations[BENEATH_OPENGL_SHADER_UNIFORM_LOCATION_INSTANCE_COLOR], draw_call->colors[0], draw_call->colors[1], draw_call->colors[2]);
-                }
+/* Main thread, the graphics_draw of the render thread mode */
+BENEATH_API beneath_bool beneath_opengl_command_list_record(
+    beneath_opengl_command_list *list,
+    beneath_draw_call *draw_call,
+    float projection_view[16],
+    float projection_inverse[16],
+    float view_inverse[16],
+    float camera_position[3],
+    beneath_api_io_print print)
+{
+    beneath_opengl_command *command;
+    void *models;
+    void *colors;
+    void *texture_indices;
+    unsigned int i;
 
-                if (draw_call->lightning)
-                {
-                    beneath_light_directional *dl = &draw_call->lightning->directional;
-                    glUniform3f(glGetUniformLocation(shader_active.program_id, "dir_light.direction"), dl->direction[0], dl->direction[1], dl->direction[2]);
-                    glUniform3f(glGetUniformLocation(shader_active.program_id, "dir_light.ambient"), dl->ambient[0], dl->ambient[1], dl->ambient[2]);
-                    glUniform3f(glGetUniformLocation(shader_active.program_id, "dir_light.diffuse"), dl->diffuse[0], dl->diffuse[1], dl->diffuse[2]);
-                    glUniform3f(glGetUniformLocation(shader_active.program_id, "dir_light.specular"), dl->specular[0], dl->specular[1], dl->specular[2]);
-                }
-            }
+    if (!draw_call || draw_call->models_count == 0 || !draw_call->mesh)
+    {
+        return false;
+    }
 
-            glDrawElementsInstanced(GL_TRIANGLES, (int)mesh->indices_count, GL_UNSIGNED_INT, 0, (int)draw_call->models_count);
-            glBindVertexArray(0);
+    if (list->commands_count == BENEATH_OPENGL_QUEUE_MAX)
+    {
+        print(__FILE__, __LINE__, "[opengl] command list is full!\n");
+        return false;
+    }
+
+    if (!beneath_opengl_command_list_copy(list, &models, draw_call->models, draw_call->models_count * (unsigned int)sizeof(float) * 16) ||
+        !beneath_opengl_command_list_copy(list, &colors, draw_call->colors, draw_call->colors_count * (unsigned int)sizeof(float) * 3) ||
+        !beneath_opengl_command_list_copy(list, &texture_indices, draw_call->texture_indices, draw_call->texture_indices_count * (unsigned int)sizeof(int)))
+    {
+        print(__FILE__, __LINE__, "[opengl] command list memory is exhausted!\n");
+        return false;
+    }
+
+    command = &list->commands[list->commands_count];
+    command->draw_call = *draw_call;
+    command->draw_call.models = (float *)models;
+    command->draw_call.colors = (float *)colors;
+    command->draw_call.texture_indices = (int *)texture_indices;
+
+    /* Meshes of the LOD chain included */
+    command->draw_call.mesh = beneath_opengl_command_list_mesh(list, draw_call->mesh, print);
+
+    if (!command->draw_call.mesh)
+    {
+        return false;
+    }
+
+    for (i = 0; i < draw_call->lods_count; ++i)
+    {
+        command->draw_call.lods[i] = beneath_opengl_command_list_mesh(list, draw_call->lods[i], print);
+
+        if (!command->draw_call.lods[i])
+        {
+            return false;
         }
+    }
 
-        /* --- Post-processing --- */
-        if (draw_call->pixelize || draw_call->volumetric)
+    /* Lighting, the uniform upload groups draw calls by lighting pointer */
+    if (draw_call->lightning)
+    {
+        for (i = 0; i < list->lightnings_count && list->lightnings_source[i] != draw_call->lightning; ++i)
         {
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
-            glViewport(0, 0, (int)state->window_width, (int)state->window_height);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
 
-            if (draw_call->pixelize)
-            {
-                /* Use the pixel shader program */
-                glUseProgram(ctx.blit_program);
-                glBindVertexArray(ctx.fbo_screen_vao);
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, ctx.fbo_screen_color_texture);
-                glUniform1i(ctx.blit_tex_uniform, 0);
-                glUniform2f(ctx.blit_texel_uniform, 1.0f / (float)ctx.fbo_screen_width, 1.0f / (float)ctx.fbo_screen_height);
-                glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-            }
-            else if (draw_call->volumetric)
-            {
-                /* Use volumetric program */
-                glUseProgram(ctx.volumetric_program);
-                glBindVertexArray(ctx.fbo_screen_vao);
-
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, ctx.fbo_screen_color_texture);
-                glUniform1i(ctx.volumetric_uniform_screen_texture, 0);
-
-                glActiveTexture(GL_TEXTURE1);
-                glBindTexture(GL_TEXTURE_2D, ctx.fbo_screen_depth_texture);
-                glUniform1i(ctx.volumetric_uniform_depth_texture, 1);
-
-                glActiveTexture(GL_TEXTURE2);
-                glBindTexture(GL_TEXTURE_2D, ctx.shadow_texture_depth);
-                glUniform1i(ctx.volumetric_uniform_shadow_map, 2);
-
-                glUniform3f(ctx.volumetric_uniform_light_position, shadow_light_position.x, shadow_light_position.y, shadow_light_position.z);
-                glUniform3f(ctx.volumetric_uniform_light_direction, draw_call->lightning->directional.direction[0], draw_call->lightning->directional.direction[1], draw_call->lightning->directional.direction[2]);
-                glUniformMatrix4fv(ctx.volumetric_uniform_light_projection, 1, GL_FALSE, shadow_projection.e);
-                glUniformMatrix4fv(ctx.volumetric_uniform_light_view, 1, GL_FALSE, shadow_view.e);
-                glUniform3f(ctx.volumetric_uniform_camera_position, camera_position[0], camera_position[1], camera_position[2]);
-                glUniformMatrix4fv(ctx.volumetric_uniform_camera_projection_inverse, 1, GL_FALSE, projection_inverse);
-                glUniformMatrix4fv(ctx.volumetric_uniform_camera_view_inverse, 1, GL_FALSE, view_inverse);
-
-                glUniform1f(glGetUniformLocation(ctx.volumetric_program, "camera_far"), 100.0f);
-                glUniform1f(glGetUniformLocation(ctx.volumetric_program, "cone_angle"), 20.0f);
-                glUniform1f(glGetUniformLocation(ctx.volumetric_program, "shadow_bias"), 0.001f);
-
-                glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-            }
-            else
+        if (i == list->lightnings_count)
+        {
+            if (i == BENEATH_OPENGL_UNIFORM_LIGHTS_MAX)
             {
-                /* Use base post processing shader */
-                glUseProgram(ctx.post_process_base_program);
-                glBindVertexArray(ctx.fbo_screen_vao);
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, ctx.fbo_screen_color_texture);
-                glUniform1i(ctx.post_process_base_uniform_screen_texture, 0);
-                glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+                print(__FILE__, __LINE__, "[opengl] too many lightings in the command list!\n");
+                return false;
             }
+
+            list->lightnings_source[i] = draw_call->lightning;
+            list->lightnings[i] = *draw_call->lightning;
+            list->lightnings_count++;
         }
 
-        draw_call->changed = false;
-        draw_call->mesh->changed = false;
+        command->draw_call.lightning = &list->lightnings[i];
+    }
+
+    for (i = 0; i < 16; ++i)
+    {
+        command->projection_view[i] = projection_view[i];
+        command->projection_inverse[i] = projection_inverse[i];
+        command->view_inverse[i] = view_inverse[i];
     }
+
+    command->camera_position[0] = camera_position[0];
+    command->camera_position[1] = camera_position[1];
+    command->camera_position[2] = camera_position[2];
+
+    draw_call->changed = false;
+    list->commands_count++;
+
     return true;
 }
 
-#endif /* WIN32_BENEATH_OPENGL */
\ No newline at end of file
+/* Render thread, between beneath_opengl_frame_begin and beneath_opengl_frame_end */
+BENEATH_API void beneath_opengl_command_list_replay(beneath_opengl_command_list *list, beneath_api_io_print print)
+{
+    unsigned int i;
+
+    for (i = 0; i < list->commands_count; ++i)
+    {
+        beneath_opengl_command *command = &list->commands[i];
+
+        beneath_opengl_draw(
+            &list->state,
+            &command->draw_call,
+            command->projection_view,
+            command->projection_inverse,
+            command->view_inverse,
+            command->camera_position,
+            print);
+    }
+}
+#endif /* BENEATH_RENDER_THREAD */
+
+#endif /* WIN32_BENEATH_OPENGL */